@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/charscanner.hpp"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define I2_CHARSCANNER_SSE2
+#	include <emmintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	endif /* _MSC_VER */
+#endif
+
+using namespace icinga;
+
+CharScanner::CharScanner(const char *chars)
+{
+	size_t count = strlen(chars);
+
+	for (size_t i = 0; i < count; i++) {
+		m_Table[static_cast<unsigned char>(chars[i])] = true;
+	}
+
+	if (count > 0 && count <= MaxVectorChars) {
+		m_CharCount = count;
+
+		/* Pad with the first char, so that the vector loop always does MaxVectorChars comparisons. */
+		for (size_t i = 0; i < MaxVectorChars; i++) {
+			m_Chars[i] = chars[i < count ? i : 0];
+		}
+	}
+}
+
+#ifdef I2_CHARSCANNER_SSE2
+static inline unsigned int CountTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else /* _MSC_VER */
+	return __builtin_ctz(mask);
+#endif /* _MSC_VER */
+}
+#endif /* I2_CHARSCANNER_SSE2 */
+
+/**
+ * Finds the first delimiter in [begin, end).
+ *
+ * @returns A pointer to the delimiter or end if there's none
+ */
+const char *CharScanner::FindFirst(const char *begin, const char *end) const
+{
+#ifdef I2_CHARSCANNER_SSE2
+	if (m_CharCount) {
+		const __m128i c0 = _mm_set1_epi8(m_Chars[0]);
+		const __m128i c1 = _mm_set1_epi8(m_Chars[1]);
+		const __m128i c2 = _mm_set1_epi8(m_Chars[2]);
+		const __m128i c3 = _mm_set1_epi8(m_Chars[3]);
+
+		for (; end - begin >= 16; begin += 16) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+
+			__m128i hits = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, c0), _mm_cmpeq_epi8(chunk, c1)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, c2), _mm_cmpeq_epi8(chunk, c3))
+			);
+
+			auto mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+
+			if (mask) {
+				return begin + CountTrailingZeros(mask);
+			}
+		}
+	}
+#endif /* I2_CHARSCANNER_SSE2 */
+
+	for (; begin < end; begin++) {
+		if (m_Table[static_cast<unsigned char>(*begin)]) {
+			return begin;
+		}
+	}
+
+	return end;
+}
+
+/**
+ * Finds the first delimiter in str, starting at pos.
+ *
+ * @returns The delimiter's position or String::NPos if there's none
+ */
+size_t CharScanner::FindFirst(const String& str, size_t pos) const
+{
+	if (pos >= str.GetLength()) {
+		return String::NPos;
+	}
+
+	const char *begin = str.CStr();
+	const char *end = begin + str.GetLength();
+	const char *found = FindFirst(begin + pos, end);
+
+	return found == end ? String::NPos : found - begin;
+}
@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef CHARSCANNER_H
+#define CHARSCANNER_H
+
+#include "base/i2-base.hpp"
+#include "base/string.hpp"
+#include <array>
+#include <cstddef>
+
+namespace icinga
+{
+
+/**
+ * Searches a buffer for the first occurrence of any of a few delimiter characters.
+ *
+ * Where SSE2 is available (always on x86-64), 16 bytes are compared at once.
+ * Otherwise, or for more than MaxVectorChars delimiters, a lookup table is used.
+ *
+ * @ingroup base
+ */
+class CharScanner
+{
+public:
+	static constexpr size_t MaxVectorChars = 4;
+
+	explicit CharScanner(const char *chars);
+
+	const char *FindFirst(const char *begin, const char *end) const;
+	size_t FindFirst(const String& str, size_t pos = 0) const;
+
+private:
+	std::array<bool, 256> m_Table{};
+	std::array<char, MaxVectorChars> m_Chars{};
+	size_t m_CharCount{0};
+};
+
+}
+
+#endif /* CHARSCANNER_H */
@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/gzipcompressor.hpp"
+#include "base/exception.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace icinga;
+
+/* zlib counts in uInt, so larger inputs and outputs are handled in pieces. */
+static constexpr size_t l_MaxPiece = std::numeric_limits<uInt>::max();
+
+GzipCompressor::GzipCompressor(int level)
+	: m_Stream(new z_stream())
+{
+	/* 15 bits of window plus 16 selects the gzip wrapper instead of the zlib one. */
+	int rc = deflateInit2(m_Stream.get(), level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+
+	if (rc == Z_MEM_ERROR) {
+		BOOST_THROW_EXCEPTION(std::bad_alloc());
+	} else if (rc != Z_OK) {
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid gzip compression level: " + std::to_string(level)));
+	}
+}
+
+GzipCompressor::~GzipCompressor()
+{
+	deflateEnd(m_Stream.get());
+}
+
+/**
+ * Starts a new gzip stream, keeping the allocated compression state.
+ */
+void GzipCompressor::Reset()
+{
+	deflateReset(m_Stream.get());
+	m_Finished = false;
+}
+
+/**
+ * Sets the data to compress by the following Deflate() calls.
+ *
+ * The data must stay valid until IsInputConsumed(). If it's larger than what zlib can take at once,
+ * only the first part is consumed and the caller has to pass the rest again afterwards.
+ *
+ * @param data The uncompressed data
+ * @param size Its size in bytes
+ */
+void GzipCompressor::SetInput(const char *data, size_t size)
+{
+	m_Stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+	m_Stream->avail_in = static_cast<uInt>(std::min(size, l_MaxPiece));
+}
+
+/**
+ * Compresses as much of the input set by SetInput() as fits into out.
+ *
+ * Without finish, the compressed output lags behind the input. Call Deflate() until IsInputConsumed()
+ * to pass the next input. With finish, call it until IsFinished() to get the remaining output.
+ *
+ * @param out The buffer to write compressed data to
+ * @param size Its size in bytes
+ * @param finish Whether there won't be any more input
+ *
+ * @return The number of bytes written to out
+ */
+size_t GzipCompressor::Deflate(char *out, size_t size, bool finish)
+{
+	size = std::min(size, l_MaxPiece);
+
+	m_Stream->next_out = reinterpret_cast<Bytef*>(out);
+	m_Stream->avail_out = static_cast<uInt>(size);
+
+	int rc = deflate(m_Stream.get(), finish ? Z_FINISH : Z_NO_FLUSH);
+
+	if (rc == Z_STREAM_END) {
+		m_Finished = true;
+	} else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+		BOOST_THROW_EXCEPTION(std::runtime_error("gzip compression failed with error code " + std::to_string(rc)));
+	}
+
+	return size - m_Stream->avail_out;
+}
+
+bool GzipCompressor::IsInputConsumed() const
+{
+	return m_Stream->avail_in == 0;
+}
+
+bool GzipCompressor::IsFinished() const
+{
+	return m_Finished;
+}
+
+/**
+ * Compresses a whole body into a new gzip stream.
+ *
+ * @param in The uncompressed body
+ * @param out Is overwritten with the compressed body, its capacity is reused
+ */
+void GzipCompressor::Compress(std::string_view in, std::string& out)
+{
+	Reset();
+
+	size_t pos = 0;
+	size_t produced = 0;
+
+	/* Metrics usually compress well, so start small and grow if necessary. */
+	out.resize(std::max(out.capacity(), std::max(in.size() / 4, size_t(4096))));
+
+	while (!m_Finished) {
+		if (IsInputConsumed() && pos < in.size()) {
+			size_t piece = std::min(in.size() - pos, l_MaxPiece);
+			SetInput(in.data() + pos, piece);
+			pos += piece;
+		}
+
+		if (produced == out.size()) {
+			out.resize(out.size() * 2);
+		}
+
+		produced += Deflate(&out[produced], out.size() - produced, pos == in.size());
+	}
+
+	out.resize(produced);
+}
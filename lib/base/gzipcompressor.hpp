@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef GZIPCOMPRESSOR_H
+#define GZIPCOMPRESSOR_H
+
+#include "base/i2-base.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct z_stream_s;
+
+namespace icinga
+{
+
+/**
+ * Compresses data into the gzip format, e.g. for HTTP request bodies with "Content-Encoding: gzip".
+ *
+ * The compression state is allocated once and reused after Reset(), so one instance should be kept
+ * around for all requests of a connection. Compress() handles whole bodies, while SetInput() and
+ * Deflate() allow to compress a body piece by piece directly into the caller's output buffers.
+ *
+ * @ingroup base
+ */
+class GzipCompressor
+{
+public:
+	static constexpr int DefaultLevel = 6;
+
+	explicit GzipCompressor(int level = DefaultLevel);
+	~GzipCompressor();
+
+	GzipCompressor(const GzipCompressor&) = delete;
+	GzipCompressor& operator=(const GzipCompressor&) = delete;
+
+	void Reset();
+
+	void SetInput(const char *data, size_t size);
+	size_t Deflate(char *out, size_t size, bool finish);
+
+	bool IsInputConsumed() const;
+	bool IsFinished() const;
+
+	void Compress(std::string_view in, std::string& out);
+
+private:
+	std::unique_ptr<z_stream_s> m_Stream;
+	bool m_Finished{false};
+};
+
+}
+
+#endif /* GZIPCOMPRESSOR_H */
@@ -0,0 +1,396 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/metricsregistry.hpp"
+#include "base/statsfunction.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+using namespace icinga;
+
+REGISTER_STATSFUNCTION(MetricsRegistry, &MetricsRegistry::StatsFunc);
+
+namespace {
+
+struct RegistryEntry
+{
+	String Name;
+	String Help;
+	MetricLabels Labels;
+	std::weak_ptr<Metric> Object;
+};
+
+struct RegistryState
+{
+	std::mutex Mutex;
+	std::unordered_map<const Metric*, RegistryEntry> Entries;
+};
+
+/* Function-local, as components may register metrics during static initialisation. */
+RegistryState& GetRegistryState()
+{
+	static RegistryState state;
+	return state;
+}
+
+/**
+ * Takes strong references to all metrics which are still alive and forgets about the others.
+ *
+ * @return The metrics, sorted by name
+ */
+std::vector<std::pair<RegistryEntry, std::shared_ptr<Metric>>> CollectMetrics()
+{
+	auto& state (GetRegistryState());
+	std::vector<std::pair<RegistryEntry, std::shared_ptr<Metric>>> metrics;
+
+	{
+		std::unique_lock<std::mutex> lock (state.Mutex);
+
+		for (auto it (state.Entries.begin()); it != state.Entries.end();) {
+			if (auto object = it->second.Object.lock(); object) {
+				metrics.emplace_back(it->second, std::move(object));
+				++it;
+			} else {
+				it = state.Entries.erase(it);
+			}
+		}
+	}
+
+	std::stable_sort(metrics.begin(), metrics.end(), [](auto& a, auto& b) {
+		return a.first.Name < b.first.Name;
+	});
+
+	return metrics;
+}
+
+String EscapeOpenMetrics(const String& value, bool quote)
+{
+	String result;
+
+	for (char c : value) {
+		switch (c) {
+			case '\\':
+				result += "\\\\";
+				break;
+			case '\n':
+				result += "\\n";
+				break;
+			case '"':
+				result += quote ? "\\\"" : "\"";
+				break;
+			default:
+				result += c;
+		}
+	}
+
+	return result;
+}
+
+void WriteSample(std::ostream& out, const String& name, const String& labels, const String& extraLabel = String())
+{
+	out << name;
+
+	if (!labels.IsEmpty() || !extraLabel.IsEmpty()) {
+		out << '{' << labels;
+
+		if (!labels.IsEmpty() && !extraLabel.IsEmpty()) {
+			out << ',';
+		}
+
+		out << extraLabel << '}';
+	}
+
+	out << ' ';
+}
+
+}
+
+const char* MetricCounter::GetType() const
+{
+	return "counter";
+}
+
+Dictionary::Ptr MetricCounter::GetStatus() const
+{
+	return new Dictionary({ { "value", Get() } });
+}
+
+void MetricCounter::WriteOpenMetrics(std::ostream& out, const String& name, const String& labels) const
+{
+	WriteSample(out, name + "_total", labels);
+	out << Get() << '\n';
+}
+
+const char* MetricGauge::GetType() const
+{
+	return "gauge";
+}
+
+Dictionary::Ptr MetricGauge::GetStatus() const
+{
+	return new Dictionary({ { "value", Get() } });
+}
+
+void MetricGauge::WriteOpenMetrics(std::ostream& out, const String& name, const String& labels) const
+{
+	WriteSample(out, name, labels);
+	out << Get() << '\n';
+}
+
+void MetricLatencyHistogram::Record(Clock::duration latency, Clock::time_point now)
+{
+	auto microseconds (std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+	uint64_t value = microseconds > 0 ? microseconds : 0;
+
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+	m_SumMicroseconds.fetch_add(value, std::memory_order_relaxed);
+
+	auto epoch (GetEpoch(now));
+	auto current (m_Epoch.load(std::memory_order_relaxed));
+
+	if (epoch > current) {
+		if (m_Epoch.compare_exchange_strong(current, epoch, std::memory_order_relaxed)) {
+			/* Only the thread which won the race starts the new window. */
+			for (auto& bucket : m_Windows[epoch & 1]) {
+				bucket.store(0, std::memory_order_relaxed);
+			}
+
+			if (epoch - current > 1) {
+				for (auto& bucket : m_Windows[(epoch - 1) & 1]) {
+					bucket.store(0, std::memory_order_relaxed);
+				}
+			}
+		}
+	} else if (epoch < current - 1) {
+		/* The window this belongs to is gone already. */
+		return;
+	}
+
+	m_Windows[epoch & 1][GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricLatencyHistogram::Record(double seconds, Clock::time_point now)
+{
+	Record(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)), now);
+}
+
+MetricLatencyHistogram::Snapshot MetricLatencyHistogram::GetSnapshot(Clock::time_point now) const
+{
+	Snapshot snapshot{};
+	snapshot.Count = m_Count.load(std::memory_order_relaxed);
+	snapshot.Sum = m_SumMicroseconds.load(std::memory_order_relaxed) / 1e6;
+
+	auto epoch (GetEpoch(now));
+	auto current (m_Epoch.load(std::memory_order_relaxed));
+	std::vector<uint64_t> counts (BucketCount, 0);
+
+	/* Merge the windows which still belong to the last two. */
+	for (auto windowEpoch : { current, current - 1 }) {
+		if (windowEpoch < epoch - 1 || windowEpoch > epoch) {
+			continue;
+		}
+
+		auto& window (m_Windows[windowEpoch & 1]);
+
+		for (std::size_t i = 0; i < BucketCount; ++i) {
+			counts[i] += window[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	for (auto count : counts) {
+		snapshot.WindowCount += count;
+	}
+
+	if (snapshot.WindowCount == 0) {
+		return snapshot;
+	}
+
+	std::pair<double, double*> quantiles[] = {
+		{ 0.5, &snapshot.P50 }, { 0.9, &snapshot.P90 }, { 0.99, &snapshot.P99 }, { 1, &snapshot.Max }
+	};
+
+	uint64_t seen = 0;
+	auto quantile (std::begin(quantiles));
+
+	for (std::size_t i = 0; i < BucketCount && quantile != std::end(quantiles); ++i) {
+		seen += counts[i];
+
+		while (quantile != std::end(quantiles) && seen >= std::ceil(quantile->first * snapshot.WindowCount)) {
+			*quantile->second = GetBucketUpperBound(i) / 1e6;
+			++quantile;
+		}
+	}
+
+	return snapshot;
+}
+
+const char* MetricLatencyHistogram::GetType() const
+{
+	return "summary";
+}
+
+Dictionary::Ptr MetricLatencyHistogram::GetStatus() const
+{
+	auto snapshot (GetSnapshot());
+
+	return new Dictionary({
+		{ "count", snapshot.Count },
+		{ "sum", snapshot.Sum },
+		{ "window_count", snapshot.WindowCount },
+		{ "p50", snapshot.P50 },
+		{ "p90", snapshot.P90 },
+		{ "p99", snapshot.P99 },
+		{ "max", snapshot.Max }
+	});
+}
+
+void MetricLatencyHistogram::WriteOpenMetrics(std::ostream& out, const String& name, const String& labels) const
+{
+	auto snapshot (GetSnapshot());
+
+	std::pair<const char*, double> quantiles[] = {
+		{ "0.5", snapshot.P50 }, { "0.9", snapshot.P90 }, { "0.99", snapshot.P99 }, { "1.0", snapshot.Max }
+	};
+
+	for (auto& [quantile, value] : quantiles) {
+		WriteSample(out, name, labels, String("quantile=\"") + quantile + "\"");
+		out << value << '\n';
+	}
+
+	WriteSample(out, name + "_count", labels);
+	out << snapshot.Count << '\n';
+
+	WriteSample(out, name + "_sum", labels);
+	out << snapshot.Sum << '\n';
+}
+
+/**
+ * Computes the bucket the given latency is counted in.
+ *
+ * The first @c SubBuckets buckets hold one value each, after that every power of two is divided into
+ * @c SubBuckets buckets of equal width. Latencies beyond 2^MaxExponent end up in the last bucket.
+ */
+std::size_t MetricLatencyHistogram::GetBucketIndex(uint64_t microseconds)
+{
+	if (microseconds < SubBuckets) {
+		return microseconds;
+	}
+
+	if (microseconds >> MaxExponent) {
+		return BucketCount - 1;
+	}
+
+	unsigned int shift = 0;
+
+	while ((microseconds >> shift) >= SubBuckets * 2) {
+		++shift;
+	}
+
+	return (shift + 1) * SubBuckets + (microseconds >> shift) - SubBuckets;
+}
+
+/**
+ * @return The highest latency counted in the given bucket, in microseconds
+ */
+uint64_t MetricLatencyHistogram::GetBucketUpperBound(std::size_t index)
+{
+	if (index < SubBuckets) {
+		return index;
+	}
+
+	auto shift (index / SubBuckets - 1);
+	auto subBucket (index % SubBuckets + SubBuckets);
+
+	return ((subBucket + 1) << shift) - 1;
+}
+
+int64_t MetricLatencyHistogram::GetEpoch(Clock::time_point now)
+{
+	return std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count() / WindowLength.count();
+}
+
+/**
+ * Registers a metric, or updates its name and labels if it's registered already.
+ *
+ * @param name The metric family's name, in the OpenMetrics format, e.g. "icinga_workqueue_items"
+ * @param help A short description of the metric family
+ * @param labels The labels which distinguish this metric from the others of the same family
+ * @param metric The metric, which is unregistered automatically once it has been destroyed
+ */
+void MetricsRegistry::Register(const String& name, const String& help, const MetricLabels& labels, const std::shared_ptr<Metric>& metric)
+{
+	auto& state (GetRegistryState());
+	std::unique_lock<std::mutex> lock (state.Mutex);
+
+	state.Entries[metric.get()] = RegistryEntry{name, help, labels, metric};
+}
+
+/**
+ * @return The current values of all metrics, grouped by their name
+ */
+Dictionary::Ptr MetricsRegistry::GetStatus()
+{
+	std::map<String, ArrayData> families;
+
+	for (auto& [entry, metric] : CollectMetrics()) {
+		Dictionary::Ptr labels = new Dictionary();
+
+		for (auto& [key, value] : entry.Labels) {
+			labels->Set(key, value);
+		}
+
+		Dictionary::Ptr status = metric->GetStatus();
+		status->Set("labels", labels);
+
+		families[entry.Name].emplace_back(std::move(status));
+	}
+
+	DictionaryData result;
+
+	for (auto& [name, values] : families) {
+		result.emplace_back(name, new Array(std::move(values)));
+	}
+
+	return new Dictionary(std::move(result));
+}
+
+/**
+ * Writes all metrics in the OpenMetrics text format[^1].
+ *
+ * [^1]: https://github.com/prometheus/OpenMetrics/blob/main/specification/OpenMetrics.md
+ */
+void MetricsRegistry::WriteOpenMetrics(std::ostream& out)
+{
+	String family;
+
+	for (auto& [entry, metric] : CollectMetrics()) {
+		if (entry.Name != family) {
+			family = entry.Name;
+
+			out << "# TYPE " << family << ' ' << metric->GetType() << '\n'
+				<< "# HELP " << family << ' ' << EscapeOpenMetrics(entry.Help, false) << '\n';
+		}
+
+		String labels;
+
+		for (auto& [key, value] : entry.Labels) {
+			if (!labels.IsEmpty()) {
+				labels += ",";
+			}
+
+			labels += key + "=\"" + EscapeOpenMetrics(value, true) + "\"";
+		}
+
+		metric->WriteOpenMetrics(out, entry.Name, labels);
+	}
+
+	out << "# EOF\n";
+}
+
+void MetricsRegistry::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+{
+	GetStatus()->CopyTo(status);
+}
@@ -0,0 +1,184 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include "base/i2-base.hpp"
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include "base/string.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace icinga
+{
+
+using MetricLabels = std::vector<std::pair<String, String>>;
+
+/**
+ * A single time series of the metrics registry.
+ *
+ * Metrics are owned by the component which updates them. Updating them never blocks, so that they
+ * can be used in hot code paths.
+ *
+ * @ingroup base
+ */
+class Metric
+{
+public:
+	virtual ~Metric() = default;
+
+	virtual const char* GetType() const = 0;
+	virtual Dictionary::Ptr GetStatus() const = 0;
+	virtual void WriteOpenMetrics(std::ostream& out, const String& name, const String& labels) const = 0;
+};
+
+/**
+ * A monotonically increasing count.
+ *
+ * @ingroup base
+ */
+class MetricCounter final : public Metric
+{
+public:
+	void Increment(uint64_t count = 1)
+	{
+		m_Value.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	uint64_t Get() const
+	{
+		return m_Value.load(std::memory_order_relaxed);
+	}
+
+	const char* GetType() const override;
+	Dictionary::Ptr GetStatus() const override;
+	void WriteOpenMetrics(std::ostream& out, const String& name, const String& labels) const override;
+
+private:
+	std::atomic<uint64_t> m_Value{0};
+};
+
+/**
+ * A current value, e.g. the length of a queue.
+ *
+ * @ingroup base
+ */
+class MetricGauge final : public Metric
+{
+public:
+	void Set(int64_t value)
+	{
+		m_Value.store(value, std::memory_order_relaxed);
+	}
+
+	void Add(int64_t value)
+	{
+		m_Value.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	int64_t Get() const
+	{
+		return m_Value.load(std::memory_order_relaxed);
+	}
+
+	const char* GetType() const override;
+	Dictionary::Ptr GetStatus() const override;
+	void WriteOpenMetrics(std::ostream& out, const String& name, const String& labels) const override;
+
+private:
+	std::atomic<int64_t> m_Value{0};
+};
+
+/**
+ * A latency distribution with a bounded relative error, similar to an HDR histogram.
+ *
+ * Latencies are counted in microseconds. Each power of two is divided into @c SubBuckets linear
+ * buckets, so that a quantile is off by at most 1/SubBuckets of its value. Besides the all-time count
+ * and sum, the buckets are kept for two alternating windows of @c WindowLength, which is what the
+ * quantiles are computed from. So they reflect the last one to two minutes, not the whole uptime.
+ *
+ * Recording is lock-free. Samples recorded concurrently with a window rotation may be lost.
+ *
+ * @ingroup base
+ */
+class MetricLatencyHistogram final : public Metric
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr unsigned int SubBucketBits = 5;
+	static constexpr uint64_t SubBuckets = 1u << SubBucketBits;
+	static constexpr unsigned int MaxExponent = 36; // 2^36us, about 19 hours
+	static constexpr std::size_t BucketCount = (MaxExponent - SubBucketBits + 1) * SubBuckets;
+	static constexpr std::chrono::seconds WindowLength{60};
+
+	struct Snapshot
+	{
+		uint64_t Count; // all-time
+		double Sum; // all-time, in seconds
+		uint64_t WindowCount; // within the last one to two windows
+		double P50, P90, P99, Max; // in seconds, within the last one to two windows
+	};
+
+	void Record(Clock::duration latency, Clock::time_point now = Clock::now());
+	void Record(double seconds, Clock::time_point now = Clock::now());
+
+	Snapshot GetSnapshot(Clock::time_point now = Clock::now()) const;
+
+	const char* GetType() const override;
+	Dictionary::Ptr GetStatus() const override;
+	void WriteOpenMetrics(std::ostream& out, const String& name, const String& labels) const override;
+
+	static std::size_t GetBucketIndex(uint64_t microseconds);
+	static uint64_t GetBucketUpperBound(std::size_t index);
+
+private:
+	using Window = std::array<std::atomic<uint32_t>, BucketCount>;
+
+	std::atomic<uint64_t> m_Count{0};
+	std::atomic<uint64_t> m_SumMicroseconds{0};
+	std::atomic<int64_t> m_Epoch{0};
+	std::array<Window, 2> m_Windows{};
+
+	static int64_t GetEpoch(Clock::time_point now);
+};
+
+/**
+ * Keeps track of the metrics of all components, for /v1/status and the OpenMetrics export.
+ *
+ * The registry only references the metrics weakly, so a component's metrics vanish with it.
+ *
+ * @ingroup base
+ */
+class MetricsRegistry
+{
+public:
+	static void Register(const String& name, const String& help, const MetricLabels& labels, const std::shared_ptr<Metric>& metric);
+
+	/**
+	 * Registers the given metric and returns it, to initialise it where it's declared.
+	 */
+	template<class T>
+	static std::shared_ptr<T> Register(const String& name, const String& help, const MetricLabels& labels, std::shared_ptr<T> metric)
+	{
+		Register(name, help, labels, std::static_pointer_cast<Metric>(metric));
+		return metric;
+	}
+
+	static Dictionary::Ptr GetStatus();
+	static void WriteOpenMetrics(std::ostream& out);
+
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+};
+
+}
+
+#endif /* METRICSREGISTRY_H */
@@ -3,6 +3,7 @@
 
 #include "base/perfdatavalue.hpp"
 #include "base/perfdatavalue-ti.cpp"
+#include "base/charscanner.hpp"
 #include "base/convert.hpp"
 #include "base/exception.hpp"
 #include "base/logger.hpp"
@@ -226,6 +227,9 @@ PerfdataValue::PerfdataValue(const String& label, double value, bool counter,
 	SetMax(max, true);
 }
 
+/* ';' separates value, thresholds, min and max. ',' is rejected as that'd be a decimal comma. */
+static const CharScanner l_TokenDelims (";,");
+
 PerfdataValue::Ptr PerfdataValue::Parse(const String& perfdata)
 {
 	size_t eqp = perfdata.FindLastOf('=');
@@ -243,11 +247,26 @@ PerfdataValue::Ptr PerfdataValue::Parse(const String& perfdata)
 	if (spq == String::NPos)
 		spq = perfdata.GetLength();
 
-	String valueStr = perfdata.SubStr(eqp + 1, spq - eqp - 1);
-	std::vector<String> tokens = valueStr.Split(";");
+	std::vector<String> tokens;
 
-	if (valueStr.FindFirstOf(',') != String::NPos || tokens.empty()) {
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid performance data value: " + perfdata));
+	{
+		const char *token = perfdata.CStr() + eqp + 1;
+		const char *end = perfdata.CStr() + spq;
+
+		for (;;) {
+			const char *delim = l_TokenDelims.FindFirst(token, end);
+
+			if (delim != end && *delim == ',') {
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid performance data value: " + perfdata));
+			}
+
+			tokens.emplace_back(token, delim);
+
+			if (delim == end)
+				break;
+
+			token = delim + 1;
+		}
 	}
 
 	// Find the position where to split value and unit. Possible values of tokens[0] include:
@@ -38,6 +38,15 @@ WorkQueue::~WorkQueue()
 void WorkQueue::SetName(const String& name)
 {
 	m_Name = name;
+
+	MetricLabels labels ({ { "queue", name }, { "id", Convert::ToString(m_ID) } });
+
+	MetricsRegistry::Register("icinga_workqueue_items", "Tasks waiting in the work queue.", labels, m_ItemsMetric);
+	MetricsRegistry::Register("icinga_workqueue_tasks", "Tasks run by the work queue.", labels, m_TasksMetric);
+	MetricsRegistry::Register("icinga_workqueue_wait_seconds",
+		"Time tasks spent in the work queue before a worker picked them up.", labels, m_WaitTimeMetric);
+	MetricsRegistry::Register("icinga_workqueue_task_duration_seconds", "Time the work queue spent running a task.",
+		labels, m_RunTimeMetric);
 }
 
 String WorkQueue::GetName() const
@@ -75,6 +84,7 @@ void WorkQueue::EnqueueUnlocked(std::unique_lock<std::mutex>& lock, std::functio
 	}
 
 	m_Tasks.emplace(std::move(function), priority, ++m_NextTaskID);
+	m_ItemsMetric->Set(m_Tasks.size());
 
 	m_CVEmpty.notify_one();
 }
@@ -272,13 +282,20 @@ void WorkQueue::WorkerThreadProc()
 
 		Task task = m_Tasks.top();
 		m_Tasks.pop();
+		m_ItemsMetric->Set(m_Tasks.size());
 
 		m_Processing++;
 
 		lock.unlock();
 
+		auto start (std::chrono::steady_clock::now());
+		m_WaitTimeMetric->Record(start - task.Enqueued, start);
+
 		RunTaskFunction(task.Function);
 
+		auto end (std::chrono::steady_clock::now());
+		m_RunTimeMetric->Record(end - start, end);
+
 		/* clear the task so whatever other resources it holds are released _before_ we re-acquire the mutex */
 		task = Task();
 
@@ -296,6 +313,7 @@ void WorkQueue::WorkerThreadProc()
 void WorkQueue::IncreaseTaskCount()
 {
 	m_TaskStats.InsertValue(Utility::GetTime(), 1);
+	m_TasksMetric->Increment();
 }
 
 size_t WorkQueue::GetTaskCount(RingBuffer::SizeType span)
@@ -8,7 +8,9 @@
 #include "base/timer.hpp"
 #include "base/ringbuffer.hpp"
 #include "base/logger.hpp"
+#include "base/metricsregistry.hpp"
 #include <boost/thread/thread.hpp>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -33,12 +35,13 @@ struct Task
 	Task() = default;
 
 	Task(TaskFunction function, WorkQueuePriority priority, int id)
-		: Function(std::move(function)), Priority(priority), ID(id)
+		: Function(std::move(function)), Priority(priority), ID(id), Enqueued(std::chrono::steady_clock::now())
 	{ }
 
 	TaskFunction Function;
 	WorkQueuePriority Priority{PriorityNormal};
 	int ID{-1};
+	std::chrono::steady_clock::time_point Enqueued;
 };
 
 bool operator<(const Task& a, const Task& b);
@@ -145,6 +148,11 @@ private:
 	size_t m_PendingTasks{0};
 	double m_PendingTasksTimestamp{0};
 
+	std::shared_ptr<MetricGauge> m_ItemsMetric = std::make_shared<MetricGauge>();
+	std::shared_ptr<MetricCounter> m_TasksMetric = std::make_shared<MetricCounter>();
+	std::shared_ptr<MetricLatencyHistogram> m_WaitTimeMetric = std::make_shared<MetricLatencyHistogram>();
+	std::shared_ptr<MetricLatencyHistogram> m_RunTimeMetric = std::make_shared<MetricLatencyHistogram>();
+
 	void WorkerThreadProc();
 	void StatusTimerHandler();
 
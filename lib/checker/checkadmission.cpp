@@ -0,0 +1,152 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "checker/checkadmission.hpp"
+#include <algorithm>
+
+using namespace icinga;
+
+/**
+ * Sets the targets which must not be exceeded, 0 to ignore one. With both ignored, all checks are admitted at once.
+ *
+ * @param startLatency The average time between dispatching a check and its plugin being started
+ * @param load The system load per CPU
+ */
+void CheckAdmission::SetTargets(double startLatency, double load)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	m_TargetStartLatency = startLatency;
+	m_TargetLoad = load;
+}
+
+bool CheckAdmission::IsEnabled() const
+{
+	return m_TargetStartLatency > 0 || m_TargetLoad > 0;
+}
+
+void CheckAdmission::RecordStartLatency(double seconds)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	m_LatencySum += seconds;
+	m_LatencyCount++;
+}
+
+bool CheckAdmission::IsUpdateDue(double now)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return now - m_LastUpdate >= UpdateInterval || now < m_LastUpdate;
+}
+
+/**
+ * Adjusts the rate limit to the start latencies recorded since the last update and the given load.
+ */
+void CheckAdmission::Update(double now, double load)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	double elapsed = now - m_LastUpdate;
+
+	if (m_LastUpdate > 0 && elapsed > 0) {
+		double actualRate = m_Admitted / elapsed;
+
+		/* Without any checks started, a high latency of the past fades out. */
+		double latency = m_LatencyCount ? m_LatencySum / m_LatencyCount : 0;
+
+		m_StartLatency = m_StartLatency > 0 ? (m_StartLatency + latency) / 2 : latency;
+
+		bool congested = (m_TargetStartLatency > 0 && m_StartLatency > m_TargetStartLatency)
+			|| (m_TargetLoad > 0 && load > m_TargetLoad);
+
+		if (!IsEnabled()) {
+			/* Start over with a slow start once enabled. */
+			m_Rate = BaseRate;
+			m_Tokens = BaseRate * BurstLength;
+		} else if (congested) {
+			m_Rate = std::max(MinRate, std::min(m_Rate, actualRate) / 2);
+			m_Tokens = std::min(m_Tokens, 1.0);
+		} else {
+			m_Rate = std::max(BaseRate, std::min(m_Rate, actualRate) * 2);
+		}
+	}
+
+	m_LastUpdate = now;
+	m_Admitted = 0;
+	m_LatencySum = 0;
+	m_LatencyCount = 0;
+}
+
+void CheckAdmission::Refill(double now)
+{
+	if (now > m_LastRefill) {
+		m_Tokens = std::min(std::max(1.0, m_Rate * BurstLength), m_Tokens + (now - m_LastRefill) * m_Rate);
+	}
+
+	m_LastRefill = now;
+}
+
+/**
+ * Takes a token for starting a check.
+ *
+ * @param force Take it even if there's none, e.g. for a check forced by a user
+ *
+ * @return Whether the check may be started now
+ */
+bool CheckAdmission::TryAdmit(double now, bool force)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	if (!IsEnabled()) {
+		m_Admitted++;
+		return true;
+	}
+
+	Refill(now);
+
+	if (m_Tokens < 1 && !force) {
+		return false;
+	}
+
+	m_Tokens -= 1;
+	m_Admitted++;
+
+	return true;
+}
+
+/**
+ * @return The time until the next check is admitted
+ */
+double CheckAdmission::GetWaitTime(double now)
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	if (!IsEnabled()) {
+		return 0;
+	}
+
+	Refill(now);
+
+	return m_Tokens >= 1 ? 0 : (1 - m_Tokens) / m_Rate;
+}
+
+/**
+ * @return The current rate limit in checks per second, 0 if there's none
+ */
+double CheckAdmission::GetRate()
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return IsEnabled() ? m_Rate : 0;
+}
+
+/**
+ * @return The smoothed average start latency as of the last update
+ */
+double CheckAdmission::GetStartLatency()
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return m_StartLatency;
+}
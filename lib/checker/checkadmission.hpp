@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef CHECKADMISSION_H
+#define CHECKADMISSION_H
+
+#include "base/i2-base.hpp"
+#include <cstdint>
+#include <mutex>
+
+namespace icinga
+{
+
+/**
+ * Limits the rate at which the checker starts checks, based on how long starting them takes and the system load.
+ *
+ * Checks are admitted from a token bucket. On every update the rate limit is halved if the average start latency
+ * or the load exceed their targets. Otherwise it doubles while it's reached and follows twice the actual rate
+ * while it isn't, like a TCP slow start. So a burst of due checks is started gradually, as fast as the system
+ * keeps up with it. Without any targets, every check is admitted right away.
+ *
+ * All timestamps are in seconds.
+ *
+ * @ingroup checker
+ */
+class CheckAdmission
+{
+public:
+	static constexpr double MinRate = 10; // checks per second, under congestion
+	static constexpr double BaseRate = 100; // checks per second, if there are hardly any checks to start
+	static constexpr double UpdateInterval = 1;
+	static constexpr double BurstLength = 0.1; // the tokens which can be saved up, in seconds of the rate
+
+	void SetTargets(double startLatency, double load);
+
+	void RecordStartLatency(double seconds);
+
+	bool IsUpdateDue(double now);
+	void Update(double now, double load);
+
+	bool TryAdmit(double now, bool force = false);
+	double GetWaitTime(double now);
+
+	double GetRate();
+	double GetStartLatency();
+
+private:
+	std::mutex m_Mutex;
+
+	double m_TargetStartLatency{0};
+	double m_TargetLoad{0};
+
+	double m_Rate{BaseRate};
+	double m_Tokens{BaseRate * BurstLength};
+	double m_LastRefill{0};
+
+	double m_LastUpdate{0};
+	uint_fast64_t m_Admitted{0};
+	double m_LatencySum{0};
+	uint_fast64_t m_LatencyCount{0};
+	double m_StartLatency{0};
+
+	bool IsEnabled() const;
+	void Refill(double now);
+};
+
+}
+
+#endif /* CHECKADMISSION_H */
@@ -5,6 +5,7 @@
 #include "checker/checkercomponent-ti.cpp"
 #include "icinga/icingaapplication.hpp"
 #include "icinga/cib.hpp"
+#include "icinga/pluginutility.hpp"
 #include "remote/apilistener.hpp"
 #include "base/configuration.hpp"
 #include "base/configtype.hpp"
@@ -16,6 +17,12 @@
 #include "base/convert.hpp"
 #include "base/statsfunction.hpp"
 #include <chrono>
+#include <cmath>
+#include <thread>
+
+#ifndef _WIN32
+#	include <stdlib.h>
+#endif /* _WIN32 */
 
 using namespace icinga;
 
@@ -23,6 +30,12 @@ REGISTER_TYPE(CheckerComponent);
 
 REGISTER_STATSFUNCTION(CheckerComponent, &CheckerComponent::StatsFunc);
 
+/* Overdue checks deferred by the admission control are spread over their interval, at most this far. */
+static constexpr double l_MaxRespreadDelay = 300;
+
+/* Only checks which are overdue by more than this are spread, the others wait to be admitted. */
+static constexpr double l_MinRespreadLag = 1;
+
 void CheckerComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	DictionaryData nodes;
@@ -30,15 +43,32 @@ void CheckerComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr
 	for (const CheckerComponent::Ptr& checker : ConfigType::GetObjectsByType<CheckerComponent>()) {
 		unsigned long idle = checker->GetIdleCheckables();
 		unsigned long pending = checker->GetPendingCheckables();
+		auto lag (checker->m_ScheduleDelayMetric->GetSnapshot());
+		auto deferred (checker->m_DeferredMetric->Get());
+		auto respread (checker->m_RespreadMetric->Get());
 
 		nodes.emplace_back(checker->GetName(), new Dictionary({
 			{ "idle", idle },
-			{ "pending", pending }
+			{ "pending", pending },
+			{ "deferred", deferred },
+			{ "respread", respread },
+			{ "admission_rate", checker->m_Admission.GetRate() },
+			{ "start_latency", checker->m_Admission.GetStartLatency() },
+			{ "schedule_lag", new Dictionary({
+				{ "p50", lag.P50 },
+				{ "p90", lag.P90 },
+				{ "p99", lag.P99 },
+				{ "max", lag.Max }
+			}) }
 		}));
 
 		String perfdata_prefix = "checkercomponent_" + checker->GetName() + "_";
 		perfdata->Add(new PerfdataValue(perfdata_prefix + "idle", Convert::ToDouble(idle)));
 		perfdata->Add(new PerfdataValue(perfdata_prefix + "pending", Convert::ToDouble(pending)));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "deferred", Convert::ToDouble(deferred), true));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "respread", Convert::ToDouble(respread), true));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "schedule_lag_p50", lag.P50));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "schedule_lag_p99", lag.P99));
 	}
 
 	status->Set("checkercomponent", new Dictionary(std::move(nodes)));
@@ -65,6 +95,25 @@ void CheckerComponent::Start(bool runtimeCreated)
 	Log(LogInformation, "CheckerComponent")
 		<< "'" << GetName() << "' started.";
 
+	MetricLabels labels ({ { "checker", GetName() } });
+
+	MetricsRegistry::Register("icinga_checker_idle_checkables", "Checkables waiting for their next check.", labels, m_IdleMetric);
+	MetricsRegistry::Register("icinga_checker_pending_checkables", "Checkables being checked.", labels, m_PendingMetric);
+	MetricsRegistry::Register("icinga_checker_schedule_delay_seconds",
+		"Time between a check's scheduled time and the checker starting it.", labels, m_ScheduleDelayMetric);
+	MetricsRegistry::Register("icinga_checker_dispatch_wait_seconds",
+		"Time a started check waited for a thread pool worker to run it.", labels, m_DispatchWaitMetric);
+	MetricsRegistry::Register("icinga_checker_check_start_seconds",
+		"Time between the checker starting a check and the check having been started, e.g. its plugin spawned.", labels, m_StartLatencyMetric);
+	MetricsRegistry::Register("icinga_checker_deferred_checks",
+		"Due checks which had to wait for the admission control.", labels, m_DeferredMetric);
+	MetricsRegistry::Register("icinga_checker_respread_checks",
+		"Overdue checks which the admission control moved to a later point within their interval.", labels, m_RespreadMetric);
+	MetricsRegistry::Register("icinga_checker_admission_rate", "Checks per second the admission control lets start.", labels, m_AdmissionRateMetric);
+
+	m_Admission.SetTargets(GetMaxCheckStartLatency(), GetMaxLoadPerCpu());
+
+	CheckTrace::SetSampleRate(GetTraceSampleRate());
 
 	m_Thread = std::thread([this]() { CheckThreadProc(); });
 
@@ -131,8 +180,7 @@ void CheckerComponent::CheckThreadProc()
 		}
 
 		Checkable::Ptr checkable = csi.Object;
-
-		m_IdleCheckables.erase(checkable);
+		double now = Utility::GetTime();
 
 		bool forced = checkable->GetForceNextCheck();
 		bool check = true;
@@ -185,6 +233,9 @@ void CheckerComponent::CheckThreadProc()
 
 		/* reschedule the checkable if checks are disabled */
 		if (!check) {
+			m_IdleCheckables.erase(checkable);
+			m_OriginallyDue.erase(checkable.get());
+			m_ScheduleDelayMetric->Record(-wait);
 			m_IdleCheckables.insert(GetCheckableScheduleInfo(checkable));
 			lock.unlock();
 
@@ -202,6 +253,44 @@ void CheckerComponent::CheckThreadProc()
 			continue;
 		}
 
+		/* Checks which aren't run anyway don't need to be admitted. */
+		if (m_Admission.IsUpdateDue(now)) {
+			m_Admission.Update(now, GetLoadPerCpu());
+			m_AdmissionRateMetric->Set(static_cast<int64_t>(m_Admission.GetRate()));
+		}
+
+		if (!m_Admission.TryAdmit(now, forced)) {
+			if (m_LastDeferred != checkable.get()) {
+				m_LastDeferred = checkable.get();
+				m_DeferredMetric->Increment();
+			}
+
+			/* When it was due before having been respread for the first time. */
+			double due = m_OriginallyDue.emplace(checkable.get(), csi.NextCheck).first->second;
+			double interval = std::min(checkable->GetCurrentCheckInterval(), l_MaxRespreadDelay);
+
+			/* Spread a burst of overdue checks like their regular checks instead of starting them all as fast
+			 * as admitted. Unless a check has been waiting for two intervals already, so that none of them starves. */
+			if (-wait > l_MinRespreadLag && interval > l_MinRespreadLag && now - due < 2 * checkable->GetCurrentCheckInterval()) {
+				double delay = std::fmod(checkable->GetSchedulingOffset(), interval * 100) / 100.0;
+
+				m_RespreadMetric->Increment();
+
+				lock.unlock();
+				checkable->SetNextCheck(now + std::max(delay, l_MinRespreadLag));
+				lock.lock();
+
+				continue;
+			}
+
+			m_CV.wait_for(lock, std::chrono::duration<double>(m_Admission.GetWaitTime(now)));
+
+			continue;
+		}
+
+		m_IdleCheckables.erase(checkable);
+		m_OriginallyDue.erase(checkable.get());
+		m_ScheduleDelayMetric->Record(-wait);
 
 		csi = GetCheckableScheduleInfo(checkable);
 
@@ -232,15 +321,34 @@ void CheckerComponent::CheckThreadProc()
 		 */
 		CheckerComponent::Ptr checkComponent(this);
 
-		Utility::QueueAsyncCallback([this, checkComponent, checkable]() { ExecuteCheckHelper(checkable); });
+		Utility::QueueAsyncCallback([this, checkComponent, checkable, dispatched = std::chrono::steady_clock::now(),
+			trace = CheckTrace::Sample(checkable)]() {
+			ExecuteCheckHelper(checkable, dispatched, trace);
+		});
 
 		lock.lock();
 	}
 }
 
-void CheckerComponent::ExecuteCheckHelper(const Checkable::Ptr& checkable)
+void CheckerComponent::ExecuteCheckHelper(const Checkable::Ptr& checkable, std::chrono::steady_clock::time_point dispatched, const CheckTrace::Ptr& trace)
 {
+	auto now (std::chrono::steady_clock::now());
+	m_DispatchWaitMetric->Record(now - dispatched, now);
+
+	if (trace) {
+		trace->Record(CheckTraceStage::DispatchWait, now - dispatched);
+	}
+
 	try {
+		CheckTrace::Scope traceScope (trace);
+
+		/* In-process checks don't have a start latency, they're done once ExecuteCheck() returns. */
+		PluginUtility::CheckStartHook startHook ([this, dispatched]() {
+			auto started (std::chrono::steady_clock::now());
+			m_StartLatencyMetric->Record(started - dispatched, started);
+			m_Admission.RecordStartLatency(std::chrono::duration<double>(started - dispatched).count());
+		});
+
 		checkable->ExecuteCheck(m_WaitGroup);
 	} catch (const std::exception& ex) {
 		CheckResult::Ptr cr = new CheckResult();
@@ -291,10 +399,18 @@ void CheckerComponent::ResultTimerHandler()
 	{
 		std::unique_lock<std::mutex> lock(m_Mutex);
 
+		m_IdleMetric->Set(m_IdleCheckables.size());
+		m_PendingMetric->Set(m_PendingCheckables.size());
+
 		msgbuf << "Pending checkables: " << m_PendingCheckables.size() << "; Idle checkables: " << m_IdleCheckables.size() << "; Checks/s: "
 			<< (CIB::GetActiveHostChecksStatistics(60) + CIB::GetActiveServiceChecksStatistics(60)) / 60.0;
 	}
 
+	auto lag (m_ScheduleDelayMetric->GetSnapshot());
+
+	msgbuf << "; Deferred checks: " << m_DeferredMetric->Get() << "; Respread checks: " << m_RespreadMetric->Get()
+		<< "; Admitted checks/s: " << m_Admission.GetRate() << "; Schedule lag p50/p99: " << lag.P50 << "s/" << lag.P99 << "s";
+
 	Log(LogNotice, "CheckerComponent", msgbuf.str());
 }
 
@@ -319,12 +435,29 @@ void CheckerComponent::ObjectHandler(const ConfigObject::Ptr& object)
 		} else {
 			m_IdleCheckables.erase(checkable);
 			m_PendingCheckables.erase(checkable);
+			m_OriginallyDue.erase(checkable.get());
 		}
 
 		m_CV.notify_all();
 	}
 }
 
+/**
+ * @return The load average of the last minute per CPU or 0 if it isn't available
+ */
+double CheckerComponent::GetLoadPerCpu()
+{
+#ifndef _WIN32
+	double load;
+	unsigned int cpus = std::thread::hardware_concurrency();
+
+	if (getloadavg(&load, 1) == 1 && cpus > 0)
+		return load / cpus;
+#endif /* _WIN32 */
+
+	return 0;
+}
+
 CheckableScheduleInfo CheckerComponent::GetCheckableScheduleInfo(const Checkable::Ptr& checkable)
 {
 	CheckableScheduleInfo csi;
@@ -367,3 +500,27 @@ unsigned long CheckerComponent::GetPendingCheckables()
 
 	return m_PendingCheckables.size();
 }
+
+void CheckerComponent::ValidateTraceSampleRate(const Lazy<double>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<CheckerComponent>::ValidateTraceSampleRate(lvalue, utils);
+
+	if (lvalue() < 0 || lvalue() > 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "trace_sample_rate" }, "Trace sample rate must be between 0 and 1."));
+}
+
+void CheckerComponent::ValidateMaxCheckStartLatency(const Lazy<double>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<CheckerComponent>::ValidateMaxCheckStartLatency(lvalue, utils);
+
+	if (lvalue() < 0)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "max_check_start_latency" }, "Maximum check start latency must not be negative."));
+}
+
+void CheckerComponent::ValidateMaxLoadPerCpu(const Lazy<double>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<CheckerComponent>::ValidateMaxLoadPerCpu(lvalue, utils);
+
+	if (lvalue() < 0)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "max_load_per_cpu" }, "Maximum load per CPU must not be negative."));
+}
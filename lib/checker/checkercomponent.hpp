@@ -5,8 +5,11 @@
 #define CHECKERCOMPONENT_H
 
 #include "checker/checkercomponent-ti.hpp"
+#include "checker/checkadmission.hpp"
+#include "icinga/checktrace.hpp"
 #include "icinga/service.hpp"
 #include "base/configobject.hpp"
+#include "base/metricsregistry.hpp"
 #include "base/timer.hpp"
 #include "base/utility.hpp"
 #include "base/wait-group.hpp"
@@ -16,6 +19,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 
 namespace icinga
 {
@@ -70,6 +74,10 @@ public:
 	unsigned long GetIdleCheckables();
 	unsigned long GetPendingCheckables();
 
+	void ValidateTraceSampleRate(const Lazy<double>& lvalue, const ValidationUtils& utils) override;
+	void ValidateMaxCheckStartLatency(const Lazy<double>& lvalue, const ValidationUtils& utils) override;
+	void ValidateMaxLoadPerCpu(const Lazy<double>& lvalue, const ValidationUtils& utils) override;
+
 private:
 	std::mutex m_Mutex;
 	std::condition_variable m_CV;
@@ -82,10 +90,23 @@ private:
 	StoppableWaitGroup::Ptr m_WaitGroup = new StoppableWaitGroup();
 	Timer::Ptr m_ResultTimer;
 
+	CheckAdmission m_Admission;
+	const Checkable *m_LastDeferred{nullptr};
+	std::unordered_map<const Checkable*, double> m_OriginallyDue; // of deferred checks
+
+	std::shared_ptr<MetricGauge> m_IdleMetric = std::make_shared<MetricGauge>();
+	std::shared_ptr<MetricGauge> m_PendingMetric = std::make_shared<MetricGauge>();
+	std::shared_ptr<MetricLatencyHistogram> m_ScheduleDelayMetric = std::make_shared<MetricLatencyHistogram>();
+	std::shared_ptr<MetricLatencyHistogram> m_DispatchWaitMetric = std::make_shared<MetricLatencyHistogram>();
+	std::shared_ptr<MetricLatencyHistogram> m_StartLatencyMetric = std::make_shared<MetricLatencyHistogram>();
+	std::shared_ptr<MetricCounter> m_DeferredMetric = std::make_shared<MetricCounter>();
+	std::shared_ptr<MetricCounter> m_RespreadMetric = std::make_shared<MetricCounter>();
+	std::shared_ptr<MetricGauge> m_AdmissionRateMetric = std::make_shared<MetricGauge>();
+
 	void CheckThreadProc();
 	void ResultTimerHandler();
 
-	void ExecuteCheckHelper(const Checkable::Ptr& checkable);
+	void ExecuteCheckHelper(const Checkable::Ptr& checkable, std::chrono::steady_clock::time_point dispatched, const CheckTrace::Ptr& trace);
 
 	void AdjustCheckTimer();
 
@@ -95,6 +116,7 @@ private:
 	void RescheduleCheckTimer();
 
 	static CheckableScheduleInfo GetCheckableScheduleInfo(const Checkable::Ptr& checkable);
+	static double GetLoadPerCpu();
 };
 
 }
@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <cstring>
 #include <boost/program_options.hpp>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
 
@@ -661,6 +662,14 @@ int DaemonCommand::Run(const po::variables_map& vm, [[maybe_unused]] const std::
 	if (vm.count("validate")) {
 		Log(LogInformation, "cli", "Loading configuration file(s).");
 
+		/* The ITL has already been loaded, only report what's caused by the config files. */
+		std::vector<std::pair<String, double>> phases;
+
+		for (auto phase : { "parsing config files", "evaluating config files", "committing config items",
+			"OnAllConfigLoaded", "evaluating apply rules" }) {
+			phases.emplace_back(phase, ConfigCompilerContext::GetInstance()->GetPhaseDuration(phase));
+		}
+
 		std::vector<ConfigItem::Ptr> newItems;
 
 		if (!DaemonUtility::LoadConfigFiles(configs, newItems, l_ObjectsPath, Configuration::VarsPath)) {
@@ -669,6 +678,13 @@ int DaemonCommand::Run(const po::variables_map& vm, [[maybe_unused]] const std::
 		}
 
 		Log(LogInformation, "cli", "Finished validating the configuration file(s).");
+
+		for (auto& phase : phases) {
+			Log(LogInformation, "cli")
+				<< "Validation phase '" << phase.first << "' took " << std::fixed << std::setprecision(3)
+				<< ConfigCompilerContext::GetInstance()->GetPhaseDuration(phase.first) - phase.second << "s.";
+		}
+
 		return EXIT_SUCCESS;
 	}
 
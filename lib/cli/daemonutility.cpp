@@ -46,10 +46,11 @@ static bool IncludeZoneDirRecursive(const String& path, const String& package, b
 	/* register this zone path for cluster config sync */
 	ConfigCompiler::RegisterZoneDir("_etc", path, zoneName);
 
+	std::vector<String> files;
+	Utility::GlobRecursive(path, "*.conf", [&files](const String& file) { files.emplace_back(file); }, GlobFile);
+
 	std::vector<std::unique_ptr<Expression> > expressions;
-	Utility::GlobRecursive(path, "*.conf", [&expressions, zoneName, package](const String& file) {
-		ConfigCompiler::CollectIncludes(expressions, file, zoneName, package);
-	}, GlobFile);
+	ConfigCompiler::CollectIncludes(expressions, files, zoneName, package);
 
 	DictExpression expr(std::move(expressions));
 	if (!ExecuteExpression(&expr))
@@ -81,10 +82,11 @@ static bool IncludeNonLocalZone(const String& zonePath, const String& package, b
 		return true;
 	}
 
+	std::vector<String> files;
+	Utility::GlobRecursive(zonePath, "*.conf", [&files](const String& file) { files.emplace_back(file); }, GlobFile);
+
 	std::vector<std::unique_ptr<Expression> > expressions;
-	Utility::GlobRecursive(zonePath, "*.conf", [&expressions, zoneName, package](const String& file) {
-		ConfigCompiler::CollectIncludes(expressions, file, zoneName, package);
-	}, GlobFile);
+	ConfigCompiler::CollectIncludes(expressions, files, zoneName, package);
 
 	DictExpression expr(std::move(expressions));
 	if (!ExecuteExpression(&expr))
@@ -100,8 +102,10 @@ static void IncludePackage(const String& packagePath, bool& success)
 	String packageName = Utility::BaseName(packagePath);
 
 	if (Utility::PathExists(packagePath + "/include.conf")) {
+		double start = Utility::GetTime();
 		std::unique_ptr<Expression> expr = ConfigCompiler::CompileFile(packagePath + "/include.conf",
 			String(), packageName);
+		ConfigCompilerContext::GetInstance()->AddPhaseDuration("parsing config files", Utility::GetTime() - start);
 
 		if (!ExecuteExpression(&*expr))
 			success = false;
@@ -124,7 +128,10 @@ bool DaemonUtility::ValidateConfigFiles(const std::vector<std::string>& configs,
 	if (!configs.empty()) {
 		for (String configPath : configs) {
 			try {
+				double start = Utility::GetTime();
 				std::unique_ptr<Expression> expression = ConfigCompiler::CompileFile(configPath, String(), "_etc");
+				ConfigCompilerContext::GetInstance()->AddPhaseDuration("parsing config files", Utility::GetTime() - start);
+
 				success = ExecuteExpression(&*expression);
 				if (!success)
 					return false;
@@ -242,12 +249,19 @@ bool DaemonUtility::LoadConfigFiles(const std::vector<std::string>& configs,
 	const String& objectsFile, const String& varsfile)
 {
 	ActivationScope ascope;
+	auto compilerContext (ConfigCompilerContext::GetInstance());
+	double start = Utility::GetTime();
+	double parsing = compilerContext->GetPhaseDuration("parsing config files");
 
 	if (!DaemonUtility::ValidateConfigFiles(configs, objectsFile)) {
 		ConfigCompilerContext::GetInstance()->CancelObjectsFile();
 		return false;
 	}
 
+	/* Includes are parsed while evaluating the including file, so that's accounted to the parsing phase. */
+	compilerContext->AddPhaseDuration("evaluating config files", Utility::GetTime() - start
+		- (compilerContext->GetPhaseDuration("parsing config files") - parsing));
+
 	// After evaluating the top-level statements of the config files (happening in ValidateConfigFiles() above),
 	// prevent further modification of the global scope. This allows for a faster execution of the following steps
 	// as Freeze() disables locking as it's not necessary on a read-only data structure anymore.
@@ -134,6 +134,9 @@ void ExternalCommandListener::CommandPipeThread(const String& commandPath)
 
 			fifo->Write(buffer, rc);
 
+			/* Execute all of the complete commands at once, so that passive check results can be processed in parallel. */
+			std::vector<String> commands;
+
 			for (;;) {
 				String command;
 				StreamReadStatus srs = fifo->ReadLine(&command, src);
@@ -141,18 +144,13 @@ void ExternalCommandListener::CommandPipeThread(const String& commandPath)
 				if (srs != StatusNewItem)
 					break;
 
-				try {
-					Log(LogInformation, "ExternalCommandListener")
-						<< "Executing external command: " << command;
-
-					ExternalCommandProcessor::Execute(m_WaitGroup, command);
-				} catch (const std::exception& ex) {
-					Log(LogWarning, "ExternalCommandListener")
-						<< "External command failed: " << DiagnosticInformation(ex, false);
-					Log(LogNotice, "ExternalCommandListener")
-						<< "External command failed: " << DiagnosticInformation(ex, true);
-				}
+				Log(LogInformation, "ExternalCommandListener")
+					<< "Executing external command: " << command;
+
+				commands.emplace_back(std::move(command));
 			}
+
+			ExternalCommandProcessor::ExecuteMany(m_WaitGroup, commands);
 		}
 	}
 }
@@ -3,6 +3,8 @@
 
 #include "config/applyrule.hpp"
 #include "base/logger.hpp"
+#include "base/objectlock.hpp"
+#include "base/scriptglobal.hpp"
 #include <set>
 #include <unordered_set>
 
@@ -76,7 +78,27 @@ void ApplyRule::AddRule(const String& sourceType, const String& targetType, cons
 	auto& rules (m_Rules[Type::GetByName(sourceType).get()]);
 
 	if (!AddTargetedRule(rule, *actualTargetType, rules)) {
-		rules.Regular[Type::GetByName(*actualTargetType).get()].emplace_back(std::move(rule));
+		auto type (Type::GetByName(*actualTargetType));
+		std::vector<String> locals;
+
+		if (!fkvar.IsEmpty()) {
+			locals.emplace_back(fkvar);
+		}
+
+		if (!fvvar.IsEmpty()) {
+			locals.emplace_back(fvvar);
+		}
+
+		if (scope) {
+			ObjectLock olock (scope);
+
+			for (auto& kv : scope) {
+				locals.emplace_back(kv.first);
+			}
+		}
+
+		rules.Indexed.try_emplace(type.get(), type).first->second.Add(filter.get(), locals);
+		rules.Regular[type.get()].emplace_back(std::move(rule));
 	}
 }
 
@@ -151,6 +173,32 @@ const std::vector<ApplyRule::Ptr>& ApplyRule::GetRules(const Type::Ptr& sourceTy
 	return noRules;
 }
 
+/**
+ * @returns The subset of GetRules() (in the same order) which may match the given target, see ApplyRuleIndex.
+ */
+std::vector<ApplyRule::Ptr> ApplyRule::GetCandidateRules(const Type::Ptr& sourceType, const Type::Ptr& targetType, const Object::Ptr& target)
+{
+	auto& rules (GetRules(sourceType, targetType));
+	std::vector<ApplyRule::Ptr> candidates;
+
+	if (rules.empty()) {
+		return candidates;
+	}
+
+	auto& index (m_Rules.find(sourceType.get())->second.Indexed.at(targetType.get()));
+	std::vector<size_t> positions;
+
+	/* Each rule is evaluated in a ScriptFrame of its own, i.e. with the global namespace as "this". */
+	index.GetCandidates(target, ScriptGlobal::GetGlobals(), positions);
+	candidates.reserve(positions.size());
+
+	for (auto pos : positions) {
+		candidates.emplace_back(rules[pos]);
+	}
+
+	return candidates;
+}
+
 void ApplyRule::CheckMatches(bool silent)
 {
 	for (auto& perSourceType : m_Rules) {
@@ -5,6 +5,7 @@
 #define APPLYRULE_H
 
 #include "config/i2-config.hpp"
+#include "config/applyruleindex.hpp"
 #include "config/expression.hpp"
 #include "base/debuginfo.hpp"
 #include "base/shared-object.hpp"
@@ -32,6 +33,7 @@ public:
 	struct PerSourceType
 	{
 		std::unordered_map<Type* /* target type */, std::vector<ApplyRule::Ptr>> Regular;
+		std::unordered_map<Type* /* target type */, ApplyRuleIndex> Indexed;
 		std::unordered_map<String /* host */, PerHost> Targeted;
 	};
 
@@ -48,6 +50,10 @@ public:
 	 *
 	 * m_Rules[T::TypeInstance.get()].Regular[C::TypeInstance.get()]
 	 * contains all other apply rules like apply T "x" to C { ... }.
+	 *
+	 * m_Rules[T::TypeInstance.get()].Indexed[C::TypeInstance.get()]
+	 * pre-selects the ones of the above which can match a specific C
+	 * by their assign filters, e.g. assign where c.vars.os == "Linux".
 	 */
 	typedef std::unordered_map<Type* /* source type */, PerSourceType> RuleMap;
 
@@ -81,6 +87,7 @@ public:
 		const Expression::Ptr& filter, const String& package, const String& fkvar, const String& fvvar, const Expression::Ptr& fterm,
 		bool ignoreOnError, const DebugInfo& di, const Dictionary::Ptr& scope);
 	static const std::vector<ApplyRule::Ptr>& GetRules(const Type::Ptr& sourceType, const Type::Ptr& targetType);
+	static std::vector<ApplyRule::Ptr> GetCandidateRules(const Type::Ptr& sourceType, const Type::Ptr& targetType, const Object::Ptr& target);
 	[[gnu::no_dangling]] static const std::set<ApplyRule::Ptr>& GetTargetedHostRules(const Type::Ptr& sourceType, const String& host);
 	[[gnu::no_dangling]] static const std::set<ApplyRule::Ptr>& GetTargetedServiceRules(const Type::Ptr& sourceType, const String& host, const String& service);
 	static bool GetTargetHosts(Expression* assignFilter, std::vector<const String *>& hosts, const Dictionary::Ptr& constants = nullptr);
@@ -0,0 +1,323 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "config/applyruleindex.hpp"
+#include "config/vmops.hpp"
+#include "base/array.hpp"
+#include "base/objectlock.hpp"
+#include <algorithm>
+
+using namespace icinga;
+
+/**
+ * Lower-cases like match() does for the ASCII characters it compares case-insensitively.
+ */
+static inline char MatchToLower(char c)
+{
+	return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+static void AppendRules(std::vector<size_t>& candidates, const std::vector<size_t>& rules)
+{
+	candidates.insert(candidates.end(), rules.begin(), rules.end());
+}
+
+template<class T>
+static void AppendRules(std::vector<size_t>& candidates, const std::unordered_map<String, std::vector<size_t>>& index, const T& key)
+{
+	auto rules (index.find(key));
+
+	if (rules != index.end()) {
+		AppendRules(candidates, rules->second);
+	}
+}
+
+/**
+ * Creates an index for rules applied to objects of the given type, i.e. referring to it as e.g. host.
+ */
+ApplyRuleIndex::ApplyRuleIndex(const Type::Ptr& targetType)
+	: m_TargetType(targetType), m_Variable(targetType ? targetType->GetName().ToLower() : String())
+{ }
+
+/**
+ * Adds the next rule (position GetRuleCount()) to the index.
+ *
+ * @param filter The rule's assign filter
+ * @param locals The variables set by the rule itself (scope, for loop), they may shadow e.g. host and match()
+ */
+void ApplyRuleIndex::Add(Expression *filter, const std::vector<String>& locals)
+{
+	auto rule (m_RuleCount++);
+	std::vector<Term> terms;
+
+	if (!m_TargetType || std::find(locals.begin(), locals.end(), m_Variable) != locals.end()
+		|| !GetTerms(filter, std::find(locals.begin(), locals.end(), "match") != locals.end(), terms)) {
+		m_Unindexed.emplace_back(rule);
+		return;
+	}
+
+	for (auto& term : terms) {
+		auto id (m_PathIds.find(term.Path));
+
+		if (id == m_PathIds.end()) {
+			id = m_PathIds.emplace(term.Path, m_Paths.size()).first;
+			m_Paths.emplace_back();
+			m_Paths.back().Path = term.Path;
+		}
+
+		auto& path (m_Paths[id->second]);
+
+		switch (term.Cond) {
+			case Condition::Equal:
+				path.Equal[term.Key].emplace_back(rule);
+				path.AllEqual.emplace_back(rule);
+				break;
+			case Condition::Contains:
+				path.Contains[term.Key].emplace_back(rule);
+				path.AllContains.emplace_back(rule);
+				break;
+			case Condition::Match:
+				path.Match[term.Key].emplace_back(rule);
+				path.MatchPrefixLengths.emplace(term.Key.GetLength());
+				path.AllMatch.emplace_back(rule);
+		}
+	}
+}
+
+/**
+ * Collects the positions of all rules which may match the given object, in ascending order.
+ *
+ * Every attribute path referred to by any indexed rule is resolved once, the same way the filter would do it.
+ *
+ * @param target The object to find the rules for
+ * @param self The object the filters will be evaluated with as "this", see VariableExpression
+ * @param candidates Receives the positions of the rules
+ */
+void ApplyRuleIndex::GetCandidates(const Object::Ptr& target, const Object::Ptr& self, std::vector<size_t>& candidates) const
+{
+	candidates.clear();
+	AppendRules(candidates, m_Unindexed);
+
+	/* Fields of "this" are looked up before the System namespace, so they shadow its match() function.
+	 * Locals named "match" have already been taken care of by Add().
+	 */
+	bool matchShadowed = false;
+
+	for (auto& path : m_Paths) {
+		if (!path.Match.empty()) {
+			matchShadowed = self && self->HasOwnField("match");
+			break;
+		}
+	}
+
+	for (auto& path : m_Paths) {
+		Value value = target;
+
+		try {
+			for (auto& key : path.Path) {
+				value = VMOps::GetField(value, key);
+			}
+		} catch (const std::exception&) {
+			/* Let the full evaluation raise the error. */
+			AppendRules(candidates, path.AllEqual);
+			AppendRules(candidates, path.AllContains);
+			AppendRules(candidates, path.AllMatch);
+			continue;
+		}
+
+		bool isString = value.IsString() || value.IsEmpty();
+		String str = value.IsString() ? value.Get<String>() : String();
+
+		/* null == "" holds, any other comparison with a non-string is left to the filter. */
+		if (!path.Equal.empty()) {
+			if (isString) {
+				AppendRules(candidates, path.Equal, str);
+			} else {
+				AppendRules(candidates, path.AllEqual);
+			}
+		}
+
+		if (!path.Contains.empty() && !value.IsEmpty()) {
+			if (value.IsObjectType<Array>()) {
+				Array::Ptr arr = value;
+				ObjectLock olock (arr);
+
+				for (auto& item : arr) {
+					if (item.IsString()) {
+						AppendRules(candidates, path.Contains, item.Get<String>());
+					} else if (item.IsEmpty()) {
+						AppendRules(candidates, path.Contains, String());
+					} else {
+						AppendRules(candidates, path.AllContains);
+						break;
+					}
+				}
+			} else {
+				AppendRules(candidates, path.AllContains);
+			}
+		}
+
+		if (!path.Match.empty()) {
+			if (isString && !matchShadowed) {
+				String text;
+
+				for (auto length : path.MatchPrefixLengths) {
+					if (length > str.GetLength()) {
+						break;
+					}
+
+					while (text.GetLength() < length) {
+						text += MatchToLower(str[text.GetLength()]);
+					}
+
+					AppendRules(candidates, path.Match, text);
+				}
+			} else {
+				AppendRules(candidates, path.AllMatch);
+			}
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+}
+
+/**
+ * Derives the terms from the given filter of which at least one has to be true for the filter to be true.
+ *
+ * - A || B: the terms of A and B
+ * - A && B: the terms of A (B isn't even evaluated if A is false)
+ * - host.vars.x == "y", "y" == host.vars.x, "g" in host.groups, match("p*", host.name): one term each
+ *
+ * @returns Whether such terms exist, i.e. whether the filter can be indexed at all.
+ */
+bool ApplyRuleIndex::GetTerms(Expression *filter, bool matchShadowed, std::vector<Term>& terms) const
+{
+	if (auto lor = dynamic_cast<LogicalOrExpression*>(filter); lor) {
+		return GetTerms(lor->GetOperand1().get(), matchShadowed, terms)
+			&& GetTerms(lor->GetOperand2().get(), matchShadowed, terms);
+	}
+
+	if (auto land = dynamic_cast<LogicalAndExpression*>(filter); land) {
+		return GetTerms(land->GetOperand1().get(), matchShadowed, terms);
+	}
+
+	Term term;
+
+	if (auto eq = dynamic_cast<EqualExpression*>(filter); eq) {
+		auto op1 (eq->GetOperand1().get());
+		auto op2 (eq->GetOperand2().get());
+		auto key (GetConstString(op2));
+
+		if (!key || !GetPath(op1, term.Path)) {
+			key = GetConstString(op1);
+
+			if (!key || !GetPath(op2, term.Path)) {
+				return false;
+			}
+		}
+
+		term.Cond = Condition::Equal;
+		term.Key = *key;
+	} else if (auto in = dynamic_cast<InExpression*>(filter); in) {
+		auto key (GetConstString(in->GetOperand1().get()));
+
+		if (!key || !GetPath(in->GetOperand2().get(), term.Path)) {
+			return false;
+		}
+
+		term.Cond = Condition::Contains;
+		term.Key = *key;
+	} else if (auto call = dynamic_cast<FunctionCallExpression*>(filter); call) {
+		auto func (dynamic_cast<VariableExpression*>(call->m_FName.get()));
+
+		if (matchShadowed || !func || func->GetVariable() != "match" || call->m_Args.size() != 2u) {
+			return false;
+		}
+
+		auto pattern (GetConstString(call->m_Args[0].get()));
+
+		if (!pattern || !GetMatchPrefix(*pattern, term.Key) || !GetPath(call->m_Args[1].get(), term.Path)) {
+			return false;
+		}
+
+		term.Cond = Condition::Match;
+	} else {
+		return false;
+	}
+
+	terms.emplace_back(std::move(term));
+	return true;
+}
+
+/**
+ * If the given expression is like host.vars["x"].y, extracts the indexers ("vars", "x", "y").
+ *
+ * @returns Whether the given expression is like above.
+ */
+bool ApplyRuleIndex::GetPath(Expression *expr, std::vector<String>& path) const
+{
+	path.clear();
+
+	for (;;) {
+		auto ixr (dynamic_cast<IndexerExpression*>(expr));
+
+		if (!ixr) {
+			break;
+		}
+
+		auto key (GetConstString(ixr->GetOperand2().get()));
+
+		if (!key) {
+			return false;
+		}
+
+		path.emplace_back(*key);
+		expr = ixr->GetOperand1().get();
+	}
+
+	auto var (dynamic_cast<VariableExpression*>(expr));
+
+	if (!var || var->GetVariable() != m_Variable || path.empty()) {
+		return false;
+	}
+
+	std::reverse(path.begin(), path.end());
+
+	/* Such attributes can't be read in sandbox mode, let the filter decide what to do. */
+	int fid = m_TargetType->GetFieldId(path.front());
+
+	return fid < 0 || !(m_TargetType->GetFieldInfo(fid).Attributes & FANoUserView);
+}
+
+/**
+ * @returns If the given expression is a literal string, its address. nullptr otherwise.
+ */
+const String *ApplyRuleIndex::GetConstString(Expression *expr)
+{
+	auto lit (dynamic_cast<LiteralExpression*>(expr));
+
+	return lit && lit->GetValue().IsString() ? &lit->GetValue().Get<String>() : nullptr;
+}
+
+/**
+ * Extracts the part of the given match() pattern before the first wildcard, lower-cased.
+ *
+ * Non-ASCII characters end the prefix as well as their case-insensitive comparison depends on the locale.
+ *
+ * @returns Whether the prefix isn't empty.
+ */
+bool ApplyRuleIndex::GetMatchPrefix(const String& pattern, String& prefix)
+{
+	prefix.Clear();
+
+	for (auto p (pattern.CStr()); *p && *p != '*' && *p != '?' && !(*p & 0x80); ++p) {
+		if (*p == '\\' && (p[1] == '*' || p[1] == '?')) {
+			++p;
+		}
+
+		prefix += MatchToLower(*p);
+	}
+
+	return !prefix.IsEmpty();
+}
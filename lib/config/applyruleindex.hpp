@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef APPLYRULEINDEX_H
+#define APPLYRULEINDEX_H
+
+#include "config/i2-config.hpp"
+#include "config/expression.hpp"
+#include "base/type.hpp"
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * Pre-selects the apply rules (identified by their position) which can match a given object.
+ *
+ * For every added assign filter a necessary condition is derived from common shapes like
+ *
+ * - host.vars.os == "Linux"
+ * - "linux-servers" in host.groups
+ * - match("db-*", host.name)
+ *
+ * and stored in hash tables keyed by the compared string (or the literal prefix of the pattern).
+ * GetCandidates() then resolves each indexed attribute path of the object once and only returns
+ * the rules whose condition can hold plus the rules which couldn't be indexed.
+ *
+ * Rules are never dropped incorrectly: whenever the outcome of an indexed condition can't be
+ * predicted exactly (e.g. because a non-string value is compared or the evaluation would fail)
+ * the rule is returned as a candidate, so that the full evaluation yields the same result/error.
+ *
+ * @ingroup config
+ */
+class ApplyRuleIndex
+{
+public:
+	ApplyRuleIndex(const Type::Ptr& targetType);
+
+	void Add(Expression *filter, const std::vector<String>& locals = {});
+	void GetCandidates(const Object::Ptr& target, const Object::Ptr& self, std::vector<size_t>& candidates) const;
+
+	inline size_t GetRuleCount() const noexcept
+	{
+		return m_RuleCount;
+	}
+
+	inline size_t GetIndexedRuleCount() const noexcept
+	{
+		return m_RuleCount - m_Unindexed.size();
+	}
+
+private:
+	enum class Condition
+	{
+		Equal, /* <path> == "key" */
+		Contains, /* "key" in <path> */
+		Match /* match("key*", <path>) */
+	};
+
+	struct Term
+	{
+		std::vector<String> Path;
+		Condition Cond;
+		String Key;
+	};
+
+	struct PathIndex
+	{
+		std::vector<String> Path;
+		std::unordered_map<String, std::vector<size_t>> Equal;
+		std::unordered_map<String, std::vector<size_t>> Contains;
+		std::unordered_map<String, std::vector<size_t>> Match;
+		std::set<size_t> MatchPrefixLengths;
+
+		/* All rules with a term on this path, by condition (for the cases which can't be looked up) */
+		std::vector<size_t> AllEqual;
+		std::vector<size_t> AllContains;
+		std::vector<size_t> AllMatch;
+	};
+
+	Type::Ptr m_TargetType;
+	String m_Variable;
+	size_t m_RuleCount{0};
+	std::vector<size_t> m_Unindexed;
+	std::vector<PathIndex> m_Paths;
+	std::map<std::vector<String>, size_t> m_PathIds;
+
+	bool GetTerms(Expression *filter, bool matchShadowed, std::vector<Term>& terms) const;
+	bool GetPath(Expression *expr, std::vector<String>& path) const;
+	static const String *GetConstString(Expression *expr);
+	static bool GetMatchPrefix(const String& pattern, String& prefix);
+};
+
+}
+
+#endif /* APPLYRULEINDEX_H */
@@ -0,0 +1,820 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "config/compiledfilter.hpp"
+#include "config/vmops.hpp"
+#include "base/configobject.hpp"
+#include "base/json.hpp"
+#include "base/namespace.hpp"
+#include "base/scriptglobal.hpp"
+#include <boost/container/small_vector.hpp>
+#include <boost/exception/errinfo_nested_exception.hpp>
+#include <limits>
+#include <set>
+
+using namespace icinga;
+
+/* Operands with this bit set refer to CompiledFilter::m_Constants rather than to a register. */
+static constexpr uint16_t l_FilterConstantFlag = 0x8000;
+
+namespace icinga
+{
+
+/**
+ * Lowers a filter Expression tree into the instructions of a CompiledFilter.
+ *
+ * Variables are resolved exactly like FilterUtility::EvaluateFilter() would populate the ScriptFrame:
+ * the navigation fields of the target's type take precedence over the target itself ("obj" and the
+ * type-specific variable name) which in turn takes precedence over the filter variables. Everything
+ * else is either a constant of a frozen namespace (e.g. the match() function) or gets resolved
+ * through the original VariableExpression at runtime.
+ *
+ * @ingroup config
+ */
+class FilterCompiler
+{
+public:
+	FilterCompiler(CompiledFilter& program, const Type::Ptr& type, const String& variableName, const std::vector<String>& variables)
+		: m_Program(program), m_Type(type), m_VariableName(variableName), m_Variables(variables.begin(), variables.end())
+	{
+		m_FieldAccess = ConfigObject::TypeInstance->IsAssignableFrom(type);
+
+		for (int fid = 0; fid < type->GetFieldCount(); fid++) {
+			Field field = type->GetFieldInfo(fid);
+
+			if (field.Attributes & FANavigation) {
+				m_Navigation[field.NavigationName ? field.NavigationName : field.Name] = fid;
+			}
+		}
+	}
+
+	bool Compile(const Expression *expr, uint16_t& operand);
+
+private:
+	CompiledFilter& m_Program;
+	Type::Ptr m_Type;
+	String m_VariableName;
+	std::set<String> m_Variables;
+	std::map<String, int> m_Navigation;
+	bool m_FieldAccess;
+
+	bool CompileVariable(const VariableExpression *expr, uint16_t& operand);
+	bool CompileIndexer(const IndexerExpression *expr, uint16_t& operand);
+	bool CompileCall(const FunctionCallExpression *expr, uint16_t& operand);
+	bool CompileArray(const ArrayExpression *expr, uint16_t& operand, bool readOnly);
+	bool CompileLogical(const BinaryExpression *expr, FilterOpcode jump, uint16_t& operand);
+	bool CompileBinary(const BinaryExpression *expr, FilterOpcode op, uint16_t& operand);
+	bool CompileIn(const BinaryExpression *expr, FilterOpcode op, uint16_t& operand);
+
+	bool IsTarget(const Expression *expr) const;
+	bool ResolveConstant(const String& name, Value& self, Value& value) const;
+
+	bool AllocateRegister(uint16_t& reg);
+	bool AddConstant(const Value& value, uint16_t& operand);
+	uint32_t AddName(const String& name);
+	uint32_t Emit(FilterOpcode op, uint16_t dst, uint16_t op1, uint16_t op2, uint32_t arg, const Expression *source, uint16_t count = 0);
+};
+
+}
+
+bool FilterCompiler::AllocateRegister(uint16_t& reg)
+{
+	if (m_Program.m_RegisterCount >= l_FilterConstantFlag - 1) {
+		return false;
+	}
+
+	reg = m_Program.m_RegisterCount++;
+	return true;
+}
+
+bool FilterCompiler::AddConstant(const Value& value, uint16_t& operand)
+{
+	if (m_Program.m_Constants.size() >= l_FilterConstantFlag - 1) {
+		return false;
+	}
+
+	operand = l_FilterConstantFlag | m_Program.m_Constants.size();
+	m_Program.m_Constants.emplace_back(value);
+	return true;
+}
+
+uint32_t FilterCompiler::AddName(const String& name)
+{
+	auto& names (m_Program.m_Names);
+
+	for (uint32_t i = 0; i < names.size(); i++) {
+		if (names[i] == name) {
+			return i;
+		}
+	}
+
+	names.emplace_back(name);
+	return names.size() - 1u;
+}
+
+uint32_t FilterCompiler::Emit(FilterOpcode op, uint16_t dst, uint16_t op1, uint16_t op2, uint32_t arg, const Expression *source, uint16_t count)
+{
+	m_Program.m_Instructions.emplace_back(FilterInstruction{op, dst, op1, op2, count, arg, source});
+	return m_Program.m_Instructions.size() - 1u;
+}
+
+/**
+ * @returns Whether the given expression refers to the filter target itself, i.e. "obj" or e.g. "host".
+ */
+bool FilterCompiler::IsTarget(const Expression *expr) const
+{
+	auto var (dynamic_cast<const VariableExpression*>(expr));
+
+	if (!var) {
+		return false;
+	}
+
+	auto& name (var->GetVariable());
+
+	return m_Navigation.find(name) == m_Navigation.end() && (name == "obj" || name == m_VariableName);
+}
+
+/**
+ * Looks the given variable up in the same namespaces VariableExpression imports by default.
+ *
+ * @returns Whether the variable has been found in a frozen namespace, i.e. it can't change anymore.
+ */
+bool FilterCompiler::ResolveConstant(const String& name, Value& self, Value& value) const
+{
+	Namespace::Ptr globals = ScriptGlobal::GetGlobals();
+	Namespace::Ptr system = globals->Get("System");
+
+	std::vector<Object::Ptr> imports {
+		system,
+		system ? Object::Ptr(system->Get("Configuration")) : nullptr,
+		Object::Ptr(globals->Get("Types")),
+		Object::Ptr(globals->Get("Icinga"))
+	};
+
+	for (auto& import : imports) {
+		if (!import || !import->HasOwnField(name)) {
+			continue;
+		}
+
+		auto ns (dynamic_pointer_cast<Namespace>(import));
+
+		if (!ns || !ns->Frozen()) {
+			return false;
+		}
+
+		self = ns;
+		value = ns->Get(name);
+		return true;
+	}
+
+	return false;
+}
+
+bool FilterCompiler::Compile(const Expression *expr, uint16_t& operand)
+{
+	if (auto lit = dynamic_cast<const LiteralExpression*>(expr)) {
+		return AddConstant(lit->GetValue(), operand);
+	}
+
+	if (auto var = dynamic_cast<const VariableExpression*>(expr)) {
+		return CompileVariable(var, operand);
+	}
+
+	if (auto ixr = dynamic_cast<const IndexerExpression*>(expr)) {
+		return CompileIndexer(ixr, operand);
+	}
+
+	if (auto call = dynamic_cast<const FunctionCallExpression*>(expr)) {
+		return CompileCall(call, operand);
+	}
+
+	if (auto arr = dynamic_cast<const ArrayExpression*>(expr)) {
+		return CompileArray(arr, operand, false);
+	}
+
+	if (auto land = dynamic_cast<const LogicalAndExpression*>(expr)) {
+		return CompileLogical(land, FilterOpcode::JumpIfFalse, operand);
+	}
+
+	if (auto lor = dynamic_cast<const LogicalOrExpression*>(expr)) {
+		return CompileLogical(lor, FilterOpcode::JumpIfTrue, operand);
+	}
+
+	auto unary (dynamic_cast<const UnaryExpression*>(expr));
+
+	if (unary) {
+		FilterOpcode op;
+
+		if (dynamic_cast<const LogicalNegateExpression*>(expr)) {
+			op = FilterOpcode::LogicalNegate;
+		} else if (dynamic_cast<const NegateExpression*>(expr)) {
+			op = FilterOpcode::Negate;
+		} else {
+			return false;
+		}
+
+		uint16_t src;
+
+		if (!Compile(unary->GetOperand().get(), src) || !AllocateRegister(operand)) {
+			return false;
+		}
+
+		Emit(op, operand, src, 0, 0, expr);
+		return true;
+	}
+
+	auto binary (dynamic_cast<const BinaryExpression*>(expr));
+
+	if (!binary) {
+		return false;
+	}
+
+	if (dynamic_cast<const EqualExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::Equal, operand);
+	} else if (dynamic_cast<const NotEqualExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::NotEqual, operand);
+	} else if (dynamic_cast<const LessThanExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::LessThan, operand);
+	} else if (dynamic_cast<const GreaterThanExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::GreaterThan, operand);
+	} else if (dynamic_cast<const LessThanOrEqualExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::LessThanOrEqual, operand);
+	} else if (dynamic_cast<const GreaterThanOrEqualExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::GreaterThanOrEqual, operand);
+	} else if (dynamic_cast<const InExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::In, operand);
+	} else if (dynamic_cast<const NotInExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::NotIn, operand);
+	} else if (dynamic_cast<const AddExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::Add, operand);
+	} else if (dynamic_cast<const SubtractExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::Subtract, operand);
+	} else if (dynamic_cast<const MultiplyExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::Multiply, operand);
+	} else if (dynamic_cast<const DivideExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::Divide, operand);
+	} else if (dynamic_cast<const ModuloExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::Modulo, operand);
+	} else if (dynamic_cast<const XorExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::Xor, operand);
+	} else if (dynamic_cast<const BinaryAndExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::BinaryAnd, operand);
+	} else if (dynamic_cast<const BinaryOrExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::BinaryOr, operand);
+	} else if (dynamic_cast<const ShiftLeftExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::ShiftLeft, operand);
+	} else if (dynamic_cast<const ShiftRightExpression*>(expr)) {
+		return CompileBinary(binary, FilterOpcode::ShiftRight, operand);
+	}
+
+	/* Assignments, conditionals, loops, closures etc. are never lowered. */
+	return false;
+}
+
+bool FilterCompiler::CompileVariable(const VariableExpression *expr, uint16_t& operand)
+{
+	auto& name (expr->GetVariable());
+	auto nav (m_Navigation.find(name));
+
+	if (nav != m_Navigation.end()) {
+		if (!AllocateRegister(operand)) {
+			return false;
+		}
+
+		Emit(FilterOpcode::NavigateField, operand, 0, 0, nav->second, expr);
+		return true;
+	}
+
+	if (IsTarget(expr)) {
+		if (!AllocateRegister(operand)) {
+			return false;
+		}
+
+		Emit(FilterOpcode::LoadTarget, operand, 0, 0, 0, expr);
+		return true;
+	}
+
+	if (m_Variables.find(name) != m_Variables.end()) {
+		if (!AllocateRegister(operand)) {
+			return false;
+		}
+
+		Emit(FilterOpcode::LoadVariable, operand, 0, 0, AddName(name), expr);
+		return true;
+	}
+
+	Value self, value;
+
+	if (ResolveConstant(name, self, value)) {
+		return AddConstant(value, operand);
+	}
+
+	if (!AllocateRegister(operand)) {
+		return false;
+	}
+
+	Emit(FilterOpcode::ResolveVariable, operand, 0, 0, 0, expr);
+	return true;
+}
+
+bool FilterCompiler::CompileIndexer(const IndexerExpression *expr, uint16_t& operand)
+{
+	auto index (dynamic_cast<const LiteralExpression*>(expr->GetOperand2().get()));
+
+	if (index && m_FieldAccess && IsTarget(expr->GetOperand1().get())) {
+		String name = index->GetValue();
+		int fid = m_Type->GetFieldId(name);
+
+		if (fid != -1) {
+			if (!AllocateRegister(operand)) {
+				return false;
+			}
+
+			bool noUserView = m_Type->GetFieldInfo(fid).Attributes & FANoUserView;
+
+			Emit(FilterOpcode::GetField, operand, 0, AddName(name), fid, expr, noUserView);
+			return true;
+		}
+	}
+
+	uint16_t parent;
+
+	if (!Compile(expr->GetOperand1().get(), parent)) {
+		return false;
+	}
+
+	if (index) {
+		if (!AllocateRegister(operand)) {
+			return false;
+		}
+
+		Emit(FilterOpcode::GetIndexConst, operand, parent, 0, AddName(index->GetValue()), expr);
+		return true;
+	}
+
+	uint16_t key;
+
+	if (!Compile(expr->GetOperand2().get(), key) || !AllocateRegister(operand)) {
+		return false;
+	}
+
+	Emit(FilterOpcode::GetIndex, operand, parent, key, 0, expr);
+	return true;
+}
+
+bool FilterCompiler::CompileCall(const FunctionCallExpression *expr, uint16_t& operand)
+{
+	uint16_t self, func;
+	auto fname (expr->m_FName.get());
+
+	if (auto var = dynamic_cast<const VariableExpression*>(fname)) {
+		auto& name (var->GetVariable());
+
+		/* Functions stored in the filter's own scope would be called with that scope as "this". */
+		if (m_Navigation.find(name) != m_Navigation.end() || IsTarget(var) || m_Variables.find(name) != m_Variables.end()) {
+			return false;
+		}
+
+		Value vself, vfunc;
+
+		if (ResolveConstant(name, vself, vfunc)) {
+			if (!AddConstant(vself, self) || !AddConstant(vfunc, func)) {
+				return false;
+			}
+		} else {
+			if (!AllocateRegister(self) || !AllocateRegister(func)) {
+				return false;
+			}
+
+			Emit(FilterOpcode::ResolveFunction, func, self, 0, 0, var);
+		}
+	} else if (auto ixr = dynamic_cast<const IndexerExpression*>(fname)) {
+		/* Method call like host.name.contains("x"), the object the method belongs to becomes "this". */
+		if (!Compile(ixr->GetOperand1().get(), self)) {
+			return false;
+		}
+
+		auto index (dynamic_cast<const LiteralExpression*>(ixr->GetOperand2().get()));
+
+		if (index) {
+			if (!AllocateRegister(func)) {
+				return false;
+			}
+
+			Emit(FilterOpcode::GetIndexConst, func, self, 0, AddName(index->GetValue()), ixr);
+		} else {
+			uint16_t key;
+
+			if (!Compile(ixr->GetOperand2().get(), key) || !AllocateRegister(func)) {
+				return false;
+			}
+
+			Emit(FilterOpcode::GetIndex, func, self, key, 0, ixr);
+		}
+	} else {
+		/* E.g. a closure being called directly, there is no "this" then. */
+		if (!Compile(fname, func) || !AddConstant(Empty, self)) {
+			return false;
+		}
+	}
+
+	/* Like FunctionCallExpression, reject the callee before evaluating any argument. */
+	Emit(FilterOpcode::CheckCallable, 0, func, 0, 0, expr);
+
+	std::vector<uint16_t> args;
+
+	for (auto& arg : expr->m_Args) {
+		uint16_t argOperand;
+
+		if (!Compile(arg.get(), argOperand)) {
+			return false;
+		}
+
+		args.emplace_back(argOperand);
+	}
+
+	if (args.size() > std::numeric_limits<uint16_t>::max() || !AllocateRegister(operand)) {
+		return false;
+	}
+
+	auto& arguments (m_Program.m_Arguments);
+	uint32_t offset = arguments.size();
+
+	arguments.insert(arguments.end(), args.begin(), args.end());
+
+	Emit(FilterOpcode::Call, operand, func, self, offset, expr, args.size());
+	return true;
+}
+
+bool FilterCompiler::CompileArray(const ArrayExpression *expr, uint16_t& operand, bool readOnly)
+{
+	auto& elements (expr->GetExpressions());
+
+	if (readOnly) {
+		ArrayData items;
+
+		for (auto& element : elements) {
+			auto lit (dynamic_cast<const LiteralExpression*>(element.get()));
+
+			if (!lit) {
+				break;
+			}
+
+			items.emplace_back(lit->GetValue());
+		}
+
+		if (items.size() == elements.size()) {
+			/* Only ever read from by the 'in' operator, so it's safe to share a single instance. */
+			Array::Ptr arr = new Array(std::move(items));
+			arr->Freeze();
+
+			return AddConstant(arr, operand);
+		}
+	}
+
+	std::vector<uint16_t> items;
+
+	for (auto& element : elements) {
+		uint16_t item;
+
+		if (!Compile(element.get(), item)) {
+			return false;
+		}
+
+		items.emplace_back(item);
+	}
+
+	if (items.size() > std::numeric_limits<uint16_t>::max() || !AllocateRegister(operand)) {
+		return false;
+	}
+
+	auto& arguments (m_Program.m_Arguments);
+	uint32_t offset = arguments.size();
+
+	arguments.insert(arguments.end(), items.begin(), items.end());
+
+	Emit(FilterOpcode::MakeArray, operand, 0, 0, offset, expr, items.size());
+	return true;
+}
+
+/**
+ * Lowers && and || preserving their short-circuit semantics as well as their result,
+ * i.e. the value of the last evaluated operand, not just a boolean.
+ */
+bool FilterCompiler::CompileLogical(const BinaryExpression *expr, FilterOpcode jump, uint16_t& operand)
+{
+	uint16_t op1, op2;
+
+	if (!Compile(expr->GetOperand1().get(), op1) || !AllocateRegister(operand)) {
+		return false;
+	}
+
+	Emit(FilterOpcode::Move, operand, op1, 0, 0, expr);
+
+	auto skip (Emit(jump, 0, operand, 0, 0, expr));
+
+	if (!Compile(expr->GetOperand2().get(), op2)) {
+		return false;
+	}
+
+	Emit(FilterOpcode::Move, operand, op2, 0, 0, expr);
+
+	m_Program.m_Instructions[skip].Arg = m_Program.m_Instructions.size();
+	return true;
+}
+
+bool FilterCompiler::CompileBinary(const BinaryExpression *expr, FilterOpcode op, uint16_t& operand)
+{
+	if (op == FilterOpcode::In || op == FilterOpcode::NotIn) {
+		return CompileIn(expr, op, operand);
+	}
+
+	uint16_t op1, op2;
+
+	if (!Compile(expr->GetOperand1().get(), op1) || !Compile(expr->GetOperand2().get(), op2) || !AllocateRegister(operand)) {
+		return false;
+	}
+
+	Emit(op, operand, op1, op2, 0, expr);
+	return true;
+}
+
+/**
+ * Lowers 'in' and '!in' like InExpression evaluates them: the right side first and
+ * the left side only if the right side is an array, i.e. not if it's null.
+ */
+bool FilterCompiler::CompileIn(const BinaryExpression *expr, FilterOpcode op, uint16_t& operand)
+{
+	uint16_t op1, op2;
+	auto arr (dynamic_cast<const ArrayExpression*>(expr->GetOperand2().get()));
+
+	if (!(arr ? CompileArray(arr, op2, true) : Compile(expr->GetOperand2().get(), op2)) || !AllocateRegister(operand)) {
+		return false;
+	}
+
+	auto check (Emit(FilterOpcode::CheckHaystack, operand, op2, 0, 0, expr, op == FilterOpcode::NotIn));
+
+	if (!Compile(expr->GetOperand1().get(), op1)) {
+		return false;
+	}
+
+	Emit(op, operand, op1, op2, 0, expr);
+
+	m_Program.m_Instructions[check].Arg = m_Program.m_Instructions.size();
+	return true;
+}
+
+/**
+ * Lowers the given filter into bytecode.
+ *
+ * @param filter The filter as returned by ConfigCompiler::CompileText()
+ * @param type The type of the objects the filter will be evaluated for
+ * @param variableName The name the target object is available as in addition to "obj", defaults to the type name in lower case
+ * @param variables The names of all additional variables (filter_vars) which will be passed to Evaluate()
+ *
+ * @returns The compiled filter or nullptr if the filter can't be lowered.
+ */
+CompiledFilter::Ptr CompiledFilter::Compile(const Expression *filter, const Type::Ptr& type,
+	const String& variableName, const std::vector<String>& variables)
+{
+	auto dict (dynamic_cast<const DictExpression*>(filter));
+
+	if (dict) {
+		auto& subex (dict->GetExpressions());
+
+		if (!dict->IsInline() || subex.size() != 1u) {
+			return nullptr;
+		}
+
+		filter = subex.at(0).get();
+	}
+
+	if (!filter || !type) {
+		return nullptr;
+	}
+
+	CompiledFilter::Ptr program = new CompiledFilter();
+	program->m_Type = type;
+
+	FilterCompiler compiler (*program, type, variableName.IsEmpty() ? type->GetName().ToLower() : variableName, variables);
+
+	if (!compiler.Compile(filter, program->m_Result)) {
+		return nullptr;
+	}
+
+	return program;
+}
+
+/**
+ * Evaluates the filter for the given object.
+ *
+ * @param frame Frame used for calling functions and for resolving variables which aren't constant
+ * @param target The object to evaluate the filter for
+ * @param variables Values of the variables passed to Compile()
+ *
+ * @returns Whether the filter matches the object.
+ */
+bool CompiledFilter::Evaluate(ScriptFrame& frame, const Object::Ptr& target, const Dictionary::Ptr& variables) const
+{
+	return Convert::ToBool(Run(frame, target, variables));
+}
+
+Value CompiledFilter::Run(ScriptFrame& frame, const Object::Ptr& target, const Dictionary::Ptr& variables) const
+{
+	boost::container::small_vector<Value, 16> registers (m_RegisterCount);
+
+	auto operand ([this, &registers](uint16_t operand) -> const Value& {
+		if (operand & l_FilterConstantFlag) {
+			return m_Constants[operand & ~l_FilterConstantFlag];
+		}
+
+		return registers[operand];
+	});
+
+	bool typedTarget = target->GetReflectionType() == m_Type;
+	const FilterInstruction *current = nullptr;
+
+	try {
+		for (size_t ip = 0; ip < m_Instructions.size(); ip++) {
+			auto& ins (m_Instructions[ip]);
+			auto& dst (registers[ins.Dst]);
+
+			current = &ins;
+
+			switch (ins.Op) {
+				case FilterOpcode::LoadTarget:
+					dst = target;
+					break;
+				case FilterOpcode::LoadVariable:
+					dst = variables ? variables->Get(m_Names[ins.Arg]) : Empty;
+					break;
+				case FilterOpcode::ResolveVariable:
+					dst = ins.Source->Evaluate(frame).GetValue();
+					break;
+				case FilterOpcode::ResolveFunction: {
+					Value self;
+					String index;
+
+					ins.Source->GetReference(frame, false, &self, &index);
+					dst = VMOps::GetField(self, index, frame.Sandboxed, ins.Source->GetDebugInfo());
+					registers[ins.Op1] = std::move(self);
+					break;
+				}
+				case FilterOpcode::NavigateField:
+					dst = target->NavigateField(ins.Arg);
+					break;
+				case FilterOpcode::GetField:
+					if (typedTarget && !(ins.Count && frame.Sandboxed)) {
+						dst = target->GetField(ins.Arg);
+					} else {
+						dst = VMOps::GetField(target, m_Names[ins.Op2], frame.Sandboxed, ins.Source->GetDebugInfo());
+					}
+					break;
+				case FilterOpcode::GetIndex:
+					dst = VMOps::GetField(operand(ins.Op1), operand(ins.Op2), frame.Sandboxed, ins.Source->GetDebugInfo());
+					break;
+				case FilterOpcode::GetIndexConst:
+					dst = VMOps::GetField(operand(ins.Op1), m_Names[ins.Arg], frame.Sandboxed, ins.Source->GetDebugInfo());
+					break;
+				case FilterOpcode::CheckCallable: {
+					auto& vfunc (operand(ins.Op1));
+
+					if (vfunc.IsObjectType<Type>()) {
+						break;
+					}
+
+					if (!vfunc.IsObjectType<Function>())
+						BOOST_THROW_EXCEPTION(ScriptError("Argument is not a callable object.", ins.Source->GetDebugInfo()));
+
+					Function::Ptr func = vfunc;
+
+					if (!func->IsSideEffectFree() && frame.Sandboxed)
+						BOOST_THROW_EXCEPTION(ScriptError("Function is not marked as safe for sandbox mode.", ins.Source->GetDebugInfo()));
+
+					break;
+				}
+				case FilterOpcode::Call: {
+					auto& vfunc (operand(ins.Op1));
+					std::vector<Value> arguments;
+
+					arguments.reserve(ins.Count);
+
+					for (uint32_t i = ins.Arg; i < ins.Arg + ins.Count; i++) {
+						arguments.emplace_back(operand(m_Arguments[i]));
+					}
+
+					if (vfunc.IsObjectType<Type>()) {
+						dst = VMOps::ConstructorCall(vfunc, arguments);
+					} else {
+						Function::Ptr func = vfunc;
+						dst = VMOps::FunctionCall(operand(ins.Op2), func, arguments);
+					}
+					break;
+				}
+				case FilterOpcode::Move:
+					dst = operand(ins.Op1);
+					break;
+				case FilterOpcode::JumpIfFalse:
+					if (!operand(ins.Op1).ToBool())
+						ip = ins.Arg - 1u;
+					break;
+				case FilterOpcode::JumpIfTrue:
+					if (operand(ins.Op1).ToBool())
+						ip = ins.Arg - 1u;
+					break;
+				case FilterOpcode::CheckHaystack: {
+					auto& haystack (operand(ins.Op1));
+
+					if (haystack.IsEmpty()) {
+						dst = static_cast<bool>(ins.Count);
+						ip = ins.Arg - 1u;
+					} else if (!haystack.IsObjectType<Array>())
+						BOOST_THROW_EXCEPTION(ScriptError("Invalid right side argument for 'in' operator: " + JsonEncode(haystack), ins.Source->GetDebugInfo()));
+					break;
+				}
+				case FilterOpcode::LogicalNegate:
+					dst = !operand(ins.Op1).ToBool();
+					break;
+				case FilterOpcode::Negate:
+					dst = ~(long)operand(ins.Op1);
+					break;
+				case FilterOpcode::Add:
+					dst = operand(ins.Op1) + operand(ins.Op2);
+					break;
+				case FilterOpcode::Subtract:
+					dst = operand(ins.Op1) - operand(ins.Op2);
+					break;
+				case FilterOpcode::Multiply:
+					dst = operand(ins.Op1) * operand(ins.Op2);
+					break;
+				case FilterOpcode::Divide:
+					dst = operand(ins.Op1) / operand(ins.Op2);
+					break;
+				case FilterOpcode::Modulo:
+					dst = operand(ins.Op1) % operand(ins.Op2);
+					break;
+				case FilterOpcode::Xor:
+					dst = operand(ins.Op1) ^ operand(ins.Op2);
+					break;
+				case FilterOpcode::BinaryAnd:
+					dst = operand(ins.Op1) & operand(ins.Op2);
+					break;
+				case FilterOpcode::BinaryOr:
+					dst = operand(ins.Op1) | operand(ins.Op2);
+					break;
+				case FilterOpcode::ShiftLeft:
+					dst = operand(ins.Op1) << operand(ins.Op2);
+					break;
+				case FilterOpcode::ShiftRight:
+					dst = operand(ins.Op1) >> operand(ins.Op2);
+					break;
+				case FilterOpcode::Equal:
+					dst = operand(ins.Op1) == operand(ins.Op2);
+					break;
+				case FilterOpcode::NotEqual:
+					dst = operand(ins.Op1) != operand(ins.Op2);
+					break;
+				case FilterOpcode::LessThan:
+					dst = operand(ins.Op1) < operand(ins.Op2);
+					break;
+				case FilterOpcode::GreaterThan:
+					dst = operand(ins.Op1) > operand(ins.Op2);
+					break;
+				case FilterOpcode::LessThanOrEqual:
+					dst = operand(ins.Op1) <= operand(ins.Op2);
+					break;
+				case FilterOpcode::GreaterThanOrEqual:
+					dst = operand(ins.Op1) >= operand(ins.Op2);
+					break;
+				case FilterOpcode::In:
+				case FilterOpcode::NotIn: {
+					auto arr (static_cast<Array*>(operand(ins.Op2).Get<Object::Ptr>().get()));
+
+					dst = arr->Contains(operand(ins.Op1)) == (ins.Op == FilterOpcode::In);
+					break;
+				}
+				case FilterOpcode::MakeArray: {
+					ArrayData items;
+
+					items.reserve(ins.Count);
+
+					for (uint32_t i = ins.Arg; i < ins.Arg + ins.Count; i++) {
+						items.emplace_back(operand(m_Arguments[i]));
+					}
+
+					dst = new Array(std::move(items));
+					break;
+				}
+				default:
+					VERIFY(!"Invalid opcode.");
+			}
+		}
+	} catch (ScriptError&) {
+		throw;
+	} catch (const std::exception& ex) {
+		BOOST_THROW_EXCEPTION(ScriptError("Error while evaluating expression: " + String(ex.what()), current ? current->Source->GetDebugInfo() : DebugInfo())
+			<< boost::errinfo_nested_exception(boost::current_exception()));
+	}
+
+	return operand(m_Result);
+}
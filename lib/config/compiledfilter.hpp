@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef COMPILEDFILTER_H
+#define COMPILEDFILTER_H
+
+#include "config/i2-config.hpp"
+#include "config/expression.hpp"
+#include "base/shared-object.hpp"
+#include "base/type.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * Opcodes of the CompiledFilter register machine.
+ *
+ * R are the registers, N the names (attributes, variables) and A the argument lists of a CompiledFilter.
+ * Operands (Op1, Op2 and the entries of A) with the highest bit set refer to constants instead of registers.
+ *
+ * @ingroup config
+ */
+enum class FilterOpcode : uint8_t
+{
+	LoadTarget, /* R[Dst] = target */
+	LoadVariable, /* R[Dst] = variables[N[Arg]] */
+	ResolveVariable, /* R[Dst] = Source->Evaluate(frame) */
+	ResolveFunction, /* R[Op1], R[Dst] = parent and value of Source->GetReference(frame) */
+	NavigateField, /* R[Dst] = target->NavigateField(Arg) */
+	GetField, /* R[Dst] = target->GetField(Arg) if the target is of the compiled type, target[N[Op2]] otherwise */
+	GetIndex, /* R[Dst] = R[Op1][R[Op2]] */
+	GetIndexConst, /* R[Dst] = R[Op1][N[Arg]] */
+	CheckCallable, /* throws unless R[Op1] is a type or a function which may be called */
+	Call, /* R[Dst] = R[Op1](R[A[Arg]], ..., R[A[Arg + Count - 1]]) with self R[Op2] */
+	Move, /* R[Dst] = R[Op1] */
+	JumpIfFalse, /* if (!R[Op1]) goto Arg */
+	JumpIfTrue, /* if (R[Op1]) goto Arg */
+	CheckHaystack, /* if (R[Op1] == null) { R[Dst] = Count; goto Arg } throws unless R[Op1] is an array */
+	LogicalNegate, /* R[Dst] = !R[Op1] */
+	Negate, /* R[Dst] = ~R[Op1] */
+	Add, /* R[Dst] = R[Op1] + R[Op2], the following binary operators work alike */
+	Subtract,
+	Multiply,
+	Divide,
+	Modulo,
+	Xor,
+	BinaryAnd,
+	BinaryOr,
+	ShiftLeft,
+	ShiftRight,
+	Equal,
+	NotEqual,
+	LessThan,
+	GreaterThan,
+	LessThanOrEqual,
+	GreaterThanOrEqual,
+	In, /* R[Dst] = R[Op2].contains(R[Op1]), R[Op2] has passed CheckHaystack */
+	NotIn,
+	MakeArray /* R[Dst] = [ R[A[Arg]], ..., R[A[Arg + Count - 1]] ] */
+};
+
+/**
+ * A single CompiledFilter instruction.
+ *
+ * @ingroup config
+ */
+struct FilterInstruction
+{
+	FilterOpcode Op;
+	uint16_t Dst;
+	uint16_t Op1;
+	uint16_t Op2;
+	uint16_t Count;
+	uint32_t Arg;
+	const Expression *Source;
+};
+
+/**
+ * A filter expression (as used by the API, e.g. host.vars.os == "Linux" && "g" in host.groups)
+ * lowered into a flat register bytecode.
+ *
+ * Evaluating a CompiledFilter doesn't require the ScriptFrame to be populated with the filter target
+ * and its navigation fields, and object attributes of the compiled type are read directly by their
+ * pre-resolved field IDs rather than being looked up by name for every single object.
+ *
+ * Only filter-shaped expressions (literals, variables, indexers, comparisons, logical and arithmetic
+ * operators and function calls) can be lowered. For anything else Compile() returns nullptr and
+ * the caller has to evaluate the original Expression.
+ *
+ * @ingroup config
+ */
+class CompiledFilter final : public SharedObject
+{
+public:
+	DECLARE_PTR_TYPEDEFS(CompiledFilter);
+
+	static CompiledFilter::Ptr Compile(const Expression *filter, const Type::Ptr& type,
+		const String& variableName = String(), const std::vector<String>& variables = {});
+
+	bool Evaluate(ScriptFrame& frame, const Object::Ptr& target, const Dictionary::Ptr& variables = nullptr) const;
+
+	inline const std::vector<FilterInstruction>& GetInstructions() const noexcept
+	{
+		return m_Instructions;
+	}
+
+private:
+	Type::Ptr m_Type;
+	std::vector<FilterInstruction> m_Instructions;
+	std::vector<Value> m_Constants;
+	std::vector<String> m_Names;
+	std::vector<uint16_t> m_Arguments;
+	uint16_t m_RegisterCount{0};
+	uint16_t m_Result{0};
+
+	friend class FilterCompiler;
+
+	CompiledFilter() = default;
+
+	Value Run(ScriptFrame& frame, const Object::Ptr& target, const Dictionary::Ptr& variables) const;
+};
+
+}
+
+#endif /* COMPILEDFILTER_H */
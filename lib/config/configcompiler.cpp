@@ -2,12 +2,16 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "config/configcompiler.hpp"
+#include "config/configcompilercontext.hpp"
 #include "config/configitem.hpp"
+#include "base/configuration.hpp"
 #include "base/logger.hpp"
 #include "base/utility.hpp"
 #include "base/loader.hpp"
 #include "base/context.hpp"
 #include "base/exception.hpp"
+#include "base/workqueue.hpp"
+#include <algorithm>
 #include <fstream>
 
 using namespace icinga;
@@ -105,6 +109,41 @@ void ConfigCompiler::CollectIncludes(std::vector<std::unique_ptr<Expression> >&
 	}
 }
 
+/**
+ * Compiles the given files concurrently and appends their expressions in the same order as the files.
+ *
+ * Files which can't be compiled are skipped like CollectIncludes() for a single file does.
+ */
+void ConfigCompiler::CollectIncludes(std::vector<std::unique_ptr<Expression> >& expressions,
+	const std::vector<String>& files, const String& zone, const String& package)
+{
+	double start = Utility::GetTime();
+	std::vector<std::vector<std::unique_ptr<Expression> > > results (files.size());
+
+	if (files.size() > 1u && Configuration::Concurrency > 1) {
+		WorkQueue upq (0, std::min<int>(Configuration::Concurrency, files.size()));
+		upq.SetName("ConfigCompiler::CollectIncludes");
+
+		upq.ParallelFor(files, false, [&files, &results, &zone, &package](const String& file) {
+			CollectIncludes(results[&file - files.data()], file, zone, package);
+		});
+
+		upq.Join();
+	} else {
+		for (decltype(files.size()) i = 0; i < files.size(); i++) {
+			CollectIncludes(results[i], files[i], zone, package);
+		}
+	}
+
+	for (auto& result : results) {
+		for (auto& expression : result) {
+			expressions.emplace_back(std::move(expression));
+		}
+	}
+
+	ConfigCompilerContext::GetInstance()->AddPhaseDuration("parsing config files", Utility::GetTime() - start);
+}
+
 /**
  * Handles an include directive.
  *
@@ -136,8 +175,8 @@ std::unique_ptr<Expression> ConfigCompiler::HandleInclude(const String& relative
 		}
 	}
 
-	std::vector<std::unique_ptr<Expression> > expressions;
-	auto funcCallback = [&expressions, zone, package](const String& file) { CollectIncludes(expressions, file, zone, package); };
+	std::vector<String> files;
+	auto funcCallback = [&files](const String& file) { files.emplace_back(file); };
 
 	if (!Utility::Glob(includePath, funcCallback, GlobFile) && includePath.FindFirstOf("*?") == String::NPos) {
 		std::ostringstream msgbuf;
@@ -145,6 +184,9 @@ std::unique_ptr<Expression> ConfigCompiler::HandleInclude(const String& relative
 		BOOST_THROW_EXCEPTION(ScriptError(msgbuf.str(), debuginfo));
 	}
 
+	std::vector<std::unique_ptr<Expression> > expressions;
+	CollectIncludes(expressions, files, zone, package);
+
 	std::unique_ptr<DictExpression> expr{new DictExpression(std::move(expressions))};
 	expr->MakeInline();
 	return expr;
@@ -168,11 +210,14 @@ std::unique_ptr<Expression> ConfigCompiler::HandleIncludeRecursive(const String&
 	else
 		ppath = relativeBase + "/" + path;
 
-	std::vector<std::unique_ptr<Expression> > expressions;
-	Utility::GlobRecursive(ppath, pattern, [&expressions, zone, package](const String& file) {
-		CollectIncludes(expressions, file, zone, package);
+	std::vector<String> files;
+	Utility::GlobRecursive(ppath, pattern, [&files](const String& file) {
+		files.emplace_back(file);
 	}, GlobFile);
 
+	std::vector<std::unique_ptr<Expression> > expressions;
+	CollectIncludes(expressions, files, zone, package);
+
 	std::unique_ptr<DictExpression> dict{new DictExpression(std::move(expressions))};
 	dict->MakeInline();
 	return dict;
@@ -191,9 +236,12 @@ void ConfigCompiler::HandleIncludeZone(const String& relativeBase, const String&
 
 	RegisterZoneDir(tag, ppath, zoneName);
 
-	Utility::GlobRecursive(ppath, pattern, [&expressions, zoneName, package](const String& file) {
-		CollectIncludes(expressions, file, zoneName, package);
+	std::vector<String> files;
+	Utility::GlobRecursive(ppath, pattern, [&files](const String& file) {
+		files.emplace_back(file);
 	}, GlobFile);
+
+	CollectIncludes(expressions, files, zoneName, package);
 }
 
 /**
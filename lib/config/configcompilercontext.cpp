@@ -55,3 +55,20 @@ void ConfigCompilerContext::FinishObjectsFile()
 	m_ObjectsFP->Commit();
 	m_ObjectsFP.reset(nullptr);
 }
+
+/**
+ * Accounts the given wall clock time (in seconds) to a phase of loading the config, e.g. parsing.
+ */
+void ConfigCompilerContext::AddPhaseDuration(const String& phase, double duration)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_PhaseDurations[phase] += duration;
+}
+
+double ConfigCompilerContext::GetPhaseDuration(const String& phase) const
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	auto it (m_PhaseDurations.find(phase));
+	return it == m_PhaseDurations.end() ? 0 : it->second;
+}
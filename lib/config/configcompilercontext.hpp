@@ -8,6 +8,7 @@
 #include "base/atomic-file.hpp"
 #include "base/dictionary.hpp"
 #include <fstream>
+#include <map>
 #include <memory>
 #include <mutex>
 
@@ -30,10 +31,14 @@ public:
 		return (bool)m_ObjectsFP;
 	}
 
+	void AddPhaseDuration(const String& phase, double duration);
+	double GetPhaseDuration(const String& phase) const;
+
 	static ConfigCompilerContext *GetInstance();
 
 private:
 	std::unique_ptr<AtomicFile> m_ObjectsFP;
+	std::map<String, double> m_PhaseDurations;
 
 	mutable std::mutex m_Mutex;
 };
@@ -28,6 +28,7 @@
 #include <algorithm>
 #include <random>
 #include <unordered_map>
+#include <unordered_set>
 
 using namespace icinga;
 
@@ -449,6 +450,8 @@ bool ConfigItem::CommitNewItems(const ActivationContext::Ptr& context, WorkQueue
 	int itemsCount {0};
 #endif /* I2_DEBUG */
 
+	double commitStart = Utility::GetTime();
+
 	for (auto& type : Type::GetConfigTypesSortedByLoadDependencies()) {
 		std::atomic<int> committed_items(0);
 
@@ -495,95 +498,148 @@ bool ConfigItem::CommitNewItems(const ActivationContext::Ptr& context, WorkQueue
 		<< "Committed " << itemsCount << " items.";
 #endif /* I2_DEBUG */
 
-	for (auto& type : Type::GetConfigTypesSortedByLoadDependencies()) {
-		std::atomic<int> notified_items(0);
+	auto compilerContext (ConfigCompilerContext::GetInstance());
+	compilerContext->AddPhaseDuration("committing config items", Utility::GetTime() - commitStart);
 
-		{
+	auto types (Type::GetConfigTypesSortedByLoadDependencies());
+	std::unordered_set<Type*> done;
+
+	for (auto it (types.begin()); it != types.end(); ++it) {
+		if (done.find(it->get()) != done.end())
+			continue;
+
+		std::vector<Type::Ptr> batch ({ *it });
+
+		/* Apply rules of different types which only depend on completely processed types
+		 * can't affect each other, so evaluate them without a barrier in between. */
+		if (ApplyRule::IsValidSourceType((*it)->GetName())) {
+			for (auto next (it + 1); next != types.end(); ++next) {
+				if (done.find(next->get()) != done.end() || !ApplyRule::IsValidSourceType((*next)->GetName()))
+					continue;
+
+				auto& deps ((*next)->GetLoadDependencies());
+
+				if (std::all_of(deps.begin(), deps.end(), [&done](Type* dep) { return done.find(dep) != done.end(); }))
+					batch.emplace_back(*next);
+			}
+		}
+
+		for (auto& type : batch) {
+			done.emplace(type.get());
+		}
+
+		std::vector<std::atomic<int>> notified_items(batch.size());
+		double start = Utility::GetTime();
+		bool before = false;
+
+		for (auto& type : batch) {
 			auto items (itemsByType.find(type.get()));
+			auto configType = dynamic_cast<ConfigType*>(type.get());
+
+			// Skip the call if no handlers are connected (signal::empty()) or there are no items (vector::empty()).
+			if (items != itemsByType.end() && configType && !configType->BeforeOnAllConfigLoaded.empty() && !items->second.empty()) {
+				// Call the signal in the WorkQueue so that if an exception is thrown, it is caught by the WorkQueue
+				// and then reported like any other config validation error.
+				upq.Enqueue([configType, items]() {
+					configType->BeforeOnAllConfigLoaded(ConfigItems(items->second));
+				});
 
-			if (items != itemsByType.end()) {
-				auto configType = dynamic_cast<ConfigType*>(type.get());
-
-				// Skip the call if no handlers are connected (signal::empty()) or there are no items (vector::empty()).
-				if (configType && !configType->BeforeOnAllConfigLoaded.empty() && !items->second.empty()) {
-					// Call the signal in the WorkQueue so that if an exception is thrown, it is caught by the WorkQueue
-					// and then reported like any other config validation error.
-					upq.Enqueue([&configType, &items]() {
-						configType->BeforeOnAllConfigLoaded(ConfigItems(items->second));
-					});
+				before = true;
+			}
+		}
 
-					upq.Join();
+		if (before) {
+			upq.Join();
 
-					if (upq.HasExceptions()) {
-						return false;
-					}
-				}
+			if (upq.HasExceptions()) {
+				return false;
+			}
+		}
 
-				upq.ParallelFor(items->second, [&notified_items](const ItemPair& ip) {
-					const ConfigItem::Ptr& item = ip.first;
+		for (decltype(batch.size()) i = 0; i < batch.size(); i++) {
+			auto items (itemsByType.find(batch[i].get()));
 
-					if (!item->m_Object)
-						return;
+			if (items == itemsByType.end())
+				continue;
 
-					try {
-						item->m_Object->OnAllConfigLoaded();
-						notified_items++;
-					} catch (const std::exception& ex) {
-						if (!item->m_IgnoreOnError)
-							throw;
+			upq.ParallelFor(items->second, [&notified_items, i](const ItemPair& ip) {
+				const ConfigItem::Ptr& item = ip.first;
 
-						Log(LogNotice, "ConfigObject")
-							<< "Ignoring config object '" << item->m_Name << "' of type '" << item->m_Type->GetName() << "' due to errors: " << DiagnosticInformation(ex);
+				if (!item->m_Object)
+					return;
 
-						item->Unregister();
+				try {
+					item->m_Object->OnAllConfigLoaded();
+					notified_items[i]++;
+				} catch (const std::exception& ex) {
+					if (!item->m_IgnoreOnError)
+						throw;
 
-						{
-							std::unique_lock<std::mutex> lock(item->m_Mutex);
-							item->m_IgnoredItems.push_back(item->m_DebugInfo.Path);
-						}
-					}
-				});
+					Log(LogNotice, "ConfigObject")
+						<< "Ignoring config object '" << item->m_Name << "' of type '" << item->m_Type->GetName() << "' due to errors: " << DiagnosticInformation(ex);
 
-				upq.Join();
+					item->Unregister();
 
-				if (upq.HasExceptions()) {
-					return false;
+					{
+						std::unique_lock<std::mutex> lock(item->m_Mutex);
+						item->m_IgnoredItems.push_back(item->m_DebugInfo.Path);
+					}
 				}
-			}
+			});
+		}
+
+		upq.Join();
+
+		if (upq.HasExceptions()) {
+			return false;
 		}
 
 #ifdef I2_DEBUG
-		if (notified_items > 0)
-			Log(LogDebug, "configitem")
-				<< "Sent OnAllConfigLoaded to " << notified_items << " items of type '" << type->GetName() << "'.";
+		for (decltype(batch.size()) i = 0; i < batch.size(); i++) {
+			if (notified_items[i] > 0)
+				Log(LogDebug, "configitem")
+					<< "Sent OnAllConfigLoaded to " << notified_items[i] << " items of type '" << batch[i]->GetName() << "'.";
+
+			notified_items[i] = 0;
+		}
 #endif /* I2_DEBUG */
 
-		notified_items = 0;
-		for (auto loadDep : type->GetLoadDependencies()) {
-			auto items (itemsByType.find(loadDep));
+		double loaded = Utility::GetTime();
+		compilerContext->AddPhaseDuration("OnAllConfigLoaded", loaded - start);
 
-			if (items != itemsByType.end()) {
-				upq.ParallelFor(items->second, [&type, &notified_items](const ItemPair& ip) {
-					const ConfigItem::Ptr& item = ip.first;
+		for (decltype(batch.size()) i = 0; i < batch.size(); i++) {
+			auto& type (batch[i]);
 
-					if (!item->m_Object)
-						return;
+			for (auto loadDep : type->GetLoadDependencies()) {
+				auto items (itemsByType.find(loadDep));
 
-					ActivationScope ascope(item->m_ActivationContext);
-					item->m_Object->CreateChildObjects(type);
-					notified_items++;
-				});
+				if (items != itemsByType.end()) {
+					upq.ParallelFor(items->second, [&type, &notified_items, i](const ItemPair& ip) {
+						const ConfigItem::Ptr& item = ip.first;
+
+						if (!item->m_Object)
+							return;
+
+						ActivationScope ascope(item->m_ActivationContext);
+						item->m_Object->CreateChildObjects(type);
+						notified_items[i]++;
+					});
+				}
 			}
 		}
 
 		upq.Join();
 
 #ifdef I2_DEBUG
-		if (notified_items > 0)
-			Log(LogDebug, "configitem")
-				<< "Sent CreateChildObjects to " << notified_items << " items of type '" << type->GetName() << "'.";
+		for (decltype(batch.size()) i = 0; i < batch.size(); i++) {
+			if (notified_items[i] > 0)
+				Log(LogDebug, "configitem")
+					<< "Sent CreateChildObjects to " << notified_items[i] << " items of type '" << batch[i]->GetName() << "'.";
+		}
 #endif /* I2_DEBUG */
 
+		compilerContext->AddPhaseDuration("evaluating apply rules", Utility::GetTime() - loaded);
+
 		if (upq.HasExceptions())
 			return false;
 
@@ -273,6 +273,11 @@ public:
 		: DebuggableExpression(debugInfo), m_Operand(std::move(operand))
 	{ }
 
+	inline const std::unique_ptr<Expression>& GetOperand() const noexcept
+	{
+		return m_Operand;
+	}
+
 protected:
 	std::unique_ptr<Expression> m_Operand;
 };
@@ -607,6 +612,11 @@ public:
 		: DebuggableExpression(debugInfo), m_Expressions(std::move(expressions))
 	{ }
 
+	inline const std::vector<std::unique_ptr<Expression>>& GetExpressions() const noexcept
+	{
+		return m_Expressions;
+	}
+
 protected:
 	ExpressionResult DoEvaluate(ScriptFrame& frame, DebugHint *dhint) const override;
 
@@ -623,6 +633,11 @@ public:
 
 	void MakeInline();
 
+	inline bool IsInline() const noexcept
+	{
+		return m_Inline;
+	}
+
 	inline const std::vector<std::unique_ptr<Expression>>& GetExpressions() const noexcept
 	{
 		return m_Expressions;
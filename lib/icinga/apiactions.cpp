@@ -26,14 +26,15 @@
 using namespace icinga;
 
 REGISTER_APIACTION(process_check_result, "Service;Host", &ApiActions::ProcessCheckResult);
+REGISTER_APIACTION(process_check_results, "", &ApiActions::ProcessCheckResults);
 REGISTER_APIACTION(reschedule_check, "Service;Host", &ApiActions::RescheduleCheck);
 REGISTER_APIACTION(send_custom_notification, "Service;Host", &ApiActions::SendCustomNotification);
 REGISTER_APIACTION(delay_notification, "Service;Host", &ApiActions::DelayNotification);
-REGISTER_APIACTION(acknowledge_problem, "Service;Host", &ApiActions::AcknowledgeProblem);
+REGISTER_APIACTION_BULK(acknowledge_problem, "Service;Host", &ApiActions::AcknowledgeProblem, &ApiActions::AcknowledgeProblems);
 REGISTER_APIACTION(remove_acknowledgement, "Service;Host", &ApiActions::RemoveAcknowledgement);
 REGISTER_APIACTION(add_comment, "Service;Host", &ApiActions::AddComment);
 REGISTER_APIACTION(remove_comment, "Service;Host;Comment", &ApiActions::RemoveComment);
-REGISTER_APIACTION(schedule_downtime, "Service;Host", &ApiActions::ScheduleDowntime);
+REGISTER_APIACTION_BULK(schedule_downtime, "Service;Host", &ApiActions::ScheduleDowntime, &ApiActions::ScheduleDowntimes);
 REGISTER_APIACTION(remove_downtime, "Service;Host;Downtime", &ApiActions::RemoveDowntime);
 REGISTER_APIACTION(shutdown_process, "", &ApiActions::ShutdownProcess);
 REGISTER_APIACTION(restart_process, "", &ApiActions::RestartProcess);
@@ -54,32 +55,23 @@ Dictionary::Ptr ApiActions::CreateResult(int code, const String& status,
 	return result;
 }
 
-Dictionary::Ptr ApiActions::ProcessCheckResult(
-	const ConfigObject::Ptr& object,
-	const ApiUser::Ptr&,
-	const Dictionary::Ptr& params
-)
+/**
+ * Creates a passive check result for the given checkable from the parameters of the process-check-result action.
+ *
+ * @param result Set to the response instead if there's nothing to process
+ *
+ * @return The check result or nullptr
+ */
+CheckResult::Ptr ApiActions::MakePassiveCheckResult(const Checkable::Ptr& checkable, const Dictionary::Ptr& params, Dictionary::Ptr& result)
 {
-	using Result = Checkable::ProcessingResult;
-
-	Checkable::Ptr checkable = static_pointer_cast<Checkable>(object);
-
-	if (!checkable)
-		return ApiActions::CreateResult(404,
-			"Cannot process passive check result for non-existent object.");
-
-	if (!checkable->GetEnablePassiveChecks())
-		return ApiActions::CreateResult(403, "Passive checks are disabled for object '" + checkable->GetName() + "'.");
-
-	if (!checkable->IsReachable(DependencyCheckExecution))
-		return ApiActions::CreateResult(200, "Ignoring passive check result for unreachable object '" + checkable->GetName() + "'.");
-
 	Host::Ptr host;
 	Service::Ptr service;
 	tie(host, service) = GetHostService(checkable);
 
-	if (!params->Contains("exit_status"))
-		return ApiActions::CreateResult(400, "Parameter 'exit_status' is required.");
+	if (!params->Contains("exit_status")) {
+		result = ApiActions::CreateResult(400, "Parameter 'exit_status' is required.");
+		return nullptr;
+	}
 
 	int exitStatus = HttpUtility::GetLastParameter(params, "exit_status");
 
@@ -90,15 +82,19 @@ Dictionary::Ptr ApiActions::ProcessCheckResult(
 			state = ServiceOK;
 		else if (exitStatus == 1)
 			state = ServiceCritical;
-		else
-			return ApiActions::CreateResult(400, "Invalid 'exit_status' for Host "
+		else {
+			result = ApiActions::CreateResult(400, "Invalid 'exit_status' for Host "
 				+ checkable->GetName() + ".");
+			return nullptr;
+		}
 	} else {
 		state = PluginUtility::ExitStatusToState(exitStatus);
 	}
 
-	if (!params->Contains("plugin_output"))
-		return ApiActions::CreateResult(400, "Parameter 'plugin_output' is required");
+	if (!params->Contains("plugin_output")) {
+		result = ApiActions::CreateResult(400, "Parameter 'plugin_output' is required");
+		return nullptr;
+	}
 
 	CheckResult::Ptr cr = new CheckResult();
 	cr->SetOutput(HttpUtility::GetLastParameter(params, "plugin_output"));
@@ -130,7 +126,17 @@ Dictionary::Ptr ApiActions::ProcessCheckResult(
 	if (params->Contains("ttl"))
 		cr->SetTtl(HttpUtility::GetLastParameter(params, "ttl"));
 
-	Result result = checkable->ProcessCheckResult(cr, ApiListener::GetInstance()->GetWaitGroup());
+	return cr;
+}
+
+Dictionary::Ptr ApiActions::CreateUnreachableResult(const Checkable::Ptr& checkable)
+{
+	return ApiActions::CreateResult(200, "Ignoring passive check result for unreachable object '" + checkable->GetName() + "'.");
+}
+
+Dictionary::Ptr ApiActions::CreateProcessingResult(const Checkable::Ptr& checkable, Checkable::ProcessingResult result)
+{
+	using Result = Checkable::ProcessingResult;
 
 	switch (result) {
 		case Result::Ok:
@@ -144,6 +150,134 @@ Dictionary::Ptr ApiActions::ProcessCheckResult(
 	return ApiActions::CreateResult(500, "Unexpected result (" + std::to_string(static_cast<int>(result)) + ") for object '" + checkable->GetName() + "'. Please submit a bug report at https://github.com/Icinga/icinga2");
 }
 
+Dictionary::Ptr ApiActions::ProcessCheckResult(
+	const ConfigObject::Ptr& object,
+	const ApiUser::Ptr&,
+	const Dictionary::Ptr& params
+)
+{
+	Checkable::Ptr checkable = static_pointer_cast<Checkable>(object);
+
+	if (!checkable)
+		return ApiActions::CreateResult(404,
+			"Cannot process passive check result for non-existent object.");
+
+	if (!checkable->GetEnablePassiveChecks())
+		return ApiActions::CreateResult(403, "Passive checks are disabled for object '" + checkable->GetName() + "'.");
+
+	if (!checkable->IsReachable(DependencyCheckExecution))
+		return CreateUnreachableResult(checkable);
+
+	Dictionary::Ptr result;
+	CheckResult::Ptr cr = MakePassiveCheckResult(checkable, params, result);
+
+	if (!cr)
+		return result;
+
+	return CreateProcessingResult(checkable, checkable->ProcessCheckResult(cr, ApiListener::GetInstance()->GetWaitGroup()));
+}
+
+/**
+ * Processes many passive check results at once, each one given as the parameters of the process-check-result action.
+ *
+ * @return The results of all check results of all objects, in the given order
+ */
+Array::Ptr ApiActions::ProcessCheckResults(
+	const ConfigObject::Ptr&,
+	const ApiUser::Ptr& apiUser,
+	const Dictionary::Ptr& params
+)
+{
+	Array::Ptr entries = params->Get("results");
+
+	if (!entries || entries->GetLength() == 0)
+		return new Array({ ApiActions::CreateResult(400, "Parameter 'results' must be a non-empty array.") });
+
+	QueryDescription qd;
+	qd.Types = { "Host", "Service" };
+	qd.Permission = "actions/process-check-result";
+
+	ArrayData results;
+	std::vector<Checkable::QueuedCheckResult> queue;
+	std::vector<ArrayData::size_type> indexes;
+
+	{
+		ObjectLock olock(entries);
+
+		for (const Value& entry : entries) {
+			Dictionary::Ptr entryParams = entry.IsObjectType<Dictionary>() ? Dictionary::Ptr(entry) : nullptr;
+
+			if (!entryParams) {
+				results.emplace_back(ApiActions::CreateResult(400, "Each check result must be a dictionary."));
+				continue;
+			}
+
+			std::vector<Value> objs;
+
+			try {
+				objs = FilterUtility::GetFilterTargets(qd, entryParams, apiUser);
+			} catch (const MissingPermissionError& ex) {
+				results.emplace_back(ApiActions::CreateResult(403, ex.what()));
+				continue;
+			} catch (const std::exception& ex) {
+				results.emplace_back(ApiActions::CreateResult(404, "No objects found: " + DiagnosticInformation(ex, false)));
+				continue;
+			}
+
+			if (objs.empty()) {
+				results.emplace_back(ApiActions::CreateResult(404, "No objects found."));
+				continue;
+			}
+
+			for (Checkable::Ptr checkable : objs) {
+				if (!checkable->GetEnablePassiveChecks()) {
+					results.emplace_back(ApiActions::CreateResult(403, "Passive checks are disabled for object '" + checkable->GetName() + "'."));
+					continue;
+				}
+
+				Dictionary::Ptr result;
+				CheckResult::Ptr cr = MakePassiveCheckResult(checkable, entryParams, result);
+
+				if (cr) {
+					/* Earlier check results of this batch may change the reachability, so it's checked later. */
+					Checkable::QueuedCheckResult queued;
+					queued.Object = checkable;
+					queued.Result = cr;
+					queued.IgnoreIfUnreachable = true;
+
+					indexes.emplace_back(results.size());
+					queue.emplace_back(std::move(queued));
+				}
+
+				results.emplace_back(std::move(result));
+			}
+		}
+	}
+
+	Log(LogNotice, "ApiActions")
+		<< "Processing " << queue.size() << " passive check results at once.";
+
+	Checkable::ProcessCheckResults(queue, ApiListener::GetInstance()->GetWaitGroup());
+
+	for (decltype(queue.size()) i = 0; i < queue.size(); i++) {
+		auto& queued (queue[i]);
+
+		if (queued.Error) {
+			try {
+				std::rethrow_exception(queued.Error);
+			} catch (const std::exception& ex) {
+				results[indexes[i]] = ApiActions::CreateResult(500, "Action execution failed: '" + DiagnosticInformation(ex, false) + "'.");
+			}
+		} else if (queued.Unreachable) {
+			results[indexes[i]] = CreateUnreachableResult(queued.Object);
+		} else {
+			results[indexes[i]] = CreateProcessingResult(queued.Object, queued.Outcome);
+		}
+	}
+
+	return new Array(std::move(results));
+}
+
 Dictionary::Ptr ApiActions::RescheduleCheck(
 	const ConfigObject::Ptr& object,
 	const ApiUser::Ptr&,
@@ -284,6 +418,118 @@ Dictionary::Ptr ApiActions::AcknowledgeProblem(
 	return ApiActions::CreateResult(200, "Successfully acknowledged problem for object '" + checkable->GetName() + "'.");
 }
 
+/**
+ * Acknowledges the problems of all of the given objects and adds their comments in a single activation.
+ */
+std::vector<Value> ApiActions::AcknowledgeProblems(
+	const std::vector<ConfigObject::Ptr>& objects,
+	const ApiUser::Ptr&,
+	const Dictionary::Ptr& params
+)
+{
+	if (!params->Contains("author") || !params->Contains("comment"))
+		return std::vector<Value>(objects.size(), ApiActions::CreateResult(400, "Acknowledgements require author and comment."));
+
+	AcknowledgementType sticky = AcknowledgementNormal;
+	bool notify = false;
+	bool persistent = false;
+	double timestamp = 0.0;
+
+	if (params->Contains("sticky") && HttpUtility::GetLastParameter(params, "sticky"))
+		sticky = AcknowledgementSticky;
+	if (params->Contains("notify"))
+		notify = HttpUtility::GetLastParameter(params, "notify");
+	if (params->Contains("persistent"))
+		persistent = HttpUtility::GetLastParameter(params, "persistent");
+	if (params->Contains("expiry"))
+		timestamp = HttpUtility::GetLastParameter(params, "expiry");
+
+	std::vector<Value> results (objects.size());
+	std::vector<Checkable::Ptr> checkables;
+	std::vector<std::vector<Value>::size_type> indexes;
+
+	if (params->Contains("expiry") && timestamp <= Utility::GetTime()) {
+		for (std::vector<Value>::size_type i = 0; i < objects.size(); i++) {
+			results[i] = ApiActions::CreateResult(409, "Acknowledgement 'expiry' timestamp must be in the future for object " + objects[i]->GetName());
+		}
+
+		return results;
+	}
+
+	ConfigObjectsSharedLock lock (std::try_to_lock);
+
+	if (!lock) {
+		return std::vector<Value>(objects.size(), ApiActions::CreateResult(503, "Icinga is reloading."));
+	}
+
+	for (std::vector<Value>::size_type i = 0; i < objects.size(); i++) {
+		Checkable::Ptr checkable = static_pointer_cast<Checkable>(objects[i]);
+
+		if (!checkable) {
+			results[i] = ApiActions::CreateResult(404, "Cannot acknowledge problem for non-existent object.");
+			continue;
+		}
+
+		ObjectLock oLock (checkable);
+
+		Host::Ptr host;
+		Service::Ptr service;
+		tie(host, service) = GetHostService(checkable);
+
+		if (!service) {
+			if (host->GetState() == HostUp) {
+				results[i] = ApiActions::CreateResult(409, "Host " + checkable->GetName() + " is UP.");
+				continue;
+			}
+		} else {
+			if (service->GetState() == ServiceOK) {
+				results[i] = ApiActions::CreateResult(409, "Service " + checkable->GetName() + " is OK.");
+				continue;
+			}
+		}
+
+		if (checkable->IsAcknowledged()) {
+			results[i] = ApiActions::CreateResult(409, (service ? "Service " : "Host ") + checkable->GetName() + " is already acknowledged.");
+			continue;
+		}
+
+		checkables.emplace_back(std::move(checkable));
+		indexes.emplace_back(i);
+	}
+
+	if (checkables.empty())
+		return results;
+
+	String author = HttpUtility::GetLastParameter(params, "author");
+	String comment = HttpUtility::GetLastParameter(params, "comment");
+
+	auto comments (Comment::AddComments(checkables, CommentAcknowledgement, author, comment,
+		persistent, timestamp, sticky == AcknowledgementSticky));
+
+	for (std::vector<Checkable::Ptr>::size_type i = 0; i < checkables.size(); i++) {
+		auto& checkable (checkables[i]);
+
+		{
+			ObjectLock oLock (checkable);
+
+			if (!checkable->IsAcknowledged()) {
+				checkable->AcknowledgeProblem(author, comment, sticky, notify, persistent, Utility::GetTime(), timestamp);
+
+				results[indexes[i]] = ApiActions::CreateResult(200, "Successfully acknowledged problem for object '" + checkable->GetName() + "'.");
+				continue;
+			}
+		}
+
+		/* Someone else has been faster since the checks above. */
+		Comment::RemoveComment(comments[i]->GetName());
+
+		results[indexes[i]] = ApiActions::CreateResult(409, (checkable->GetReflectionType() == Service::TypeInstance ? "Service " : "Host ")
+			+ checkable->GetName() + " is already acknowledged.");
+	}
+
+	return results;
+}
+
 Dictionary::Ptr ApiActions::RemoveAcknowledgement(
 	const ConfigObject::Ptr& object,
 	const ApiUser::Ptr&,
@@ -392,19 +638,30 @@ Dictionary::Ptr ApiActions::RemoveComment(
 
 Dictionary::Ptr ApiActions::ScheduleDowntime(
 	const ConfigObject::Ptr& object,
-	const ApiUser::Ptr&,
+	const ApiUser::Ptr& user,
 	const Dictionary::Ptr& params
 )
 {
-	Checkable::Ptr checkable = static_pointer_cast<Checkable>(object);
+	return ScheduleDowntimes({ object }, user, params).at(0);
+}
 
-	if (!checkable)
-		return ApiActions::CreateResult(404, "Can't schedule downtime for non-existent object.");
+/**
+ * Schedules the downtimes of all of the given objects, their services and children in a single activation.
+ */
+std::vector<Value> ApiActions::ScheduleDowntimes(
+	const std::vector<ConfigObject::Ptr>& objects,
+	const ApiUser::Ptr&,
+	const Dictionary::Ptr& params
+)
+{
+	auto forAll ([&objects](const Dictionary::Ptr& result) {
+		return std::vector<Value>(objects.size(), result);
+	});
 
 	if (!params->Contains("start_time") || !params->Contains("end_time") ||
 		!params->Contains("author") || !params->Contains("comment")) {
 
-		return ApiActions::CreateResult(400, "Options 'start_time', 'end_time', 'author' and 'comment' are required");
+		return forAll(ApiActions::CreateResult(400, "Options 'start_time', 'end_time', 'author' and 'comment' are required"));
 	}
 
 	bool fixed = true;
@@ -412,21 +669,16 @@ Dictionary::Ptr ApiActions::ScheduleDowntime(
 		fixed = HttpUtility::GetLastParameter(params, "fixed");
 
 	if (!fixed && !params->Contains("duration"))
-		return ApiActions::CreateResult(400, "Option 'duration' is required for flexible downtime");
+		return forAll(ApiActions::CreateResult(400, "Option 'duration' is required for flexible downtime"));
 
 	double duration = 0.0;
 	if (params->Contains("duration"))
 		duration = HttpUtility::GetLastParameter(params, "duration");
 
-	Downtime::Ptr trigger;
 	String triggerName = HttpUtility::GetLastParameter(params, "trigger_name");
 
-	if (!triggerName.IsEmpty()) {
-		trigger = Downtime::GetByName(triggerName);
-
-		if (!trigger) {
-			return ApiActions::CreateResult(404, "Won't schedule downtime with non-existent trigger downtime.");
-		}
+	if (!triggerName.IsEmpty() && !Downtime::GetByName(triggerName)) {
+		return forAll(ApiActions::CreateResult(404, "Won't schedule downtime with non-existent trigger downtime."));
 	}
 
 	String author = HttpUtility::GetLastParameter(params, "author");
@@ -434,133 +686,149 @@ Dictionary::Ptr ApiActions::ScheduleDowntime(
 	double startTime = HttpUtility::GetLastParameter(params, "start_time");
 	double endTime = HttpUtility::GetLastParameter(params, "end_time");
 
-	Host::Ptr host;
-	Service::Ptr service;
-	tie(host, service) = GetHostService(checkable);
-
 	DowntimeChildOptions childOptions = DowntimeNoChildren;
 	if (params->Contains("child_options")) {
 		try {
 			childOptions = Downtime::ChildOptionsFromValue(HttpUtility::GetLastParameter(params, "child_options"));
 		} catch (const std::exception&) {
-			return ApiActions::CreateResult(400, "Option 'child_options' provided an invalid value.");
+			return forAll(ApiActions::CreateResult(400, "Option 'child_options' provided an invalid value."));
 		}
 	}
 
+	/* Schedule downtime for all services for the host type. */
+	bool allServices = false;
+
+	if (params->Contains("all_services"))
+		allServices = HttpUtility::GetLastParameter(params, "all_services");
+
 	ConfigObjectsSharedLock lock (std::try_to_lock);
 
 	if (!lock) {
-		return ApiActions::CreateResult(503, "Icinga is reloading.");
+		return forAll(ApiActions::CreateResult(503, "Icinga is reloading."));
 	}
 
-	Downtime::Ptr downtime = Downtime::AddDowntime(checkable, author, comment, startTime, endTime,
-		fixed, trigger, duration);
-	String downtimeName = downtime->GetName();
-
-	Dictionary::Ptr additional = new Dictionary({
-		{ "name", downtimeName },
-		{ "legacy_id", downtime->GetLegacyId() }
-	});
+	/* All downtimes are named upfront, so that they can refer to each other before they're added at once. */
+	std::vector<DowntimeTarget> targets;
+	std::vector<Dictionary::Ptr> targetResults;
 
-	/* Schedule downtime for all services for the host type. */
-	bool allServices = false;
+	auto addTarget ([&targets, &targetResults](const Checkable::Ptr& checkable, const String& triggeredBy, const String& parent) {
+		String name = Downtime::NewDowntimeName(checkable);
 
-	if (params->Contains("all_services"))
-		allServices = HttpUtility::GetLastParameter(params, "all_services");
+		targets.emplace_back(DowntimeTarget{checkable, name, triggeredBy, parent});
+		targetResults.emplace_back(new Dictionary({ { "name", name } }));
 
-	if (allServices && !service) {
-		ArrayData serviceDowntimes;
+		return targetResults.back();
+	});
 
-		for (const Service::Ptr& hostService : host->GetServices()) {
-			Log(LogNotice, "ApiActions")
-				<< "Creating downtime for service " << hostService->GetName() << " on host " << host->GetName();
+	std::vector<Value> results (objects.size());
+	std::vector<Dictionary::Ptr> additionals (objects.size());
 
-			Downtime::Ptr serviceDowntime = Downtime::AddDowntime(hostService, author, comment, startTime, endTime,
-				fixed, trigger, duration, String(), String(), downtimeName);
-			String serviceDowntimeName = serviceDowntime->GetName();
+	for (std::vector<Value>::size_type i = 0; i < objects.size(); i++) {
+		Checkable::Ptr checkable = static_pointer_cast<Checkable>(objects[i]);
 
-			serviceDowntimes.push_back(new Dictionary({
-				{ "name", serviceDowntimeName },
-				{ "legacy_id", serviceDowntime->GetLegacyId() }
-			}));
+		if (!checkable) {
+			results[i] = ApiActions::CreateResult(404, "Can't schedule downtime for non-existent object.");
+			continue;
 		}
 
-		additional->Set("service_downtimes", new Array(std::move(serviceDowntimes)));
-	}
-
-	/* Schedule downtime for all child objects. */
-	if (childOptions != DowntimeNoChildren) {
-		/* 'DowntimeTriggeredChildren' schedules child downtimes triggered by the parent downtime.
-		 * 'DowntimeNonTriggeredChildren' schedules non-triggered downtimes for all children.
-		 */
-		if (childOptions == DowntimeTriggeredChildren) {
-			trigger = downtime;
-		}
+		Host::Ptr host;
+		Service::Ptr service;
+		tie(host, service) = GetHostService(checkable);
 
-		Log(LogNotice, "ApiActions")
-			<< "Processing child options " << childOptions << " for downtime " << downtimeName;
+		Dictionary::Ptr additional = addTarget(checkable, triggerName, String());
+		String downtimeName = additional->Get("name");
 
-		ArrayData childDowntimes;
+		if (allServices && !service) {
+			ArrayData serviceDowntimes;
 
-		std::set<Checkable::Ptr> allChildren = checkable->GetAllChildren();
-		for (const Checkable::Ptr& child : allChildren) {
-			Host::Ptr childHost;
-			Service::Ptr childService;
-			tie(childHost, childService) = GetHostService(child);
+			for (const Service::Ptr& hostService : host->GetServices()) {
+				Log(LogNotice, "ApiActions")
+					<< "Creating downtime for service " << hostService->GetName() << " on host " << host->GetName();
 
-			if (allServices && childService &&
-					allChildren.find(static_pointer_cast<Checkable>(childHost)) != allChildren.end()) {
-				/* When scheduling downtimes for all service and all children, the current child is a service, and its
-				 * host is also a child, skip it here. The downtime for this service will be scheduled below together
-				 * with the downtimes of all services for that host. Scheduling it below ensures that the relation
-				 * from the child service downtime to the child host downtime is set properly. */
-				continue;
+				serviceDowntimes.push_back(addTarget(hostService, triggerName, downtimeName));
 			}
 
-			Log(LogNotice, "ApiActions")
-				<< "Scheduling downtime for child object " << child->GetName();
+			additional->Set("service_downtimes", new Array(std::move(serviceDowntimes)));
+		}
 
-			Downtime::Ptr childDowntime = Downtime::AddDowntime(child, author, comment, startTime, endTime,
-				fixed, trigger, duration, String(), String(), downtimeName);
-			String childDowntimeName = childDowntime->GetName();
+		/* Schedule downtime for all child objects. */
+		if (childOptions != DowntimeNoChildren) {
+			/* 'DowntimeTriggeredChildren' schedules child downtimes triggered by the parent downtime.
+			 * 'DowntimeNonTriggeredChildren' schedules non-triggered downtimes for all children.
+			 */
+			String childTriggerName = childOptions == DowntimeTriggeredChildren ? downtimeName : triggerName;
 
 			Log(LogNotice, "ApiActions")
-				<< "Add child downtime '" << childDowntimeName << "'.";
+				<< "Processing child options " << childOptions << " for downtime " << downtimeName;
+
+			ArrayData childDowntimes;
+
+			std::set<Checkable::Ptr> allChildren = checkable->GetAllChildren();
+			for (const Checkable::Ptr& child : allChildren) {
+				Host::Ptr childHost;
+				Service::Ptr childService;
+				tie(childHost, childService) = GetHostService(child);
+
+				if (allServices && childService &&
+						allChildren.find(static_pointer_cast<Checkable>(childHost)) != allChildren.end()) {
+					/* When scheduling downtimes for all service and all children, the current child is a service, and its
+					 * host is also a child, skip it here. The downtime for this service will be scheduled below together
+					 * with the downtimes of all services for that host. Scheduling it below ensures that the relation
+					 * from the child service downtime to the child host downtime is set properly. */
+					continue;
+				}
 
-			Dictionary::Ptr childAdditional = new Dictionary({
-				{ "name", childDowntimeName },
-				{ "legacy_id", childDowntime->GetLegacyId() }
-			});
+				Log(LogNotice, "ApiActions")
+					<< "Scheduling downtime for child object " << child->GetName();
 
-			/* For a host, also schedule all service downtimes if requested. */
-			if (allServices && !childService) {
-				ArrayData childServiceDowntimes;
+				Dictionary::Ptr childAdditional = addTarget(child, childTriggerName, downtimeName);
+				String childDowntimeName = childAdditional->Get("name");
 
-				for (const Service::Ptr& childService : childHost->GetServices()) {
-					Log(LogNotice, "ApiActions")
-						<< "Creating downtime for service " << childService->GetName() << " on child host " << childHost->GetName();
+				Log(LogNotice, "ApiActions")
+					<< "Add child downtime '" << childDowntimeName << "'.";
 
-					Downtime::Ptr serviceDowntime = Downtime::AddDowntime(childService, author, comment, startTime, endTime,
-						fixed, trigger, duration, String(), String(), childDowntimeName);
-					String serviceDowntimeName = serviceDowntime->GetName();
+				/* For a host, also schedule all service downtimes if requested. */
+				if (allServices && !childService) {
+					ArrayData childServiceDowntimes;
 
-					childServiceDowntimes.push_back(new Dictionary({
-						{ "name", serviceDowntimeName },
-						{ "legacy_id", serviceDowntime->GetLegacyId() }
-					}));
+					for (const Service::Ptr& childService : childHost->GetServices()) {
+						Log(LogNotice, "ApiActions")
+							<< "Creating downtime for service " << childService->GetName() << " on child host " << childHost->GetName();
+
+						childServiceDowntimes.push_back(addTarget(childService, childTriggerName, childDowntimeName));
+					}
+
+					childAdditional->Set("service_downtimes", new Array(std::move(childServiceDowntimes)));
 				}
 
-				childAdditional->Set("service_downtimes", new Array(std::move(childServiceDowntimes)));
+				childDowntimes.push_back(childAdditional);
 			}
 
-			childDowntimes.push_back(childAdditional);
+			additional->Set("child_downtimes", new Array(std::move(childDowntimes)));
 		}
 
-		additional->Set("child_downtimes", new Array(std::move(childDowntimes)));
+		additionals[i] = std::move(additional);
+	}
+
+	if (targets.empty())
+		return results;
+
+	auto downtimes (Downtime::AddDowntimes(targets, author, comment, startTime, endTime, fixed, duration));
+
+	for (std::vector<Downtime::Ptr>::size_type i = 0; i < downtimes.size(); i++) {
+		targetResults[i]->Set("legacy_id", downtimes[i]->GetLegacyId());
+	}
+
+	for (std::vector<Value>::size_type i = 0; i < objects.size(); i++) {
+		if (additionals[i]) {
+			String downtimeName = additionals[i]->Get("name");
+
+			results[i] = ApiActions::CreateResult(200, "Successfully scheduled downtime '" +
+				downtimeName + "' for object '" + objects[i]->GetName() + "'.", additionals[i]);
+		}
 	}
 
-	return ApiActions::CreateResult(200, "Successfully scheduled downtime '" +
-		downtimeName + "' for object '" + checkable->GetName() + "'.", additional);
+	return results;
 }
 
 Dictionary::Ptr ApiActions::RemoveDowntime(
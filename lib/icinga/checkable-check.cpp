@@ -5,6 +5,7 @@
 #include "icinga/service.hpp"
 #include "icinga/host.hpp"
 #include "icinga/checkcommand.hpp"
+#include "icinga/checktrace.hpp"
 #include "icinga/icingaapplication.hpp"
 #include "icinga/cib.hpp"
 #include "icinga/clusterevents.hpp"
@@ -15,7 +16,15 @@
 #include "base/convert.hpp"
 #include "base/utility.hpp"
 #include "base/context.hpp"
+#include "base/configuration.hpp"
+#include "base/workqueue.hpp"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <mutex>
 #include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace icinga;
 
@@ -27,6 +36,57 @@ boost::signals2::signal<void (const Checkable::Ptr&)> Checkable::OnNextCheckUpda
 
 Atomic<uint_fast64_t> Checkable::CurrentConcurrentChecks (0);
 
+namespace {
+
+struct CheckResultEventsStripe
+{
+	std::mutex Mutex;
+	std::condition_variable CV;
+};
+
+}
+
+/* Shared by all checkables, as check results of the same checkable rarely overtake each other. */
+static std::array<CheckResultEventsStripe, 64> l_CheckResultEventsStripes;
+
+static CheckResultEventsStripe& GetCheckResultEventsStripe(const Checkable *checkable)
+{
+	return l_CheckResultEventsStripes[std::hash<const Checkable*>()(checkable) % l_CheckResultEventsStripes.size()];
+}
+
+/**
+ * @param ticket The value of m_CheckResultEventsQueued after the check result has been processed
+ */
+Checkable::CheckResultEventsTurn::CheckResultEventsTurn(Checkable *checkable, uint_fast64_t ticket)
+	: m_Checkable(checkable), m_Ticket(ticket)
+{
+	auto& stripe (GetCheckResultEventsStripe(m_Checkable));
+	auto self (std::this_thread::get_id());
+	std::unique_lock<std::mutex> lock (stripe.Mutex);
+
+	/* A signal handler of an earlier check result may process another one of the same checkable. */
+	stripe.CV.wait(lock, [this, self]() {
+		return m_Checkable->m_CheckResultEventsDispatched + 1u >= m_Ticket || m_Checkable->m_CheckResultEventsThread == self;
+	});
+
+	m_PreviousThread = m_Checkable->m_CheckResultEventsThread;
+	m_Checkable->m_CheckResultEventsThread = self;
+}
+
+Checkable::CheckResultEventsTurn::~CheckResultEventsTurn()
+{
+	auto& stripe (GetCheckResultEventsStripe(m_Checkable));
+
+	{
+		std::unique_lock<std::mutex> lock (stripe.Mutex);
+
+		m_Checkable->m_CheckResultEventsDispatched = std::max(m_Checkable->m_CheckResultEventsDispatched, m_Ticket);
+		m_Checkable->m_CheckResultEventsThread = m_PreviousThread;
+	}
+
+	stripe.CV.notify_all();
+}
+
 std::mutex Checkable::m_StatsMutex;
 int Checkable::m_PendingChecks = 0;
 std::condition_variable Checkable::m_PendingChecksCV;
@@ -51,15 +111,20 @@ long Checkable::GetSchedulingOffset()
 	return m_SchedulingOffset;
 }
 
-void Checkable::UpdateNextCheck(const MessageOrigin::Ptr& origin)
+/**
+ * @return The retry interval while in a soft state, the check interval otherwise
+ */
+double Checkable::GetCurrentCheckInterval() const
 {
-	double interval;
-
 	if (GetStateType() == StateTypeSoft && GetLastCheckResult() != nullptr)
-		interval = GetRetryInterval();
+		return GetRetryInterval();
 	else
-		interval = GetCheckInterval();
+		return GetCheckInterval();
+}
 
+void Checkable::UpdateNextCheck(const MessageOrigin::Ptr& origin)
+{
+	double interval = GetCurrentCheckInterval();
 	double now = Utility::GetTime();
 	double adj = 0;
 
@@ -105,7 +170,12 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 	VERIFY(cr);
 	VERIFY(producer);
 
+	auto& trace (cr->GetTrace());
+	CheckTrace::Span lockSpan (trace, CheckTraceStage::ResultLockWait);
+
 	ObjectLock olock(this);
+	lockSpan.End();
+
 	m_CheckRunning = false;
 
 	double now = Utility::GetTime();
@@ -146,6 +216,8 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 
 	/* agent checks go through the api */
 	if (command_endpoint && GetExtension("agent_check")) {
+		olock.Unlock();
+
 		ApiListener::Ptr listener = ApiListener::GetInstance();
 
 		if (listener) {
@@ -309,9 +381,6 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 	if (!IsStateOK(new_state))
 		TriggerDowntimes(cr->GetExecutionEnd());
 
-	/* statistics for external tools */
-	Checkable::UpdateStatistics(cr, checkableType);
-
 	bool in_downtime = IsInDowntime();
 
 	bool send_notification = false;
@@ -330,9 +399,6 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 	if (is_volatile && IsStateOK(old_state) && IsStateOK(new_state))
 		send_notification = false; /* Don't send notifications for volatile OK -> OK changes. */
 
-	if (remove_acknowledgement_comments)
-		RemoveAckComments(String(), cr->GetExecutionEnd());
-
 	Dictionary::Ptr vars_after = new Dictionary({
 		{ "state", new_state },
 		{ "state_type", GetStateType() },
@@ -345,6 +411,8 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 
 	cr->SetVarsAfter(vars_after);
 
+	bool host_problem_changed = false;
+
 	if (service) {
 		SetLastCheckResult(cr);
 	} else {
@@ -352,12 +420,7 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 
 		SetLastCheckResult(cr);
 
-		if (GetProblem() != wasProblem) {
-			auto services = host->GetServices();
-			for (auto& service : services) {
-				Service::OnHostProblemChanged(service, cr, origin);
-			}
-		}
+		host_problem_changed = GetProblem() != wasProblem;
 	}
 
 	bool was_flapping = IsFlapping();
@@ -365,6 +428,7 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 	UpdateFlappingStatus(cr->GetState());
 
 	bool is_flapping = IsFlapping();
+	double flapping_current = GetFlappingCurrent();
 
 	// Don't recompute the next check when the current check isn't generated by this endpoint. When the check is
 	// remotely generated we should've already received the "SetNextCheck" event before the "event::CheckResult"
@@ -390,78 +454,39 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 		}
 	}
 
-#ifdef I2_DEBUG /* I2_DEBUG */
-	Log(LogDebug, "Checkable")
-		<< "Flapping: Checkable " << GetName()
-		<< " was: " << was_flapping
-		<< " is: " << is_flapping
-		<< " threshold low: " << GetFlappingThresholdLow()
-		<< " threshold high: " << GetFlappingThresholdHigh()
-		<< "% current: " << GetFlappingCurrent() << "%.";
-#endif /* I2_DEBUG */
-
-	OnNewCheckResult(this, cr, origin);
-
-	/* signal status updates to for example db_ido */
-	OnStateChanged(this);
-
-	String old_state_str = (service ? Service::StateToString(old_state) : Host::StateToString(Host::CalculateState(old_state)));
-	String new_state_str = (service ? Service::StateToString(new_state) : Host::StateToString(Host::CalculateState(new_state)));
-
-	/* Whether a hard state change or a volatile state change except OK -> OK happened. */
-	if (hardChange || (is_volatile && !(IsStateOK(old_state) && IsStateOK(new_state)))) {
-		OnStateChange(this, cr, StateTypeHard, origin);
-		Log(LogNotice, "Checkable")
-			<< "State Change: Checkable '" << GetName() << "' hard state change from " << old_state_str << " to " << new_state_str << " detected." << (is_volatile ? " Checkable is volatile." : "");
-	}
-	/* Whether a state change happened or the state type is SOFT (must be logged too). */
-	else if (stateChange || GetStateType() == StateTypeSoft) {
-		OnStateChange(this, cr, StateTypeSoft, origin);
-		Log(LogNotice, "Checkable")
-			<< "State Change: Checkable '" << GetName() << "' soft state change from " << old_state_str << " to " << new_state_str << " detected.";
-	}
-
-	if (GetStateType() == StateTypeSoft || hardChange || recovery ||
-		(is_volatile && !(IsStateOK(old_state) && IsStateOK(new_state))))
-		ExecuteEventHandler();
+	StateType new_stateType = GetStateType();
+	bool paused = IsPaused();
+	bool execute_event_handler = new_stateType == StateTypeSoft || hardChange || recovery ||
+		(is_volatile && !(IsStateOK(old_state) && IsStateOK(new_state)));
 
+	/* The notifications to request after the lock has been released, 0 for none. */
+	int flapping_notification = 0;
+	int state_notification = 0;
 	int suppressed_types = 0;
 
 	/* Flapping start/end notifications */
 	if (!was_flapping && is_flapping) {
 		/* FlappingStart notifications happen on state changes, not in downtimes */
-		if (!IsPaused()) {
+		if (!paused) {
 			if (in_downtime) {
 				suppressed_types |= NotificationFlappingStart;
 			} else {
-				OnNotificationsRequested(this, NotificationFlappingStart, cr, "", "", nullptr);
+				flapping_notification = NotificationFlappingStart;
 			}
 		}
-
-		Log(LogNotice, "Checkable")
-			<< "Flapping Start: Checkable '" << GetName() << "' started flapping (Current flapping value "
-			<< GetFlappingCurrent() << "% > high threshold " << GetFlappingThresholdHigh() << "%).";
-
-		NotifyFlapping(origin);
 	} else if (was_flapping && !is_flapping) {
 		/* FlappingEnd notifications are independent from state changes, must not happen in downtine */
-		if (!IsPaused()) {
+		if (!paused) {
 			if (in_downtime) {
 				suppressed_types |= NotificationFlappingEnd;
 			} else {
-				OnNotificationsRequested(this, NotificationFlappingEnd, cr, "", "", nullptr);
+				flapping_notification = NotificationFlappingEnd;
 			}
 		}
-
-		Log(LogNotice, "Checkable")
-			<< "Flapping Stop: Checkable '" << GetName() << "' stopped flapping (Current flapping value "
-			<< GetFlappingCurrent() << "% < low threshold " << GetFlappingThresholdLow() << "%).";
-
-		NotifyFlapping(origin);
 	}
 
 	if (send_notification && !is_flapping) {
-		if (!IsPaused()) {
+		if (!paused) {
 			/* If there are still some pending suppressed state notification, keep the suppression until these are
 			 * handled by Checkable::FireSuppressedNotifications().
 			 */
@@ -470,7 +495,7 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 			if (suppress_notification || pending) {
 				suppressed_types |= (recovery ? NotificationRecovery : NotificationProblem);
 			} else {
-				OnNotificationsRequested(this, recovery ? NotificationRecovery : NotificationProblem, cr, "", "", nullptr);
+				state_notification = recovery ? NotificationRecovery : NotificationProblem;
 			}
 		}
 	}
@@ -506,11 +531,98 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 	}
 
 	/* update reachability for child objects */
-	if ((stateChange || hardChange) && !children.empty() && (affectsPreviousStateChildren || AffectsChildren()))
-		OnReachabilityChanged(this, cr, children, origin);
+	bool reachability_changed = (stateChange || hardChange) && !children.empty() &&
+		(affectsPreviousStateChildren || AffectsChildren());
+
+	/* Everything below only announces the new state, so it doesn't block e.g. API reads of this checkable.
+	 * The check results of this checkable are still announced in the order they've been processed in.
+	 */
+	auto ticket (++m_CheckResultEventsQueued);
 
 	olock.Unlock();
 
+	/* The signal handlers of earlier check results might wait for the object lock otherwise. */
+	ASSERT(!OwnsLock());
+
+	CheckResultEventsTurn turn (this, ticket);
+
+#ifdef I2_DEBUG /* I2_DEBUG */
+	Log(LogDebug, "Checkable")
+		<< "Flapping: Checkable " << GetName()
+		<< " was: " << was_flapping
+		<< " is: " << is_flapping
+		<< " threshold low: " << GetFlappingThresholdLow()
+		<< " threshold high: " << GetFlappingThresholdHigh()
+		<< "% current: " << flapping_current << "%.";
+#endif /* I2_DEBUG */
+
+	/* statistics for external tools */
+	Checkable::UpdateStatistics(cr, checkableType);
+
+	if (remove_acknowledgement_comments)
+		RemoveAckComments(String(), cr->GetExecutionEnd());
+
+	{
+		CheckTrace::Span signalSpan (trace, CheckTraceStage::SignalHandlers);
+
+		if (host_problem_changed) {
+			for (auto& service : host->GetServices()) {
+				Service::OnHostProblemChanged(service, cr, origin);
+			}
+		}
+
+		OnNewCheckResult(this, cr, origin);
+
+		/* signal status updates to for example db_ido */
+		OnStateChanged(this);
+	}
+
+	if (trace) {
+		trace->Finish();
+	}
+
+	String old_state_str = (service ? Service::StateToString(old_state) : Host::StateToString(Host::CalculateState(old_state)));
+	String new_state_str = (service ? Service::StateToString(new_state) : Host::StateToString(Host::CalculateState(new_state)));
+
+	/* Whether a hard state change or a volatile state change except OK -> OK happened. */
+	if (hardChange || (is_volatile && !(IsStateOK(old_state) && IsStateOK(new_state)))) {
+		OnStateChange(this, cr, StateTypeHard, origin);
+		Log(LogNotice, "Checkable")
+			<< "State Change: Checkable '" << GetName() << "' hard state change from " << old_state_str << " to " << new_state_str << " detected." << (is_volatile ? " Checkable is volatile." : "");
+	}
+	/* Whether a state change happened or the state type is SOFT (must be logged too). */
+	else if (stateChange || new_stateType == StateTypeSoft) {
+		OnStateChange(this, cr, StateTypeSoft, origin);
+		Log(LogNotice, "Checkable")
+			<< "State Change: Checkable '" << GetName() << "' soft state change from " << old_state_str << " to " << new_state_str << " detected.";
+	}
+
+	if (execute_event_handler)
+		ExecuteEventHandler();
+
+	if (flapping_notification)
+		OnNotificationsRequested(this, NotificationType(flapping_notification), cr, "", "", nullptr);
+
+	if (!was_flapping && is_flapping) {
+		Log(LogNotice, "Checkable")
+			<< "Flapping Start: Checkable '" << GetName() << "' started flapping (Current flapping value "
+			<< flapping_current << "% > high threshold " << GetFlappingThresholdHigh() << "%).";
+
+		NotifyFlapping(origin);
+	} else if (was_flapping && !is_flapping) {
+		Log(LogNotice, "Checkable")
+			<< "Flapping Stop: Checkable '" << GetName() << "' stopped flapping (Current flapping value "
+			<< flapping_current << "% < low threshold " << GetFlappingThresholdLow() << "%).";
+
+		NotifyFlapping(origin);
+	}
+
+	if (state_notification)
+		OnNotificationsRequested(this, NotificationType(state_notification), cr, "", "", nullptr);
+
+	if (reachability_changed)
+		OnReachabilityChanged(this, cr, children, origin);
+
 	if (recovery) {
 		for (auto& child : children) {
 			if (child->GetProblem() && child->GetEnableActiveChecks()) {
@@ -544,6 +656,124 @@ Checkable::ProcessingResult Checkable::ProcessCheckResult(const CheckResult::Ptr
 	return Result::Ok;
 }
 
+/**
+ * Processes many check results at once, e.g. a batch of passive check results.
+ *
+ * The check results of different checkables are processed in parallel, the ones of the same checkable
+ * in the given order. They're relayed to the cluster in event::CheckResults messages. The outcome of
+ * each check result, or the error it caused, is stored in its entry.
+ *
+ * Check results flagged with IgnoreIfUnreachable are checked for the reachability of their checkable
+ * right before processing them, i.e. after all earlier check results of its (indirect) parents.
+ */
+void Checkable::ProcessCheckResults(std::vector<QueuedCheckResult>& results, const WaitGroup::Ptr& producer)
+{
+	auto process ([&producer](QueuedCheckResult& result) {
+		try {
+			if (result.IgnoreIfUnreachable && !result.Object->IsReachable(DependencyCheckExecution)) {
+				result.Unreachable = true;
+				return;
+			}
+
+			result.Outcome = result.Object->ProcessCheckResult(result.Result, producer, result.Origin);
+		} catch (...) {
+			result.Error = std::current_exception();
+		}
+	});
+
+	/* Not worth the threads. */
+	if (results.size() < 100 || Configuration::Concurrency < 2) {
+		ClusterEvents::CheckResultBatch batch;
+
+		for (auto& result : results) {
+			process(result);
+		}
+
+		return;
+	}
+
+	/* A check result may change the reachability of the children of its checkable and, by that, the outcome
+	 * of their check results. So checkables depending on each other (also indirectly via checkables outside
+	 * of this batch) form a group, the check results of which are processed in their original order.
+	 */
+	std::unordered_map<Checkable*, Checkable*> groupOf;
+
+	for (auto& result : results) {
+		groupOf.emplace(result.Object.get(), result.Object.get());
+	}
+
+	auto find ([&groupOf](Checkable* checkable) {
+		for (;;) {
+			auto& parent (groupOf.at(checkable));
+
+			if (parent == checkable) {
+				return checkable;
+			}
+
+			parent = groupOf.at(parent);
+			checkable = parent;
+		}
+	});
+
+	std::unordered_set<Checkable*> walked;
+
+	for (auto& result : results) {
+		if (!walked.emplace(result.Object.get()).second) {
+			continue;
+		}
+
+		std::vector<Checkable::Ptr> stack ({ result.Object });
+		std::unordered_set<Checkable*> visited ({ result.Object.get() });
+
+		while (!stack.empty()) {
+			Checkable::Ptr current (std::move(stack.back()));
+			stack.pop_back();
+
+			auto parents (current->GetParents());
+
+			if (auto service = dynamic_pointer_cast<Service>(current); service) {
+				if (auto host = service->GetHost(); host) {
+					parents.emplace(host);
+				}
+			}
+
+			for (auto& parent : parents) {
+				if (!visited.emplace(parent.get()).second) {
+					continue;
+				}
+
+				if (groupOf.find(parent.get()) == groupOf.end()) {
+					stack.emplace_back(parent);
+				} else {
+					/* Its own parents are merged into the group when walking from it. */
+					groupOf.at(find(parent.get())) = find(result.Object.get());
+				}
+			}
+		}
+	}
+
+	std::vector<std::vector<QueuedCheckResult*>> chunks (Configuration::Concurrency);
+	std::unordered_map<Checkable*, size_t> chunkOf;
+
+	for (auto& result : results) {
+		auto it (chunkOf.emplace(find(result.Object.get()), chunkOf.size() % chunks.size()).first);
+
+		chunks[it->second].emplace_back(&result);
+	}
+
+	WorkQueue upq (25000, Configuration::Concurrency, LogNotice);
+
+	upq.ParallelFor(chunks, false, [&process](const std::vector<QueuedCheckResult*>& chunk) {
+		ClusterEvents::CheckResultBatch batch;
+
+		for (auto result : chunk) {
+			process(*result);
+		}
+	});
+
+	upq.Join();
+}
+
 void Checkable::ExecuteRemoteCheck(const WaitGroup::Ptr& producer, const Dictionary::Ptr& resolvedMacros)
 {
 	CONTEXT("Executing remote check for object '" << GetName() << "'");
@@ -599,6 +829,9 @@ void Checkable::ExecuteCheck(const WaitGroup::Ptr& producer)
 	bool local = !endpoint || endpoint == Endpoint::GetLocalEndpoint();
 
 	if (local) {
+		/* Results of command endpoints come back as new check results, so only local checks can be traced. */
+		cr->SetTrace(CheckTrace::GetCurrent());
+
 		GetCheckCommand()->Execute(this, cr, producer, nullptr, false);
 	} else {
 		Dictionary::Ptr macros = new Dictionary();
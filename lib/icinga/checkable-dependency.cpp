@@ -4,6 +4,7 @@
 #include "icinga/service.hpp"
 #include "icinga/dependency.hpp"
 #include "base/logger.hpp"
+#include <unordered_set>
 
 using namespace icinga;
 
@@ -18,14 +19,21 @@ using namespace icinga;
  */
 void Checkable::PushDependencyGroupsToRegistry()
 {
-	std::lock_guard lock(m_DependencyMutex);
-	if (m_PendingDependencies != nullptr) {
+	{
+		std::lock_guard lock(m_DependencyMutex);
+		if (m_PendingDependencies == nullptr) {
+			return;
+		}
+
 		for (const auto& [key, dependencies] : *m_PendingDependencies) {
 			String redundancyGroup = std::holds_alternative<String>(key) ? std::get<String>(key) : "";
 			m_DependencyGroups.emplace(key, DependencyGroup::Register(new DependencyGroup(redundancyGroup, dependencies)));
 		}
 		m_PendingDependencies.reset();
 	}
+
+	// This checkable may have been evaluated as if it had no dependencies until now.
+	InvalidateReachability();
 }
 
 std::vector<DependencyGroup::Ptr> Checkable::GetDependencyGroups() const
@@ -90,6 +98,8 @@ void Checkable::AddDependency(const Dependency::Ptr& dependency)
 
 	lock.unlock();
 
+	InvalidateReachability();
+
 	if (existingGroup) {
 		dependencies.erase(dependency);
 		DependencyGroup::OnChildRemoved(existingGroup, {dependencies.begin(), dependencies.end()}, removeGroup);
@@ -127,6 +137,8 @@ void Checkable::RemoveDependency(const Dependency::Ptr& dependency, bool runtime
 
 	lock.unlock();
 
+	InvalidateReachability();
+
 	if (runtimeRemoved) {
 		dependencies.emplace(dependency);
 		DependencyGroup::OnChildRemoved(existingGroup, {dependencies.begin(), dependencies.end()}, removeGroup);
@@ -187,7 +199,95 @@ std::vector<Dependency::Ptr> Checkable::GetReverseDependencies() const
  */
 bool Checkable::IsReachable(DependencyType dt) const
 {
-	return DependencyStateChecker(dt).IsReachable(this);
+#ifdef I2_DEBUG
+	auto generation (DependencyStateChecker::GetGeneration(this));
+#endif /* I2_DEBUG */
+
+	bool reachable = DependencyStateChecker(dt).IsReachable(this);
+
+#ifdef I2_DEBUG
+	/* Verify the materialized reachability against a full evaluation, unless it has been invalidated meanwhile. */
+	if (DependencyStateChecker(dt, false).IsReachable(this) != reachable && DependencyStateChecker::GetGeneration(this) == generation) {
+		Log(LogCritical, "Checkable")
+			<< "Materialized reachability of checkable '" << GetName() << "' for dependency type " << dt
+			<< " is inconsistent: It's " << (reachable ? "reachable" : "unreachable") << ", but shouldn't be.";
+	}
+#endif /* I2_DEBUG */
+
+	return reachable;
+}
+
+/**
+ * Marks the materialized reachability of this checkable and all its (indirect) children as outdated.
+ *
+ * This has to be called whenever anything changes that the reachability of this checkable depends on, i.e.
+ * its dependencies or the state of its parents. The children of a host include its services, as they depend
+ * on it implicitly. The checkables are invalidated top-down, so that a concurrent evaluation of a child can't
+ * materialize an outdated parent state after that child has been invalidated.
+ */
+void Checkable::InvalidateReachability()
+{
+	std::vector<Checkable::Ptr> postOrder;
+	std::unordered_set<const Checkable*> visited;
+	std::vector<std::pair<Checkable::Ptr, std::vector<Checkable::Ptr>>> stack;
+
+	auto getChildren = [](const Checkable::Ptr& checkable) {
+		auto children (checkable->GetChildren());
+		std::vector<Checkable::Ptr> result (children.begin(), children.end());
+
+		if (auto host = dynamic_pointer_cast<Host>(checkable); host) {
+			for (auto& service : host->GetServices()) {
+				result.emplace_back(service);
+			}
+		}
+
+		return result;
+	};
+
+	visited.emplace(this);
+	stack.emplace_back(this, getChildren(this));
+
+	while (!stack.empty()) {
+		auto& children (stack.back().second);
+
+		if (children.empty()) {
+			postOrder.emplace_back(stack.back().first);
+			stack.pop_back();
+			continue;
+		}
+
+		Checkable::Ptr child (std::move(children.back()));
+		children.pop_back();
+
+		if (visited.emplace(child.get()).second) {
+			auto grandChildren (getChildren(child));
+			stack.emplace_back(std::move(child), std::move(grandChildren));
+		}
+	}
+
+	/* The reverse post-order of a depth-first search is a topological order, i.e. parents come first. */
+	for (auto it (postOrder.rbegin()); it != postOrder.rend(); ++it) {
+		DependencyStateChecker::Invalidate(it->get());
+
+		/* The statistics count unreachable checkables. */
+		CIB::InvalidateCheckable(*it);
+	}
+}
+
+/**
+ * Invalidates the reachability of the children of this checkable if its state changed in a way relevant for them.
+ *
+ * Called whenever a part of that state changes. Check results which don't change the state are ignored this way.
+ *
+ * @param invalidate Whether to invalidate the children, false to only remember the current state.
+ */
+void Checkable::UpdateDependencySignature(bool invalidate)
+{
+	uint32_t signature = 1u | (GetLastCheckResult() ? 2u : 0u) | (uint32_t(GetStateType()) << 2) | (uint32_t(GetStateRaw()) << 4);
+
+	if (m_DependencySignature.exchange(signature) != signature && invalidate) {
+		InvalidateReachability();
+	}
 }
 
 /**
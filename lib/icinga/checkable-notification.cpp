@@ -83,6 +83,8 @@ void Checkable::SendNotifications(NotificationType type, const CheckResult::Ptr&
 							{"author", author},
 							{"text", text}
 						}));
+
+						notification->NotifyStashedNotifications();
 					} else {
 						notification->BeginExecuteNotification(type, cr, force, false, author, text);
 					}
@@ -108,6 +110,8 @@ void Checkable::SendNotifications(NotificationType type, const CheckResult::Ptr&
 				{"author", author},
 				{"text", text}
 			}));
+
+			notification->NotifyStashedNotifications();
 		}
 	}
 }
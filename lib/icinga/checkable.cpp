@@ -60,6 +60,16 @@ void Checkable::StaticInitialize()
 	Downtime::OnDowntimeTriggered.connect([](const Downtime::Ptr& downtime) { Checkable::NotifyFlexibleDowntimeStart(downtime); });
 	/* fixed/flexible downtime end */
 	Downtime::OnDowntimeRemoved.connect([](const Downtime::Ptr& downtime) { Checkable::NotifyDowntimeEnd(downtime); });
+
+	/* materialized reachability of the children */
+	Checkable::OnStateRawChanged.connect([](const Checkable::Ptr& checkable, const Value&) { checkable->UpdateDependencySignature(); });
+	Checkable::OnStateTypeChanged.connect([](const Checkable::Ptr& checkable, const Value&) { checkable->UpdateDependencySignature(); });
+	Checkable::OnLastCheckResultChanged.connect([](const Checkable::Ptr& checkable, const Value&) { checkable->UpdateDependencySignature(); });
+	ConfigObject::OnActiveChanged.connect([](const ConfigObject::Ptr& object, const Value&) {
+		if (auto checkable = dynamic_pointer_cast<Checkable>(object); checkable && !checkable->IsActive()) {
+			checkable->InvalidateReachability();
+		}
+	});
 }
 
 Checkable::Checkable()
@@ -116,6 +126,9 @@ void Checkable::Start(bool runtimeCreated)
 {
 	PushDependencyGroupsToRegistry();
 
+	/* Pushing the dependency groups has invalidated the children already. */
+	UpdateDependencySignature(false);
+
 	double now = Utility::GetTime();
 
 	{
@@ -9,6 +9,7 @@
 #include "base/process.hpp"
 #include "icinga/i2-icinga.hpp"
 #include "icinga/checkable-ti.hpp"
+#include "icinga/cib.hpp"
 #include "icinga/timeperiod.hpp"
 #include "icinga/notification.hpp"
 #include "icinga/comment.hpp"
@@ -18,9 +19,12 @@
 #include "remote/messageorigin.hpp"
 #include <condition_variable>
 #include <cstdint>
+#include <exception>
 #include <functional>
 #include <limits>
+#include <thread>
 #include <variant>
+#include <vector>
 
 namespace icinga
 {
@@ -87,6 +91,7 @@ public:
 
 	bool IsReachable(DependencyType dt = DependencyState) const;
 	bool AffectsChildren() const;
+	void InvalidateReachability();
 
 	AcknowledgementType GetAcknowledgement();
 
@@ -105,6 +110,8 @@ public:
 	long GetSchedulingOffset();
 	void SetSchedulingOffset(long offset);
 
+	double GetCurrentCheckInterval() const;
+
 	void UpdateNextCheck(const MessageOrigin::Ptr& origin = nullptr);
 
 	static String StateTypeToString(StateType type);
@@ -130,6 +137,22 @@ public:
 
 	ProcessingResult ProcessCheckResult(const CheckResult::Ptr& cr, const WaitGroup::Ptr& producer, const MessageOrigin::Ptr& origin = nullptr);
 
+	/**
+	 * A check result to be processed by ProcessCheckResults() and its outcome.
+	 */
+	struct QueuedCheckResult
+	{
+		Checkable::Ptr Object;
+		CheckResult::Ptr Result;
+		MessageOrigin::Ptr Origin;
+		bool IgnoreIfUnreachable = false; // like passive check results, see IsReachable(DependencyCheckExecution)
+		bool Unreachable = false; // not processed due to IgnoreIfUnreachable
+		ProcessingResult Outcome = ProcessingResult::Ok;
+		std::exception_ptr Error;
+	};
+
+	static void ProcessCheckResults(std::vector<QueuedCheckResult>& results, const WaitGroup::Ptr& producer);
+
 	Endpoint::Ptr GetCommandEndpoint() const;
 
 	static boost::signals2::signal<void (const Checkable::Ptr&, const CheckResult::Ptr&, const MessageOrigin::Ptr&)> OnNewCheckResult;
@@ -227,6 +250,30 @@ private:
 	bool m_CheckRunning{false};
 	long m_SchedulingOffset;
 
+	/**
+	 * Waits until the events of all check results processed before a given one have been announced
+	 * and lets the following ones wait until the events of that one have been announced.
+	 */
+	class CheckResultEventsTurn
+	{
+	public:
+		CheckResultEventsTurn(Checkable *checkable, uint_fast64_t ticket);
+		CheckResultEventsTurn(const CheckResultEventsTurn&) = delete;
+		CheckResultEventsTurn& operator=(const CheckResultEventsTurn&) = delete;
+		~CheckResultEventsTurn();
+
+	private:
+		Checkable *m_Checkable;
+		uint_fast64_t m_Ticket;
+		std::thread::id m_PreviousThread;
+	};
+
+	/* The number of processed check results, guarded by the object lock. */
+	uint_fast64_t m_CheckResultEventsQueued{0};
+	/* The number of processed check results whose events have been announced and the thread announcing one. */
+	uint_fast64_t m_CheckResultEventsDispatched{0};
+	std::thread::id m_CheckResultEventsThread;
+
 	static std::mutex m_StatsMutex;
 	static int m_PendingChecks;
 	static std::condition_variable m_PendingChecksCV;
@@ -268,7 +315,23 @@ private:
 	std::unique_ptr<std::map<std::variant<Checkable*, String>, std::set<intrusive_ptr<Dependency>>>>
 		m_PendingDependencies {std::make_unique<decltype(m_PendingDependencies)::element_type>()};
 
+	/**
+	 * The materialized results of IsReachable(), maintained by DependencyStateChecker. The lowest bits hold a valid
+	 * and a reachable flag per DependencyType, the bits above count how often the results have been invalidated.
+	 */
+	mutable std::atomic<uint64_t> m_Reachability{0};
+	/* The last known state of this checkable as far as its children's dependencies are concerned. */
+	std::atomic<uint32_t> m_DependencySignature{0};
+
 	void GetAllChildrenInternal(std::set<Checkable::Ptr>& seenChildren, int level = 0) const;
+	void UpdateDependencySignature(bool invalidate = true);
+
+	friend class DependencyStateChecker;
+
+	/* What this checkable currently contributes to the CIB statistics, guarded by the CIB. */
+	CibContribution m_CibContribution;
+
+	friend class CIB;
 
 	/* Flapping */
 	static const std::map<String, int> m_FlappingStateFilterMap;
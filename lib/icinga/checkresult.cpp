@@ -3,6 +3,8 @@
 
 #include "icinga/checkresult.hpp"
 #include "icinga/checkresult-ti.cpp"
+#include "base/objectlock.hpp"
+#include "base/perfdatavalue.hpp"
 #include "base/scriptglobal.hpp"
 
 using namespace icinga;
@@ -41,3 +43,77 @@ void CheckResult::SetPerformanceData(const Array::Ptr& value, bool suppress_even
 	}
 	ObjectImpl<CheckResult>::SetPerformanceData(value, suppress_events, cookie);
 }
+
+/**
+ * Parses performance_data once, so that not every consumer (e.g. each perfdata writer) has to do it.
+ *
+ * The result isn't serialized, performance_data remains the only representation sent to the cluster and API.
+ *
+ * @returns One item per performance_data item, in the same order
+ */
+std::shared_ptr<const std::vector<ParsedPerfdata>> CheckResult::GetParsedPerformanceData() const
+{
+	Array::Ptr perfdata = GetPerformanceData();
+	auto cache (m_ParsedPerformanceData.load());
+
+	if (!cache || cache->Source != perfdata) {
+		auto parsed (std::make_shared<ParsedPerfdataCache>());
+		parsed->Source = perfdata;
+
+		if (perfdata) {
+			ObjectLock olock (perfdata);
+
+			parsed->Values.reserve(perfdata->GetLength());
+
+			for (const Value& val : perfdata) {
+				PerfdataValue::Ptr pdv;
+				ParsedPerfdata pd;
+
+				pd.Raw = val;
+
+				if (val.IsObjectType<PerfdataValue>()) {
+					pdv = val;
+				} else {
+					try {
+						pdv = PerfdataValue::Parse(val);
+					} catch (const std::exception&) {
+						parsed->Values.emplace_back(std::move(pd));
+						continue;
+					}
+				}
+
+				pd.Valid = true;
+				pd.Label = pdv->GetLabel();
+				pd.Number = pdv->GetValue();
+				pd.Counter = pdv->GetCounter();
+				pd.Unit = pdv->GetUnit();
+				pd.Warn = pdv->GetWarn();
+				pd.Crit = pdv->GetCrit();
+				pd.Min = pdv->GetMin();
+				pd.Max = pdv->GetMax();
+
+				parsed->Values.emplace_back(std::move(pd));
+			}
+		}
+
+		cache = std::move(parsed);
+		m_ParsedPerformanceData.store(cache);
+	}
+
+	return std::shared_ptr<const std::vector<ParsedPerfdata>>(cache, &cache->Values);
+}
+
+/**
+ * Attaches the trace of a sampled check, so that the stages handling the result can record their timings.
+ *
+ * The trace isn't serialized, results received from the cluster or the API are never traced.
+ */
+void CheckResult::SetTrace(std::shared_ptr<CheckTrace> trace)
+{
+	m_Trace = std::move(trace);
+}
+
+const std::shared_ptr<CheckTrace>& CheckResult::GetTrace() const
+{
+	return m_Trace;
+}
@@ -6,10 +6,34 @@
 
 #include "icinga/i2-icinga.hpp"
 #include "icinga/checkresult-ti.hpp"
+#include "base/atomic.hpp"
+#include <memory>
+#include <vector>
 
 namespace icinga
 {
 
+class CheckTrace;
+
+/**
+ * A performance data value of a CheckResult, parsed only once and shared by all its consumers.
+ *
+ * @ingroup icinga
+ */
+struct ParsedPerfdata
+{
+	Value Raw; /* The item of CheckResult#performance_data, e.g. for error messages */
+	bool Valid{false}; /* If false, Raw couldn't be parsed and all other fields are unset */
+	String Label;
+	double Number{0};
+	bool Counter{false};
+	String Unit;
+	Value Warn;
+	Value Crit;
+	Value Min;
+	Value Max;
+};
+
 /**
  * A check result.
  *
@@ -23,6 +47,23 @@ public:
 	double CalculateExecutionTime() const;
 	double CalculateLatency() const;
 	void SetPerformanceData(const Array::Ptr& value, bool suppress_events = false, const Value& cookie = Empty) override;
+
+	std::shared_ptr<const std::vector<ParsedPerfdata>> GetParsedPerformanceData() const;
+
+	void SetTrace(std::shared_ptr<CheckTrace> trace);
+	const std::shared_ptr<CheckTrace>& GetTrace() const;
+
+private:
+	struct ParsedPerfdataCache
+	{
+		Array::Ptr Source;
+		std::vector<ParsedPerfdata> Values;
+	};
+
+	mutable Locked<std::shared_ptr<const ParsedPerfdataCache>> m_ParsedPerformanceData;
+
+	/* Set once by the check's executor, before the check result is handed to anyone else. */
+	std::shared_ptr<CheckTrace> m_Trace;
 };
 
 }
@@ -0,0 +1,195 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/checktrace.hpp"
+#include "base/metricsregistry.hpp"
+#include "base/utility.hpp"
+#include <cstdlib>
+
+using namespace icinga;
+
+boost::signals2::signal<void (const CheckTrace::Ptr&)> CheckTrace::OnFinished;
+
+std::atomic<double> CheckTrace::m_SampleRate (0);
+
+static thread_local CheckTrace::Ptr l_CurrentTrace;
+
+static constexpr auto l_StageCount = static_cast<std::size_t>(CheckTraceStage::Count);
+
+static const std::array<std::shared_ptr<MetricLatencyHistogram>, l_StageCount> l_StageMetrics ([]() {
+	std::array<std::shared_ptr<MetricLatencyHistogram>, l_StageCount> metrics;
+
+	for (std::size_t i = 0; i < l_StageCount; i++) {
+		metrics[i] = MetricsRegistry::Register("icinga_check_stage_seconds",
+			"Time sampled checks spent in each stage of the check pipeline.",
+			{ { "stage", CheckTrace::GetStageName(static_cast<CheckTraceStage>(i)) } },
+			std::make_shared<MetricLatencyHistogram>());
+	}
+
+	return metrics;
+}());
+
+CheckTrace::Span::Span(const CheckTrace::Ptr& trace, CheckTraceStage stage)
+	: m_Trace(trace.get()), m_Stage(stage)
+{
+	if (m_Trace) {
+		m_Start = Clock::now();
+	}
+}
+
+CheckTrace::Span::~Span()
+{
+	End();
+}
+
+/**
+ * Records the time since the span has been started, unless it has been ended already.
+ */
+void CheckTrace::Span::End()
+{
+	if (m_Trace) {
+		m_Trace->Record(m_Stage, Clock::now() - m_Start);
+		m_Trace = nullptr;
+	}
+}
+
+CheckTrace::Scope::Scope(const CheckTrace::Ptr& trace)
+	: m_Previous(std::move(l_CurrentTrace))
+{
+	l_CurrentTrace = trace;
+}
+
+CheckTrace::Scope::~Scope()
+{
+	l_CurrentTrace = std::move(m_Previous);
+}
+
+CheckTrace::CheckTrace(Checkable::Ptr checkable)
+	: m_Checkable(std::move(checkable)), m_StartTime(Utility::GetTime())
+{
+	for (auto& stage : m_Stages) {
+		stage.store(-1, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * Decides whether to trace a check of the given checkable.
+ *
+ * @return A new trace or nullptr if the check isn't sampled
+ */
+CheckTrace::Ptr CheckTrace::Sample(const Checkable::Ptr& checkable)
+{
+	auto rate (m_SampleRate.load(std::memory_order_relaxed));
+
+	if (rate <= 0 || Utility::Random() >= rate * (RAND_MAX + 1.0)) {
+		return nullptr;
+	}
+
+	return std::make_shared<CheckTrace>(checkable);
+}
+
+/**
+ * Sets the share of checks to trace.
+ *
+ * @param rate A number between 0 (trace nothing) and 1 (trace every check)
+ */
+void CheckTrace::SetSampleRate(double rate)
+{
+	m_SampleRate.store(rate, std::memory_order_relaxed);
+}
+
+double CheckTrace::GetSampleRate()
+{
+	return m_SampleRate.load(std::memory_order_relaxed);
+}
+
+/**
+ * @return The trace of the check being executed by this thread, if it's traced
+ */
+CheckTrace::Ptr CheckTrace::GetCurrent()
+{
+	return l_CurrentTrace;
+}
+
+void CheckTrace::Record(CheckTraceStage stage, Clock::duration duration)
+{
+	Record(stage, std::chrono::duration<double>(duration).count());
+}
+
+/**
+ * Records the time spent in the given stage, unless the trace has been finished already.
+ *
+ * The latter happens e.g. if an event handler is run while the current trace is still set.
+ */
+void CheckTrace::Record(CheckTraceStage stage, double seconds)
+{
+	if (m_Finished.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	m_Stages[static_cast<std::size_t>(stage)].store(seconds < 0 ? 0 : seconds, std::memory_order_relaxed);
+}
+
+/**
+ * Aggregates the recorded stages into the stage metrics and announces the trace, once.
+ */
+void CheckTrace::Finish()
+{
+	if (m_Finished.exchange(true)) {
+		return;
+	}
+
+	for (std::size_t i = 0; i < l_StageCount; i++) {
+		if (auto seconds (m_Stages[i].load(std::memory_order_relaxed)); seconds >= 0) {
+			l_StageMetrics[i]->Record(seconds);
+		}
+	}
+
+	OnFinished(shared_from_this());
+}
+
+const Checkable::Ptr& CheckTrace::GetCheckable() const
+{
+	return m_Checkable;
+}
+
+/**
+ * @return When the check has been sampled, as a UNIX timestamp
+ */
+double CheckTrace::GetStartTime() const
+{
+	return m_StartTime;
+}
+
+bool CheckTrace::HasStage(CheckTraceStage stage) const
+{
+	return GetStageDuration(stage) >= 0;
+}
+
+/**
+ * @return The time spent in the given stage in seconds, negative if it hasn't been recorded
+ */
+double CheckTrace::GetStageDuration(CheckTraceStage stage) const
+{
+	return m_Stages[static_cast<std::size_t>(stage)].load(std::memory_order_relaxed);
+}
+
+const char* CheckTrace::GetStageName(CheckTraceStage stage)
+{
+	switch (stage) {
+		case CheckTraceStage::DispatchWait:
+			return "dispatch_wait";
+		case CheckTraceStage::MacroResolution:
+			return "macro_resolution";
+		case CheckTraceStage::Spawn:
+			return "spawn";
+		case CheckTraceStage::PluginRuntime:
+			return "plugin_runtime";
+		case CheckTraceStage::ResultLockWait:
+			return "result_lock_wait";
+		case CheckTraceStage::SignalHandlers:
+			return "signal_handlers";
+		default:
+			ABORT("Invalid check trace stage.");
+	}
+}
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef CHECKTRACE_H
+#define CHECKTRACE_H
+
+#include "icinga/i2-icinga.hpp"
+#include "icinga/checkable.hpp"
+#include <boost/signals2.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace icinga
+{
+
+/**
+ * The stages of the check pipeline, from the checker picking a checkable to the result being handled.
+ *
+ * @ingroup icinga
+ */
+enum class CheckTraceStage
+{
+	DispatchWait, // From the checker starting the check to a thread pool worker running it
+	MacroResolution, // Resolving the command line and environment of the check command
+	Spawn, // The round trip to the process spawn helper
+	PluginRuntime, // The plugin's own execution time
+	ResultLockWait, // Waiting for the checkable's lock to process the check result
+	SignalHandlers, // The check result handlers, e.g. of Icinga DB, the perfdata writers and the cluster
+	Count
+};
+
+/**
+ * The time a single check spent in each stage of the check pipeline.
+ *
+ * Checks are traced only if they're sampled by the checker, according to its trace_sample_rate. The trace
+ * is attached to the check result and handed from stage to stage along with it. Each stage has its own
+ * atomic slot, so recording them doesn't need any locks, even if e.g. a very short plugin finishes
+ * before the spawn stage has been recorded. Finished traces are aggregated into the
+ * icinga_check_stage_seconds metrics and announced via OnFinished.
+ *
+ * @ingroup icinga
+ */
+class CheckTrace final : public std::enable_shared_from_this<CheckTrace>
+{
+public:
+	using Ptr = std::shared_ptr<CheckTrace>;
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * Measures the time until it's ended or destroyed and records it as the given stage.
+	 *
+	 * Does nothing if there's no trace, so that untraced checks don't even read the clock.
+	 */
+	class Span
+	{
+	public:
+		Span(const CheckTrace::Ptr& trace, CheckTraceStage stage);
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+		~Span();
+
+		void End();
+
+	private:
+		CheckTrace* m_Trace;
+		CheckTraceStage m_Stage;
+		Clock::time_point m_Start;
+	};
+
+	/**
+	 * Makes the given trace the current one of this thread, until it goes out of scope.
+	 */
+	class Scope
+	{
+	public:
+		explicit Scope(const CheckTrace::Ptr& trace);
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		~Scope();
+
+	private:
+		CheckTrace::Ptr m_Previous;
+	};
+
+	explicit CheckTrace(Checkable::Ptr checkable);
+
+	static CheckTrace::Ptr Sample(const Checkable::Ptr& checkable);
+	static void SetSampleRate(double rate);
+	static double GetSampleRate();
+
+	static CheckTrace::Ptr GetCurrent();
+
+	void Record(CheckTraceStage stage, Clock::duration duration);
+	void Record(CheckTraceStage stage, double seconds);
+	void Finish();
+
+	const Checkable::Ptr& GetCheckable() const;
+	double GetStartTime() const;
+	bool HasStage(CheckTraceStage stage) const;
+	double GetStageDuration(CheckTraceStage stage) const;
+
+	static const char* GetStageName(CheckTraceStage stage);
+
+	static boost::signals2::signal<void (const CheckTrace::Ptr&)> OnFinished;
+
+private:
+	Checkable::Ptr m_Checkable;
+	double m_StartTime;
+	std::array<std::atomic<double>, static_cast<std::size_t>(CheckTraceStage::Count)> m_Stages;
+	std::atomic<bool> m_Finished{false};
+
+	static std::atomic<double> m_SampleRate;
+};
+
+}
+
+#endif /* CHECKTRACE_H */
@@ -11,9 +11,71 @@
 #include "base/perfdatavalue.hpp"
 #include "base/configtype.hpp"
 #include "base/statsfunction.hpp"
+#include "base/initialize.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <unordered_set>
 
 using namespace icinga;
 
+INITIALIZE_ONCE(&CIB::StaticInitialize);
+
+/**
+ * The bits of CibContribution::Flags, each one is counted separately.
+ */
+enum CibFlag : uint_fast32_t
+{
+	/* The state of a service or the state of a reachable host, i.e. up (OK) or down (Warning). */
+	CibStateOK,
+	CibStateWarning,
+	CibStateCritical,
+	CibStateUnknown,
+	CibCheckResult,
+	CibPending,
+	CibUnreachable,
+	CibFlapping,
+	CibInDowntime,
+	CibAcknowledged,
+	CibHandled,
+	CibProblem,
+	CibFlagCount
+};
+
+namespace {
+
+struct CheckableStatistics
+{
+	std::array<int_fast64_t, CibFlagCount> Counters {};
+	DurationSketch Latency;
+	DurationSketch ExecutionTime;
+};
+
+}
+
+static std::mutex l_StatisticsMutex;
+static CheckableStatistics l_HostStatistics;
+static CheckableStatistics l_ServiceStatistics;
+
+static std::atomic<uint_fast64_t> l_NextContributionSequence (1);
+
+static std::mutex l_OutdatedMutex;
+static std::unordered_set<Checkable::Ptr> l_OutdatedCheckables;
+
+static CheckableCheckStatistics GetCheckStatistics(const CheckableStatistics& statistics)
+{
+	CheckableCheckStatistics ccs;
+
+	ccs.min_latency = statistics.Latency.GetMin();
+	ccs.max_latency = statistics.Latency.GetMax();
+	ccs.avg_latency = statistics.Latency.GetAvg();
+	ccs.min_execution_time = statistics.ExecutionTime.GetMin();
+	ccs.max_execution_time = statistics.ExecutionTime.GetMax();
+	ccs.avg_execution_time = statistics.ExecutionTime.GetAvg();
+
+	return ccs;
+}
+
 RingBuffer CIB::m_ActiveHostChecksStatistics(15 * 60);
 RingBuffer CIB::m_ActiveServiceChecksStatistics(15 * 60);
 RingBuffer CIB::m_PassiveHostChecksStatistics(15 * 60);
@@ -61,198 +123,303 @@ int CIB::GetPassiveServiceChecksStatistics(long timespan)
 
 CheckableCheckStatistics CIB::CalculateHostCheckStats()
 {
-	double min_latency = -1, max_latency = 0, sum_latency = 0;
-	int count_latency = 0;
-	double min_execution_time = -1, max_execution_time = 0, sum_execution_time = 0;
-	int count_execution_time = 0;
-	bool checkresult = false;
+	UpdateOutdatedCheckables();
 
-	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>()) {
-		ObjectLock olock(host);
+	std::unique_lock<std::mutex> lock (l_StatisticsMutex);
 
-		CheckResult::Ptr cr = host->GetLastCheckResult();
+	return GetCheckStatistics(l_HostStatistics);
+}
 
-		if (!cr)
-			continue;
+CheckableCheckStatistics CIB::CalculateServiceCheckStats()
+{
+	UpdateOutdatedCheckables();
 
-		/* set to true, we have a checkresult */
-		checkresult = true;
+	std::unique_lock<std::mutex> lock (l_StatisticsMutex);
 
-		/* latency */
-		double latency = cr->CalculateLatency();
+	return GetCheckStatistics(l_ServiceStatistics);
+}
 
-		if (min_latency == -1 || latency < min_latency)
-			min_latency = latency;
+ServiceStatistics CIB::CalculateServiceStats()
+{
+	UpdateOutdatedCheckables();
 
-		if (latency > max_latency)
-			max_latency = latency;
+	std::unique_lock<std::mutex> lock (l_StatisticsMutex);
+	auto& counters (l_ServiceStatistics.Counters);
 
-		sum_latency += latency;
-		count_latency++;
+	ServiceStatistics ss;
 
-		/* execution_time */
-		double execution_time = cr->CalculateExecutionTime();
+	ss.services_ok = counters[CibStateOK];
+	ss.services_warning = counters[CibStateWarning];
+	ss.services_critical = counters[CibStateCritical];
+	ss.services_unknown = counters[CibStateUnknown];
+	ss.services_pending = counters[CibPending];
+	ss.services_unreachable = counters[CibUnreachable];
+	ss.services_flapping = counters[CibFlapping];
+	ss.services_in_downtime = counters[CibInDowntime];
+	ss.services_acknowledged = counters[CibAcknowledged];
+	ss.services_handled = counters[CibHandled];
+	ss.services_problem = counters[CibProblem];
 
-		if (min_execution_time == -1 || execution_time < min_execution_time)
-			min_execution_time = execution_time;
+	return ss;
+}
+
+HostStatistics CIB::CalculateHostStats()
+{
+	UpdateOutdatedCheckables();
+
+	std::unique_lock<std::mutex> lock (l_StatisticsMutex);
+	auto& counters (l_HostStatistics.Counters);
+
+	HostStatistics hs;
 
-		if (execution_time > max_execution_time)
-			max_execution_time = execution_time;
+	/* Only reachable hosts are counted as up or down. */
+	hs.hosts_up = counters[CibStateOK];
+	hs.hosts_down = counters[CibStateWarning];
+	hs.hosts_unreachable = counters[CibUnreachable];
+	hs.hosts_pending = counters[CibPending];
+	hs.hosts_flapping = counters[CibFlapping];
+	hs.hosts_in_downtime = counters[CibInDowntime];
+	hs.hosts_acknowledged = counters[CibAcknowledged];
+	hs.hosts_handled = counters[CibHandled];
+	hs.hosts_problem = counters[CibProblem];
+
+	return hs;
+}
+
+/**
+ * Updates what the given checkable contributes to the statistics, e.g. after it has processed a check result.
+ *
+ * Inactive checkables don't contribute anything.
+ *
+ * The contribution is evaluated without any lock, so concurrent updates of the same checkable may finish in any
+ * order. Each evaluation gets a sequence number taken before reading the checkable, so the one which has started
+ * last has seen all changes preceding any update and the older ones are dropped instead of overwriting it.
+ */
+void CIB::UpdateCheckable(const Checkable::Ptr& checkable)
+{
+	auto sequence (l_NextContributionSequence.fetch_add(1));
+	auto current (GetContribution(checkable));
+	auto& statistics (dynamic_cast<Service*>(checkable.get()) ? l_ServiceStatistics : l_HostStatistics);
 
-		sum_execution_time += execution_time;
-		count_execution_time++;
+	current.Sequence = sequence;
+
+	std::unique_lock<std::mutex> lock (l_StatisticsMutex);
+	auto& previous (checkable->m_CibContribution);
+
+	if (previous.Sequence > current.Sequence) {
+		return;
 	}
 
-	if (!checkresult) {
-		min_latency = 0;
-		min_execution_time = 0;
+	for (size_t i = 0; i < CibFlagCount; i++) {
+		statistics.Counters[i] += int_fast64_t(current.Flags >> i & 1u) - int_fast64_t(previous.Flags >> i & 1u);
 	}
 
-	CheckableCheckStatistics ccs;
+	if (previous.Flags & 1u << CibCheckResult) {
+		statistics.Latency.Remove(previous.Latency);
+		statistics.ExecutionTime.Remove(previous.ExecutionTime);
+	}
 
-	ccs.min_latency = min_latency;
-	ccs.max_latency = max_latency;
-	ccs.avg_latency = sum_latency / count_latency;
-	ccs.min_execution_time = min_execution_time;
-	ccs.max_execution_time = max_execution_time;
-	ccs.avg_execution_time = sum_execution_time / count_execution_time;
+	if (current.Flags & 1u << CibCheckResult) {
+		statistics.Latency.Add(current.Latency);
+		statistics.ExecutionTime.Add(current.ExecutionTime);
+	}
 
-	return ccs;
+	previous = current;
 }
 
-CheckableCheckStatistics CIB::CalculateServiceCheckStats()
+/**
+ * Marks what the given checkable contributes to the statistics as outdated, without evaluating it right now.
+ *
+ * This is used for changes which affect a lot of checkables at once, i.e. their reachability.
+ * The outdated checkables are updated when the statistics are read the next time.
+ */
+void CIB::InvalidateCheckable(const Checkable::Ptr& checkable)
 {
-	double min_latency = -1, max_latency = 0, sum_latency = 0;
-	int count_latency = 0;
-	double min_execution_time = -1, max_execution_time = 0, sum_execution_time = 0;
-	int count_execution_time = 0;
-	bool checkresult = false;
+	std::unique_lock<std::mutex> lock (l_OutdatedMutex);
 
-	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
-		ObjectLock olock(service);
+	l_OutdatedCheckables.emplace(checkable);
+}
 
-		CheckResult::Ptr cr = service->GetLastCheckResult();
+void CIB::UpdateOutdatedCheckables()
+{
+	std::unordered_set<Checkable::Ptr> outdated;
 
-		if (!cr)
-			continue;
+	{
+		std::unique_lock<std::mutex> lock (l_OutdatedMutex);
+		std::swap(outdated, l_OutdatedCheckables);
+	}
 
-		/* set to true, we have a checkresult */
-		checkresult = true;
+	for (auto& checkable : outdated) {
+		UpdateCheckable(checkable);
+	}
+}
+
+CibContribution CIB::GetContribution(const Checkable::Ptr& checkable)
+{
+	CibContribution contribution;
+
+	if (!checkable->IsActive()) {
+		return contribution;
+	}
 
-		/* latency */
-		double latency = cr->CalculateLatency();
+	Host::Ptr host;
+	Service::Ptr service;
+	tie(host, service) = GetHostService(checkable);
 
-		if (min_latency == -1 || latency < min_latency)
-			min_latency = latency;
+	auto set ([&contribution](CibFlag flag) { contribution.Flags |= 1u << flag; });
+	bool reachable = checkable->IsReachable();
 
-		if (latency > max_latency)
-			max_latency = latency;
+	if (service) {
+		set(CibFlag(CibStateOK + service->GetState()));
+	} else if (reachable) {
+		set(CibFlag(CibStateOK + host->GetState()));
+	}
 
-		sum_latency += latency;
-		count_latency++;
+	if (CheckResult::Ptr cr = checkable->GetLastCheckResult(); cr) {
+		set(CibCheckResult);
+		contribution.Latency = cr->CalculateLatency();
+		contribution.ExecutionTime = cr->CalculateExecutionTime();
+	} else {
+		set(CibPending);
+	}
 
-		/* execution_time */
-		double execution_time = cr->CalculateExecutionTime();
+	if (!reachable)
+		set(CibUnreachable);
 
-		if (min_execution_time == -1 || execution_time < min_execution_time)
-			min_execution_time = execution_time;
+	if (checkable->IsFlapping())
+		set(CibFlapping);
+	if (checkable->IsInDowntime())
+		set(CibInDowntime);
+	if (checkable->IsAcknowledged())
+		set(CibAcknowledged);
 
-		if (execution_time > max_execution_time)
-			max_execution_time = execution_time;
+	if (checkable->GetHandled())
+		set(CibHandled);
+	if (checkable->GetProblem())
+		set(CibProblem);
 
-		sum_execution_time += execution_time;
-		count_execution_time++;
-	}
+	return contribution;
+}
 
-	if (!checkresult) {
-		min_latency = 0;
-		min_execution_time = 0;
+void CIB::StaticInitialize()
+{
+	auto update ([](const Checkable::Ptr& checkable) { UpdateCheckable(checkable); });
+	auto updateDowntime ([](const Downtime::Ptr& downtime) { UpdateCheckable(downtime->GetCheckable()); });
+
+	ConfigObject::OnActiveChanged.connect([](const ConfigObject::Ptr& object, const Value&) {
+		if (auto checkable = dynamic_pointer_cast<Checkable>(object); checkable) {
+			UpdateCheckable(checkable);
+		} else if (auto downtime = dynamic_pointer_cast<Downtime>(object); downtime) {
+			UpdateCheckable(downtime->GetCheckable());
+		}
+	});
+
+	Checkable::OnNewCheckResult.connect([update](const Checkable::Ptr& checkable, const CheckResult::Ptr&, const MessageOrigin::Ptr&) {
+		update(checkable);
+	});
+	Checkable::OnFlappingChange.connect([update](const Checkable::Ptr& checkable, double) { update(checkable); });
+	Checkable::OnAcknowledgementSet.connect([update](const Checkable::Ptr& checkable, const String&, const String&,
+		AcknowledgementType, bool, bool, double, double, const MessageOrigin::Ptr&) {
+		update(checkable);
+	});
+	Checkable::OnAcknowledgementCleared.connect([update](const Checkable::Ptr& checkable, const String&, double,
+		const MessageOrigin::Ptr&) {
+		update(checkable);
+	});
+
+	Downtime::OnDowntimeStarted.connect(updateDowntime);
+	Downtime::OnDowntimeTriggered.connect(updateDowntime);
+	Downtime::OnDowntimeRemoved.connect(updateDowntime);
+}
+
+/**
+ * @return The bucket of the given duration, 0 for everything up to a microsecond
+ */
+size_t DurationSketch::GetBucket(double seconds)
+{
+	if (!(seconds > 1e-6)) {
+		return 0;
 	}
 
-	CheckableCheckStatistics ccs;
+	/* Bucket i >= 1 covers [1e-6 * 1.02^(i-1), 1e-6 * 1.02^i). */
+	auto bucket (1 + std::log(seconds * 1e6) / std::log(1.02));
 
-	ccs.min_latency = min_latency;
-	ccs.max_latency = max_latency;
-	ccs.avg_latency = sum_latency / count_latency;
-	ccs.min_execution_time = min_execution_time;
-	ccs.max_execution_time = max_execution_time;
-	ccs.avg_execution_time = sum_execution_time / count_execution_time;
+	return bucket < BucketCount - 1 ? size_t(bucket) : BucketCount - 1;
+}
 
-	return ccs;
+/**
+ * @return The geometric center of the given bucket, which differs from all of its durations by less than 1%
+ */
+double DurationSketch::GetBucketValue(size_t bucket)
+{
+	return bucket ? 1e-6 * std::pow(1.02, bucket - 0.5) : 0;
 }
 
-ServiceStatistics CIB::CalculateServiceStats()
+void DurationSketch::Add(double seconds)
+{
+	m_Buckets[GetBucket(seconds)]++;
+	m_SumMicroseconds += std::llround(seconds * 1e6);
+	m_Count++;
+}
+
+/**
+ * Removes a duration which has been added before.
+ */
+void DurationSketch::Remove(double seconds)
+{
+	m_Buckets[GetBucket(seconds)]--;
+	m_SumMicroseconds -= std::llround(seconds * 1e6);
+	m_Count--;
+}
+
+uint_fast64_t DurationSketch::GetCount() const
+{
+	return m_Count;
+}
+
+/**
+ * @return The approximate minimum or 0 if there are no durations
+ */
+double DurationSketch::GetMin() const
 {
-	ServiceStatistics ss = {};
-
-	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
-		ObjectLock olock(service);
-
-		if (service->GetState() == ServiceOK)
-			ss.services_ok++;
-		if (service->GetState() == ServiceWarning)
-			ss.services_warning++;
-		if (service->GetState() == ServiceCritical)
-			ss.services_critical++;
-		if (service->GetState() == ServiceUnknown)
-			ss.services_unknown++;
-
-		CheckResult::Ptr cr = service->GetLastCheckResult();
-
-		if (!cr)
-			ss.services_pending++;
-
-		if (!service->IsReachable())
-			ss.services_unreachable++;
-
-		if (service->IsFlapping())
-			ss.services_flapping++;
-		if (service->IsInDowntime())
-			ss.services_in_downtime++;
-		if (service->IsAcknowledged())
-			ss.services_acknowledged++;
-
-		if (service->GetHandled())
-			ss.services_handled++;
-		if (service->GetProblem())
-			ss.services_problem++;
+	if (!m_Count) {
+		return 0;
 	}
 
-	return ss;
+	size_t bucket = 0;
+
+	while (!m_Buckets[bucket]) {
+		bucket++;
+	}
+
+	/* The approximation must not contradict the exact average. */
+	return std::min(GetBucketValue(bucket), GetAvg());
 }
 
-HostStatistics CIB::CalculateHostStats()
+/**
+ * @return The approximate maximum or 0 if there are no durations
+ */
+double DurationSketch::GetMax() const
 {
-	HostStatistics hs = {};
-
-	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>()) {
-		ObjectLock olock(host);
-
-		if (host->IsReachable()) {
-			if (host->GetState() == HostUp)
-				hs.hosts_up++;
-			if (host->GetState() == HostDown)
-				hs.hosts_down++;
-		} else
-			hs.hosts_unreachable++;
-
-		if (!host->GetLastCheckResult())
-			hs.hosts_pending++;
-
-		if (host->IsFlapping())
-			hs.hosts_flapping++;
-		if (host->IsInDowntime())
-			hs.hosts_in_downtime++;
-		if (host->IsAcknowledged())
-			hs.hosts_acknowledged++;
-
-		if (host->GetHandled())
-			hs.hosts_handled++;
-		if (host->GetProblem())
-			hs.hosts_problem++;
+	if (!m_Count) {
+		return 0;
 	}
 
-	return hs;
+	size_t bucket = BucketCount - 1;
+
+	while (!m_Buckets[bucket]) {
+		bucket--;
+	}
+
+	return std::max(GetBucketValue(bucket), GetAvg());
+}
+
+/**
+ * @return The exact average, NaN if there are no durations
+ */
+double DurationSketch::GetAvg() const
+{
+	return m_SumMicroseconds / 1e6 / m_Count;
 }
 
 /*
@@ -8,6 +8,8 @@
 #include "base/ringbuffer.hpp"
 #include "base/dictionary.hpp"
 #include "base/array.hpp"
+#include <array>
+#include <cstdint>
 
 namespace icinga
 {
@@ -47,6 +49,52 @@ struct HostStatistics {
 	double hosts_problem;
 };
 
+/**
+ * Approximates the minimum and maximum of a set of durations which changes over time, e.g. the latencies
+ * of the last check results of all services, in a time which doesn't depend on the size of the set.
+ *
+ * The durations are counted in logarithmic buckets, each one covering a relative range of 2%.
+ * The average is calculated from the exact sum of all durations.
+ *
+ * @ingroup icinga
+ */
+class DurationSketch
+{
+public:
+	void Add(double seconds);
+	void Remove(double seconds);
+
+	uint_fast64_t GetCount() const;
+	double GetMin() const;
+	double GetMax() const;
+	double GetAvg() const;
+
+private:
+	static constexpr size_t BucketCount = 1600;
+
+	std::array<uint32_t, BucketCount> m_Buckets {};
+	int_fast64_t m_SumMicroseconds = 0;
+	uint_fast64_t m_Count = 0;
+
+	static size_t GetBucket(double seconds);
+	static double GetBucketValue(size_t bucket);
+};
+
+/**
+ * What a single checkable currently contributes to the host or service statistics.
+ *
+ * @ingroup icinga
+ */
+struct CibContribution
+{
+	uint_fast32_t Flags = 0;
+	double Latency = 0;
+	double ExecutionTime = 0;
+	uint_fast64_t Sequence = 0; // when it was evaluated, later ones win
+};
+
+class Checkable;
+
 /**
  * Common Information Base class. Holds some statistics (and will likely be
  * removed/refactored).
@@ -73,6 +121,9 @@ public:
 	static HostStatistics CalculateHostStats();
 	static ServiceStatistics CalculateServiceStats();
 
+	static void StaticInitialize();
+	static void UpdateCheckable(const intrusive_ptr<Checkable>& checkable);
+
 	static std::pair<Dictionary::Ptr, Array::Ptr> GetFeatureStats();
 
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
@@ -85,6 +136,12 @@ private:
 	static RingBuffer m_PassiveHostChecksStatistics;
 	static RingBuffer m_ActiveServiceChecksStatistics;
 	static RingBuffer m_PassiveServiceChecksStatistics;
+
+	static void InvalidateCheckable(const intrusive_ptr<Checkable>& checkable);
+	static void UpdateOutdatedCheckables();
+	static CibContribution GetContribution(const intrusive_ptr<Checkable>& checkable);
+
+	friend class Checkable;
 };
 
 }
@@ -17,6 +17,7 @@
 #include "base/initialize.hpp"
 #include "base/serializer.hpp"
 #include "base/json.hpp"
+#include <algorithm>
 #include <fstream>
 
 using namespace icinga;
@@ -24,6 +25,7 @@ using namespace icinga;
 INITIALIZE_ONCE(&ClusterEvents::StaticInitialize);
 
 REGISTER_APIFUNCTION(CheckResult, event, &ClusterEvents::CheckResultAPIHandler);
+REGISTER_APIFUNCTION(CheckResults, event, &ClusterEvents::CheckResultsAPIHandler);
 REGISTER_APIFUNCTION(SetNextCheck, event, &ClusterEvents::NextCheckChangedAPIHandler);
 REGISTER_APIFUNCTION(SetLastCheckStarted, event, &ClusterEvents::LastCheckStartedChangedAPIHandler);
 REGISTER_APIFUNCTION(SetStateBeforeSuppression, event, &ClusterEvents::StateBeforeSuppressionChangedAPIHandler);
@@ -44,6 +46,62 @@ REGISTER_APIFUNCTION(ExecutedCommand, event, &ClusterEvents::ExecutedCommandAPIH
 REGISTER_APIFUNCTION(UpdateExecutions, event, &ClusterEvents::UpdateExecutionsAPIHandler);
 REGISTER_APIFUNCTION(SetRemovalInfo, event, &ClusterEvents::SetRemovalInfoAPIHandler);
 
+thread_local ClusterEvents::CheckResultBatch *ClusterEvents::m_CurrentCheckResultBatch = nullptr;
+
+ClusterEvents::CheckResultBatch::CheckResultBatch()
+	: m_Active(!m_CurrentCheckResultBatch)
+{
+	if (m_Active) {
+		m_CurrentCheckResultBatch = this;
+	}
+}
+
+ClusterEvents::CheckResultBatch::~CheckResultBatch()
+{
+	if (!m_Active) {
+		return;
+	}
+
+	m_CurrentCheckResultBatch = nullptr;
+
+	ApiListener::Ptr listener = ApiListener::GetInstance();
+
+	if (!listener || m_Results.empty()) {
+		return;
+	}
+
+	/* Keep the order of the check results per origin and target zone. */
+	std::vector<std::pair<const Result*, ArrayData>> messages;
+
+	for (auto& result : m_Results) {
+		auto message (std::find_if(messages.begin(), messages.end(), [&result](auto& message) {
+			return message.first->Origin == result.Origin && message.first->Target == result.Target
+				&& message.second.size() < MaxResultsPerMessage;
+		}));
+
+		if (message == messages.end()) {
+			messages.emplace_back(&result, ArrayData());
+			message = messages.end() - 1;
+		}
+
+		message->second.emplace_back(result.Params);
+	}
+
+	for (auto& message : messages) {
+		Log(LogNotice, "ClusterEvents")
+			<< "Sending " << message.second.size() << " check results to zone '"
+			<< message.first->Target->GetName() << "' at once.";
+
+		listener->RelayMessage(message.first->Origin, message.first->Target, new Dictionary({
+			{ "jsonrpc", "2.0" },
+			{ "method", "event::CheckResults" },
+			{ "params", new Dictionary({
+				{ "results", new Array(std::move(message.second)) }
+			}) }
+		}), true);
+	}
+}
+
 void ClusterEvents::StaticInitialize()
 {
 	Checkable::OnNewCheckResult.connect(&ClusterEvents::CheckResultHandler);
@@ -103,7 +161,17 @@ void ClusterEvents::CheckResultHandler(const Checkable::Ptr& checkable, const Ch
 		return;
 
 	Dictionary::Ptr message = MakeCheckResultMessage(checkable, cr);
-	listener->RelayMessage(origin, checkable, message, true);
+
+	if (m_CurrentCheckResultBatch) {
+		Zone::Ptr target = static_pointer_cast<Zone>(checkable->GetZone());
+
+		if (!target)
+			target = Zone::GetLocalZone();
+
+		m_CurrentCheckResultBatch->m_Results.emplace_back(CheckResultBatch::Result{origin, target, message->Get("params")});
+	} else {
+		listener->RelayMessage(origin, checkable, message, true);
+	}
 }
 
 Value ClusterEvents::CheckResultAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
@@ -184,6 +252,35 @@ Value ClusterEvents::CheckResultAPIHandler(const MessageOrigin::Ptr& origin, con
 	return Empty;
 }
 
+/**
+ * Processes many check results, each as if it had been sent in its own event::CheckResult message.
+ */
+Value ClusterEvents::CheckResultsAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
+{
+	Array::Ptr results = params->Get("results");
+
+	if (!results)
+		return Empty;
+
+	/* Relay the check results to our other zones as batched as we received them. */
+	CheckResultBatch batch;
+
+	ObjectLock olock(results);
+	for (const Value& result : results) {
+		try {
+			Dictionary::Ptr single = result;
+
+			if (single)
+				CheckResultAPIHandler(origin, single);
+		} catch (const std::exception& ex) {
+			Log(LogWarning, "ClusterEvents")
+				<< "Error while processing check result: " << DiagnosticInformation(ex, false);
+		}
+	}
+
+	return Empty;
+}
+
 void ClusterEvents::NextCheckChangedHandler(const Checkable::Ptr& checkable, const MessageOrigin::Ptr& origin)
 {
 	ApiListener::Ptr listener = ApiListener::GetInstance();
@@ -9,6 +9,8 @@
 #include "icinga/checkcommand.hpp"
 #include "icinga/eventcommand.hpp"
 #include "icinga/notificationcommand.hpp"
+#include "remote/zone.hpp"
+#include <vector>
 
 namespace icinga
 {
@@ -19,10 +21,42 @@ namespace icinga
 class ClusterEvents
 {
 public:
+	/**
+	 * Collects the check results processed by the current thread and relays them as event::CheckResults messages
+	 * when going out of scope, e.g. while processing a batch of passive check results. Such a message carries up
+	 * to MaxResultsPerMessage check results of the same zone and is written to the replay log only once.
+	 *
+	 * Nested batches are merged into the outermost one.
+	 */
+	class CheckResultBatch
+	{
+	public:
+		static constexpr std::size_t MaxResultsPerMessage = 1000;
+
+		CheckResultBatch();
+		CheckResultBatch(const CheckResultBatch&) = delete;
+		CheckResultBatch& operator=(const CheckResultBatch&) = delete;
+		~CheckResultBatch();
+
+	private:
+		struct Result
+		{
+			MessageOrigin::Ptr Origin;
+			Zone::Ptr Target;
+			Dictionary::Ptr Params;
+		};
+
+		std::vector<Result> m_Results;
+		bool m_Active;
+
+		friend class ClusterEvents;
+	};
+
 	static void StaticInitialize();
 
 	static void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr& origin);
 	static Value CheckResultAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
+	static Value CheckResultsAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
 
 	static void NextCheckChangedHandler(const Checkable::Ptr& checkable, const MessageOrigin::Ptr& origin);
 	static Value NextCheckChangedAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
@@ -92,6 +126,7 @@ private:
 	static int m_ChecksExecutedDuringInterval;
 	static int m_ChecksDroppedDuringInterval;
 	static Timer::Ptr m_LogTimer;
+	static thread_local CheckResultBatch *m_CurrentCheckResultBatch;
 
 	static void RemoteCheckThreadProc();
 	static void EnqueueCheck(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
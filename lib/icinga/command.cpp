@@ -5,12 +5,51 @@
 #include "icinga/command-ti.cpp"
 #include "icinga/macroprocessor.hpp"
 #include "base/exception.hpp"
+#include "base/logger.hpp"
 #include "base/objectlock.hpp"
 
 using namespace icinga;
 
 REGISTER_TYPE(Command);
 
+void Command::OnAllConfigLoaded()
+{
+	ObjectImpl<Command>::OnAllConfigLoaded();
+
+	GetTemplate();
+}
+
+/**
+ * Returns the command line, arguments and env compiled for MacroProcessor::ResolveArguments().
+ *
+ * They're compiled once and again only after one of them has been replaced, e.g. via the API.
+ *
+ * @returns nullptr if they can't be compiled, the caller should fall back to the uncompiled attributes
+ */
+CommandTemplate::Ptr Command::GetTemplate()
+{
+	Value commandLine = GetCommandLine();
+	Value arguments = GetArguments();
+	Dictionary::Ptr env = GetEnv();
+
+	auto tmpl (m_Template.load());
+
+	if (!tmpl || !tmpl->IsCompiledFrom(commandLine, arguments, env)) {
+		try {
+			tmpl = new CommandTemplate(commandLine, arguments, env);
+		} catch (const std::exception& ex) {
+			Log(LogDebug, "Command")
+				<< "Can't compile command '" << GetName() << "': " << DiagnosticInformation(ex, false);
+
+			return nullptr;
+		}
+
+		m_Template.store(tmpl);
+	}
+
+	return tmpl;
+}
+
 void Command::Validate(int types, const ValidationUtils& utils)
 {
 	ObjectImpl<Command>::Validate(types, utils);
@@ -6,7 +6,9 @@
 
 #include "icinga/i2-icinga.hpp"
 #include "icinga/command-ti.hpp"
+#include "icinga/macrotemplate.hpp"
 #include "remote/messageorigin.hpp"
+#include "base/atomic.hpp"
 
 namespace icinga
 {
@@ -24,6 +26,14 @@ public:
 	//virtual Dictionary::Ptr Execute(const Object::Ptr& context) = 0;
 
 	void Validate(int types, const ValidationUtils& utils) override;
+
+	CommandTemplate::Ptr GetTemplate();
+
+protected:
+	void OnAllConfigLoaded() override;
+
+private:
+	Locked<CommandTemplate::Ptr> m_Template;
 };
 
 }
@@ -131,16 +131,9 @@ int Comment::GetNextCommentID()
 	return l_NextCommentID;
 }
 
-Comment::Ptr Comment::AddComment(const Checkable::Ptr& checkable, CommentType entryType, const String& author,
-	const String& text, bool persistent, double expireTime, bool sticky, const String& id)
+String Comment::CreateCommentConfig(const Checkable::Ptr& checkable, const String& fullName, CommentType entryType,
+	const String& author, const String& text, bool persistent, double expireTime, bool sticky)
 {
-	String fullName;
-
-	if (id.IsEmpty())
-		fullName = checkable->GetName() + "!" + Utility::NewUniqueID();
-	else
-		fullName = id;
-
 	Dictionary::Ptr attrs = new Dictionary();
 
 	attrs->Set("author", author);
@@ -164,7 +157,20 @@ Comment::Ptr Comment::AddComment(const Checkable::Ptr& checkable, CommentType en
 	if (!zone.IsEmpty())
 		attrs->Set("zone", zone);
 
-	String config = ConfigObjectUtility::CreateObjectConfig(Comment::TypeInstance, fullName, true, nullptr, attrs);
+	return ConfigObjectUtility::CreateObjectConfig(Comment::TypeInstance, fullName, true, nullptr, attrs);
+}
+
+Comment::Ptr Comment::AddComment(const Checkable::Ptr& checkable, CommentType entryType, const String& author,
+	const String& text, bool persistent, double expireTime, bool sticky, const String& id)
+{
+	String fullName;
+
+	if (id.IsEmpty())
+		fullName = checkable->GetName() + "!" + Utility::NewUniqueID();
+	else
+		fullName = id;
+
+	String config = CreateCommentConfig(checkable, fullName, entryType, author, text, persistent, expireTime, sticky);
 
 	Array::Ptr errors = new Array();
 
@@ -188,6 +194,54 @@ Comment::Ptr Comment::AddComment(const Checkable::Ptr& checkable, CommentType en
 	return comment;
 }
 
+/**
+ * Adds the same comment to many checkables in a single activation, e.g. the acknowledgements of a whole host group.
+ *
+ * Either all of the comments are added, or none of them is.
+ *
+ * @return The added comments, in the same order as the checkables
+ */
+std::vector<Comment::Ptr> Comment::AddComments(const std::vector<Checkable::Ptr>& checkables, CommentType entryType,
+	const String& author, const String& text, bool persistent, double expireTime, bool sticky)
+{
+	std::vector<std::pair<String, String>> configs;
+	configs.reserve(checkables.size());
+
+	for (auto& checkable : checkables) {
+		String fullName = checkable->GetName() + "!" + Utility::NewUniqueID();
+
+		configs.emplace_back(fullName, CreateCommentConfig(checkable, fullName, entryType, author, text, persistent, expireTime, sticky));
+	}
+
+	Array::Ptr errors = new Array();
+
+	if (!ConfigObjectUtility::CreateObjects(Comment::TypeInstance, configs, errors, nullptr)) {
+		ObjectLock olock(errors);
+		for (String error : errors) {
+			Log(LogCritical, "Comment", error);
+		}
+
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not create comments."));
+	}
+
+	std::vector<Comment::Ptr> comments;
+	comments.reserve(configs.size());
+
+	for (auto& config : configs) {
+		Comment::Ptr comment = Comment::GetByName(config.first);
+
+		if (!comment)
+			BOOST_THROW_EXCEPTION(std::runtime_error("Could not create comment '" + config.first + "'."));
+
+		comments.emplace_back(std::move(comment));
+	}
+
+	Log(LogNotice, "Comment")
+		<< "Added " << comments.size() << " comments.";
+
+	return comments;
+}
+
 void Comment::RemoveComment(const String& id, bool removedManually, const String& removedBy)
 {
 	Comment::Ptr comment = Comment::GetByName(id);
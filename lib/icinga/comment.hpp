@@ -8,6 +8,7 @@
 #include "icinga/comment-ti.hpp"
 #include "icinga/checkable-ti.hpp"
 #include "remote/messageorigin.hpp"
+#include <vector>
 
 namespace icinga
 {
@@ -39,6 +40,9 @@ public:
 		const String& author, const String& text, bool persistent, double expireTime, bool sticky = false,
 		const String& id = String());
 
+	static std::vector<Ptr> AddComments(const std::vector<intrusive_ptr<Checkable>>& checkables, CommentType entryType,
+		const String& author, const String& text, bool persistent, double expireTime, bool sticky = false);
+
 	static void RemoveComment(const String& id, bool removedManually = false, const String& removedBy = "");
 
 	static String GetCommentIDFromLegacyID(int id);
@@ -52,6 +56,9 @@ private:
 	ObjectImpl<Checkable>::Ptr m_Checkable;
 
 	static void CommentsExpireTimerHandler();
+
+	static String CreateCommentConfig(const intrusive_ptr<Checkable>& checkable, const String& fullName,
+		CommentType entryType, const String& author, const String& text, bool persistent, double expireTime, bool sticky);
 };
 
 }
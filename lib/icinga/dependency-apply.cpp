@@ -135,7 +135,7 @@ void Dependency::EvaluateApplyRules(const Host::Ptr& host)
 {
 	CONTEXT("Evaluating 'apply' rules for host '" << host->GetName() << "'");
 
-	for (auto& rule : ApplyRule::GetRules(Dependency::TypeInstance, Host::TypeInstance)) {
+	for (auto& rule : ApplyRule::GetCandidateRules(Dependency::TypeInstance, Host::TypeInstance, host)) {
 		if (EvaluateApplyRule(host, *rule))
 			rule->AddMatch();
 	}
@@ -150,7 +150,7 @@ void Dependency::EvaluateApplyRules(const Service::Ptr& service)
 {
 	CONTEXT("Evaluating 'apply' rules for service '" << service->GetName() << "'");
 
-	for (auto& rule : ApplyRule::GetRules(Dependency::TypeInstance, Service::TypeInstance)) {
+	for (auto& rule : ApplyRule::GetCandidateRules(Dependency::TypeInstance, Service::TypeInstance, service)) {
 		if (EvaluateApplyRule(service, *rule))
 			rule->AddMatch();
 	}
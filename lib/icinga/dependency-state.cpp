@@ -7,13 +7,27 @@
 
 using namespace icinga;
 
+/* Each DependencyType takes two bits of Checkable#m_Reachability: valid and reachable. */
+static constexpr unsigned int l_GenerationShift = 8;
+
+static constexpr uint64_t GetValidFlag(DependencyType dt)
+{
+	return uint64_t(1) << (2 * dt);
+}
+
+static constexpr uint64_t GetReachableFlag(DependencyType dt)
+{
+	return uint64_t(1) << (2 * dt + 1);
+}
+
 /**
  * Construct a helper for evaluating the state of dependencies.
  *
  * @param dt Dependency type to check for within the individual methods.
+ * @param materialized Whether to use and update the reachability materialized in the checkables.
  */
-DependencyStateChecker::DependencyStateChecker(DependencyType dt)
-	: m_DependencyType(dt)
+DependencyStateChecker::DependencyStateChecker(DependencyType dt, bool materialized)
+	: m_DependencyType(dt), m_Materialized(materialized)
 {
 }
 
@@ -26,19 +40,70 @@ DependencyStateChecker::DependencyStateChecker(DependencyType dt)
  */
 bool DependencyStateChecker::IsReachable(Checkable::ConstPtr checkable, int rstack)
 {
+	uint64_t materialized = 0;
+
+	// Reading the materialized reachability is the fast path, it doesn't even need an entry in m_Cache.
+	if (m_Materialized) {
+		materialized = checkable->m_Reachability.load();
+
+		if (materialized & GetValidFlag(m_DependencyType)) {
+			return materialized & GetReachableFlag(m_DependencyType);
+		}
+	}
+
 	// If the reachability of this checkable was already computed, return it directly. Otherwise, already create a
-	// temporary map entry that says that this checkable is unreachable so that the different cases returning false
-	// don't have to deal with updating the cache, but only the final return true does. Cyclic dependencies are invalid,
-	// hence recursive calls won't access the potentially not yet correct cached value.
-	if (auto [it, inserted] = m_Cache.insert({checkable, false}); !inserted) {
-		return it->second;
+	// temporary map entry that says that this checkable is unreachable, which is replaced once it has been evaluated.
+	// Cyclic dependencies are invalid, hence recursive calls won't access the potentially not yet correct cached value.
+	if (auto [it, inserted] = m_Cache.insert({checkable, {false, false}}); !inserted) {
+		m_Volatile = m_Volatile || it->second.Volatile;
+		return it->second.Reachable;
 	}
 
+	bool outerVolatile = m_Volatile;
+	m_Volatile = false;
+
+	bool reachable = EvaluateReachability(checkable, rstack);
+	bool isVolatile = m_Volatile;
+
+	m_Volatile = outerVolatile || isVolatile;
+
+	// Note: This must do the map lookup again. The iterator from above must not be used as a m_Cache.insert() inside a
+	// recursive may have invalidated it.
+	m_Cache[checkable] = {reachable, isVolatile};
+
+	// Change signals are only emitted for active objects, so only their reachability can be kept up to date.
+	if (m_Materialized && !isVolatile && checkable->IsActive()) {
+		auto flags (GetValidFlag(m_DependencyType) | (reachable ? GetReachableFlag(m_DependencyType) : 0));
+		auto generation (materialized >> l_GenerationShift);
+
+		// If the checkable has been invalidated meanwhile, the result may be based on outdated states already.
+		// Otherwise, the only concurrent changes are other threads materializing other dependency types.
+		while (!checkable->m_Reachability.compare_exchange_weak(materialized, materialized | flags)) {
+			if ((materialized >> l_GenerationShift) != generation) {
+				break;
+			}
+		}
+	}
+
+	return reachable;
+}
+
+/**
+ * Evaluates the reachability of the given checkable from the state of its parents.
+ *
+ * @param checkable The checkable to check reachability for.
+ * @param rstack The recursion stack level to prevent infinite recursion.
+ * @return Whether the given checkable is reachable.
+ */
+bool DependencyStateChecker::EvaluateReachability(const Checkable::ConstPtr& checkable, int rstack)
+{
 	if (rstack > Dependency::MaxDependencyRecursionLevel) {
 		Log(LogWarning, "Checkable")
 			<< "Too many nested dependencies (>" << Dependency::MaxDependencyRecursionLevel << ") for checkable '"
 			<< checkable->GetName() << "': Dependency failed.";
 
+		// Don't materialize this, the checkable may well be reachable when evaluated from a lower level.
+		m_Volatile = true;
 		return false;
 	}
 
@@ -62,12 +127,33 @@ bool DependencyStateChecker::IsReachable(Checkable::ConstPtr checkable, int rsta
 		}
 	}
 
-	// Note: This must do the map lookup again. The iterator from above must not be used as a m_Cache.insert() inside a
-	// recursive may have invalidated it.
-	m_Cache[checkable] = true;
 	return true;
 }
 
+/**
+ * Marks the materialized reachability of the given checkable as outdated.
+ *
+ * This doesn't affect any other checkable, see Checkable::InvalidateReachability() for that.
+ *
+ * @param checkable The checkable to invalidate.
+ */
+void DependencyStateChecker::Invalidate(const Checkable* checkable)
+{
+	auto value (checkable->m_Reachability.load());
+
+	// Clearing the flags and bumping the generation at once makes concurrent evaluations discard their results.
+	while (!checkable->m_Reachability.compare_exchange_weak(value, ((value >> l_GenerationShift) + 1) << l_GenerationShift)) {
+	}
+}
+
+/**
+ * @return How often the materialized reachability of the given checkable has been invalidated
+ */
+uint64_t DependencyStateChecker::GetGeneration(const Checkable* checkable)
+{
+	return checkable->m_Reachability.load() >> l_GenerationShift;
+}
+
 /**
  * Retrieve the state of the given dependency group.
  *
@@ -93,6 +179,11 @@ DependencyGroup::State DependencyStateChecker::GetState(const DependencyGroup::C
 		if (IsReachable(dependency->GetParent(), rstack)) {
 			reachable++;
 
+			// Whether the dependency is available changes with its time period, i.e. over time.
+			if (dependency->GetPeriod()) {
+				m_Volatile = true;
+			}
+
 			// Only reachable parents are considered for availability. If they are unreachable and checks are
 			// disabled, they could be incorrectly treated as available otherwise.
 			if (dependency->IsAvailable(m_DependencyType)) {
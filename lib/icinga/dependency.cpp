@@ -23,6 +23,15 @@ INITIALIZE_ONCE(&Dependency::StaticInitialize);
 void Dependency::StaticInitialize()
 {
 	ConfigType::Get<Dependency>()->BeforeOnAllConfigLoaded.connect(&BeforeOnAllConfigLoadedHandler);
+
+	auto invalidateChild = [](const Dependency::Ptr& dependency, const Value&) {
+		if (auto child (dependency->GetChild()); child) {
+			child->InvalidateReachability();
+		}
+	};
+
+	OnDisableChecksChanged.connect(invalidateChild);
+	OnDisableNotificationsChanged.connect(invalidateChild);
 }
 
 /**
@@ -241,18 +241,38 @@ private:
  * (otherwise, evaluating the state of the same checkable multiple times can result in exponential
  * worst-case complexity). Because of this cached information is not invalidated, the object is
  * intended to be short-lived.
+ *
+ * Additionally, the reachability of active checkables is materialized in the checkables themselves,
+ * so that most evaluations stop at the first parent (or even the checkable itself) instead of
+ * walking up to the roots of the graph. Whenever something the reachability depends on changes,
+ * Checkable::InvalidateReachability() marks the materialized results of the affected checkable
+ * and everything below it as outdated, and they're evaluated again on their next use. Results
+ * which depend on the current time, i.e. on a dependency's time period, aren't materialized.
  */
 class DependencyStateChecker
 {
 public:
-	explicit DependencyStateChecker(DependencyType dt);
+	explicit DependencyStateChecker(DependencyType dt, bool materialized = true);
 
 	bool IsReachable(Checkable::ConstPtr checkable, int rstack = 0);
 	DependencyGroup::State GetState(const DependencyGroup::ConstPtr& group, const Checkable* child, int rstack = 0);
 
+	static void Invalidate(const Checkable* checkable);
+	static uint64_t GetGeneration(const Checkable* checkable);
+
 private:
+	struct CacheEntry
+	{
+		bool Reachable;
+		bool Volatile; // Whether this depends on the current time and must not be materialized.
+	};
+
 	DependencyType m_DependencyType;
-	std::unordered_map<Checkable::ConstPtr, bool> m_Cache;
+	bool m_Materialized;
+	bool m_Volatile{false};
+	std::unordered_map<Checkable::ConstPtr, CacheEntry> m_Cache;
+
+	bool EvaluateReachability(const Checkable::ConstPtr& checkable, int rstack);
 };
 
 }
@@ -3,10 +3,12 @@
 
 #include "icinga/downtime.hpp"
 #include "icinga/downtime-ti.cpp"
+#include "icinga/downtimescheduler.hpp"
 #include "icinga/host.hpp"
 #include "icinga/scheduleddowntime.hpp"
 #include "remote/configobjectutility.hpp"
 #include "base/configtype.hpp"
+#include "base/exception.hpp"
 #include "base/utility.hpp"
 #include "base/timer.hpp"
 #include <boost/thread/once.hpp>
@@ -19,7 +21,7 @@ static int l_NextDowntimeID = 1;
 static std::mutex l_DowntimeMutex;
 static std::map<int, Downtime::Ptr> l_LegacyDowntimesCache;
 static Timer::Ptr l_DowntimesOrphanedTimer;
-static Timer::Ptr l_DowntimesStartTimer;
+static Timer::Ptr l_DowntimesEventTimer;
 
 boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeAdded;
 boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeRemoved;
@@ -95,10 +97,25 @@ void Downtime::Start(bool runtimeCreated)
 	static boost::once_flag once = BOOST_ONCE_INIT;
 
 	boost::call_once(once, [] {
-		l_DowntimesStartTimer = Timer::Create();
-		l_DowntimesStartTimer->SetInterval(5);
-		l_DowntimesStartTimer->OnTimerExpired.connect([](const Timer * const&){ DowntimesStartTimerHandler(); });
-		l_DowntimesStartTimer->Start();
+		l_DowntimesEventTimer = Timer::Create();
+		l_DowntimesEventTimer->SetInterval(1);
+		l_DowntimesEventTimer->OnTimerExpired.connect([](const Timer * const&){ DowntimesEventTimerHandler(); });
+		l_DowntimesEventTimer->Start();
+
+		/* The events depend on these, e.g. if a downtime has been modified via the API. */
+		auto reschedule ([](const Downtime::Ptr& downtime, const Value&) {
+			if (downtime->IsActive()) {
+				downtime->ScheduleStart();
+
+				if (!downtime->IsPaused())
+					downtime->ScheduleExpiry();
+			}
+		});
+
+		OnFixedChanged.connect(reschedule);
+		OnStartTimeChanged.connect(reschedule);
+		OnEndTimeChanged.connect(reschedule);
+		OnDurationChanged.connect(reschedule);
 
 		l_DowntimesOrphanedTimer = Timer::Create();
 		l_DowntimesOrphanedTimer->SetInterval(60);
@@ -144,6 +161,8 @@ void Downtime::Start(bool runtimeCreated)
 
 		/* Trigger fixed downtime immediately. */
 		TriggerDowntime(std::fmax(GetStartTime(), GetEntryTime()));
+	} else {
+		ScheduleStart();
 	}
 }
 
@@ -165,14 +184,14 @@ void Downtime::Stop(bool runtimeRemoved)
 	if (runtimeRemoved)
 		OnDowntimeRemoved(this);
 
+	DowntimeScheduler::GetInstance().Unschedule(this);
+
 	ObjectImpl<Downtime>::Stop(runtimeRemoved);
 }
 
 void Downtime::Pause()
 {
-	if (m_CleanupTimer) {
-		m_CleanupTimer->Stop();
-	}
+	DowntimeScheduler::GetInstance().Unschedule(this, DowntimeEventType::Expire);
 
 	ObjectImpl<Downtime>::Pause();
 }
@@ -180,7 +199,7 @@ void Downtime::Pause()
 void Downtime::Resume()
 {
 	ObjectImpl<Downtime>::Resume();
-	SetupCleanupTimer();
+	ScheduleExpiry();
 }
 
 Checkable::Ptr Downtime::GetCheckable() const
@@ -250,24 +269,19 @@ int Downtime::GetNextDowntimeID()
 	return l_NextDowntimeID;
 }
 
-Downtime::Ptr Downtime::AddDowntime(const Checkable::Ptr& checkable, const String& author,
-	const String& comment, double startTime, double endTime, bool fixed,
-	const Downtime::Ptr& parentDowntime, double duration,
-	const String& scheduledDowntime, const String& scheduledBy, const String& parent,
-	const String& id)
+/**
+ * @return A new unique name for a downtime of the given checkable
+ */
+String Downtime::NewDowntimeName(const Checkable::Ptr& checkable)
 {
-	String fullName;
-	String triggeredBy;
-
-	if (id.IsEmpty())
-		fullName = checkable->GetName() + "!" + Utility::NewUniqueID();
-	else
-		fullName = id;
-
-	if (parentDowntime) {
-		triggeredBy = parentDowntime->GetName();
-	}
+	return checkable->GetName() + "!" + Utility::NewUniqueID();
+}
 
+String Downtime::CreateDowntimeConfig(const Checkable::Ptr& checkable, const String& fullName,
+	const String& author, const String& comment, double startTime, double endTime, bool fixed,
+	const String& triggeredBy, double duration, const String& scheduledDowntime,
+	const String& scheduledBy, const String& parent)
+{
 	Dictionary::Ptr attrs = new Dictionary();
 
 	attrs->Set("author", author);
@@ -325,7 +339,29 @@ Downtime::Ptr Downtime::AddDowntime(const Checkable::Ptr& checkable, const Strin
 	if (!zone.IsEmpty())
 		attrs->Set("zone", zone);
 
-	String config = ConfigObjectUtility::CreateObjectConfig(Downtime::TypeInstance, fullName, true, nullptr, attrs);
+	return ConfigObjectUtility::CreateObjectConfig(Downtime::TypeInstance, fullName, true, nullptr, attrs);
+}
+
+Downtime::Ptr Downtime::AddDowntime(const Checkable::Ptr& checkable, const String& author,
+	const String& comment, double startTime, double endTime, bool fixed,
+	const Downtime::Ptr& parentDowntime, double duration,
+	const String& scheduledDowntime, const String& scheduledBy, const String& parent,
+	const String& id)
+{
+	String fullName;
+	String triggeredBy;
+
+	if (id.IsEmpty())
+		fullName = NewDowntimeName(checkable);
+	else
+		fullName = id;
+
+	if (parentDowntime) {
+		triggeredBy = parentDowntime->GetName();
+	}
+
+	String config = CreateDowntimeConfig(checkable, fullName, author, comment, startTime, endTime, fixed,
+		triggeredBy, duration, scheduledDowntime, scheduledBy, parent);
 
 	Array::Ptr errors = new Array();
 
@@ -360,6 +396,69 @@ Downtime::Ptr Downtime::AddDowntime(const Checkable::Ptr& checkable, const Strin
 	return downtime;
 }
 
+/**
+ * Adds the downtimes of many checkables in a single activation, e.g. for all services of a host group.
+ *
+ * The downtimes may be triggered by or be children of each other, the targets only have to be named upfront.
+ * Either all of the downtimes are added, or none of them is.
+ *
+ * @return The added downtimes, in the same order as the targets
+ */
+std::vector<Downtime::Ptr> Downtime::AddDowntimes(const std::vector<DowntimeTarget>& targets, const String& author,
+	const String& comment, double startTime, double endTime, bool fixed, double duration)
+{
+	std::vector<std::pair<String, String>> configs;
+	configs.reserve(targets.size());
+
+	for (auto& target : targets) {
+		configs.emplace_back(target.Name, CreateDowntimeConfig(target.Object, target.Name, author, comment,
+			startTime, endTime, fixed, target.TriggeredBy, duration, String(), String(), target.Parent));
+	}
+
+	Array::Ptr errors = new Array();
+
+	if (!ConfigObjectUtility::CreateObjects(Downtime::TypeInstance, configs, errors, nullptr)) {
+		ObjectLock olock(errors);
+		for (String error : errors) {
+			Log(LogCritical, "Downtime", error);
+		}
+
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not create downtimes."));
+	}
+
+	std::vector<Downtime::Ptr> downtimes;
+	downtimes.reserve(targets.size());
+
+	for (auto& target : targets) {
+		if (!target.TriggeredBy.IsEmpty()) {
+			Downtime::Ptr trigger = Downtime::GetByName(target.TriggeredBy);
+
+			if (trigger) {
+				Array::Ptr triggers = trigger->GetTriggers();
+
+				ObjectLock olock(triggers);
+				if (!triggers->Contains(target.Name))
+					triggers->Add(target.Name);
+			}
+		}
+
+		Downtime::Ptr downtime = Downtime::GetByName(target.Name);
+
+		if (!downtime)
+			BOOST_THROW_EXCEPTION(std::runtime_error("Could not create downtime object '" + target.Name + "'."));
+
+		downtimes.emplace_back(std::move(downtime));
+	}
+
+	Log(LogInformation, "Downtime")
+		<< "Added " << downtimes.size() << " downtimes between '"
+		<< Utility::FormatDateTime("%Y-%m-%d %H:%M:%S", startTime)
+		<< "' and '" << Utility::FormatDateTime("%Y-%m-%d %H:%M:%S", endTime) << "', author: '"
+		<< author << "', " << (fixed ? "fixed" : "flexible with " + Convert::ToString(duration) + "s duration");
+
+	return downtimes;
+}
+
 void Downtime::RemoveDowntime(const String& id, bool includeChildren, DowntimeRemovalReason removalReason,
 	const String& removedBy)
 {
@@ -461,26 +560,29 @@ bool Downtime::CanBeTriggered()
 	return true;
 }
 
-void Downtime::SetupCleanupTimer()
+/**
+ * Schedules a fixed downtime which hasn't been triggered yet to be started and triggered at its start time.
+ */
+void Downtime::ScheduleStart()
 {
-	if (!m_CleanupTimer) {
-		m_CleanupTimer = Timer::Create();
-
-		auto name (GetName());
+	auto& scheduler (DowntimeScheduler::GetInstance());
 
-		m_CleanupTimer->OnTimerExpired.connect([name=std::move(name)](const Timer * const&) {
-			auto downtime (Downtime::GetByName(name));
-
-			if (downtime && downtime->IsExpired()) {
-				RemoveDowntime(name, false, DowntimeExpired);
-			}
-		});
+	if (GetFixed() && GetTriggerTime() <= 0 && GetEndTime() > Utility::GetTime()) {
+		scheduler.Schedule(this, DowntimeEventType::Start, GetStartTime());
+	} else {
+		scheduler.Unschedule(this, DowntimeEventType::Start);
 	}
+}
 
+/**
+ * Schedules the downtime to be removed once it has expired.
+ */
+void Downtime::ScheduleExpiry()
+{
 	auto triggerTime (GetTriggerTime());
 
-	m_CleanupTimer->Reschedule((GetFixed() || triggerTime <= 0 ? GetEndTime() : triggerTime + GetDuration()) + 0.1);
-	m_CleanupTimer->Start();
+	DowntimeScheduler::GetInstance().Schedule(this, DowntimeEventType::Expire,
+		(GetFixed() || triggerTime <= 0 ? GetEndTime() : triggerTime + GetDuration()) + 0.1);
 }
 
 void Downtime::TriggerDowntime(double triggerTime)
@@ -497,10 +599,7 @@ void Downtime::TriggerDowntime(double triggerTime)
 		SetTriggerTime(triggerTime);
 	}
 
-	{
-		ObjectLock olock (this);
-		SetupCleanupTimer();
-	}
+	ScheduleExpiry();
 
 	Array::Ptr triggers = GetTriggers();
 
@@ -543,18 +642,45 @@ Downtime::Ptr Downtime::GetDowntimeFromLegacyID(int id)
 	return it->second;
 }
 
-void Downtime::DowntimesStartTimerHandler()
+void Downtime::DowntimesEventTimerHandler()
 {
-	/* Start fixed downtimes. Flexible downtimes will be triggered on-demand. */
-	for (const Downtime::Ptr& downtime : ConfigType::GetObjectsByType<Downtime>()) {
-		if (downtime->IsActive() &&
-			downtime->CanBeTriggered() &&
-			downtime->GetFixed()) {
-			/* Send notifications. */
-			OnDowntimeStarted(downtime);
-
-			/* Trigger fixed downtime immediately. */
-			downtime->TriggerDowntime(std::fmax(downtime->GetStartTime(), downtime->GetEntryTime()));
+	double now = Utility::GetTime();
+
+	for (auto& event : DowntimeScheduler::GetInstance().PopDue(now)) {
+		auto& downtime (event.Object);
+
+		if (!downtime->IsActive())
+			continue;
+
+		try {
+			switch (event.Type) {
+				case DowntimeEventType::Start:
+					/* Start fixed downtimes. Flexible downtimes will be triggered on-demand. */
+					if (downtime->CanBeTriggered() && downtime->GetFixed()) {
+						/* Send notifications. */
+						OnDowntimeStarted(downtime);
+
+						/* Trigger fixed downtime immediately. */
+						downtime->TriggerDowntime(std::fmax(downtime->GetStartTime(), downtime->GetEntryTime()));
+					} else {
+						/* E.g. the start time has been changed in the meantime. */
+						downtime->ScheduleStart();
+					}
+
+					break;
+				case DowntimeEventType::Expire:
+					if (downtime->IsExpired()) {
+						RemoveDowntime(downtime->GetName(), false, DowntimeExpired);
+					} else if (!downtime->IsPaused()) {
+						downtime->ScheduleExpiry();
+					}
+
+					break;
+			}
+		} catch (const std::exception& ex) {
+			Log(LogCritical, "Downtime")
+				<< "Exception occurred while processing downtime '" << downtime->GetName() << "': "
+				<< DiagnosticInformation(ex, false);
 		}
 	}
 }
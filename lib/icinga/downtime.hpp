@@ -8,6 +8,7 @@
 #include "icinga/downtime-ti.hpp"
 #include "icinga/checkable-ti.hpp"
 #include "remote/messageorigin.hpp"
+#include <vector>
 
 namespace icinga
 {
@@ -26,6 +27,19 @@ enum DowntimeRemovalReason
 	DowntimeRemovedByConfigOwner,
 };
 
+/**
+ * One of the downtimes added at once by Downtime::AddDowntimes().
+ *
+ * @ingroup icinga
+ */
+struct DowntimeTarget
+{
+	intrusive_ptr<Checkable> Object;
+	String Name; // see Downtime::NewDowntimeName()
+	String TriggeredBy;
+	String Parent;
+};
+
 /**
  * A downtime.
  *
@@ -59,6 +73,11 @@ public:
 		const Ptr& parentDowntime, double duration, const String& scheduledDowntime = String(),
 		const String& scheduledBy = String(), const String& parent = String(), const String& id = String());
 
+	static std::vector<Ptr> AddDowntimes(const std::vector<DowntimeTarget>& targets, const String& author,
+		const String& comment, double startTime, double endTime, bool fixed, double duration);
+
+	static String NewDowntimeName(const intrusive_ptr<Checkable>& checkable);
+
 	static void RemoveDowntime(const String& id, bool includeChildren, DowntimeRemovalReason removalReason,
 		const String& removedBy = "");
 
@@ -91,13 +110,17 @@ private:
 	std::set<Downtime::Ptr> m_Children;
 	mutable std::mutex m_ChildrenMutex;
 
-	Timer::Ptr m_CleanupTimer;
-
 	bool CanBeTriggered();
 
-	void SetupCleanupTimer();
+	static String CreateDowntimeConfig(const intrusive_ptr<Checkable>& checkable, const String& fullName,
+		const String& author, const String& comment, double startTime, double endTime, bool fixed,
+		const String& triggeredBy, double duration, const String& scheduledDowntime,
+		const String& scheduledBy, const String& parent);
+
+	void ScheduleStart();
+	void ScheduleExpiry();
 
-	static void DowntimesStartTimerHandler();
+	static void DowntimesEventTimerHandler();
 	static void DowntimesOrphanedTimerHandler();
 };
 
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/downtimescheduler.hpp"
+#include <algorithm>
+#include <utility>
+
+using namespace icinga;
+
+thread_local DowntimeScheduler::Batch *DowntimeScheduler::m_CurrentBatch = nullptr;
+
+DowntimeScheduler::Batch::Batch(DowntimeScheduler& scheduler)
+	: m_Scheduler(scheduler), m_Active(!m_CurrentBatch)
+{
+	if (m_Active) {
+		m_CurrentBatch = this;
+	}
+}
+
+DowntimeScheduler::Batch::~Batch()
+{
+	if (!m_Active) {
+		return;
+	}
+
+	m_CurrentBatch = nullptr;
+
+	std::unique_lock<std::mutex> lock (m_Scheduler.m_Mutex);
+
+	for (auto& event : m_Events) {
+		m_Scheduler.ScheduleUnlocked(std::move(event));
+	}
+}
+
+/**
+ * @return The scheduler of all downtimes
+ */
+DowntimeScheduler& DowntimeScheduler::GetInstance()
+{
+	static DowntimeScheduler scheduler;
+
+	return scheduler;
+}
+
+/**
+ * @return The current thread's batch for this scheduler, if any
+ */
+DowntimeScheduler::Batch *DowntimeScheduler::GetBatch()
+{
+	return m_CurrentBatch && &m_CurrentBatch->m_Scheduler == this ? m_CurrentBatch : nullptr;
+}
+
+/**
+ * Schedules an event of the given downtime, replacing its previous event of that type.
+ *
+ * @param due When the event is due, as a UNIX timestamp
+ */
+void DowntimeScheduler::Schedule(const Downtime::Ptr& downtime, DowntimeEventType type, double due)
+{
+	if (auto batch (GetBatch()); batch) {
+		batch->m_Events.emplace_back(Event{downtime, type, due});
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock (m_Mutex);
+	ScheduleUnlocked(Event{downtime, type, due});
+}
+
+void DowntimeScheduler::ScheduleUnlocked(Event event)
+{
+	auto& idx (m_Events.get<0>());
+	auto it (idx.find(boost::make_tuple(event.Object, event.Type)));
+
+	if (it == idx.end()) {
+		idx.insert(std::move(event));
+	} else {
+		idx.modify(it, [due = event.Due](Event& e) { e.Due = due; });
+	}
+}
+
+void DowntimeScheduler::Unschedule(const Downtime::Ptr& downtime, DowntimeEventType type)
+{
+	if (auto batch (GetBatch()); batch) {
+		auto& events (batch->m_Events);
+
+		events.erase(std::remove_if(events.begin(), events.end(), [&downtime, type](const Event& e) {
+			return e.Object == downtime && e.Type == type;
+		}), events.end());
+	}
+
+	std::unique_lock<std::mutex> lock (m_Mutex);
+	auto& idx (m_Events.get<0>());
+	auto it (idx.find(boost::make_tuple(downtime, type)));
+
+	if (it != idx.end()) {
+		idx.erase(it);
+	}
+}
+
+/**
+ * Removes all events of the given downtime.
+ */
+void DowntimeScheduler::Unschedule(const Downtime::Ptr& downtime)
+{
+	Unschedule(downtime, DowntimeEventType::Start);
+	Unschedule(downtime, DowntimeEventType::Expire);
+}
+
+/**
+ * Removes all events which are due.
+ *
+ * @return The due events, the oldest first
+ */
+std::vector<DowntimeScheduler::Event> DowntimeScheduler::PopDue(double now)
+{
+	std::vector<Event> due;
+
+	std::unique_lock<std::mutex> lock (m_Mutex);
+	auto& idx (m_Events.get<1>());
+	auto end (idx.upper_bound(now));
+
+	due.assign(idx.begin(), end);
+	idx.erase(idx.begin(), end);
+
+	return due;
+}
+
+/**
+ * @return When the next event is due or 0 if there are no events
+ */
+double DowntimeScheduler::GetNextDue()
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+	auto& idx (m_Events.get<1>());
+
+	return idx.empty() ? 0 : idx.begin()->Due;
+}
+
+size_t DowntimeScheduler::GetSize()
+{
+	std::unique_lock<std::mutex> lock (m_Mutex);
+
+	return m_Events.size();
+}
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DOWNTIMESCHEDULER_H
+#define DOWNTIMESCHEDULER_H
+
+#include "icinga/i2-icinga.hpp"
+#include "icinga/downtime.hpp"
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/key_extractors.hpp>
+#include <mutex>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * @ingroup icinga
+ */
+enum class DowntimeEventType
+{
+	Start, // A fixed downtime starts and is triggered
+	Expire // A downtime is over and removed
+};
+
+/**
+ * The pending start and expiry events of all downtimes, ordered by when they're due.
+ *
+ * This replaces a timer per downtime and the periodic scans over all downtimes by a single
+ * queue, which is polled by a single timer. Each downtime has at most one event of each type.
+ *
+ * @ingroup icinga
+ */
+class DowntimeScheduler
+{
+public:
+	struct Event
+	{
+		Downtime::Ptr Object;
+		DowntimeEventType Type;
+		double Due;
+	};
+
+	/**
+	 * Collects the events scheduled by the current thread and adds them all at once when going out of scope,
+	 * e.g. while a scheduled downtime creates the downtimes of all of its children.
+	 *
+	 * Nested batches are merged into the outermost one.
+	 */
+	class Batch
+	{
+	public:
+		explicit Batch(DowntimeScheduler& scheduler);
+		Batch(const Batch&) = delete;
+		Batch& operator=(const Batch&) = delete;
+		~Batch();
+
+	private:
+		DowntimeScheduler& m_Scheduler;
+		std::vector<Event> m_Events;
+		bool m_Active;
+
+		friend class DowntimeScheduler;
+	};
+
+	typedef boost::multi_index_container<
+		Event,
+		boost::multi_index::indexed_by<
+			boost::multi_index::ordered_unique<
+				boost::multi_index::composite_key<
+					Event,
+					boost::multi_index::member<Event, Downtime::Ptr, &Event::Object>,
+					boost::multi_index::member<Event, DowntimeEventType, &Event::Type>
+				>
+			>,
+			boost::multi_index::ordered_non_unique<boost::multi_index::member<Event, double, &Event::Due> >
+		>
+	> EventSet;
+
+	static DowntimeScheduler& GetInstance();
+
+	void Schedule(const Downtime::Ptr& downtime, DowntimeEventType type, double due);
+	void Unschedule(const Downtime::Ptr& downtime, DowntimeEventType type);
+	void Unschedule(const Downtime::Ptr& downtime);
+
+	std::vector<Event> PopDue(double now);
+
+	double GetNextDue();
+	size_t GetSize();
+
+private:
+	std::mutex m_Mutex;
+	EventSet m_Events;
+
+	static thread_local Batch *m_CurrentBatch;
+
+	Batch *GetBatch();
+
+	void ScheduleUnlocked(Event event);
+};
+
+}
+
+#endif /* DOWNTIMESCHEDULER_H */
@@ -28,10 +28,15 @@ using namespace icinga;
 
 boost::signals2::signal<void(double, const String&, const std::vector<String>&)> ExternalCommandProcessor::OnNewExternalCommand;
 
-void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, const String& line)
+/**
+ * Splits a command line into its timestamp, name and arguments.
+ *
+ * @return false if the line is empty
+ */
+bool ExternalCommandProcessor::ParseLine(const String& line, double& time, String& command, std::vector<String>& arguments)
 {
 	if (line.IsEmpty())
-		return;
+		return false;
 
 	if (line[0] != '[')
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing timestamp in command: " + line));
@@ -44,9 +49,9 @@ void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, const Str
 	String timestamp = line.SubStr(1, pos - 1);
 	String args = line.SubStr(pos + 2, String::NPos);
 
-	double ts = Convert::ToDouble(timestamp);
+	time = Convert::ToDouble(timestamp);
 
-	if (ts == 0)
+	if (time == 0)
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid timestamp in command: " + line));
 
 	std::vector<String> argv = args.Split(";");
@@ -54,11 +59,111 @@ void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, const Str
 	if (argv.empty())
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing arguments in command: " + line));
 
-	std::vector<String> argvExtra(argv.begin() + 1, argv.end());
-	Execute(producer, ts, argv[0], argvExtra);
+	command = argv[0];
+	arguments.assign(argv.begin() + 1, argv.end());
+
+	return true;
 }
 
-void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, double time, const String& command, const std::vector<String>& arguments)
+void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, const String& line)
+{
+	double ts;
+	String command;
+	std::vector<String> arguments;
+
+	if (ParseLine(line, ts, command, arguments))
+		Execute(producer, ts, command, arguments);
+}
+
+/**
+ * Executes many command lines, e.g. all of the ones read from the command pipe at once.
+ *
+ * Consecutive passive check results are processed in parallel by Checkable::ProcessCheckResults(),
+ * all other commands one after another in the given order. Failed commands are logged and don't
+ * affect the other ones.
+ */
+void ExternalCommandProcessor::ExecuteMany(const WaitGroup::Ptr& producer, const std::vector<String>& lines)
+{
+	std::vector<Checkable::QueuedCheckResult> checkResults;
+
+	auto logFailure ([](const std::exception& ex) {
+		Log(LogWarning, "ExternalCommandProcessor")
+			<< "External command failed: " << DiagnosticInformation(ex, false);
+		Log(LogNotice, "ExternalCommandProcessor")
+			<< "External command failed: " << DiagnosticInformation(ex, true);
+	});
+
+	auto processCheckResults ([&checkResults, &producer, &logFailure]() {
+		if (checkResults.empty())
+			return;
+
+		Checkable::ProcessCheckResults(checkResults, producer);
+
+		for (auto& checkResult : checkResults) {
+			if (checkResult.Error) {
+				try {
+					std::rethrow_exception(checkResult.Error);
+				} catch (const std::exception& ex) {
+					logFailure(ex);
+				}
+			} else if (checkResult.Unreachable) {
+				Log(LogNotice, "ExternalCommandProcessor")
+					<< "Ignoring passive check result for unreachable object '" << checkResult.Object->GetName() << "'";
+			}
+		}
+
+		checkResults.clear();
+	});
+
+	for (auto& line : lines) {
+		try {
+			double time;
+			String command;
+			std::vector<String> arguments;
+
+			if (!ParseLine(line, time, command, arguments))
+				continue;
+
+			bool host = command == "PROCESS_HOST_CHECK_RESULT";
+
+			if (host || command == "PROCESS_SERVICE_CHECK_RESULT") {
+				std::vector<String> realArguments;
+
+				GetCommandInfo(command, arguments, realArguments);
+				OnNewExternalCommand(time, command, realArguments);
+
+				Checkable::Ptr checkable;
+				CheckResult::Ptr cr = host
+					? MakeHostCheckResult(time, realArguments, checkable, false)
+					: MakeServiceCheckResult(time, realArguments, checkable, false);
+
+				/* Earlier check results of this batch may change the reachability, so it's checked later. */
+				Checkable::QueuedCheckResult queued;
+				queued.Object = checkable;
+				queued.Result = cr;
+				queued.IgnoreIfUnreachable = true;
+
+				checkResults.emplace_back(std::move(queued));
+
+				continue;
+			}
+
+			/* Other commands may depend on the check results before them, e.g. acknowledgements. */
+			processCheckResults();
+
+			Execute(producer, time, command, arguments);
+		} catch (const std::exception& ex) {
+			logFailure(ex);
+		}
+	}
+
+	processCheckResults();
+}
+
+/**
+ * Looks up the given command and merges its surplus arguments into the last one.
+ */
+ExternalCommandInfo ExternalCommandProcessor::GetCommandInfo(const String& command, const std::vector<String>& arguments, std::vector<String>& realArguments)
 {
 	ExternalCommandInfo eci;
 
@@ -84,7 +189,7 @@ void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, double ti
 
 	size_t argnum = std::min(arguments.size(), eci.MaxArgs);
 
-	std::vector<String> realArguments;
+	realArguments.clear();
 	realArguments.resize(argnum);
 
 	if (argnum > 0) {
@@ -101,6 +206,14 @@ void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, double ti
 		realArguments[argnum - 1] = last_argument;
 	}
 
+	return eci;
+}
+
+void ExternalCommandProcessor::Execute(const WaitGroup::Ptr& producer, double time, const String& command, const std::vector<String>& arguments)
+{
+	std::vector<String> realArguments;
+	ExternalCommandInfo eci = GetCommandInfo(command, arguments, realArguments);
+
 	OnNewExternalCommand(time, command, realArguments);
 
 	eci.Callback(producer, time, realArguments);
@@ -250,42 +363,30 @@ void ExternalCommandProcessor::RegisterCommands()
 
 void ExternalCommandProcessor::ExecuteFromFile(const WaitGroup::Ptr& producer, const String& line, std::deque<std::vector<String>>& file_queue)
 {
-	if (line.IsEmpty())
-		return;
-
-	if (line[0] != '[')
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing timestamp in command: " + line));
-
-	size_t pos = line.FindFirstOf("]");
-
-	if (pos == String::NPos)
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing timestamp in command: " + line));
-
-	String timestamp = line.SubStr(1, pos - 1);
-	String args = line.SubStr(pos + 2, String::NPos);
-
-	double ts = Convert::ToDouble(timestamp);
-
-	if (ts == 0)
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid timestamp in command: " + line));
-
-	std::vector<String> argv = args.Split(";");
-
-	if (argv.empty())
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing arguments in command: " + line));
+	double ts;
+	String command;
+	std::vector<String> argvExtra;
 
-	std::vector<String> argvExtra(argv.begin() + 1, argv.end());
+	if (!ParseLine(line, ts, command, argvExtra))
+		return;
 
-	if (argv[0] == "PROCESS_FILE") {
+	if (command == "PROCESS_FILE") {
 		Log(LogDebug, "ExternalCommandProcessor")
 			<< "Enqueing external command file " << argvExtra[0];
 		file_queue.push_back(argvExtra);
 	} else {
-		Execute(producer, ts, argv[0], argvExtra);
+		Execute(producer, ts, command, argvExtra);
 	}
 }
 
-void ExternalCommandProcessor::ProcessHostCheckResult(const WaitGroup::Ptr& producer, double time, const std::vector<String>& arguments)
+/**
+ * Creates the check result of a PROCESS_HOST_CHECK_RESULT command.
+ *
+ * @param checkReachability Whether to ignore it if the host is unreachable, otherwise that's up to the caller
+ *
+ * @return The check result or nullptr if it has to be ignored
+ */
+CheckResult::Ptr ExternalCommandProcessor::MakeHostCheckResult(double time, const std::vector<String>& arguments, Checkable::Ptr& checkable, bool checkReachability)
 {
 	Host::Ptr host = Host::GetByName(arguments[0]);
 
@@ -295,10 +396,10 @@ void ExternalCommandProcessor::ProcessHostCheckResult(const WaitGroup::Ptr& prod
 	if (!host->GetEnablePassiveChecks())
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Got passive check result for host '" + arguments[0] + "' which has passive checks disabled."));
 
-	if (!host->IsReachable(DependencyCheckExecution)) {
+	if (checkReachability && !host->IsReachable(DependencyCheckExecution)) {
 		Log(LogNotice, "ExternalCommandProcessor")
 			<< "Ignoring passive check result for unreachable host '" << arguments[0] << "'";
-		return;
+		return nullptr;
 	}
 
 	int exitStatus = Convert::ToDouble(arguments[1]);
@@ -329,10 +430,27 @@ void ExternalCommandProcessor::ProcessHostCheckResult(const WaitGroup::Ptr& prod
 	Log(LogNotice, "ExternalCommandProcessor")
 		<< "Processing passive check result for host '" << arguments[0] << "'";
 
-	host->ProcessCheckResult(result, producer);
+	checkable = host;
+	return result;
 }
 
-void ExternalCommandProcessor::ProcessServiceCheckResult(const WaitGroup::Ptr& producer, double time, const std::vector<String>& arguments)
+void ExternalCommandProcessor::ProcessHostCheckResult(const WaitGroup::Ptr& producer, double time, const std::vector<String>& arguments)
+{
+	Checkable::Ptr host;
+	CheckResult::Ptr result = MakeHostCheckResult(time, arguments, host, true);
+
+	if (result)
+		host->ProcessCheckResult(result, producer);
+}
+
+/**
+ * Creates the check result of a PROCESS_SERVICE_CHECK_RESULT command.
+ *
+ * @param checkReachability Whether to ignore it if the service is unreachable, otherwise that's up to the caller
+ *
+ * @return The check result or nullptr if it has to be ignored
+ */
+CheckResult::Ptr ExternalCommandProcessor::MakeServiceCheckResult(double time, const std::vector<String>& arguments, Checkable::Ptr& checkable, bool checkReachability)
 {
 	Service::Ptr service = Service::GetByNamePair(arguments[0], arguments[1]);
 
@@ -342,10 +460,10 @@ void ExternalCommandProcessor::ProcessServiceCheckResult(const WaitGroup::Ptr& p
 	if (!service->GetEnablePassiveChecks())
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Got passive check result for service '" + arguments[1] + "' which has passive checks disabled."));
 
-	if (!service->IsReachable(DependencyCheckExecution)) {
+	if (checkReachability && !service->IsReachable(DependencyCheckExecution)) {
 		Log(LogNotice, "ExternalCommandProcessor")
 			<< "Ignoring passive check result for unreachable service '" << arguments[1] << "'";
-		return;
+		return nullptr;
 	}
 
 	int exitStatus = Convert::ToDouble(arguments[2]);
@@ -367,7 +485,17 @@ void ExternalCommandProcessor::ProcessServiceCheckResult(const WaitGroup::Ptr& p
 	Log(LogNotice, "ExternalCommandProcessor")
 		<< "Processing passive check result for service '" << arguments[1] << "'";
 
-	service->ProcessCheckResult(result, producer);
+	checkable = service;
+	return result;
+}
+
+void ExternalCommandProcessor::ProcessServiceCheckResult(const WaitGroup::Ptr& producer, double time, const std::vector<String>& arguments)
+{
+	Checkable::Ptr service;
+	CheckResult::Ptr result = MakeServiceCheckResult(time, arguments, service, true);
+
+	if (result)
+		service->ProcessCheckResult(result, producer);
 }
 
 void ExternalCommandProcessor::ScheduleHostCheck(double, const std::vector<String>& arguments)
@@ -5,6 +5,7 @@
 #define EXTERNALCOMMANDPROCESSOR_H
 
 #include "icinga/i2-icinga.hpp"
+#include "icinga/checkable.hpp"
 #include "icinga/command.hpp"
 #include "base/wait-group.hpp"
 #include "base/string.hpp"
@@ -28,14 +29,19 @@ class ExternalCommandProcessor {
 public:
 	static void Execute(const WaitGroup::Ptr& producer, const String& line);
 	static void Execute(const WaitGroup::Ptr& producer, double time, const String& command, const std::vector<String>& arguments);
+	static void ExecuteMany(const WaitGroup::Ptr& producer, const std::vector<String>& lines);
 
 	static boost::signals2::signal<void(double, const String&, const std::vector<String>&)> OnNewExternalCommand;
 
 private:
 	ExternalCommandProcessor();
 
+	static bool ParseLine(const String& line, double& time, String& command, std::vector<String>& arguments);
+	static ExternalCommandInfo GetCommandInfo(const String& command, const std::vector<String>& arguments, std::vector<String>& realArguments);
 	static void ExecuteFromFile(const WaitGroup::Ptr& producer, const String& line, std::deque<std::vector<String>>& file_queue);
 
+	static CheckResult::Ptr MakeHostCheckResult(double time, const std::vector<String>& arguments, Checkable::Ptr& checkable, bool checkReachability);
+	static CheckResult::Ptr MakeServiceCheckResult(double time, const std::vector<String>& arguments, Checkable::Ptr& checkable, bool checkReachability);
 	static void ProcessHostCheckResult(const WaitGroup::Ptr& producer, double time, const std::vector<String>& arguments);
 	static void ProcessServiceCheckResult(const WaitGroup::Ptr& producer, double time, const std::vector<String>& arguments);
 	static void ScheduleHostCheck(double time, const std::vector<String>& arguments);
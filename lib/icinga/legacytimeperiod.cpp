@@ -9,6 +9,7 @@
 #include "base/logger.hpp"
 #include "base/debug.hpp"
 #include "base/utility.hpp"
+#include <algorithm>
 
 using namespace icinga;
 
@@ -464,44 +465,303 @@ void LegacyTimePeriod::ProcessTimeRanges(const String& timeranges, const tm *ref
 	}
 }
 
+/**
+ * Finds the segment of a single entry of the ranges which is running at reference and lasts the longest.
+ *
+ * @param daydef Day definition, for example "monday - friday"
+ * @param timeranges Comma separated time ranges, for example "08:00-12:00,13:00-17:00"
+ * @param reference The time to find the running segment at
+ */
 Dictionary::Ptr LegacyTimePeriod::FindRunningSegment(const String& daydef, const String& timeranges, const tm *reference)
+{
+	return LegacyTimeRanges::Compile(daydef, timeranges).FindRunningSegment(reference);
+}
+
+/**
+ * Finds the segment of a single entry of the ranges which begins next, at or after reference.
+ *
+ * @param daydef Day definition, for example "monday - friday"
+ * @param timeranges Comma separated time ranges, for example "08:00-12:00,13:00-17:00"
+ * @param reference The time to find the next segment after
+ */
+Dictionary::Ptr LegacyTimePeriod::FindNextSegment(const String& daydef, const String& timeranges, const tm *reference)
+{
+	return LegacyTimeRanges::Compile(daydef, timeranges).FindNextSegment(reference);
+}
+
+static const std::size_t l_MaxCachedDays = 64;
+
+LegacyTimeRanges::LegacyTimeRanges(Dictionary::Ptr ranges)
+	: m_Ranges(std::move(ranges))
+{
+	ObjectLock olock(m_Ranges);
+	for (const Dictionary::Pair& kv : m_Ranges) {
+		m_Compiled.emplace_back(Compile(kv.first, kv.second));
+	}
+}
+
+/**
+ * @return The ranges this has been compiled from
+ */
+const Dictionary::Ptr& LegacyTimeRanges::GetRanges() const
+{
+	return m_Ranges;
+}
+
+/**
+ * Parses a day specification once, in the same way LegacyTimePeriod::ParseTimeSpec() does.
+ *
+ * @param timespec Day specification, for example "2021-10-20", "day -1", "monday 2 march", ...
+ */
+LegacyTimeRanges::TimeSpec LegacyTimeRanges::TimeSpec::Parse(const String& timespec)
+{
+	TimeSpec spec { Kind::Date, 0, -1, 0, 0, false };
+
+	/* YYYY-MM-DD */
+	if (timespec.GetLength() == 10 && timespec[4] == '-' && timespec[7] == '-') {
+		spec.Year = Convert::ToLong(timespec.SubStr(0, 4));
+		spec.Month = Convert::ToLong(timespec.SubStr(5, 2)) - 1;
+		spec.Day = Convert::ToLong(timespec.SubStr(8, 2));
+
+		if (spec.Month < 0 || spec.Month > 11)
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid month in time specification: " + timespec));
+		if (spec.Day < 1 || spec.Day > 31)
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid day in time specification: " + timespec));
+
+		return spec;
+	}
+
+	std::vector<String> tokens = timespec.Split(" ");
+
+	int mon = -1;
+
+	if (tokens.size() > 1 && (tokens[0] == "day" || (mon = LegacyTimePeriod::MonthFromString(tokens[0])) != -1)) {
+		spec.Type = Kind::MonthDay;
+		spec.Month = mon;
+		spec.Day = Convert::ToLong(tokens[1]);
+
+		return spec;
+	}
+
+	int wday;
+
+	if (tokens.size() >= 1 && (wday = LegacyTimePeriod::WeekdayFromString(tokens[0])) != -1) {
+		spec.Type = Kind::Weekday;
+		spec.Weekday = wday;
+
+		if (tokens.size() > 2) {
+			spec.Month = LegacyTimePeriod::MonthFromString(tokens[2]);
+
+			if (spec.Month == -1)
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid month in time specification: " + timespec));
+		}
+
+		if (tokens.size() > 1) {
+			spec.Day = Convert::ToLong(tokens[1]);
+			spec.HasNth = true;
+		}
+
+		return spec;
+	}
+
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid time specification: " + timespec));
+}
+
+/**
+ * Finds the first day on or after the day given by reference, see LegacyTimePeriod::ParseTimeSpec().
+ *
+ * @param begin if != nullptr, set to 00:00:00 on that day
+ * @param end if != nullptr, set to 24:00:00 on that day (i.e. 00:00:00 of the next day)
+ * @param reference Time to begin the search at
+ */
+void LegacyTimeRanges::TimeSpec::Evaluate(tm *begin, tm *end, const tm *reference) const
+{
+	switch (Type) {
+		case Kind::Date:
+			if (begin) {
+				*begin = *reference;
+				begin->tm_year = Year - 1900;
+				begin->tm_mon = Month;
+				begin->tm_mday = Day;
+				begin->tm_hour = 0;
+				begin->tm_min = 0;
+				begin->tm_sec = 0;
+				begin->tm_isdst = -1;
+			}
+
+			if (end) {
+				*end = *reference;
+				end->tm_year = Year - 1900;
+				end->tm_mon = Month;
+				end->tm_mday = Day;
+				end->tm_hour = 24;
+				end->tm_min = 0;
+				end->tm_sec = 0;
+				end->tm_isdst = -1;
+			}
+
+			break;
+
+		case Kind::MonthDay: {
+			int mon = Month == -1 ? reference->tm_mon : Month;
+
+			if (begin) {
+				*begin = *reference;
+				begin->tm_mon = mon;
+				begin->tm_mday = Day;
+				begin->tm_hour = 0;
+				begin->tm_min = 0;
+				begin->tm_sec = 0;
+				begin->tm_isdst = -1;
+
+				/* day -X: Negative days are relative to the next month. */
+				if (Day < 0) {
+					boost::gregorian::date d(LegacyTimePeriod::GetEndOfMonthDay(reference->tm_year + 1900, mon + 1));
+
+					d = d - boost::gregorian::days(Day * -1 - 1);
+
+					*begin = boost::gregorian::to_tm(d);
+					begin->tm_hour = 0;
+					begin->tm_min = 0;
+					begin->tm_sec = 0;
+				}
+			}
+
+			if (end) {
+				*end = *reference;
+				end->tm_mon = mon;
+				end->tm_mday = Day;
+				end->tm_hour = 24;
+				end->tm_min = 0;
+				end->tm_sec = 0;
+				end->tm_isdst = -1;
+
+				/* day -X: Negative days are relative to the next month. */
+				if (Day < 0) {
+					boost::gregorian::date d(LegacyTimePeriod::GetEndOfMonthDay(reference->tm_year + 1900, mon + 1));
+
+					d = d - boost::gregorian::days(Day * -1 - 1) + boost::gregorian::days(1);
+
+					*end = boost::gregorian::to_tm(d);
+					end->tm_hour = 0;
+					end->tm_min = 0;
+					end->tm_sec = 0;
+				}
+			}
+
+			break;
+		}
+
+		case Kind::Weekday: {
+			tm myref = *reference;
+			myref.tm_isdst = -1;
+
+			if (Month != -1)
+				myref.tm_mon = Month;
+
+			if (begin) {
+				*begin = myref;
+
+				if (HasNth)
+					LegacyTimePeriod::FindNthWeekday(Weekday, Day, begin);
+				else
+					begin->tm_mday += (7 - begin->tm_wday + Weekday) % 7;
+
+				begin->tm_hour = 0;
+				begin->tm_min = 0;
+				begin->tm_sec = 0;
+			}
+
+			if (end) {
+				*end = myref;
+
+				if (HasNth)
+					LegacyTimePeriod::FindNthWeekday(Weekday, Day, end);
+				else
+					end->tm_mday += (7 - end->tm_wday + Weekday) % 7;
+
+				end->tm_hour = 0;
+				end->tm_min = 0;
+				end->tm_sec = 0;
+				end->tm_mday++;
+			}
+
+			break;
+		}
+	}
+}
+
+bool LegacyTimeRanges::Range::IsInDayDefinition(const tm *reference) const
+{
+	tm begin, end;
+
+	Begin.Evaluate(&begin, nullptr, reference);
+	End.Evaluate(nullptr, &end, reference);
+
+	return LegacyTimePeriod::IsInTimeRange(&begin, &end, Stride, reference);
+}
+
+/**
+ * Adds the segments of the times of day on the day given by reference, see LegacyTimePeriod::ProcessTimeRanges().
+ */
+void LegacyTimeRanges::Range::EvaluateTimes(const tm *reference, Segments& segments) const
+{
+	for (auto& time : Times) {
+		tm begin = *reference;
+		begin.tm_hour = time.first.Hour;
+		begin.tm_min = time.first.Minute;
+		begin.tm_sec = time.first.Second;
+
+		tm end = *reference;
+		end.tm_hour = time.second.Hour;
+		end.tm_min = time.second.Minute;
+		end.tm_sec = time.second.Second;
+
+		long tsBegin = Utility::TmToTimestamp(&begin);
+		long tsEnd = Utility::TmToTimestamp(&end);
+
+		if (tsBegin >= tsEnd)
+			continue;
+
+		segments.emplace_back(tsBegin, tsEnd);
+	}
+}
+
+Dictionary::Ptr LegacyTimeRanges::Range::FindRunningSegment(const tm *reference) const
 {
 	tm begin, end, iter;
 	time_t tsend, tsiter, tsref;
-	int stride;
 
 	tsref = Utility::TmToTimestamp(reference);
 
-	ParseTimeRange(daydef, &begin, &end, &stride, reference);
+	Begin.Evaluate(&begin, nullptr, reference);
+	End.Evaluate(nullptr, &end, reference);
 
 	iter = begin;
 
 	tsend = Utility::NormalizeTm(&end);
 
 	do {
-		if (IsInTimeRange(&begin, &end, stride, &iter)) {
-			Array::Ptr segments = new Array();
-			ProcessTimeRanges(timeranges, &iter, segments);
-
-			Dictionary::Ptr bestSegment;
-			double bestEnd = 0.0;
+		if (LegacyTimePeriod::IsInTimeRange(&begin, &end, Stride, &iter)) {
+			Segments segments;
+			EvaluateTimes(&iter, segments);
 
-			ObjectLock olock(segments);
-			for (Dictionary::Ptr segment : segments) {
-				double begin = segment->Get("begin");
-				double end = segment->Get("end");
+			const std::pair<long, long> *bestSegment = nullptr;
 
-				if (begin >= tsref || end < tsref)
+			for (auto& segment : segments) {
+				if (segment.first >= tsref || segment.second < tsref)
 					continue;
 
-				if (!bestSegment || end > bestEnd) {
-					bestSegment = segment;
-					bestEnd = end;
-				}
+				if (!bestSegment || segment.second > bestSegment->second)
+					bestSegment = &segment;
 			}
 
-			if (bestSegment)
-				return bestSegment;
+			if (bestSegment) {
+				return new Dictionary({
+					{ "begin", bestSegment->first },
+					{ "end", bestSegment->second }
+				});
+			}
 		}
 
 		iter.tm_mday++;
@@ -514,11 +774,10 @@ Dictionary::Ptr LegacyTimePeriod::FindRunningSegment(const String& daydef, const
 	return nullptr;
 }
 
-Dictionary::Ptr LegacyTimePeriod::FindNextSegment(const String& daydef, const String& timeranges, const tm *reference)
+Dictionary::Ptr LegacyTimeRanges::Range::FindNextSegment(const tm *reference) const
 {
 	tm begin, end, iter, ref;
 	time_t tsend, tsiter, tsref;
-	int stride;
 
 	for (int pass = 1; pass <= 2; pass++) {
 		if (pass == 1) {
@@ -530,35 +789,34 @@ Dictionary::Ptr LegacyTimePeriod::FindNextSegment(const String& daydef, const St
 
 		tsref = Utility::NormalizeTm(&ref);
 
-		ParseTimeRange(daydef, &begin, &end, &stride, &ref);
+		Begin.Evaluate(&begin, nullptr, &ref);
+		End.Evaluate(nullptr, &end, &ref);
 
 		iter = begin;
 
 		tsend = Utility::NormalizeTm(&end);
 
 		do {
-			if (IsInTimeRange(&begin, &end, stride, &iter)) {
-				Array::Ptr segments = new Array();
-				ProcessTimeRanges(timeranges, &iter, segments);
-
-				Dictionary::Ptr bestSegment;
-				double bestBegin = 0;
+			if (LegacyTimePeriod::IsInTimeRange(&begin, &end, Stride, &iter)) {
+				Segments segments;
+				EvaluateTimes(&iter, segments);
 
-				ObjectLock olock(segments);
-				for (Dictionary::Ptr segment : segments) {
-					double begin = segment->Get("begin");
+				const std::pair<long, long> *bestSegment = nullptr;
 
-					if (begin < tsref)
+				for (auto& segment : segments) {
+					if (segment.first < tsref)
 						continue;
 
-					if (!bestSegment || begin < bestBegin) {
-						bestSegment = segment;
-						bestBegin = begin;
-					}
+					if (!bestSegment || segment.first < bestSegment->first)
+						bestSegment = &segment;
 				}
 
-				if (bestSegment)
-					return bestSegment;
+				if (bestSegment) {
+					return new Dictionary({
+						{ "begin", bestSegment->first },
+						{ "end", bestSegment->second }
+					});
+				}
 			}
 
 			iter.tm_mday++;
@@ -572,6 +830,229 @@ Dictionary::Ptr LegacyTimePeriod::FindNextSegment(const String& daydef, const St
 	return nullptr;
 }
 
+/**
+ * Compiles a single entry of the ranges, in the same way LegacyTimePeriod::ParseTimeRange()
+ * and LegacyTimePeriod::ProcessTimeRanges() parse it.
+ *
+ * @param daydef Day definition, for example "monday - friday", "day 1 - 15 / 2", ...
+ * @param timeranges Comma separated time ranges, for example "08:00-12:00,13:00-17:00"
+ */
+LegacyTimeRanges::Range LegacyTimeRanges::Compile(const String& daydef, const String& timeranges)
+{
+	Range range;
+
+	CompileDayDefinition(daydef, range);
+	CompileTimeRanges(timeranges, range);
+
+	return range;
+}
+
+/**
+ * Validates a day definition of the ranges, e.g. of a time period, by compiling it.
+ *
+ * @throws std::exception if it's invalid
+ */
+void LegacyTimeRanges::ValidateDayDefinition(const String& daydef)
+{
+	Range range;
+
+	CompileDayDefinition(daydef, range);
+}
+
+/**
+ * Validates the comma separated time ranges of a day definition by compiling them.
+ *
+ * @throws std::exception if they're invalid
+ */
+void LegacyTimeRanges::ValidateTimeRanges(const String& timeranges)
+{
+	Range range;
+
+	CompileTimeRanges(timeranges, range);
+}
+
+void LegacyTimeRanges::CompileDayDefinition(const String& daydef, Range& range)
+{
+	range.DayDefinition = daydef;
+
+	String def = daydef;
+
+	/* Figure out the stride. */
+	size_t pos = def.FindFirstOf('/');
+
+	if (pos != String::NPos) {
+		range.Stride = Convert::ToLong(def.SubStr(pos + 1).Trim());
+		def = def.SubStr(0, pos);
+	} else {
+		range.Stride = 1;
+	}
+
+	/* Figure out whether the user has specified two dates. */
+	pos = def.Find("- ");
+
+	if (pos != String::NPos) {
+		String first = def.SubStr(0, pos).Trim();
+		String second = def.SubStr(pos + 1).Trim();
+
+		range.Begin = TimeSpec::Parse(first);
+
+		/* day 1 - 15 --> "day 15", see LegacyTimePeriod::ParseTimeRange() */
+		bool is_number = true;
+		size_t xpos = second.FindFirstOf(' ');
+		String fword = second.SubStr(0, xpos);
+
+		try {
+			Convert::ToLong(fword);
+		} catch (...) {
+			is_number = false;
+		}
+
+		if (is_number) {
+			xpos = first.FindFirstOf(' ');
+			ASSERT(xpos != String::NPos);
+			second = first.SubStr(0, xpos + 1) + second;
+		}
+
+		range.End = TimeSpec::Parse(second);
+	} else {
+		range.Begin = TimeSpec::Parse(def);
+		range.End = range.Begin;
+	}
+}
+
+void LegacyTimeRanges::CompileTimeRanges(const String& timeranges, Range& range)
+{
+	for (const String& timerange : timeranges.Split(",")) {
+		std::vector<String> times = timerange.Split("-");
+
+		if (times.size() != 2)
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid timerange: " + timerange));
+
+		TimeOfDay begin = ParseTimeOfDay(times[0]);
+		TimeOfDay end = ParseTimeOfDay(times[1]);
+
+		if (begin.Hour * 3600 + begin.Minute * 60 + begin.Second >= end.Hour * 3600 + end.Minute * 60 + end.Second)
+			end.Hour += 24;
+
+		range.Times.emplace_back(begin, end);
+	}
+}
+
+LegacyTimeRanges::TimeOfDay LegacyTimeRanges::ParseTimeOfDay(const String& in)
+{
+	TimeOfDay time;
+
+	auto hd (in.Split(":"));
+
+	switch (hd.size()) {
+		case 2:
+			time.Second = 0;
+			break;
+		case 3:
+			time.Second = Convert::ToLong(hd[2]);
+			break;
+		default:
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid time specification: " + in));
+	}
+
+	time.Hour = Convert::ToLong(hd[0]);
+	time.Minute = Convert::ToLong(hd[1]);
+
+	return time;
+}
+
+/**
+ * Adds the segments of the day given by reference to result.
+ *
+ * @param timezone The timezone the reference has been calculated in, i.e. the TZ environment variable
+ * @param reference 00:00:00 of the day to evaluate, with tm_isdst = -1
+ * @param result For each segment, a dict with keys "begin" and "end" is added
+ */
+void LegacyTimeRanges::Evaluate(const String& timezone, const tm *reference, const Array::Ptr& result)
+{
+	auto day (std::make_pair(timezone, Utility::TmToTimestamp(reference)));
+	Segments segments;
+	bool cached = false;
+
+	{
+		std::unique_lock<std::mutex> lock (m_Mutex);
+		auto it (m_Days.find(day));
+
+		if (it != m_Days.end()) {
+			it->second.LastUsed = ++m_DaysUsed;
+			segments = it->second.DaySegments;
+			cached = true;
+		}
+	}
+
+	if (!cached) {
+		segments = EvaluateDay(reference);
+
+		std::unique_lock<std::mutex> lock (m_Mutex);
+		m_Days.emplace(std::move(day), CachedDay{segments, ++m_DaysUsed});
+
+		/* Evict the least recently used days, i.e. the ones before the update window
+		 * or the ones of a timezone which isn't used anymore, not just the earliest key.
+		 */
+		while (m_Days.size() > l_MaxCachedDays) {
+			m_Days.erase(std::min_element(m_Days.begin(), m_Days.end(), [](auto& a, auto& b) {
+				return a.second.LastUsed < b.second.LastUsed;
+			}));
+		}
+	}
+
+	for (auto& segment : segments) {
+		result->Add(new Dictionary({
+			{ "begin", segment.first },
+			{ "end", segment.second }
+		}));
+	}
+}
+
+LegacyTimeRanges::Segments LegacyTimeRanges::EvaluateDay(const tm *reference) const
+{
+	Segments segments;
+
+	for (const Range& range : m_Compiled) {
+		if (!range.IsInDayDefinition(reference)) {
+#ifdef I2_DEBUG
+			Log(LogDebug, "LegacyTimePeriod")
+				<< "Not in day definition '" << range.DayDefinition << "'.";
+#endif /* I2_DEBUG */
+			continue;
+		}
+
+#ifdef I2_DEBUG
+		Log(LogDebug, "LegacyTimePeriod")
+			<< "In day definition '" << range.DayDefinition << "'.";
+#endif /* I2_DEBUG */
+
+		range.EvaluateTimes(reference, segments);
+	}
+
+	return segments;
+}
+
+/**
+ * @return The compiled ranges of the time period, compiled again if they have been replaced since
+ */
+std::shared_ptr<LegacyTimeRanges> LegacyTimePeriod::GetCompiledRanges(const TimePeriod::Ptr& tp, const Dictionary::Ptr& ranges)
+{
+	{
+		ObjectLock olock(tp);
+
+		if (tp->m_LegacyRanges && tp->m_LegacyRanges->GetRanges() == ranges)
+			return tp->m_LegacyRanges;
+	}
+
+	auto compiled (std::make_shared<LegacyTimeRanges>(ranges));
+
+	ObjectLock olock(tp);
+	tp->m_LegacyRanges = compiled;
+
+	return compiled;
+}
+
 Array::Ptr LegacyTimePeriod::ScriptFunc(const TimePeriod::Ptr& tp, double begin, double end)
 {
 	Array::Ptr segments = new Array();
@@ -579,6 +1060,9 @@ Array::Ptr LegacyTimePeriod::ScriptFunc(const TimePeriod::Ptr& tp, double begin,
 	Dictionary::Ptr ranges = tp->GetRanges();
 
 	if (ranges) {
+		auto compiled (GetCompiledRanges(tp, ranges));
+		String timezone = Utility::GetFromEnvironment("TZ");
+
 		tm tm_begin = Utility::LocalTime(begin);
 
 		// Always evaluate time periods for full days as their ranges are given per day.
@@ -610,23 +1094,7 @@ Array::Ptr LegacyTimePeriod::ScriptFunc(const TimePeriod::Ptr& tp, double begin,
 				<< "Checking reference time " << Utility::TmToTimestamp(&reference);
 #endif /* I2_DEBUG */
 
-			ObjectLock olock(ranges);
-			for (const Dictionary::Pair& kv : ranges) {
-				if (!IsInDayDefinition(kv.first, &reference)) {
-#ifdef I2_DEBUG
-					Log(LogDebug, "LegacyTimePeriod")
-						<< "Not in day definition '" << kv.first << "'.";
-#endif /* I2_DEBUG */
-					continue;
-				}
-
-#ifdef I2_DEBUG
-				Log(LogDebug, "LegacyTimePeriod")
-					<< "In day definition '" << kv.first << "'.";
-#endif /* I2_DEBUG */
-
-				ProcessTimeRanges(kv.second, &reference, segments);
-			}
+			compiled->Evaluate(timezone, &reference, segments);
 		}
 	}
 
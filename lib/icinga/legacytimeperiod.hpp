@@ -8,10 +8,18 @@
 #include "icinga/timeperiod.hpp"
 #include "base/dictionary.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace icinga
 {
 
+class LegacyTimeRanges;
+
 /**
  * Implements Icinga 1.x time periods.
  *
@@ -39,6 +47,103 @@ private:
 	LegacyTimePeriod();
 
 	static boost::gregorian::date GetEndOfMonthDay(int year, int month);
+
+	static std::shared_ptr<LegacyTimeRanges> GetCompiledRanges(const TimePeriod::Ptr& tp, const Dictionary::Ptr& ranges);
+
+	friend class LegacyTimeRanges;
+};
+
+/**
+ * The ranges of a legacy time period, parsed once.
+ *
+ * Each day definition (e.g. "monday - friday / 2") is compiled into the day specifications of its begin and end
+ * and each time range (e.g. "08:00-12:00,13:00-17:00") into its times of day, so that they don't have to be
+ * parsed again for every day of every update. As the segments of a day only depend on the day and the timezone,
+ * the most recently used days are memoized per timezone.
+ *
+ * This is the parser time periods and scheduled downtimes are validated and evaluated with. The string based
+ * functions of LegacyTimePeriod parse the same syntax on every call and remain as a reference for it.
+ *
+ * @ingroup icinga
+ */
+class LegacyTimeRanges
+{
+public:
+	explicit LegacyTimeRanges(Dictionary::Ptr ranges);
+
+	const Dictionary::Ptr& GetRanges() const;
+
+	void Evaluate(const String& timezone, const tm *reference, const Array::Ptr& result);
+
+	static void ValidateDayDefinition(const String& daydef);
+	static void ValidateTimeRanges(const String& timeranges);
+
+private:
+	using Segments = std::vector<std::pair<long, long>>;
+
+	struct TimeSpec
+	{
+		enum class Kind
+		{
+			Date, // YYYY-MM-DD
+			MonthDay, // day 1, january -1, ...
+			Weekday // monday, monday 2, monday -1 march, ...
+		};
+
+		Kind Type;
+		int Year;
+		int Month; // -1 for the month of the reference
+		int Day; // The n-th weekday for Kind::Weekday
+		int Weekday;
+		bool HasNth;
+
+		static TimeSpec Parse(const String& timespec);
+
+		void Evaluate(tm *begin, tm *end, const tm *reference) const;
+	};
+
+	struct TimeOfDay
+	{
+		int Hour;
+		int Minute;
+		int Second;
+	};
+
+	struct Range
+	{
+		String DayDefinition;
+		TimeSpec Begin;
+		TimeSpec End;
+		int Stride;
+		std::vector<std::pair<TimeOfDay, TimeOfDay>> Times;
+
+		bool IsInDayDefinition(const tm *reference) const;
+		void EvaluateTimes(const tm *reference, Segments& segments) const;
+		Dictionary::Ptr FindRunningSegment(const tm *reference) const;
+		Dictionary::Ptr FindNextSegment(const tm *reference) const;
+	};
+
+	struct CachedDay
+	{
+		Segments DaySegments;
+		uint_fast64_t LastUsed;
+	};
+
+	Dictionary::Ptr m_Ranges;
+	std::vector<Range> m_Compiled;
+
+	std::mutex m_Mutex;
+	std::map<std::pair<String, time_t>, CachedDay> m_Days;
+	uint_fast64_t m_DaysUsed = 0;
+
+	static Range Compile(const String& daydef, const String& timeranges);
+	static void CompileDayDefinition(const String& daydef, Range& range);
+	static void CompileTimeRanges(const String& timeranges, Range& range);
+	static TimeOfDay ParseTimeOfDay(const String& in);
+
+	Segments EvaluateDay(const tm *reference) const;
+
+	friend class LegacyTimePeriod;
 };
 
 }
@@ -14,7 +14,6 @@
 #include "base/scriptframe.hpp"
 #include "base/convert.hpp"
 #include "base/exception.hpp"
-#include <boost/algorithm/string/join.hpp>
 
 using namespace icinga;
 
@@ -24,25 +23,36 @@ Value MacroProcessor::ResolveMacros(const Value& str, const ResolverList& resolv
 	const CheckResult::Ptr& cr, String *missingMacro,
 	const MacroProcessor::EscapeCallback& escapeFn, const Dictionary::Ptr& resolvedMacros,
 	bool useResolvedMacros, int recursionLevel)
+{
+	return ResolveMacros(MacroValueTemplate(str), resolvers, cr, missingMacro, escapeFn,
+		resolvedMacros, useResolvedMacros, recursionLevel);
+}
+
+/**
+ * Like ResolveMacros() for a value with already compiled strings, e.g. a Command's argument.
+ */
+Value MacroProcessor::ResolveMacros(const MacroValueTemplate& tmpl, const ResolverList& resolvers,
+	const CheckResult::Ptr& cr, String *missingMacro,
+	const MacroProcessor::EscapeCallback& escapeFn, const Dictionary::Ptr& resolvedMacros,
+	bool useResolvedMacros, int recursionLevel)
 {
 	if (useResolvedMacros)
 		REQUIRE_NOT_NULL(resolvedMacros);
 
 	Value result;
+	const Value& str = tmpl.Raw;
 
 	if (str.IsEmpty())
 		return Empty;
 
 	if (str.IsScalar()) {
-		result = InternalResolveMacros(str, resolvers, cr, missingMacro, escapeFn,
+		result = InternalResolveMacros(tmpl.Strings[0], resolvers, cr, missingMacro, escapeFn,
 			resolvedMacros, useResolvedMacros, recursionLevel + 1);
 	} else if (str.IsObjectType<Array>()) {
 		ArrayData resultArr;
-		Array::Ptr arr = str;
+		resultArr.reserve(tmpl.Strings.size());
 
-		ObjectLock olock(arr);
-
-		for (const Value& arg : arr) {
+		for (const MacroTemplate& arg : tmpl.Strings) {
 			/* Note: don't escape macros here. */
 			Value value = InternalResolveMacros(arg, resolvers, cr, missingMacro,
 				EscapeCallback(), resolvedMacros, useResolvedMacros, recursionLevel + 1);
@@ -86,20 +96,15 @@ static MacroProcessor::ResolverList GetDefaultResolvers()
 	};
 }
 
-bool MacroProcessor::ResolveMacro(const String& macro, const ResolverList& resolvers,
+bool MacroProcessor::ResolveMacro(const MacroTemplate::Macro& macro, const ResolverList& resolvers,
 	const CheckResult::Ptr& cr, Value *result, bool *recursive_macro)
 {
-	CONTEXT("Resolving macro '" << macro << "'");
+	CONTEXT("Resolving macro '" << macro.Name << "'");
 
 	*recursive_macro = false;
 
-	std::vector<String> tokens = macro.Split(".");
-
-	String objName;
-	if (tokens.size() > 1) {
-		objName = tokens[0];
-		tokens.erase(tokens.begin());
-	}
+	const std::vector<String>& tokens = macro.Tokens;
+	const String& objName = macro.ObjName;
 
 	const auto defaultResolvers (GetDefaultResolvers());
 
@@ -125,8 +130,8 @@ bool MacroProcessor::ResolveMacro(const String& macro, const ResolverList& resol
 					}
 				}
 
-				if (vars && vars->Contains(macro)) {
-					*result = vars->Get(macro);
+				if (vars && vars->Contains(macro.Name)) {
+					*result = vars->Get(macro.Name);
 					*recursive_macro = true;
 					return true;
 				}
@@ -134,7 +139,7 @@ bool MacroProcessor::ResolveMacro(const String& macro, const ResolverList& resol
 
 			auto *mresolver = dynamic_cast<MacroResolver *>(resolver.Obj.get());
 
-			if (mresolver && mresolver->ResolveMacro(boost::algorithm::join(tokens, "."), cr, result))
+			if (mresolver && mresolver->ResolveMacro(macro.Path, cr, result))
 				return true;
 
 			Value ref = resolver.Obj;
@@ -235,24 +240,34 @@ Value MacroProcessor::InternalResolveMacros(const String& str, const ResolverLis
 	const MacroProcessor::EscapeCallback& escapeFn, const Dictionary::Ptr& resolvedMacros,
 	bool useResolvedMacros, int recursionLevel)
 {
-	CONTEXT("Resolving macros for string '" << str << "'");
+	return InternalResolveMacros(MacroTemplate(str), resolvers, cr, missingMacro, escapeFn,
+		resolvedMacros, useResolvedMacros, recursionLevel);
+}
+
+Value MacroProcessor::InternalResolveMacros(const MacroTemplate& tmpl, const ResolverList& resolvers,
+	const CheckResult::Ptr& cr, String *missingMacro,
+	const MacroProcessor::EscapeCallback& escapeFn, const Dictionary::Ptr& resolvedMacros,
+	bool useResolvedMacros, int recursionLevel)
+{
+	CONTEXT("Resolving macros for string '" << tmpl.GetString() << "'");
 
 	if (recursionLevel > 15)
 		BOOST_THROW_EXCEPTION(std::runtime_error("Infinite recursion detected while resolving macros"));
 
-	size_t offset, pos_first, pos_second;
-	offset = 0;
+	if (!tmpl.HasMacros() && !tmpl.IsUnterminated())
+		return tmpl.GetString();
 
-	Dictionary::Ptr resolvers_this;
+	String result;
 
-	String result = str;
-	while ((pos_first = result.FindFirstOf("$", offset)) != String::NPos) {
-		pos_second = result.FindFirstOf("$", pos_first + 1);
+	for (auto& segment : tmpl.GetSegments()) {
+		auto macro (std::get_if<MacroTemplate::Macro>(&segment));
 
-		if (pos_second == String::NPos)
-			BOOST_THROW_EXCEPTION(std::runtime_error("Closing $ not found in macro format string."));
+		if (!macro) {
+			result += std::get<String>(segment);
+			continue;
+		}
 
-		String name = result.SubStr(pos_first + 1, pos_second - pos_first - 1);
+		const String& name = macro->Name;
 
 		Value resolved_macro;
 		bool recursive_macro;
@@ -265,7 +280,7 @@ Value MacroProcessor::InternalResolveMacros(const String& str, const ResolverLis
 			if (found)
 				resolved_macro = resolvedMacros->Get(name);
 		} else
-			found = ResolveMacro(name, resolvers, cr, &resolved_macro, &recursive_macro);
+			found = ResolveMacro(*macro, resolvers, cr, &resolved_macro, &recursive_macro);
 
 		/* $$ is an escape sequence for $. */
 		if (name.IsEmpty()) {
@@ -317,25 +332,20 @@ Value MacroProcessor::InternalResolveMacros(const String& str, const ResolverLis
 			resolved_macro = escapeFn(resolved_macro);
 
 		/* we're done if this is the only macro and there are no other non-macro parts in the string */
-		if (pos_first == 0 && pos_second == str.GetLength() - 1)
+		if (tmpl.IsSingleMacro())
 			return resolved_macro;
-		else if (resolved_macro.IsObjectType<Array>())
-				BOOST_THROW_EXCEPTION(std::invalid_argument("Mixing both strings and non-strings in macros is not allowed."));
 
-		if (resolved_macro.IsObjectType<Array>()) {
-			/* don't allow mixing strings and arrays in macro strings */
-			if (pos_first != 0 || pos_second != str.GetLength() - 1)
-				BOOST_THROW_EXCEPTION(std::invalid_argument("Mixing both strings and non-strings in macros is not allowed."));
-
-			return resolved_macro;
-		}
+		/* don't allow mixing strings and arrays in macro strings */
+		if (resolved_macro.IsObjectType<Array>())
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Mixing both strings and non-strings in macros is not allowed."));
 
 		String resolved_macro_str = resolved_macro;
-
-		result.Replace(pos_first, pos_second - pos_first + 1, resolved_macro_str);
-		offset = pos_first + resolved_macro_str.GetLength();
+		result += resolved_macro_str;
 	}
 
+	if (tmpl.IsUnterminated())
+		BOOST_THROW_EXCEPTION(std::runtime_error("Closing $ not found in macro format string."));
+
 	return result;
 }
 
@@ -458,90 +468,79 @@ struct CommandArgument
 Value MacroProcessor::ResolveArguments(const Value& command, const Dictionary::Ptr& arguments,
 	const MacroProcessor::ResolverList& resolvers, const CheckResult::Ptr& cr,
 	const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros, int recursionLevel)
+{
+	return ResolveArguments(CommandTemplate(command, arguments), resolvers, cr,
+		resolvedMacros, useResolvedMacros, recursionLevel);
+}
+
+/**
+ * Like ResolveArguments() for an already compiled command, see Command::GetTemplate().
+ */
+Value MacroProcessor::ResolveArguments(const CommandTemplate& tmpl,
+	const MacroProcessor::ResolverList& resolvers, const CheckResult::Ptr& cr,
+	const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros, int recursionLevel)
 {
 	if (useResolvedMacros)
 		REQUIRE_NOT_NULL(resolvedMacros);
 
 	Value resolvedCommand;
-	if (!arguments || command.IsObjectType<Array>() || command.IsObjectType<Function>())
-		resolvedCommand = MacroProcessor::ResolveMacros(command, resolvers, cr, nullptr,
+	if (!tmpl.WrapCommandLine())
+		resolvedCommand = MacroProcessor::ResolveMacros(tmpl.GetCommandLine(), resolvers, cr, nullptr,
 			EscapeMacroShellArg, resolvedMacros, useResolvedMacros, recursionLevel + 1);
 	else {
-		resolvedCommand = new Array({ command });
+		resolvedCommand = new Array({ tmpl.GetCommandLine().Raw });
 	}
 
-	if (arguments) {
+	if (tmpl.HasArguments()) {
 		std::vector<CommandArgument> args;
 
-		ObjectLock olock(arguments);
-		for (const Dictionary::Pair& kv : arguments) {
-			const Value& arginfo = kv.second;
-
+		for (const CommandTemplate::Argument& argtmpl : tmpl.GetArguments()) {
 			CommandArgument arg;
-			arg.Key = kv.first;
-
-			bool required = false;
-			Value argval;
-
-			if (arginfo.IsObjectType<Dictionary>()) {
-				Dictionary::Ptr argdict = arginfo;
-				if (argdict->Contains("key"))
-					arg.Key = argdict->Get("key");
-				argval = argdict->Get("value");
-				if (argdict->Contains("required"))
-					required = argdict->Get("required");
-				arg.SkipKey = argdict->Get("skip_key");
-				if (argdict->Contains("repeat_key"))
-					arg.RepeatKey = argdict->Get("repeat_key");
-				arg.Order = argdict->Get("order");
-				arg.Separator = argdict->Get("separator");
-
-				Value set_if = argdict->Get("set_if");
-
-				if (!set_if.IsEmpty()) {
-					String missingMacro;
-					Value set_if_resolved = MacroProcessor::ResolveMacros(set_if, resolvers,
-						cr, &missingMacro, MacroProcessor::EscapeCallback(), resolvedMacros,
-						useResolvedMacros, recursionLevel + 1);
-
-					if (!missingMacro.IsEmpty())
-						continue;
-
-					int value;
-
-					if (set_if_resolved == "true")
-						value = 1;
-					else if (set_if_resolved == "false")
-						value = 0;
-					else {
-						try {
-							value = Convert::ToLong(set_if_resolved);
-						} catch (const std::exception& ex) {
-							/* tried to convert a string */
-							Log(LogWarning, "PluginUtility")
-								<< "Error evaluating set_if value '" << set_if_resolved
-								<< "' used in argument '" << arg.Key << "': " << ex.what();
-							continue;
-						}
-					}
+			arg.Key = argtmpl.Key;
+			arg.SkipKey = argtmpl.SkipKey;
+			arg.RepeatKey = argtmpl.RepeatKey;
+			arg.SkipValue = argtmpl.SkipValue;
+			arg.Order = argtmpl.Order;
+			arg.Separator = argtmpl.Separator;
+
+			if (argtmpl.HasSetIf) {
+				String missingMacro;
+				Value set_if_resolved = MacroProcessor::ResolveMacros(argtmpl.SetIf, resolvers,
+					cr, &missingMacro, MacroProcessor::EscapeCallback(), resolvedMacros,
+					useResolvedMacros, recursionLevel + 1);
+
+				if (!missingMacro.IsEmpty())
+					continue;
 
-					if (!value)
+				int value;
+
+				if (set_if_resolved == "true")
+					value = 1;
+				else if (set_if_resolved == "false")
+					value = 0;
+				else {
+					try {
+						value = Convert::ToLong(set_if_resolved);
+					} catch (const std::exception& ex) {
+						/* tried to convert a string */
+						Log(LogWarning, "PluginUtility")
+							<< "Error evaluating set_if value '" << set_if_resolved
+							<< "' used in argument '" << arg.Key << "': " << ex.what();
 						continue;
+					}
 				}
-			}
-			else
-				argval = arginfo;
 
-			if (argval.IsEmpty())
-				arg.SkipValue = true;
+				if (!value)
+					continue;
+			}
 
 			String missingMacro;
-			arg.AValue = MacroProcessor::ResolveMacros(argval, resolvers,
+			arg.AValue = MacroProcessor::ResolveMacros(argtmpl.AValue, resolvers,
 				cr, &missingMacro, MacroProcessor::EscapeCallback(), resolvedMacros,
 				useResolvedMacros, recursionLevel + 1);
 
 			if (!missingMacro.IsEmpty()) {
-				if (required) {
+				if (argtmpl.Required) {
 					BOOST_THROW_EXCEPTION(ScriptError("Non-optional macro '" + missingMacro + "' used in argument '" +
 						arg.Key + "' is missing."));
 				}
@@ -6,6 +6,7 @@
 
 #include "icinga/i2-icinga.hpp"
 #include "icinga/checkable.hpp"
+#include "icinga/macrotemplate.hpp"
 #include "base/value.hpp"
 #include <vector>
 #include <utility>
@@ -44,23 +45,38 @@ public:
 		const Dictionary::Ptr& resolvedMacros = nullptr,
 		bool useResolvedMacros = false, int recursionLevel = 0);
 
+	static Value ResolveMacros(const MacroValueTemplate& tmpl, const ResolverList& resolvers,
+		const CheckResult::Ptr& cr = nullptr, String *missingMacro = nullptr,
+		const EscapeCallback& escapeFn = EscapeCallback(),
+		const Dictionary::Ptr& resolvedMacros = nullptr,
+		bool useResolvedMacros = false, int recursionLevel = 0);
+
 	static Value ResolveArguments(const Value& command, const Dictionary::Ptr& arguments,
 		const MacroProcessor::ResolverList& resolvers, const CheckResult::Ptr& cr,
 		const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros, int recursionLevel = 0);
 
+	static Value ResolveArguments(const CommandTemplate& tmpl,
+		const MacroProcessor::ResolverList& resolvers, const CheckResult::Ptr& cr,
+		const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros, int recursionLevel = 0);
+
 	static bool ValidateMacroString(const String& macro);
 	static void ValidateCustomVars(const ConfigObject::Ptr& object, const Dictionary::Ptr& value);
 
 private:
 	MacroProcessor();
 
-	static bool ResolveMacro(const String& macro, const ResolverList& resolvers,
+	static bool ResolveMacro(const MacroTemplate::Macro& macro, const ResolverList& resolvers,
 		const CheckResult::Ptr& cr, Value *result, bool *recursive_macro);
 	static Value InternalResolveMacros(const String& str,
 		const ResolverList& resolvers, const CheckResult::Ptr& cr,
 		String *missingMacro, const EscapeCallback& escapeFn,
 		const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros,
 		int recursionLevel = 0);
+	static Value InternalResolveMacros(const MacroTemplate& tmpl,
+		const ResolverList& resolvers, const CheckResult::Ptr& cr,
+		String *missingMacro, const EscapeCallback& escapeFn,
+		const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros,
+		int recursionLevel = 0);
 	static Value EvaluateFunction(const Function::Ptr& func, const ResolverList& resolvers,
 		const CheckResult::Ptr& cr,
 		const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros, int recursionLevel);
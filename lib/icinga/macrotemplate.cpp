@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/macrotemplate.hpp"
+#include "base/array.hpp"
+#include "base/objectlock.hpp"
+#include <boost/algorithm/string/join.hpp>
+
+using namespace icinga;
+
+MacroTemplate::Macro::Macro(String name)
+	: Name(std::move(name)), Tokens(Name.Split("."))
+{
+	if (Tokens.size() > 1) {
+		ObjName = Tokens[0];
+		Tokens.erase(Tokens.begin());
+	}
+
+	Path = boost::algorithm::join(Tokens, ".");
+}
+
+MacroTemplate::MacroTemplate(String str)
+	: m_String(std::move(str))
+{
+	size_t offset = 0, pos_first, pos_second;
+
+	while ((pos_first = m_String.FindFirstOf("$", offset)) != String::NPos) {
+		pos_second = m_String.FindFirstOf("$", pos_first + 1);
+
+		if (pos_second == String::NPos) {
+			m_Unterminated = true;
+			return;
+		}
+
+		if (pos_first > offset) {
+			m_Segments.emplace_back(m_String.SubStr(offset, pos_first - offset));
+		}
+
+		m_Segments.emplace_back(Macro(m_String.SubStr(pos_first + 1, pos_second - pos_first - 1)));
+		m_HasMacros = true;
+		offset = pos_second + 1;
+	}
+
+	if (offset < m_String.GetLength()) {
+		m_Segments.emplace_back(m_String.SubStr(offset));
+	}
+}
+
+MacroValueTemplate::MacroValueTemplate(Value raw)
+	: Raw(std::move(raw))
+{
+	if (Raw.IsScalar()) {
+		Strings.emplace_back(Raw);
+	} else if (Raw.IsObjectType<Array>()) {
+		Array::Ptr arr = Raw;
+		ObjectLock olock (arr);
+
+		for (const Value& arg : arr) {
+			Strings.emplace_back(arg);
+		}
+	}
+}
+
+/**
+ * Compiles everything MacroProcessor::ResolveArguments() and PluginUtility::ExecuteCommand() would otherwise
+ * look up and parse for every single execution.
+ */
+CommandTemplate::CommandTemplate(const Value& commandLine, const Dictionary::Ptr& arguments, const Dictionary::Ptr& env)
+	: m_CommandLine(commandLine), m_RawArguments(arguments), m_RawEnv(env), m_HasArguments(arguments),
+	m_WrapCommandLine(arguments && !commandLine.IsObjectType<Array>() && !commandLine.IsObjectType<Function>())
+{
+	if (arguments) {
+		ObjectLock olock (arguments);
+
+		for (const Dictionary::Pair& kv : arguments) {
+			const Value& arginfo = kv.second;
+
+			Argument arg;
+			arg.Key = kv.first;
+
+			Value argval;
+
+			if (arginfo.IsObjectType<Dictionary>()) {
+				Dictionary::Ptr argdict = arginfo;
+				if (argdict->Contains("key"))
+					arg.Key = argdict->Get("key");
+				argval = argdict->Get("value");
+				if (argdict->Contains("required"))
+					arg.Required = argdict->Get("required");
+				arg.SkipKey = argdict->Get("skip_key");
+				if (argdict->Contains("repeat_key"))
+					arg.RepeatKey = argdict->Get("repeat_key");
+				arg.Order = argdict->Get("order");
+				arg.Separator = argdict->Get("separator");
+
+				Value set_if = argdict->Get("set_if");
+
+				if (!set_if.IsEmpty()) {
+					arg.HasSetIf = true;
+					arg.SetIf = MacroValueTemplate(std::move(set_if));
+				}
+			} else
+				argval = arginfo;
+
+			if (argval.IsEmpty())
+				arg.SkipValue = true;
+
+			arg.AValue = MacroValueTemplate(std::move(argval));
+
+			m_Arguments.emplace_back(std::move(arg));
+		}
+	}
+
+	if (env) {
+		ObjectLock olock (env);
+
+		for (const Dictionary::Pair& kv : env) {
+			m_Env.emplace_back(kv.first, MacroValueTemplate(String(kv.second)));
+		}
+	}
+}
+
+/**
+ * Compares objects by identity, so in-place modifications of e.g. the arguments dictionary aren't detected.
+ * The API and config only ever replace the whole attribute value, though.
+ */
+static bool IsSameValue(const Value& lhs, const Value& rhs)
+{
+	if (lhs.IsObject() || rhs.IsObject()) {
+		return lhs.IsObject() && rhs.IsObject() && lhs.Get<Object::Ptr>() == rhs.Get<Object::Ptr>();
+	}
+
+	return lhs.GetType() == rhs.GetType() && lhs == rhs;
+}
+
+/**
+ * @returns Whether this has been compiled from (still) the given attribute values of a Command.
+ */
+bool CommandTemplate::IsCompiledFrom(const Value& commandLine, const Value& arguments, const Dictionary::Ptr& env) const
+{
+	return IsSameValue(commandLine, m_CommandLine.Raw) && IsSameValue(arguments, m_RawArguments) && env == m_RawEnv;
+}
@@ -0,0 +1,161 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef MACROTEMPLATE_H
+#define MACROTEMPLATE_H
+
+#include "icinga/i2-icinga.hpp"
+#include "base/dictionary.hpp"
+#include "base/value.hpp"
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * A macro string split into literals and macro references once, e.g. "-H $host.address$" into
+ * "-H " and host.address, so that resolving it only has to look up and substitute the macros.
+ *
+ * @ingroup icinga
+ */
+class MacroTemplate
+{
+public:
+	struct Macro
+	{
+		String Name; /* e.g. host.vars.os */
+		String ObjName; /* e.g. host, empty for short macros like $os$ */
+		std::vector<String> Tokens; /* e.g. vars, os */
+		String Path; /* the tokens joined with dots */
+
+		explicit Macro(String name);
+	};
+
+	typedef std::variant<String, Macro> Segment;
+
+	explicit MacroTemplate(String str);
+
+	inline const String& GetString() const noexcept
+	{
+		return m_String;
+	}
+
+	inline const std::vector<Segment>& GetSegments() const noexcept
+	{
+		return m_Segments;
+	}
+
+	/**
+	 * @returns Whether the string is exactly one macro, i.e. its value isn't converted to a string.
+	 */
+	inline bool IsSingleMacro() const noexcept
+	{
+		return m_Segments.size() == 1u && !m_Unterminated && std::holds_alternative<Macro>(m_Segments[0]);
+	}
+
+	/**
+	 * @returns Whether the segments are followed by a $ without a closing one.
+	 */
+	inline bool IsUnterminated() const noexcept
+	{
+		return m_Unterminated;
+	}
+
+	inline bool HasMacros() const noexcept
+	{
+		return m_HasMacros;
+	}
+
+private:
+	String m_String;
+	std::vector<Segment> m_Segments;
+	bool m_Unterminated{false};
+	bool m_HasMacros{false};
+};
+
+/**
+ * A value as passed to MacroProcessor::ResolveMacros() with its strings compiled to MacroTemplates.
+ *
+ * @ingroup icinga
+ */
+struct MacroValueTemplate
+{
+	Value Raw;
+
+	/* One for a string (or other scalar), one per item for an array, none otherwise */
+	std::vector<MacroTemplate> Strings;
+
+	explicit MacroValueTemplate(Value raw);
+};
+
+/**
+ * The command line, arguments and env of a Command compiled for MacroProcessor::ResolveArguments().
+ *
+ * @ingroup icinga
+ */
+class CommandTemplate final : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(CommandTemplate);
+
+	struct Argument
+	{
+		String Key;
+		int Order{0};
+		bool Required{false};
+		bool SkipKey{false};
+		bool RepeatKey{true};
+		bool SkipValue{false};
+		Value Separator;
+		bool HasSetIf{false};
+		MacroValueTemplate SetIf{Empty};
+		MacroValueTemplate AValue{Empty};
+	};
+
+	CommandTemplate(const Value& commandLine, const Dictionary::Ptr& arguments, const Dictionary::Ptr& env = nullptr);
+
+	bool IsCompiledFrom(const Value& commandLine, const Value& arguments, const Dictionary::Ptr& env) const;
+
+	inline const MacroValueTemplate& GetCommandLine() const noexcept
+	{
+		return m_CommandLine;
+	}
+
+	inline bool HasArguments() const noexcept
+	{
+		return m_HasArguments;
+	}
+
+	/**
+	 * @returns Whether the command line is used as is as the first item of the resolved one.
+	 */
+	inline bool WrapCommandLine() const noexcept
+	{
+		return m_WrapCommandLine;
+	}
+
+	inline const std::vector<Argument>& GetArguments() const noexcept
+	{
+		return m_Arguments;
+	}
+
+	inline const std::vector<std::pair<String, MacroValueTemplate>>& GetEnv() const noexcept
+	{
+		return m_Env;
+	}
+
+private:
+	MacroValueTemplate m_CommandLine;
+	Dictionary::Ptr m_RawArguments;
+	Dictionary::Ptr m_RawEnv;
+	bool m_HasArguments;
+	bool m_WrapCommandLine;
+	std::vector<Argument> m_Arguments;
+	std::vector<std::pair<String, MacroValueTemplate>> m_Env;
+};
+
+}
+
+#endif /* MACROTEMPLATE_H */
@@ -134,7 +134,7 @@ void Notification::EvaluateApplyRules(const Host::Ptr& host)
 {
 	CONTEXT("Evaluating 'apply' rules for host '" << host->GetName() << "'");
 
-	for (auto& rule : ApplyRule::GetRules(Notification::TypeInstance, Host::TypeInstance))
+	for (auto& rule : ApplyRule::GetCandidateRules(Notification::TypeInstance, Host::TypeInstance, host))
 	{
 		if (EvaluateApplyRule(host, *rule))
 			rule->AddMatch();
@@ -150,7 +150,7 @@ void Notification::EvaluateApplyRules(const Service::Ptr& service)
 {
 	CONTEXT("Evaluating 'apply' rules for service '" << service->GetName() << "'");
 
-	for (auto& rule : ApplyRule::GetRules(Notification::TypeInstance, Service::TypeInstance)) {
+	for (auto& rule : ApplyRule::GetCandidateRules(Notification::TypeInstance, Service::TypeInstance, service)) {
 		if (EvaluateApplyRule(service, *rule))
 			rule->AddMatch();
 	}
@@ -2,7 +2,9 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "icinga/pluginutility.hpp"
+#include "icinga/checktrace.hpp"
 #include "icinga/macroprocessor.hpp"
+#include "base/charscanner.hpp"
 #include "base/logger.hpp"
 #include "base/utility.hpp"
 #include "base/perfdatavalue.hpp"
@@ -11,22 +13,44 @@
 #include "base/objectlock.hpp"
 #include "base/exception.hpp"
 #include <boost/algorithm/string/trim.hpp>
+#include <cstring>
 
 using namespace icinga;
 
+static thread_local std::function<void()> l_CheckStartHook;
+
+PluginUtility::CheckStartHook::CheckStartHook(std::function<void()> hook)
+	: m_Previous(std::move(l_CheckStartHook))
+{
+	l_CheckStartHook = std::move(hook);
+}
+
+PluginUtility::CheckStartHook::~CheckStartHook()
+{
+	l_CheckStartHook = std::move(m_Previous);
+}
+
 void PluginUtility::ExecuteCommand(const Command::Ptr& commandObj,
 	const CheckResult::Ptr& cr, const MacroProcessor::ResolverList& macroResolvers,
 	const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros, int timeout,
 	const std::function<void(const Value& commandLine, const ProcessResult&)>& callback)
 {
-	Value raw_command = commandObj->GetCommandLine();
-	Dictionary::Ptr raw_arguments = commandObj->GetArguments();
+	auto tmpl (commandObj->GetTemplate());
+	auto trace (CheckTrace::GetCurrent());
+	CheckTrace::Span macroSpan (trace, CheckTraceStage::MacroResolution);
 
 	Value command;
 
 	try {
-		command = MacroProcessor::ResolveArguments(raw_command, raw_arguments,
-			macroResolvers, cr, resolvedMacros, useResolvedMacros);
+		if (tmpl) {
+			command = MacroProcessor::ResolveArguments(*tmpl, macroResolvers, cr, resolvedMacros, useResolvedMacros);
+		} else {
+			Value raw_command = commandObj->GetCommandLine();
+			Dictionary::Ptr raw_arguments = commandObj->GetArguments();
+
+			command = MacroProcessor::ResolveArguments(raw_command, raw_arguments,
+				macroResolvers, cr, resolvedMacros, useResolvedMacros);
+		}
 	} catch (const std::exception& ex) {
 		String message = DiagnosticInformation(ex);
 
@@ -47,39 +71,59 @@ void PluginUtility::ExecuteCommand(const Command::Ptr& commandObj,
 
 	Dictionary::Ptr envMacros = new Dictionary();
 
-	Dictionary::Ptr env = commandObj->GetEnv();
-
-	if (env) {
-		ObjectLock olock(env);
-		for (const Dictionary::Pair& kv : env) {
-			String name = kv.second;
-
-			String missingMacro;
-			Value value = MacroProcessor::ResolveMacros(name, macroResolvers, cr,
-				&missingMacro, MacroProcessor::EscapeCallback(), resolvedMacros,
-				useResolvedMacros);
+	auto resolveEnv = [&macroResolvers, &cr, &resolvedMacros, useResolvedMacros, &envMacros](const String& key, const MacroValueTemplate& name) {
+		String missingMacro;
+		Value value = MacroProcessor::ResolveMacros(name, macroResolvers, cr,
+			&missingMacro, MacroProcessor::EscapeCallback(), resolvedMacros,
+			useResolvedMacros);
 
 #ifdef I2_DEBUG
-			if (!missingMacro.IsEmpty())
-				Log(LogDebug, "PluginUtility")
-					<< "Macro '" << name << "' is not defined.";
+		if (!missingMacro.IsEmpty())
+			Log(LogDebug, "PluginUtility")
+				<< "Macro '" << name.Raw << "' is not defined.";
 #endif /* I2_DEBUG */
 
-			if (value.IsObjectType<Array>())
-				value = Utility::Join(value, ';');
+		if (value.IsObjectType<Array>())
+			value = Utility::Join(value, ';');
 
-			envMacros->Set(kv.first, value);
+		envMacros->Set(key, value);
+	};
+
+	if (tmpl) {
+		for (auto& kv : tmpl->GetEnv()) {
+			resolveEnv(kv.first, kv.second);
+		}
+	} else {
+		Dictionary::Ptr env = commandObj->GetEnv();
+
+		if (env) {
+			ObjectLock olock(env);
+			for (const Dictionary::Pair& kv : env) {
+				resolveEnv(kv.first, MacroValueTemplate(String(kv.second)));
+			}
 		}
 	}
 
 	if (resolvedMacros && !useResolvedMacros)
 		return;
 
+	macroSpan.End();
+
 	Process::Ptr process = new Process(Process::PrepareCommand(command), envMacros);
 
 	process->SetTimeout(timeout);
 	process->SetAdjustPriority(true);
 
+	/* Not for e.g. event handlers run while processing the check result of an in-process check. */
+	if (l_CheckStartHook && dynamic_cast<CheckCommand*>(commandObj.get())) {
+		auto hook (std::move(l_CheckStartHook));
+
+		l_CheckStartHook = nullptr;
+		hook();
+	}
+
+	CheckTrace::Span spawnSpan (trace, CheckTraceStage::Spawn);
+
 	process->Run([callback, command](const ProcessResult& pr) { callback(command, pr); });
 }
 
@@ -97,29 +141,45 @@ ServiceState PluginUtility::ExitStatusToState(int exitStatus)
 	}
 }
 
+static const CharScanner l_LineBreaks ("\r\n");
+static const CharScanner l_LineBreaksAndPipe ("\r\n|");
+
 std::pair<String, String> PluginUtility::ParseCheckOutput(const String& output)
 {
 	String text;
 	String perfdata;
 
-	std::vector<String> lines = output.Split("\r\n");
+	const char *lineBegin = output.CStr();
+	const char *end = lineBegin + output.GetLength();
 
-	for (const String& line : lines) {
-		size_t delim = line.FindFirstOf("|");
+	for (;;) {
+		const char *delim = l_LineBreaksAndPipe.FindFirst(lineBegin, end);
+		const char *lineEnd = delim;
+
+		if (delim != end && *delim == '|') {
+			lineEnd = l_LineBreaks.FindFirst(delim + 1, end);
+		} else {
+			delim = nullptr;
+		}
 
 		if (!text.IsEmpty())
 			text += "\n";
 
-		if (delim != String::NPos && line.FindFirstOf("=", delim) != String::NPos) {
-			text += line.SubStr(0, delim);
+		if (delim && memchr(delim + 1, '=', lineEnd - delim - 1)) {
+			text.GetData().append(lineBegin, delim);
 
 			if (!perfdata.IsEmpty())
 				perfdata += " ";
 
-			perfdata += line.SubStr(delim + 1, line.GetLength());
+			perfdata.GetData().append(delim + 1, lineEnd);
 		} else {
-			text += line;
+			text.GetData().append(lineBegin, lineEnd);
 		}
+
+		if (lineEnd == end)
+			break;
+
+		lineBegin = lineEnd + 1;
 	}
 
 	boost::algorithm::trim(perfdata);
@@ -8,6 +8,7 @@
 #include "icinga/checkable.hpp"
 #include "icinga/checkcommand.hpp"
 #include "icinga/macroprocessor.hpp"
+#include <functional>
 #include <vector>
 
 namespace icinga
@@ -23,6 +24,22 @@ struct ProcessResult;
 class PluginUtility
 {
 public:
+	/**
+	 * Calls the given function right before ExecuteCommand() starts the plugin of a check command in this
+	 * thread, at most once and until it goes out of scope. It's not called for checks run in-process.
+	 */
+	class CheckStartHook
+	{
+	public:
+		explicit CheckStartHook(std::function<void()> hook);
+		CheckStartHook(const CheckStartHook&) = delete;
+		CheckStartHook& operator=(const CheckStartHook&) = delete;
+		~CheckStartHook();
+
+	private:
+		std::function<void()> m_Previous;
+	};
+
 	static void ExecuteCommand(const Command::Ptr& commandObj,
 		const CheckResult::Ptr& cr, const MacroProcessor::ResolverList& macroResolvers,
 		const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros, int timeout,
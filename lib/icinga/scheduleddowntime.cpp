@@ -5,6 +5,7 @@
 #include "icinga/scheduleddowntime-ti.cpp"
 #include "icinga/legacytimeperiod.hpp"
 #include "icinga/downtime.hpp"
+#include "icinga/downtimescheduler.hpp"
 #include "icinga/service.hpp"
 #include "base/timer.hpp"
 #include "base/tlsutility.hpp"
@@ -85,12 +86,19 @@ void ScheduledDowntime::Start(bool runtimeCreated)
 		l_Timer->Start();
 	});
 
-	if (!IsPaused())
-		Utility::QueueAsyncCallback([this]() { CreateNextDowntime(); });
+	if (!IsPaused()) {
+		Utility::QueueAsyncCallback([this]() {
+			DowntimeScheduler::Batch batch (DowntimeScheduler::GetInstance());
+			CreateNextDowntime();
+		});
+	}
 }
 
 void ScheduledDowntime::TimerProc()
 {
+	/* Add the events of all new downtimes at once, e.g. for a maintenance window of many hosts. */
+	DowntimeScheduler::Batch batch (DowntimeScheduler::GetInstance());
+
 	for (const ScheduledDowntime::Ptr& sd : ConfigType::GetObjectsByType<ScheduledDowntime>()) {
 		if (sd->IsActive() && !sd->IsPaused()) {
 			try {
@@ -336,23 +344,16 @@ void ScheduledDowntime::ValidateRanges(const Lazy<Dictionary::Ptr>& lvalue, cons
 	if (!lvalue())
 		return;
 
-	/* create a fake time environment to validate the definitions */
-	time_t refts = Utility::GetTime();
-	tm reference = Utility::LocalTime(refts);
-	Array::Ptr segments = new Array();
-
 	ObjectLock olock(lvalue());
 	for (const Dictionary::Pair& kv : lvalue()) {
 		try {
-			tm begin_tm, end_tm;
-			int stride;
-			LegacyTimePeriod::ParseTimeRange(kv.first, &begin_tm, &end_tm, &stride, &reference);
+			LegacyTimeRanges::ValidateDayDefinition(kv.first);
 		} catch (const std::exception& ex) {
 			BOOST_THROW_EXCEPTION(ValidationError(this, { "ranges" }, "Invalid time specification '" + kv.first + "': " + ex.what()));
 		}
 
 		try {
-			LegacyTimePeriod::ProcessTimeRanges(kv.second, &reference, segments);
+			LegacyTimeRanges::ValidateTimeRanges(kv.second);
 		} catch (const std::exception& ex) {
 			BOOST_THROW_EXCEPTION(ValidationError(this, { "ranges" }, "Invalid time range definition '" + kv.second + "': " + ex.what()));
 		}
@@ -11,6 +11,7 @@
 #include "base/timer.hpp"
 #include "base/utility.hpp"
 #include <boost/thread/once.hpp>
+#include <algorithm>
 
 using namespace icinga;
 
@@ -53,51 +54,39 @@ void TimePeriod::AddSegment(double begin, double end)
 	if (GetValidEnd().IsEmpty() || end > GetValidEnd())
 		SetValidEnd(end);
 
-	Array::Ptr segments = GetSegments();
-
-	if (segments) {
-		/* Try to merge the new segment into an existing segment. */
-		ObjectLock dlock(segments);
-		for (Dictionary::Ptr segment : segments) {
-			if (segment->Get("begin") <= begin && segment->Get("end") >= end)
-				return; /* New segment is fully contained in this segment. */
+	InsertSegment(begin, end);
+}
 
-			if (segment->Get("begin") >= begin && segment->Get("end") <= end) {
-				segment->Set("begin", begin);
-				segment->Set("end", end); /* Extend an existing segment to both sides */
-				return;
-			}
+void TimePeriod::AddSegment(const Dictionary::Ptr& segment)
+{
+	AddSegment(segment->Get("begin"), segment->Get("end"));
+}
 
-			if (segment->Get("end") >= begin && segment->Get("end") <= end) {
-				segment->Set("end", end); /* Extend an existing segment to right. */
-				return;
-			}
+/**
+ * Merges the given segment with all segments it overlaps with or touches, if any.
+ */
+void TimePeriod::InsertSegment(double begin, double end)
+{
+	ASSERT(OwnsLock());
 
-			if (segment->Get("begin") >= begin && segment->Get("begin") <= end) {
-				segment->Set("begin", begin); /* Extend an existing segment to left. */
-				return;
-			}
+	if (end <= begin)
+		return;
 
-		}
-	}
+	auto first (std::lower_bound(m_Segments.begin(), m_Segments.end(), begin,
+		[](const Segment& segment, double ts) { return segment.End < ts; }));
 
-	/* Create new segment if we weren't able to merge this into an existing segment. */
-	Dictionary::Ptr segment = new Dictionary({
-		{ "begin", begin },
-		{ "end", end }
-	});
+	auto last (std::upper_bound(first, m_Segments.end(), end,
+		[](double ts, const Segment& segment) { return ts < segment.Begin; }));
 
-	if (!segments) {
-		segments = new Array();
-		SetSegments(segments);
+	if (first == last) {
+		m_Segments.insert(first, Segment{begin, end});
+	} else {
+		first->Begin = std::min(first->Begin, begin);
+		first->End = std::max((last - 1)->End, end);
+		m_Segments.erase(first + 1, last);
 	}
 
-	segments->Add(segment);
-}
-
-void TimePeriod::AddSegment(const Dictionary::Ptr& segment)
-{
-	AddSegment(segment->Get("begin"), segment->Get("end"));
+	m_SerializedSegments = nullptr;
 }
 
 void TimePeriod::RemoveSegment(double begin, double end)
@@ -114,54 +103,32 @@ void TimePeriod::RemoveSegment(double begin, double end)
 	if (GetValidEnd().IsEmpty() || end > GetValidEnd())
 		SetValidEnd(end);
 
-	Array::Ptr segments = GetSegments();
-
-	if (!segments)
+	if (end <= begin)
 		return;
 
-	Array::Ptr newSegments = new Array();
-
-	/* Try to split or adjust an existing segment. */
-	ObjectLock dlock(segments);
-	for (Dictionary::Ptr segment : segments) {
-		/* Fully contained in the specified range? */
-		if (segment->Get("begin") >= begin && segment->Get("end") <= end)
-			// Don't add the old segment, because the segment is fully contained into our range
-			continue;
+	/* The segments overlapping with the specified range. */
+	auto first (std::upper_bound(m_Segments.begin(), m_Segments.end(), begin,
+		[](double ts, const Segment& segment) { return ts < segment.End; }));
 
-		/* Not overlapping at all? */
-		if (segment->Get("end") < begin || segment->Get("begin") > end) {
-			newSegments->Add(segment);
-			continue;
-		}
+	auto last (std::lower_bound(first, m_Segments.end(), end,
+		[](const Segment& segment, double ts) { return segment.Begin < ts; }));
 
-		/* Cut between */
-		if (segment->Get("begin") < begin && segment->Get("end") > end) {
-			newSegments->Add(new Dictionary({
-				{ "begin", segment->Get("begin") },
-				{ "end", begin }
-			}));
+	if (first != last) {
+		/* Keep whatever sticks out of the range on both sides. */
+		Segment head {first->Begin, begin};
+		Segment tail {end, (last - 1)->End};
 
-			newSegments->Add(new Dictionary({
-				{ "begin", end },
-				{ "end", segment->Get("end") }
-			}));
-			// Don't add the old segment, because we have now two new segments and a gap between
-			continue;
-		}
+		auto pos (m_Segments.erase(first, last));
 
-		/* Adjust the begin/end timestamps so as to not overlap with the specified range. */
-		if (segment->Get("begin") > begin && segment->Get("begin") < end)
-			segment->Set("begin", end);
+		if (tail.Begin < tail.End)
+			pos = m_Segments.insert(pos, tail);
 
-		if (segment->Get("end") > begin && segment->Get("end") < end)
-			segment->Set("end", begin);
+		if (head.Begin < head.End)
+			m_Segments.insert(pos, head);
 
-		newSegments->Add(segment);
+		m_SerializedSegments = nullptr;
 	}
 
-	SetSegments(newSegments);
-
 #ifdef _DEBUG
 	Dump();
 #endif /* _DEBUG */
@@ -185,21 +152,14 @@ void TimePeriod::PurgeSegments(double end)
 
 	SetValidBegin(end);
 
-	Array::Ptr segments = GetSegments();
-
-	if (!segments)
-		return;
-
-	Array::Ptr newSegments = new Array();
-
 	/* Remove old segments. */
-	ObjectLock dlock(segments);
-	for (Dictionary::Ptr segment : segments) {
-		if (segment->Get("end") >= end)
-			newSegments->Add(segment);
-	}
+	auto first (std::lower_bound(m_Segments.begin(), m_Segments.end(), end,
+		[](const Segment& segment, double ts) { return segment.End < ts; }));
 
-	SetSegments(newSegments);
+	if (first != m_Segments.begin()) {
+		m_Segments.erase(m_Segments.begin(), first);
+		m_SerializedSegments = nullptr;
+	}
 }
 
 void TimePeriod::Merge(const TimePeriod::Ptr& timeperiod, bool include)
@@ -208,14 +168,16 @@ void TimePeriod::Merge(const TimePeriod::Ptr& timeperiod, bool include)
 		<< "Merge TimePeriod '" << GetName() << "' with '" << timeperiod->GetName() << "' "
 		<< "Method: " << (include ? "include" : "exclude");
 
-	Array::Ptr segments = timeperiod->GetSegments();
+	std::vector<Segment> segments;
 
-	if (segments) {
-		ObjectLock dlock(segments);
-		ObjectLock ilock(this);
-		for (Dictionary::Ptr segment : segments) {
-			include ? AddSegment(segment) : RemoveSegment(segment);
-		}
+	{
+		ObjectLock olock(timeperiod);
+		segments = timeperiod->m_Segments;
+	}
+
+	ObjectLock olock(this);
+	for (auto& segment : segments) {
+		include ? AddSegment(segment.Begin, segment.End) : RemoveSegment(segment.Begin, segment.End);
 	}
 }
 
@@ -223,7 +185,8 @@ void TimePeriod::UpdateRegion(double begin, double end, bool clearExisting)
 {
 	if (clearExisting) {
 		ObjectLock olock(this);
-		SetSegments(new Array());
+		m_Segments.clear();
+		m_SerializedSegments = nullptr;
 	} else {
 		if (begin < GetValidEnd())
 			begin = GetValidEnd();
@@ -287,39 +250,71 @@ bool TimePeriod::IsInside(double ts) const
 	if (GetValidBegin().IsEmpty() || ts < GetValidBegin() || GetValidEnd().IsEmpty() || ts > GetValidEnd())
 		return true; /* Assume that all invalid regions are "inside". */
 
-	Array::Ptr segments = GetSegments();
+	/* The last segment beginning at or before ts is the only one which may contain it. */
+	auto next (std::upper_bound(m_Segments.begin(), m_Segments.end(), ts,
+		[](double value, const Segment& segment) { return value < segment.Begin; }));
 
-	if (segments) {
-		ObjectLock dlock(segments);
-		for (Dictionary::Ptr segment : segments) {
-			if (ts >= segment->Get("begin") && ts < segment->Get("end"))
-				return true;
-		}
-	}
-
-	return false;
+	return next != m_Segments.begin() && ts < (next - 1)->End;
 }
 
 double TimePeriod::FindNextTransition(double begin)
 {
 	ObjectLock olock(this);
 
-	Array::Ptr segments = GetSegments();
+	/* The first segment ending after begin contains the closest transition. */
+	auto next (std::upper_bound(m_Segments.begin(), m_Segments.end(), begin,
+		[](double ts, const Segment& segment) { return ts < segment.End; }));
+
+	if (next == m_Segments.end())
+		return -1;
 
-	double closestTransition = -1;
+	return next->Begin > begin ? next->Begin : next->End;
+}
+
+/**
+ * Serializes the segments into their dictionary form, e.g. for the API and the state file.
+ *
+ * The result is cached until the segments change.
+ */
+Array::Ptr TimePeriod::GetSegments() const
+{
+	ObjectLock olock(this);
 
-	if (segments) {
-		ObjectLock dlock(segments);
-		for (Dictionary::Ptr segment : segments) {
-			if (segment->Get("begin") > begin && (segment->Get("begin") < closestTransition || closestTransition == -1))
-				closestTransition = segment->Get("begin");
+	if (!m_SerializedSegments) {
+		ArrayData segments;
+		segments.reserve(m_Segments.size());
 
-			if (segment->Get("end") > begin && (segment->Get("end") < closestTransition || closestTransition == -1))
-				closestTransition = segment->Get("end");
+		for (auto& segment : m_Segments) {
+			segments.emplace_back(new Dictionary({
+				{ "begin", segment.Begin },
+				{ "end", segment.End }
+			}));
+		}
+
+		m_SerializedSegments = new Array(std::move(segments));
+	}
+
+	return m_SerializedSegments;
+}
+
+void TimePeriod::SetSegments(const Array::Ptr& value, bool suppress_events, const Value& cookie)
+{
+	{
+		ObjectLock olock(this);
+
+		m_Segments.clear();
+		m_SerializedSegments = nullptr;
+
+		if (value) {
+			ObjectLock dlock(value);
+			for (Dictionary::Ptr segment : value) {
+				InsertSegment(segment->Get("begin"), segment->Get("end"));
+			}
 		}
 	}
 
-	return closestTransition;
+	if (!suppress_events)
+		NotifySegments(cookie);
 }
 
 void TimePeriod::UpdateTimerHandler()
@@ -350,8 +345,6 @@ void TimePeriod::Dump()
 {
 	ObjectLock olock(this);
 
-	Array::Ptr segments = GetSegments();
-
 	Log(LogDebug, "TimePeriod")
 		<< "Dumping TimePeriod '" << GetName() << "'";
 
@@ -359,13 +352,10 @@ void TimePeriod::Dump()
 		<< "Valid from '" << Utility::FormatDateTime("%c", GetValidBegin())
 		<< "' until '" << Utility::FormatDateTime("%c", GetValidEnd());
 
-	if (segments) {
-		ObjectLock dlock(segments);
-		for (Dictionary::Ptr segment : segments) {
-			Log(LogDebug, "TimePeriod")
-				<< "Segment: " << Utility::FormatDateTime("%c", segment->Get("begin")) << " <-> "
-				<< Utility::FormatDateTime("%c", segment->Get("end"));
-		}
+	for (auto& segment : m_Segments) {
+		Log(LogDebug, "TimePeriod")
+			<< "Segment: " << Utility::FormatDateTime("%c", segment.Begin) << " <-> "
+			<< Utility::FormatDateTime("%c", segment.End);
 	}
 
 	Log(LogDebug, "TimePeriod", "---");
@@ -378,23 +368,16 @@ void TimePeriod::ValidateRanges(const Lazy<Dictionary::Ptr>& lvalue, const Valid
 	if (!lvalue())
 		return;
 
-	/* create a fake time environment to validate the definitions */
-	time_t refts = Utility::GetTime();
-	tm reference = Utility::LocalTime(refts);
-	Array::Ptr segments = new Array();
-
 	ObjectLock olock(lvalue());
 	for (const Dictionary::Pair& kv : lvalue()) {
 		try {
-			tm begin_tm, end_tm;
-			int stride;
-			LegacyTimePeriod::ParseTimeRange(kv.first, &begin_tm, &end_tm, &stride, &reference);
+			LegacyTimeRanges::ValidateDayDefinition(kv.first);
 		} catch (const std::exception& ex) {
 			BOOST_THROW_EXCEPTION(ValidationError(this, { "ranges" }, "Invalid time specification '" + kv.first + "': " + ex.what()));
 		}
 
 		try {
-			LegacyTimePeriod::ProcessTimeRanges(kv.second, &reference, segments);
+			LegacyTimeRanges::ValidateTimeRanges(kv.second);
 		} catch (const std::exception& ex) {
 			BOOST_THROW_EXCEPTION(ValidationError(this, { "ranges" }, "Invalid time range definition '" + kv.second + "': " + ex.what()));
 		}
@@ -6,13 +6,20 @@
 
 #include "icinga/i2-icinga.hpp"
 #include "icinga/timeperiod-ti.hpp"
+#include <memory>
+#include <vector>
 
 namespace icinga
 {
 
+class LegacyTimeRanges;
+
 /**
  * A time period.
  *
+ * The segments are kept as a sorted list of non-overlapping, half-open intervals, so that e.g. IsInside()
+ * is a binary search. Their dictionary form (the segments attribute) is only built if actually requested.
+ *
  * @ingroup icinga
  */
 class TimePeriod final : public ObjectImpl<TimePeriod>
@@ -27,14 +34,29 @@ public:
 
 	bool GetIsInside() const override;
 
+	Array::Ptr GetSegments() const override;
+	void SetSegments(const Array::Ptr& value, bool suppress_events = false, const Value& cookie = Empty) override;
+
 	bool IsInside(double ts) const;
 	double FindNextTransition(double begin);
 
 	void ValidateRanges(const Lazy<Dictionary::Ptr>& lvalue, const ValidationUtils& utils) override;
 
 private:
+	struct Segment
+	{
+		double Begin;
+		double End;
+	};
+
+	std::vector<Segment> m_Segments;
+	mutable Array::Ptr m_SerializedSegments;
+
+	std::shared_ptr<LegacyTimeRanges> m_LegacyRanges;
+
 	void AddSegment(double s, double end);
 	void AddSegment(const Dictionary::Ptr& segment);
+	void InsertSegment(double begin, double end);
 	void RemoveSegment(double begin, double end);
 	void RemoveSegment(const Dictionary::Ptr& segment);
 	void PurgeSegments(double end);
@@ -44,6 +66,8 @@ private:
 	void Dump();
 
 	static void UpdateTimerHandler();
+
+	friend class LegacyTimePeriod;
 };
 
 }
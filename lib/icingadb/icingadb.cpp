@@ -81,9 +81,11 @@ void IcingaDB::Start(bool runtimeCreated)
 	RedisConnInfo::ConstPtr connInfo = GetRedisConnInfo();
 
 	m_Rcon = new RedisConnection(connInfo);
+	m_Rcon->RegisterMetrics({ { "icingadb", GetName() }, { "connection", "main" } });
 	m_RconLocked.store(m_Rcon);
 
 	m_RconWorker = new RedisConnection(connInfo, m_Rcon);
+	m_RconWorker->RegisterMetrics({ { "icingadb", GetName() }, { "connection", "worker" } });
 
 	for (const auto& [type, _] : GetSyncableTypes()) {
 		auto ctype (dynamic_cast<ConfigType*>(type.get()));
@@ -91,6 +93,7 @@ void IcingaDB::Start(bool runtimeCreated)
 			continue;
 
 		RedisConnection::Ptr con = new RedisConnection(connInfo, m_Rcon);
+		con->RegisterMetrics({ { "icingadb", GetName() }, { "connection", type->GetName() } });
 
 		con->SetConnectedCallback([this, con](boost::asio::yield_context&) {
 			con->SetConnectedCallback(nullptr);
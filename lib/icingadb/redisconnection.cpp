@@ -455,6 +455,8 @@ void RedisConnection::WriteLoop(asio::yield_context& yc)
 
 		while (m_Queues.HasWrites()) {
 			auto queuedWrite(m_Queues.PopFront());
+			m_QueueWaitMetric->Record(Utility::GetTime() - queuedWrite.CTime);
+
 			std::visit(
 				[this, &yc, &queuedWrite](const auto& item) {
 					if (WriteItem(item, yc)) {
@@ -686,6 +688,24 @@ void RedisConnection::SetConnectedCallback(std::function<void(asio::yield_contex
 	m_ConnectedCallback = std::move(callback);
 }
 
+/**
+ * Make this connection's stats available in the metrics registry.
+ *
+ * @param labels The labels identifying this connection
+ */
+void RedisConnection::RegisterMetrics(const MetricLabels& labels)
+{
+	MetricsRegistry::Register("icingadb_redis_queue_wait_seconds",
+		"Time Redis queries spent in the write queue of the connection.", labels, m_QueueWaitMetric);
+
+	// Same as in IncreasePendingQueries().
+	if (!m_Parent || m_TrackOwnPendingQueries) {
+		MetricsRegistry::Register("icingadb_redis_pending_queries", "Redis queries waiting to be answered.",
+			labels, m_PendingQueriesMetric);
+		MetricsRegistry::Register("icingadb_redis_queries", "Redis queries answered.", labels, m_QueriesMetric);
+	}
+}
+
 int RedisConnection::GetQueryCount(RingBuffer::SizeType span)
 {
 	return m_OutputQueries.UpdateAndGetValues(Utility::GetTime(), span);
@@ -702,6 +722,7 @@ void RedisConnection::IncreasePendingQueries(int count)
 	if (!m_Parent || m_TrackOwnPendingQueries) {
 		m_PendingQueries.fetch_add(count);
 		m_InputQueries.InsertValue(Utility::GetTime(), count);
+		m_PendingQueriesMetric->Add(count);
 	}
 }
 
@@ -715,6 +736,8 @@ void RedisConnection::DecreasePendingQueries(int count)
 	if (!m_Parent || m_TrackOwnPendingQueries) {
 		m_PendingQueries.fetch_sub(count);
 		m_OutputQueries.InsertValue(Utility::GetTime(), count);
+		m_PendingQueriesMetric->Add(-count);
+		m_QueriesMetric->Increment(count);
 	}
 }
 
@@ -8,6 +8,7 @@
 #include "base/atomic.hpp"
 #include "base/convert.hpp"
 #include "base/io-engine.hpp"
+#include "base/metricsregistry.hpp"
 #include "base/object.hpp"
 #include "base/ringbuffer.hpp"
 #include "base/shared.hpp"
@@ -173,6 +174,7 @@ struct RedisConnInfo final : SharedObject
 		double GetOldestPendingQueryTs() const;
 
 		void SetConnectedCallback(std::function<void(boost::asio::yield_context& yc)> callback);
+		void RegisterMetrics(const MetricLabels& labels);
 
 		int GetQueryCount(RingBuffer::SizeType span);
 
@@ -347,6 +349,9 @@ struct RedisConnInfo final : SharedObject
 		// Number of pending Redis queries, always 0 if m_Parent is set unless m_TrackOwnPendingQueries is true.
 		std::atomic_size_t m_PendingQueries{0};
 		bool m_TrackOwnPendingQueries; // Whether to track pending queries even if m_Parent is set.
+		std::shared_ptr<MetricGauge> m_PendingQueriesMetric = std::make_shared<MetricGauge>();
+		std::shared_ptr<MetricCounter> m_QueriesMetric = std::make_shared<MetricCounter>();
+		std::shared_ptr<MetricLatencyHistogram> m_QueueWaitMetric = std::make_shared<MetricLatencyHistogram>();
 		boost::asio::steady_timer m_LogStatsTimer;
 		Ptr m_Parent;
 	};
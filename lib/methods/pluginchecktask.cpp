@@ -4,6 +4,7 @@
 #include "methods/pluginchecktask.hpp"
 #include "icinga/pluginutility.hpp"
 #include "icinga/checkcommand.hpp"
+#include "icinga/checktrace.hpp"
 #include "icinga/macroprocessor.hpp"
 #include "base/configtype.hpp"
 #include "base/logger.hpp"
@@ -95,5 +96,9 @@ void PluginCheckTask::ProcessFinishedHandler(const Checkable::Ptr& checkable, co
 	cr->SetExecutionStart(pr.ExecutionStart);
 	cr->SetExecutionEnd(pr.ExecutionEnd);
 
+	if (auto& trace (cr->GetTrace()); trace) {
+		trace->Record(CheckTraceStage::PluginRuntime, pr.ExecutionEnd - pr.ExecutionStart);
+	}
+
 	checkable->ProcessCheckResult(cr, producer);
 }
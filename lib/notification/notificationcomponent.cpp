@@ -11,7 +11,10 @@
 #include "base/utility.hpp"
 #include "base/exception.hpp"
 #include "base/statsfunction.hpp"
+#include "base/perfdatavalue.hpp"
+#include "base/convert.hpp"
 #include "remote/apilistener.hpp"
+#include <limits>
 
 using namespace icinga;
 
@@ -19,12 +22,31 @@ REGISTER_TYPE(NotificationComponent);
 
 REGISTER_STATSFUNCTION(NotificationComponent, &NotificationComponent::StatsFunc);
 
-void NotificationComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+void NotificationComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	DictionaryData nodes;
 
 	for (const NotificationComponent::Ptr& notification_component : ConfigType::GetObjectsByType<NotificationComponent>()) {
-		nodes.emplace_back(notification_component->GetName(), 1); //add more stats
+		unsigned long scheduled, due;
+		double lag;
+
+		{
+			std::unique_lock<std::mutex> lock(notification_component->m_Mutex);
+			scheduled = notification_component->m_ScheduledNotifications.size();
+			due = notification_component->m_LastTickDue;
+			lag = notification_component->m_LastTickLag;
+		}
+
+		nodes.emplace_back(notification_component->GetName(), new Dictionary({
+			{ "scheduled", scheduled },
+			{ "due", due },
+			{ "lag", lag }
+		}));
+
+		String perfdata_prefix = "notificationcomponent_" + notification_component->GetName() + "_";
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "scheduled", Convert::ToDouble(scheduled)));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "due", Convert::ToDouble(due)));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "lag", lag));
 	}
 
 	status->Set("notificationcomponent", new Dictionary(std::move(nodes)));
@@ -45,6 +67,55 @@ void NotificationComponent::Start(bool runtimeCreated)
 		SendNotificationsHandler(checkable, type, cr, author, text);
 	});
 
+	ConfigObject::OnActiveChanged.connect([this](const ConfigObject::Ptr& object, const Value&) {
+		if (auto notification = dynamic_pointer_cast<Notification>(object); notification) {
+			ScheduleNotification(notification);
+		}
+	});
+	ConfigObject::OnPausedChanged.connect([this](const ConfigObject::Ptr& object, const Value&) {
+		if (auto notification = dynamic_pointer_cast<Notification>(object); notification) {
+			ScheduleNotification(notification);
+		}
+	});
+
+	/* Notification::OnNextNotificationChanged is another signal which hides the generated one. */
+	ObjectImpl<Notification>::OnNextNotificationChanged.connect([this](const Notification::Ptr& notification, const Value&) {
+		ScheduleNotification(notification);
+	});
+
+	Notification::OnIntervalChanged.connect([this](const Notification::Ptr& notification, const Value&) {
+		ScheduleNotification(notification);
+	});
+	Notification::OnNoMoreNotificationsChanged.connect([this](const Notification::Ptr& notification, const Value&) {
+		ScheduleNotification(notification);
+	});
+	Notification::OnSuppressedNotificationsChanged.connect([this](const Notification::Ptr& notification, const Value&) {
+		ScheduleNotification(notification);
+	});
+	Notification::OnStashedNotificationsChanged.connect([this](const Notification::Ptr& notification, const Value&) {
+		ScheduleNotification(notification);
+	});
+
+	Checkable::OnEnableNotificationsChanged.connect([this](const Checkable::Ptr& checkable, const Value&) {
+		ScheduleNotifications(checkable);
+	});
+	Checkable::OnStateRawChanged.connect([this](const Checkable::Ptr& checkable, const Value&) {
+		ScheduleNotifications(checkable);
+	});
+	Checkable::OnStateTypeChanged.connect([this](const Checkable::Ptr& checkable, const Value&) {
+		ScheduleNotifications(checkable);
+	});
+
+	IcingaApplication::OnEnableNotificationsChanged.connect([this](const IcingaApplication::Ptr&, const Value&) {
+		for (const Notification::Ptr& notification : ConfigType::GetObjectsByType<Notification>()) {
+			ScheduleNotification(notification);
+		}
+	});
+
+	for (const Notification::Ptr& notification : ConfigType::GetObjectsByType<Notification>()) {
+		ScheduleNotification(notification);
+	}
+
 	m_NotificationTimer = Timer::Create();
 	m_NotificationTimer->SetInterval(5);
 	m_NotificationTimer->OnTimerExpired.connect([this](const Timer * const&) { NotificationTimerHandler(); });
@@ -124,6 +195,8 @@ void FireSuppressedNotifications(const Notification::Ptr& notification)
 /**
  * Periodically sends notifications.
  *
+ * Only looks at the notifications which are due, see GetNextDue().
+ *
  * @param - Event arguments for the timer.
  */
 void NotificationComponent::NotificationTimerHandler()
@@ -133,131 +206,241 @@ void NotificationComponent::NotificationTimerHandler()
 	/* Function already checks whether 'api' feature is enabled. */
 	Endpoint::Ptr myEndpoint = Endpoint::GetLocalEndpoint();
 
-	for (const Notification::Ptr& notification : ConfigType::GetObjectsByType<Notification>()) {
-		if (!notification->IsActive())
-			continue;
+	std::vector<Notification::Ptr> notifications;
+	double firstDue = now;
 
-		String notificationName = notification->GetName();
-		bool updatedObjectAuthority = ApiListener::UpdatedObjectAuthority();
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
 
-		/* Skip notification if paused, in a cluster setup & HA feature is enabled. */
-		if (notification->IsPaused()) {
-			if (updatedObjectAuthority) {
-				auto stashedNotifications (notification->GetStashedNotifications());
-				ObjectLock olock(stashedNotifications);
+		typedef boost::multi_index::nth_index<NotificationSet, 1>::type NextDueView;
+		NextDueView& idx = boost::get<1>(m_ScheduledNotifications);
 
-				if (stashedNotifications->GetLength()) {
-					Log(LogNotice, "NotificationComponent")
-						<< "Notification '" << notificationName << "': HA cluster active, this endpoint does not have the authority. Dropping all stashed notifications.";
+		if (!idx.empty()) {
+			firstDue = idx.begin()->NextDue;
+		}
 
-					stashedNotifications->Clear();
-				}
-			}
+		for (auto it (idx.begin()); it != idx.end() && it->NextDue <= now; ++it) {
+			notifications.emplace_back(it->Object);
+		}
+	}
 
-			if (myEndpoint && GetEnableHA()) {
+	for (const Notification::Ptr& notification : notifications) {
+		ProcessNotification(notification, now, myEndpoint);
+		ScheduleNotification(notification);
+	}
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_LastTickDue = notifications.size();
+	m_LastTickLag = notifications.empty() ? 0 : Utility::GetTime() - firstDue;
+}
+
+/**
+ * Sends the stashed, previously suppressed and reminder notifications of the given notification, if any.
+ */
+void NotificationComponent::ProcessNotification(const Notification::Ptr& notification, double now, const Endpoint::Ptr& myEndpoint)
+{
+	if (!notification->IsActive())
+		return;
+
+	String notificationName = notification->GetName();
+	bool updatedObjectAuthority = ApiListener::UpdatedObjectAuthority();
+
+	/* Skip notification if paused, in a cluster setup & HA feature is enabled. */
+	if (notification->IsPaused()) {
+		if (updatedObjectAuthority) {
+			auto stashedNotifications (notification->GetStashedNotifications());
+			ObjectLock olock(stashedNotifications);
+
+			if (stashedNotifications->GetLength()) {
 				Log(LogNotice, "NotificationComponent")
-					<< "Reminder notification '" << notificationName << "': HA cluster active, this endpoint does not have the authority (paused=true). Skipping.";
-				continue;
+					<< "Notification '" << notificationName << "': HA cluster active, this endpoint does not have the authority. Dropping all stashed notifications.";
+
+				stashedNotifications->Clear();
 			}
 		}
 
-		Checkable::Ptr checkable = notification->GetCheckable();
-		ObjectLock lock{checkable};
+		if (myEndpoint && GetEnableHA()) {
+			Log(LogNotice, "NotificationComponent")
+				<< "Reminder notification '" << notificationName << "': HA cluster active, this endpoint does not have the authority (paused=true). Skipping.";
+			return;
+		}
+	}
+
+	Checkable::Ptr checkable = notification->GetCheckable();
+	ObjectLock lock{checkable};
 
-		if (!IcingaApplication::GetInstance()->GetEnableNotifications() || !checkable->GetEnableNotifications())
-			continue;
+	if (!IcingaApplication::GetInstance()->GetEnableNotifications() || !checkable->GetEnableNotifications())
+		return;
 
-		bool reachable = checkable->IsReachable(DependencyNotification);
+	bool reachable = checkable->IsReachable(DependencyNotification);
+
+	if (reachable) {
+		{
+			Array::Ptr unstashedNotifications = new Array();
 
-		if (reachable) {
 			{
-				Array::Ptr unstashedNotifications = new Array();
+				auto stashedNotifications (notification->GetStashedNotifications());
+				ObjectLock olock(stashedNotifications);
 
-				{
-					auto stashedNotifications (notification->GetStashedNotifications());
-					ObjectLock olock(stashedNotifications);
+				stashedNotifications->CopyTo(unstashedNotifications);
+				stashedNotifications->Clear();
+			}
 
-					stashedNotifications->CopyTo(unstashedNotifications);
-					stashedNotifications->Clear();
-				}
+			ObjectLock olock(unstashedNotifications);
 
-				ObjectLock olock(unstashedNotifications);
-
-				for (Dictionary::Ptr unstashedNotification : unstashedNotifications) {
-					if (!unstashedNotification)
-						continue;
-
-					try {
-						Log(LogNotice, "NotificationComponent")
-							<< "Attempting to send stashed notification '" << notificationName << "'.";
-
-						notification->BeginExecuteNotification(
-							(NotificationType)(int)unstashedNotification->Get("notification_type"),
-							(CheckResult::Ptr)unstashedNotification->Get("cr"),
-							(bool)unstashedNotification->Get("force"),
-							(bool)unstashedNotification->Get("reminder"),
-							(String)unstashedNotification->Get("author"),
-							(String)unstashedNotification->Get("text")
-						);
-					} catch (const std::exception& ex) {
-						Log(LogWarning, "NotificationComponent")
-							<< "Exception occurred during notification for object '"
-							<< notificationName << "': " << DiagnosticInformation(ex, false);
-					}
+			for (Dictionary::Ptr unstashedNotification : unstashedNotifications) {
+				if (!unstashedNotification)
+					continue;
+
+				try {
+					Log(LogNotice, "NotificationComponent")
+						<< "Attempting to send stashed notification '" << notificationName << "'.";
+
+					notification->BeginExecuteNotification(
+						(NotificationType)(int)unstashedNotification->Get("notification_type"),
+						(CheckResult::Ptr)unstashedNotification->Get("cr"),
+						(bool)unstashedNotification->Get("force"),
+						(bool)unstashedNotification->Get("reminder"),
+						(String)unstashedNotification->Get("author"),
+						(String)unstashedNotification->Get("text")
+					);
+				} catch (const std::exception& ex) {
+					Log(LogWarning, "NotificationComponent")
+						<< "Exception occurred during notification for object '"
+						<< notificationName << "': " << DiagnosticInformation(ex, false);
 				}
 			}
-
-			FireSuppressedNotifications(notification);
 		}
 
-		if (notification->GetInterval() <= 0 && notification->GetNoMoreNotifications()) {
-			Log(LogNotice, "NotificationComponent")
-				<< "Reminder notification '" << notificationName << "': Notification was sent out once and interval=0 disables reminder notifications.";
-			continue;
-		}
+		FireSuppressedNotifications(notification);
+	}
 
-		if (notification->GetNextNotification() > now)
-			continue;
+	if (notification->GetInterval() <= 0 && notification->GetNoMoreNotifications()) {
+		Log(LogNotice, "NotificationComponent")
+			<< "Reminder notification '" << notificationName << "': Notification was sent out once and interval=0 disables reminder notifications.";
+		return;
+	}
 
-		{
-			ObjectLock olock(notification);
-			notification->SetNextNotification(Utility::GetTime() + notification->GetInterval());
-		}
+	if (notification->GetNextNotification() > now)
+		return;
 
-		{
-			Host::Ptr host;
-			Service::Ptr service;
-			tie(host, service) = GetHostService(checkable);
+	{
+		ObjectLock olock(notification);
+		notification->SetNextNotification(Utility::GetTime() + notification->GetInterval());
+	}
 
-			if (checkable->GetStateType() == StateTypeSoft)
-				continue;
+	{
+		Host::Ptr host;
+		Service::Ptr service;
+		tie(host, service) = GetHostService(checkable);
 
-			/* Don't send reminder notifications for OK/Up states. */
-			if ((service && service->GetState() == ServiceOK) || (!service && host->GetState() == HostUp))
-				continue;
+		if (checkable->GetStateType() == StateTypeSoft)
+			return;
 
-			/* Don't send reminder notifications before initial ones. */
-			if (checkable->GetSuppressedNotifications() & NotificationProblem || notification->GetSuppressedNotifications() & NotificationProblem)
-				continue;
+		/* Don't send reminder notifications for OK/Up states. */
+		if ((service && service->GetState() == ServiceOK) || (!service && host->GetState() == HostUp))
+			return;
 
-			/* Skip in runtime filters. */
-			if (!reachable || checkable->IsInDowntime() || checkable->IsAcknowledged() || checkable->IsFlapping())
-				continue;
-		}
+		/* Don't send reminder notifications before initial ones. */
+		if (checkable->GetSuppressedNotifications() & NotificationProblem || notification->GetSuppressedNotifications() & NotificationProblem)
+			return;
 
-		try {
-			Log(LogNotice, "NotificationComponent")
-				<< "Attempting to send reminder notification '" << notificationName << "'.";
+		/* Skip in runtime filters. */
+		if (!reachable || checkable->IsInDowntime() || checkable->IsAcknowledged() || checkable->IsFlapping())
+			return;
+	}
 
-			notification->BeginExecuteNotification(NotificationProblem, checkable->GetLastCheckResult(), false, true);
-		} catch (const std::exception& ex) {
-			Log(LogWarning, "NotificationComponent")
-				<< "Exception occurred during notification for object '"
-				<< notificationName << "': " << DiagnosticInformation(ex, false);
-		}
+	try {
+		Log(LogNotice, "NotificationComponent")
+			<< "Attempting to send reminder notification '" << notificationName << "'.";
+
+		notification->BeginExecuteNotification(NotificationProblem, checkable->GetLastCheckResult(), false, true);
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "NotificationComponent")
+			<< "Exception occurred during notification for object '"
+			<< notificationName << "': " << DiagnosticInformation(ex, false);
 	}
 }
 
+/**
+ * Determines when the timer has to look at the given notification next.
+ *
+ * Notifications with stashed or suppressed notifications are due on every run of the timer, as whether
+ * these can be sent depends on e.g. reachability and time periods. Other notifications are due when
+ * their next reminder is. Notifications the timer would skip anyway are not due at all until one of
+ * the events NotificationComponent listens to changes that.
+ *
+ * @return The time the notification is due at or +infinity
+ */
+double NotificationComponent::GetNextDue(const Notification::Ptr& notification, double now)
+{
+	if (notification->GetStashedNotifications()->GetLength())
+		return now;
+
+	/* Function already checks whether 'api' feature is enabled. */
+	if (notification->IsPaused() && Endpoint::GetLocalEndpoint() && GetEnableHA())
+		return std::numeric_limits<double>::infinity();
+
+	Checkable::Ptr checkable = notification->GetCheckable();
+
+	if (!IcingaApplication::GetInstance()->GetEnableNotifications() || !checkable->GetEnableNotifications())
+		return std::numeric_limits<double>::infinity();
+
+	if (notification->GetSuppressedNotifications())
+		return now;
+
+	if (notification->GetInterval() <= 0) {
+		if (notification->GetNoMoreNotifications())
+			return std::numeric_limits<double>::infinity();
+
+		/* Without an interval the timer merely moves the next reminder to now for OK/Up and soft states,
+		 * so these can wait for the next state change instead of being due on every run.
+		 */
+		Host::Ptr host;
+		Service::Ptr service;
+		tie(host, service) = GetHostService(checkable);
+
+		if (checkable->GetStateType() == StateTypeSoft || (service && service->GetState() == ServiceOK) || (!service && host->GetState() == HostUp))
+			return std::numeric_limits<double>::infinity();
+	}
+
+	return notification->GetNextNotification();
+}
+
+/**
+ * (Re-)schedules the given notification according to its current state.
+ */
+void NotificationComponent::ScheduleNotification(const Notification::Ptr& notification)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	/* Determine the due time while holding the lock, so that the last event wins. */
+	double nextDue = notification->IsActive() ? GetNextDue(notification, Utility::GetTime()) : std::numeric_limits<double>::infinity();
+
+	typedef boost::multi_index::nth_index<NotificationSet, 0>::type NotificationView;
+	NotificationView& idx = boost::get<0>(m_ScheduledNotifications);
+
+	idx.erase(notification);
+
+	if (nextDue < std::numeric_limits<double>::infinity()) {
+		idx.insert(NotificationScheduleInfo{ notification, nextDue });
+	}
+}
+
+void NotificationComponent::ScheduleNotifications(const Checkable::Ptr& checkable)
+{
+	for (const Notification::Ptr& notification : checkable->GetNotifications()) {
+		ScheduleNotification(notification);
+	}
+}
+
+unsigned long NotificationComponent::GetScheduledNotifications()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	return m_ScheduledNotifications.size();
+}
+
 /**
  * Processes icinga::SendNotifications messages.
  */
@@ -6,12 +6,27 @@
 
 #include "notification/notificationcomponent-ti.hpp"
 #include "icinga/service.hpp"
+#include "icinga/notification.hpp"
+#include "remote/endpoint.hpp"
 #include "base/configobject.hpp"
 #include "base/timer.hpp"
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/key_extractors.hpp>
+#include <mutex>
 
 namespace icinga
 {
 
+/**
+ * @ingroup notification
+ */
+struct NotificationScheduleInfo
+{
+	Notification::Ptr Object;
+	double NextDue;
+};
+
 /**
  * @ingroup notification
  */
@@ -21,15 +36,36 @@ public:
 	DECLARE_OBJECT(NotificationComponent);
 	DECLARE_OBJECTNAME(NotificationComponent);
 
+	typedef boost::multi_index_container<
+		NotificationScheduleInfo,
+		boost::multi_index::indexed_by<
+			boost::multi_index::ordered_unique<boost::multi_index::member<NotificationScheduleInfo, Notification::Ptr, &NotificationScheduleInfo::Object> >,
+			boost::multi_index::ordered_non_unique<boost::multi_index::member<NotificationScheduleInfo, double, &NotificationScheduleInfo::NextDue> >
+		>
+	> NotificationSet;
+
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 	void Start(bool runtimeCreated) override;
 	void Stop(bool runtimeRemoved) override;
 
+	unsigned long GetScheduledNotifications();
+
 private:
 	Timer::Ptr m_NotificationTimer;
 
+	std::mutex m_Mutex;
+	NotificationSet m_ScheduledNotifications;
+	unsigned long m_LastTickDue{0};
+	double m_LastTickLag{0};
+
 	void NotificationTimerHandler();
+	void ProcessNotification(const Notification::Ptr& notification, double now, const Endpoint::Ptr& myEndpoint);
+
+	void ScheduleNotification(const Notification::Ptr& notification);
+	void ScheduleNotifications(const Checkable::Ptr& checkable);
+	double GetNextDue(const Notification::Ptr& notification, double now);
+
 	void SendNotificationsHandler(const Checkable::Ptr& checkable, NotificationType type,
 		const CheckResult::Ptr& cr, const String& author, const String& text);
 };
@@ -151,7 +151,7 @@ void OTel::Stop()
  *
  * @param request The OTel metrics request to export.
  */
-void OTel::Export(std::unique_ptr<MetricsRequest>&& request)
+void OTel::Export(std::shared_ptr<MetricsRequest> request)
 {
 	std::unique_lock lock(m_Mutex);
 	if (m_Exporting) {
@@ -185,12 +185,12 @@ void OTel::Export(std::unique_ptr<MetricsRequest>&& request)
  * [^1]: https://opentelemetry.io/docs/specs/semconv/resource/#telemetry-sdk
  * [^2]: https://opentelemetry.io/docs/specs/semconv/resource/service/
  */
-void OTel::PopulateResourceAttrs(const std::unique_ptr<v1_metrics::ResourceMetrics>& rm)
+void OTel::PopulateResourceAttrs(v1_metrics::ResourceMetrics& rm)
 {
 	using namespace std::string_view_literals;
 
-	rm->set_schema_url(l_OTelSchemaConv.data());
-	auto* resource = rm->mutable_resource();
+	rm.set_schema_url(l_OTelSchemaConv.data());
+	auto* resource = rm.mutable_resource();
 
 	auto* attr = resource->add_attributes();
 	SetAttribute(*attr, "service.name"sv, "Icinga 2"sv);
@@ -215,7 +215,7 @@ void OTel::PopulateResourceAttrs(const std::unique_ptr<v1_metrics::ResourceMetri
 	attr = resource->add_attributes();
 	SetAttribute(*attr, "telemetry.sdk.version"sv, Application::GetAppVersion());
 
-	auto* ism = rm->add_scope_metrics();
+	auto* ism = rm.add_scope_metrics();
 	ism->set_schema_url(l_OTelSchemaConv.data());
 	ism->mutable_scope()->set_name("icinga2");
 	ism->mutable_scope()->set_version(Application::GetAppVersion());
@@ -363,11 +363,17 @@ void OTel::ExportLoop(boost::asio::yield_context& yc)
 	}
 }
 
-void OTel::ExportImpl(boost::asio::yield_context& yc) const
+void OTel::ExportImpl(boost::asio::yield_context& yc)
 {
 	AsioProtobufOutStream outputS{*m_Stream, m_ConnInfo, yc};
+	auto start = std::chrono::steady_clock::now();
 	[[maybe_unused]] auto serialized = m_Request->SerializeToZeroCopyStream(&outputS);
 	ASSERT(serialized);
+
+	// The serializer writes to the network as it goes, so the time spent waiting for it must be subtracted.
+	auto encodeTime = std::chrono::steady_clock::now() - start - outputS.GetWriteTime();
+	m_LastEncodeTime.store(std::chrono::duration<double>(encodeTime).count(), std::memory_order_relaxed);
+
 	// Must have completed chunk writing successfully, otherwise reading the response will hang forever.
 	if (!outputS.WriterDone()) {
 		BOOST_THROW_EXCEPTION(std::runtime_error("BUG: Protobuf output stream writer did not complete successfully."));
@@ -583,6 +589,44 @@ std::size_t OTel::Record(Gauge& gauge, T data, double start, double end, AttrsMa
 	return dataPoint->ByteSizeLong();
 }
 
+/**
+ * Record the given aggregated values as a data point of the specified exponential histogram.
+ *
+ * The data point covers the values recorded between @c start and @c end only (delta temporality),
+ * so that the histogram can start from scratch for the next export.
+ *
+ * @param histogram The OTel exponential histogram metric stream to add the data point to.
+ * @param data The aggregated values.
+ * @param start The time of the first aggregated value in seconds.
+ * @param end The time of the last aggregated value in seconds.
+ * @param attrs The attributes associated with the data point.
+ *
+ * @return The size of the data point in bytes.
+ */
+std::size_t OTel::Record(ExponentialHistogram& histogram, const OTelHistogram& data, double start, double end, AttrsMap attrs)
+{
+	namespace ch = std::chrono;
+
+	histogram.set_aggregation_temporality(v1_metrics::AGGREGATION_TEMPORALITY_DELTA);
+
+	auto* dataPoint = histogram.add_data_points();
+	data.Encode(*dataPoint);
+
+	dataPoint->set_start_time_unix_nano(
+		static_cast<uint64_t>(ch::duration_cast<ch::nanoseconds>(ch::duration<double>(start)).count())
+	);
+	dataPoint->set_time_unix_nano(
+		static_cast<uint64_t>(ch::duration_cast<ch::nanoseconds>(ch::duration<double>(end)).count())
+	);
+
+	while (!attrs.empty()) {
+		auto* attr = dataPoint->add_attributes();
+		auto node = attrs.extract(attrs.begin());
+		SetAttribute(*attr, std::move(node.key()), std::move(node.mapped()));
+	}
+	return dataPoint->ByteSizeLong();
+}
+
 /**
  * Determine if the given HTTP status code represents a retryable export error as per OTel specs[^1].
  *
@@ -610,6 +654,11 @@ AsioProtobufOutStream::AsioProtobufOutStream(const AsioTlsOrTcpStream& stream, c
 	if (!connInfo.BasicAuth.IsEmpty()) {
 		m_Writer.set(http::field::authorization, "Basic " + connInfo.BasicAuth);
 	}
+	if (connInfo.GzipCompression) {
+		m_Writer.set(http::field::content_encoding, "gzip");
+		m_Compressor = std::make_unique<GzipCompressor>();
+		m_Staging = std::make_unique<char[]>(l_BufferSize);
+	}
 	m_Writer.StartStreaming();
 }
 
@@ -623,6 +672,13 @@ bool AsioProtobufOutStream::Next(void** data, int* size)
 	// segment was fully used (which is always the case on each Next call after the initial one), so
 	// we'll end up reusing the same memory region for each Next call because when we flush, we also
 	// consume the committed data, and that region becomes writable again.
+	if (m_Compressor) {
+		*data = m_Staging.get();
+		*size = static_cast<int>(l_BufferSize);
+		m_Buffered = l_BufferSize;
+		return true;
+	}
+
 	auto buf = m_Writer.Prepare(l_BufferSize - m_Buffered);
 	*data = buf.data();
 	*size = static_cast<int>(l_BufferSize);
@@ -661,8 +717,20 @@ int64_t AsioProtobufOutStream::ByteCount() const
 void AsioProtobufOutStream::Flush(bool finish)
 {
 	ASSERT(m_Buffered > 0 || finish);
-	m_Writer.Commit(m_Buffered);
+	if (m_Compressor) {
+		// Compress the staged data into the writer's buffer. Without finish, zlib may keep some of it back
+		// for the next flush, so there might be nothing to write this time, which the writer tolerates.
+		m_Compressor->SetInput(m_Staging.get(), m_Buffered);
+		do {
+			auto buf = m_Writer.Prepare(l_BufferSize);
+			m_Writer.Commit(m_Compressor->Deflate(static_cast<char*>(buf.data()), buf.size(), finish));
+		} while (finish ? !m_Compressor->IsFinished() : !m_Compressor->IsInputConsumed());
+	} else {
+		m_Writer.Commit(m_Buffered);
+	}
+	auto start = std::chrono::steady_clock::now();
 	m_Writer.Flush(m_YieldContext, finish);
+	m_WriteTime += std::chrono::steady_clock::now() - start;
 	m_Pos += static_cast<int64_t>(m_Buffered);
 	m_Buffered = 0;
 }
@@ -676,3 +744,55 @@ bool AsioProtobufOutStream::WriterDone()
 {
 	return m_Writer.Done();
 }
+
+/**
+ * Create an empty OTel metrics request on a recycled arena.
+ *
+ * The arena is recycled once the last reference to the request is gone, e.g. after it has been exported.
+ *
+ * @return The request.
+ */
+std::shared_ptr<OTel::MetricsRequest> OTelArenaPool::NewRequest()
+{
+	Slot* slot;
+	{
+		std::lock_guard lock(m_Mutex);
+		if (m_FreeSlots.empty()) {
+			slot = m_Slots.emplace_back(std::make_unique<Slot>()).get();
+			slot->Arena.emplace();
+		} else {
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+	}
+
+	auto* request = OTel::MetricsRequest::default_instance().New(&*slot->Arena);
+	// The request is owned by the arena, so the deleter just hands the arena back to the pool.
+	return {request, [pool = Ptr(this), slot](OTel::MetricsRequest*) { pool->Recycle(*slot); }};
+}
+
+void OTelArenaPool::Recycle(Slot& slot)
+{
+	auto allocated = static_cast<std::size_t>(slot.Arena->SpaceAllocated());
+
+	if (allocated > slot.BlockSize && slot.BlockSize < MaxBlockSize) {
+		// Grow the initial block, so that the next request of that size fits into it. The arena
+		// must be destroyed first, since it may still use the previous block.
+		auto blockSize = std::min(allocated, MaxBlockSize);
+
+		slot.Arena.reset();
+		slot.Block.reset(new char[blockSize]);
+		m_Bytes.fetch_add(blockSize - slot.BlockSize, std::memory_order_relaxed);
+		slot.BlockSize = blockSize;
+
+		google::protobuf::ArenaOptions options;
+		options.initial_block = slot.Block.get();
+		options.initial_block_size = slot.BlockSize;
+		slot.Arena.emplace(options);
+	} else {
+		slot.Arena->Reset();
+	}
+
+	std::lock_guard lock(m_Mutex);
+	m_FreeSlots.emplace_back(&slot);
+}
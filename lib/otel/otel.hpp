@@ -3,20 +3,26 @@
 
 #pragma once
 
+#include "base/gzipcompressor.hpp"
 #include "base/io-engine.hpp"
 #include "base/tlsstream.hpp"
 #include "base/shared.hpp"
 #include "base/shared-object.hpp"
 #include "base/string.hpp"
+#include "otel/otelhistogram.hpp"
 #include "remote/httpmessage.hpp"
 #include "otel/opentelemetry/proto/collector/metrics/v1/metrics_service.pb.h"
 #include <boost/asio/steady_timer.hpp>
+#include <google/protobuf/arena.h>
 #include <google/protobuf/io/zero_copy_stream.h>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <vector>
 
 namespace icinga
 {
@@ -37,6 +43,7 @@ struct OTelConnInfo
 	String TlsKey;
 	String MetricsEndpoint;
 	String BasicAuth; // Base64-encoded "username:password" string for basic authentication.
+	bool GzipCompression{false}; // Whether to send the request bodies gzip-compressed.
 };
 
 /**
@@ -61,6 +68,8 @@ public:
 	using Attribute = opentelemetry::proto::common::v1::KeyValue;
 	// Protobuf Gauge type used for representing OTel Gauge metric streams.
 	using Gauge = opentelemetry::proto::metrics::v1::Gauge;
+	// Protobuf ExponentialHistogram type used for representing aggregated OTel metric streams.
+	using ExponentialHistogram = opentelemetry::proto::metrics::v1::ExponentialHistogram;
 
 	/**
 	 * Represents a collection of OTel attributes[^1] as key-value pairs.
@@ -73,7 +82,7 @@ public:
 
 	void Start();
 	void Stop();
-	void Export(std::unique_ptr<MetricsRequest>&& request);
+	void Export(std::shared_ptr<MetricsRequest> request);
 
 	bool Exporting() const
 	{
@@ -83,7 +92,14 @@ public:
 
 	bool Stopped() const { return m_Stopped.load(); }
 
-	static void PopulateResourceAttrs(const std::unique_ptr<opentelemetry::proto::metrics::v1::ResourceMetrics>& rm);
+	/**
+	 * Get the time spent on serializing and compressing the last exported request, excluding network I/O.
+	 *
+	 * @return The time in seconds.
+	 */
+	double GetLastEncodeTime() const { return m_LastEncodeTime.load(std::memory_order_relaxed); }
+
+	static void PopulateResourceAttrs(opentelemetry::proto::metrics::v1::ResourceMetrics& rm);
 	static void ValidateName(std::string_view name);
 	template<typename Key, typename AttrVal, typename = std::enable_if_t<
 		std::is_constructible_v<std::string, Key> && (
@@ -98,13 +114,20 @@ public:
 		std::is_same_v<std::decay_t<T>, int64_t> || std::is_same_v<std::decay_t<T>, double>>
 	>
 	[[nodiscard]] static std::size_t Record(Gauge& gauge, T data, double start, double end, AttrsMap attrs);
+	[[nodiscard]] static std::size_t Record(
+		ExponentialHistogram& histogram,
+		const OTelHistogram& data,
+		double start,
+		double end,
+		AttrsMap attrs
+	);
 
 private:
 	OTel(OTelConnInfo& connInfo, boost::asio::io_context& io);
 
 	void Connect(boost::asio::yield_context& yc);
 	void ExportLoop(boost::asio::yield_context& yc);
-	void ExportImpl(boost::asio::yield_context& yc) const;
+	void ExportImpl(boost::asio::yield_context& yc);
 
 	void ResetExporting(bool notifyAll = false);
 
@@ -120,9 +143,10 @@ private:
 	// Mutex and condition variable for synchronizing concurrent export requests.
 	mutable std::mutex m_Mutex;
 	std::condition_variable m_ExportCV;
-	std::unique_ptr<MetricsRequest> m_Request; // Current export request being processed (if any).
+	std::shared_ptr<MetricsRequest> m_Request; // Current export request being processed (if any).
 	bool m_Exporting; // Whether an export operation is in progress.
 	std::atomic_bool m_Stopped; // Whether someone has requested to stop the exporter.
+	std::atomic<double> m_LastEncodeTime{0}; // See GetLastEncodeTime().
 };
 extern template std::size_t OTel::Record(Gauge&, int64_t, double, double, AttrsMap);
 extern template std::size_t OTel::Record(Gauge&, double, double, double, AttrsMap);
@@ -138,6 +162,9 @@ extern template void OTel::SetAttribute(Attribute&, String&&, Value&);
  * request writer (@c HttpRequestWriter) in a Protobuf binary format. It is not safe to be reused across
  * multiple export calls.
  *
+ * With gzip compression enabled, the serializer writes into a staging buffer instead, which is compressed
+ * into the request writer's buffer on each flush.
+ *
  * @ingroup otel
  */
 class AsioProtobufOutStream final : public google::protobuf::io::ZeroCopyOutputStream
@@ -151,13 +178,64 @@ public:
 
 	bool WriterDone();
 
+	/**
+	 * Get the time spent on writing to the underlying stream so far, i.e. waiting for the network.
+	 */
+	std::chrono::steady_clock::duration GetWriteTime() const { return m_WriteTime; }
+
 private:
 	void Flush(bool finish = false);
 
 	int64_t m_Pos{0}; // Monotonically increasing byte position in the stream (excluding m_Buffered bytes).
 	std::size_t m_Buffered{0}; // Number of uncommitted bytes currently buffered.
 	OutgoingHttpRequest m_Writer;
+	std::unique_ptr<GzipCompressor> m_Compressor; // Only set if gzip compression is enabled.
+	std::unique_ptr<char[]> m_Staging; // Uncompressed data not yet passed to m_Compressor.
 	boost::asio::yield_context m_YieldContext; // Yield context for async operations.
+	std::chrono::steady_clock::duration m_WriteTime{0}; // See GetWriteTime().
+};
+
+/**
+ * Recycles the Protobuf arenas OTel metrics requests are allocated on.
+ *
+ * A request and all of its messages are allocated on one arena, so that they are freed at once after the
+ * export. The arena then gets its memory from a single block sized after the previous request, so that a
+ * writer recording similar amounts of data in each flush interval doesn't need to allocate memory at all.
+ *
+ * @ingroup otel
+ */
+class OTelArenaPool final : public SharedObject
+{
+public:
+	DECLARE_PTR_TYPEDEFS(OTelArenaPool);
+
+	// Upper bound for the memory kept per arena.
+	static constexpr std::size_t MaxBlockSize = 64UL * 1024 * 1024;
+
+	std::shared_ptr<OTel::MetricsRequest> NewRequest();
+
+	/**
+	 * Get the memory kept for reuse by all arenas.
+	 *
+	 * @return The size in bytes.
+	 */
+	uint64_t GetBytes() const { return m_Bytes.load(std::memory_order_relaxed); }
+
+private:
+	struct Slot
+	{
+		// Declared before the arena, so that it outlives the arena using it.
+		std::unique_ptr<char[]> Block;
+		std::size_t BlockSize{0};
+		std::optional<google::protobuf::Arena> Arena;
+	};
+
+	void Recycle(Slot& slot);
+
+	std::mutex m_Mutex;
+	std::vector<std::unique_ptr<Slot>> m_Slots;
+	std::vector<Slot*> m_FreeSlots;
+	std::atomic<uint64_t> m_Bytes{0};
 };
 
 /**
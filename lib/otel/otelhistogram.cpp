@@ -0,0 +1,176 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "otel/otelhistogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace icinga;
+
+namespace v1_metrics = opentelemetry::proto::metrics::v1;
+
+/**
+ * Count the given value.
+ *
+ * NaN and infinite values can't be represented by an exponential histogram and are ignored.
+ *
+ * @param value The value to count.
+ */
+void OTelHistogram::Add(double value)
+{
+	if (!std::isfinite(value)) {
+		return;
+	}
+
+	++m_Count;
+	m_Sum += value;
+	m_Min = std::min(m_Min, value);
+	m_Max = std::max(m_Max, value);
+
+	if (value == 0) {
+		++m_ZeroCount;
+		return;
+	}
+
+	auto& buckets = value > 0 ? m_Positive : m_Negative;
+	auto index = MapToIndex(std::abs(value), m_Scale);
+
+	if (auto change = buckets.GetScaleChange(index); change > 0) {
+		// Both signs have to share the same scale.
+		m_Positive.Downscale(change);
+		m_Negative.Downscale(change);
+		m_Scale -= change;
+		index >>= change;
+	}
+
+	buckets.Increment(index);
+}
+
+/**
+ * Fill the given OTel data point with the aggregated values.
+ *
+ * @param dataPoint The data point to fill, its timestamps and attributes are left to the caller.
+ */
+void OTelHistogram::Encode(v1_metrics::ExponentialHistogramDataPoint& dataPoint) const
+{
+	dataPoint.set_scale(m_Scale);
+	dataPoint.set_count(m_Count);
+	dataPoint.set_zero_count(m_ZeroCount);
+	dataPoint.set_sum(m_Sum);
+
+	if (m_Count > 0) {
+		dataPoint.set_min(m_Min);
+		dataPoint.set_max(m_Max);
+	}
+
+	if (!m_Positive.Counts.empty()) {
+		m_Positive.Encode(*dataPoint.mutable_positive());
+	}
+
+	if (!m_Negative.Counts.empty()) {
+		m_Negative.Encode(*dataPoint.mutable_negative());
+	}
+}
+
+/**
+ * Compute the index of the bucket the given positive value belongs to.
+ *
+ * Buckets are upper-inclusive, i.e. bucket i holds the values in (base^i, base^(i+1)] where base is
+ * 2^(2^-scale). Exact powers of two are computed exactly, all other values via the logarithm, which
+ * may be off by one very close to a bucket boundary. That's permitted by the specification[^1].
+ *
+ * [^1]: https://opentelemetry.io/docs/specs/otel/metrics/data-model/#all-scales-use-the-logarithm-function
+ *
+ * @param value A positive, finite value.
+ * @param scale The histogram's scale.
+ *
+ * @return The bucket index.
+ */
+int64_t OTelHistogram::MapToIndex(double value, int scale)
+{
+	int exponent;
+	double fraction = std::frexp(value, &exponent); // value = fraction * 2^exponent with fraction in [0.5, 1)
+	bool powerOfTwo = fraction == 0.5;
+
+	if (scale <= 0) {
+		// The value lies in [2^(exponent-1), 2^exponent), and powers of two belong to the bucket below.
+		int64_t base2 = powerOfTwo ? exponent - 2 : exponent - 1;
+		return base2 >> -scale;
+	}
+
+	if (powerOfTwo) {
+		return (static_cast<int64_t>(exponent - 1) << scale) - 1;
+	}
+
+	double scaleFactor = std::ldexp(1 / std::log(2.0), scale);
+	return static_cast<int64_t>(std::ceil(std::log(value) * scaleFactor)) - 1;
+}
+
+/**
+ * Compute by how much the scale has to be reduced to make room for the given index.
+ *
+ * @param index The bucket index at the current scale.
+ *
+ * @return The scale change, 0 if the index fits already.
+ */
+int OTelHistogram::Buckets::GetScaleChange(int64_t index) const
+{
+	if (Counts.empty()) {
+		return 0;
+	}
+
+	int64_t low = std::min(Offset, index);
+	int64_t high = std::max(Offset + static_cast<int64_t>(Counts.size()) - 1, index);
+	int change = 0;
+
+	while ((high >> change) - (low >> change) + 1 > static_cast<int64_t>(MaxSize)) {
+		++change;
+	}
+
+	return change;
+}
+
+void OTelHistogram::Buckets::Increment(int64_t index)
+{
+	if (Counts.empty()) {
+		Offset = index;
+		Counts.assign(1, 0);
+	} else if (index < Offset) {
+		Counts.insert(Counts.begin(), Offset - index, 0);
+		Offset = index;
+	} else if (auto size = static_cast<int64_t>(Counts.size()); index >= Offset + size) {
+		Counts.resize(index - Offset + 1, 0);
+	}
+
+	++Counts[index - Offset];
+}
+
+/**
+ * Merge the buckets for a scale reduced by the given change, i.e. merge each 2^change neighbouring buckets.
+ */
+void OTelHistogram::Buckets::Downscale(int change)
+{
+	if (Counts.empty() || change == 0) {
+		return;
+	}
+
+	int64_t offset = Offset >> change;
+	std::vector<uint64_t> counts (((Offset + static_cast<int64_t>(Counts.size()) - 1) >> change) - offset + 1, 0);
+
+	for (std::size_t i = 0; i < Counts.size(); ++i) {
+		counts[((Offset + static_cast<int64_t>(i)) >> change) - offset] += Counts[i];
+	}
+
+	Offset = offset;
+	Counts = std::move(counts);
+}
+
+void OTelHistogram::Buckets::Encode(v1_metrics::ExponentialHistogramDataPoint::Buckets& buckets) const
+{
+	buckets.set_offset(static_cast<int32_t>(Offset));
+	buckets.mutable_bucket_counts()->Reserve(static_cast<int>(Counts.size()));
+
+	for (auto count : Counts) {
+		buckets.add_bucket_counts(count);
+	}
+}
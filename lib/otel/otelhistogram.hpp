@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "otel/opentelemetry/proto/metrics/v1/metrics.pb.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * Aggregates values into an OTel exponential histogram[^1].
+ *
+ * Values are counted in buckets whose boundaries grow exponentially by the factor 2^(2^-scale). The
+ * histogram starts with the highest resolution and halves it whenever the values wouldn't fit into
+ * @c MaxSize buckets anymore, so that the relative error stays small, no matter the range of values.
+ *
+ * [^1]: https://opentelemetry.io/docs/specs/otel/metrics/data-model/#exponentialhistogram
+ *
+ * @ingroup otel
+ */
+class OTelHistogram
+{
+public:
+	// The defaults recommended by the OTel SDK specification for the exponential histogram aggregation.
+	static constexpr int MaxScale = 20;
+	static constexpr std::size_t MaxSize = 160;
+
+	void Add(double value);
+
+	bool IsEmpty() const { return m_Count == 0; }
+	uint64_t GetCount() const { return m_Count; }
+	int GetScale() const { return m_Scale; }
+
+	void Encode(opentelemetry::proto::metrics::v1::ExponentialHistogramDataPoint& dataPoint) const;
+
+	static int64_t MapToIndex(double value, int scale);
+
+private:
+	/**
+	 * Contiguous bucket counts of one sign, Counts[0] being the count of the bucket with index Offset.
+	 */
+	struct Buckets
+	{
+		int64_t Offset{0};
+		std::vector<uint64_t> Counts;
+
+		int GetScaleChange(int64_t index) const;
+		void Increment(int64_t index);
+		void Downscale(int change);
+		void Encode(opentelemetry::proto::metrics::v1::ExponentialHistogramDataPoint::Buckets& buckets) const;
+	};
+
+	int m_Scale{MaxScale};
+	uint64_t m_Count{0};
+	uint64_t m_ZeroCount{0};
+	double m_Sum{0};
+	double m_Min{std::numeric_limits<double>::infinity()};
+	double m_Max{-std::numeric_limits<double>::infinity()};
+	Buckets m_Positive;
+	Buckets m_Negative;
+};
+
+} // namespace icinga
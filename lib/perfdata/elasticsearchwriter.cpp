@@ -10,6 +10,7 @@
 #include "icinga/macroprocessor.hpp"
 #include "icinga/checkcommand.hpp"
 #include "base/application.hpp"
+#include "base/configuration.hpp"
 #include "base/stream.hpp"
 #include "base/base64.hpp"
 #include "base/json.hpp"
@@ -33,6 +34,11 @@ void ElasticsearchWriter::OnConfigLoaded()
 
 	m_WorkQueue.SetName("ElasticsearchWriter, " + GetName());
 
+	/* One buffer per connection, the spool has to be replayed in order over a single one. */
+	while (m_DataBuffers.size() < (GetEnableSpool() ? 1u : static_cast<size_t>(GetConnections()))) {
+		m_DataBuffers.emplace_back();
+	}
+
 	if (!GetEnableHa()) {
 		Log(LogDebug, "ElasticsearchWriter")
 			<< "HA functionality disabled. Won't pause connection: " << GetName();
@@ -58,14 +64,37 @@ void ElasticsearchWriter::StatsFunc(const Dictionary::Ptr& status, const Array::
 	for (const ElasticsearchWriter::Ptr& elasticsearchwriter : ConfigType::GetObjectsByType<ElasticsearchWriter>()) {
 		size_t workQueueItems = elasticsearchwriter->m_WorkQueue.GetLength();
 		double workQueueItemRate = elasticsearchwriter->m_WorkQueue.GetTaskCount(60) / 60.0;
+		size_t dataBufferItems = 0;
+		size_t dataBufferBytes = 0;
+		auto pool (elasticsearchwriter->m_LockedPool.load());
+		auto spool (elasticsearchwriter->m_LockedSpool.load());
+
+		for (auto& dataBuffer : elasticsearchwriter->m_DataBuffers) {
+			dataBufferItems += dataBuffer.GetDataPoints();
+			dataBufferBytes += dataBuffer.GetBytes();
+		}
 
-		nodes.emplace_back(elasticsearchwriter->GetName(), new Dictionary({
+		Dictionary::Ptr node = new Dictionary({
 			{ "work_queue_items", workQueueItems },
-			{ "work_queue_item_rate", workQueueItemRate }
-		}));
+			{ "work_queue_item_rate", workQueueItemRate },
+			{ "data_buffer_items", dataBufferItems },
+			{ "data_buffer_bytes", dataBufferBytes }
+		});
+
+		if (pool) {
+			pool->AddStats(node, perfdata, "elasticsearchwriter_" + elasticsearchwriter->GetName());
+		}
+
+		if (spool) {
+			spool->AddStats(node, perfdata, "elasticsearchwriter_" + elasticsearchwriter->GetName());
+		}
+
+		nodes.emplace_back(elasticsearchwriter->GetName(), node);
 
 		perfdata->Add(new PerfdataValue("elasticsearchwriter_" + elasticsearchwriter->GetName() + "_work_queue_items", workQueueItems));
 		perfdata->Add(new PerfdataValue("elasticsearchwriter_" + elasticsearchwriter->GetName() + "_work_queue_item_rate", workQueueItemRate));
+		perfdata->Add(new PerfdataValue("elasticsearchwriter_" + elasticsearchwriter->GetName() + "_data_buffer_items", dataBufferItems));
+		perfdata->Add(new PerfdataValue("elasticsearchwriter_" + elasticsearchwriter->GetName() + "_data_buffer_bytes", dataBufferBytes, false, "bytes"));
 	}
 
 	status->Set("elasticsearchwriter", new Dictionary(std::move(nodes)));
@@ -95,14 +124,39 @@ void ElasticsearchWriter::Resume()
 
 	m_WorkQueue.SetExceptionCallback([this](std::exception_ptr exp) { ExceptionHandler(std::move(exp)); });
 
-	/* Setup timer for periodically flushing m_DataBuffer */
+	/* Setup timer for periodically flushing m_DataBuffers */
 	m_FlushTimer = Timer::Create();
 	m_FlushTimer->SetInterval(GetFlushInterval());
 	m_FlushTimer->OnTimerExpired.connect([this](const Timer * const&) { FlushTimeout(); });
 	m_FlushTimer->Start();
 	m_FlushTimer->Reschedule(0);
 
-	m_Connection = new PerfdataWriterConnection{this, GetHost(), GetPort(), m_SslContext, !GetInsecureNoverify()};
+	m_Pool = new PerfdataWriterConnectionPool{this, GetHost(), GetPort(), m_SslContext, !GetInsecureNoverify(), m_DataBuffers.size()};
+	m_LockedPool.store(m_Pool);
+
+	if (GetCompression() == "gzip" && !m_Compressor) {
+		m_Compressor = std::make_unique<GzipCompressor>();
+	}
+
+	if (GetEnableSpool()) {
+		if (!m_Spool) {
+			try {
+				m_Spool = std::make_shared<PerfdataSpool>(Configuration::SpoolDir + "/elasticsearchwriter/" + GetName(),
+					GetSpoolMaxSize(), "ElasticsearchWriter");
+				m_LockedSpool.store(m_Spool);
+			} catch (const std::exception& ex) {
+				Log(LogCritical, "ElasticsearchWriter")
+					<< "Unable to set up the spool, continuing without: " << DiagnosticInformation(ex, false);
+			}
+		}
+
+		if (m_Spool) {
+			m_SpoolReplayTimer = Timer::Create();
+			m_SpoolReplayTimer->SetInterval(1);
+			m_SpoolReplayTimer->OnTimerExpired.connect([this](const Timer * const&) { ReplaySpoolTimeout(); });
+			m_SpoolReplayTimer->Start();
+		}
+	}
 
 	/* Register for new metrics. */
 	m_HandleCheckResults = Checkable::OnNewCheckResult.connect([this](const Checkable::Ptr& checkable,
@@ -129,14 +183,19 @@ void ElasticsearchWriter::Pause()
 
 	m_FlushTimer->Stop(true);
 
+	if (m_SpoolReplayTimer) {
+		m_SpoolReplayTimer->Stop(true);
+	}
+
 	std::promise<void> queueDonePromise;
 	m_WorkQueue.Enqueue([&]() {
 		Flush();
+		m_Pool->Join();
 		queueDonePromise.set_value();
 	}, PriorityLow);
 
 	auto timeout = std::chrono::duration<double>{GetDisconnectTimeout()};
-	m_Connection->CancelAfterTimeout(queueDonePromise.get_future(), timeout);
+	m_Pool->CancelAfterTimeout(queueDonePromise.get_future(), timeout);
 
 	m_WorkQueue.Join();
 
@@ -202,24 +261,16 @@ void ElasticsearchWriter::AddCheckResult(const Dictionary::Ptr& fields, const Ch
 	CheckCommand::Ptr checkCommand = checkable->GetCheckCommand();
 
 	if (perfdata) {
-		for (const Value& val : perfdata) {
-			PerfdataValue::Ptr pdv;
-
-			if (val.IsObjectType<PerfdataValue>())
-				pdv = val;
-			else {
-				try {
-					pdv = PerfdataValue::Parse(val);
-				} catch (const std::exception&) {
-					Log(LogWarning, "ElasticsearchWriter")
-						<< "Ignoring invalid perfdata for checkable '"
-						<< checkable->GetName() << "' and command '"
-						<< checkCommand->GetName() << "' with value: " << val;
-					continue;
-				}
+		for (auto& pdv : *cr->GetParsedPerformanceData()) {
+			if (!pdv.Valid) {
+				Log(LogWarning, "ElasticsearchWriter")
+					<< "Ignoring invalid perfdata for checkable '"
+					<< checkable->GetName() << "' and command '"
+					<< checkCommand->GetName() << "' with value: " << pdv.Raw;
+				continue;
 			}
 
-			String escapedKey = pdv->GetLabel();
+			String escapedKey = pdv.Label;
 			boost::replace_all(escapedKey, " ", "_");
 			boost::replace_all(escapedKey, ".", "_");
 			boost::replace_all(escapedKey, "\\", "_");
@@ -227,19 +278,19 @@ void ElasticsearchWriter::AddCheckResult(const Dictionary::Ptr& fields, const Ch
 
 			String perfdataPrefix = prefix + "perfdata." + escapedKey;
 
-			fields->Set(perfdataPrefix + ".value", pdv->GetValue());
+			fields->Set(perfdataPrefix + ".value", pdv.Number);
 
-			if (!pdv->GetMin().IsEmpty())
-				fields->Set(perfdataPrefix + ".min", pdv->GetMin());
-			if (!pdv->GetMax().IsEmpty())
-				fields->Set(perfdataPrefix + ".max", pdv->GetMax());
-			if (!pdv->GetWarn().IsEmpty())
-				fields->Set(perfdataPrefix + ".warn", pdv->GetWarn());
-			if (!pdv->GetCrit().IsEmpty())
-				fields->Set(perfdataPrefix + ".crit", pdv->GetCrit());
+			if (!pdv.Min.IsEmpty())
+				fields->Set(perfdataPrefix + ".min", pdv.Min);
+			if (!pdv.Max.IsEmpty())
+				fields->Set(perfdataPrefix + ".max", pdv.Max);
+			if (!pdv.Warn.IsEmpty())
+				fields->Set(perfdataPrefix + ".warn", pdv.Warn);
+			if (!pdv.Crit.IsEmpty())
+				fields->Set(perfdataPrefix + ".crit", pdv.Crit);
 
-			if (!pdv->GetUnit().IsEmpty())
-				fields->Set(perfdataPrefix + ".unit", pdv->GetUnit());
+			if (!pdv.Unit.IsEmpty())
+				fields->Set(perfdataPrefix + ".unit", pdv.Unit);
 		}
 	}
 }
@@ -281,7 +332,7 @@ void ElasticsearchWriter::CheckResultHandler(const Checkable::Ptr& checkable, co
 	AddTemplateTags(fields, checkable, cr);
 
 	m_WorkQueue.Enqueue([this, checkable, cr, fields = std::move(fields)]() {
-		if (m_Connection->IsStopped()) {
+		if (m_Pool->IsStopped()) {
 			return;
 		}
 
@@ -324,7 +375,7 @@ void ElasticsearchWriter::StateChangeHandler(const Checkable::Ptr& checkable, co
 	AddTemplateTags(fields, checkable, cr);
 
 	m_WorkQueue.Enqueue([this, checkable, cr, fields = std::move(fields)]() {
-		if (m_Connection->IsStopped()) {
+		if (m_Pool->IsStopped()) {
 			return;
 		}
 
@@ -378,7 +429,7 @@ void ElasticsearchWriter::NotificationSentToAllUsersHandler(const Checkable::Ptr
 	AddTemplateTags(fields, checkable, cr);
 
 	m_WorkQueue.Enqueue([this, checkable, cr, fields = std::move(fields)]() {
-		if (m_Connection->IsStopped()) {
+		if (m_Pool->IsStopped()) {
 			return;
 		}
 
@@ -411,19 +462,26 @@ void ElasticsearchWriter::Enqueue(const Checkable::Ptr& checkable, const String&
 	/* Every payload needs a line describing the index.
 	 * We do it this way to avoid problems with a near full queue.
 	 */
-	String indexBody = "{\"index\": {} }\n";
-	String fieldsBody = JsonEncode(fields);
+	/* All data of a checkable goes over the same connection to keep it in order. */
+	auto index (PerfdataWriterConnectionPool::GetIndexFor(checkable.get(), m_DataBuffers.size()));
+	auto& dataBuffer (m_DataBuffers[index]);
+
+	std::string& body = dataBuffer.BeginDataPoint();
+	body.append("{\"index\": {} }\n");
+	auto fieldsBegin (body.size());
+	JsonEncoder(body).Encode(fields);
 
 	Log(LogDebug, "ElasticsearchWriter")
-		<< "Checkable '" << checkable->GetName() << "' adds to metric list: '" << fieldsBody << "'.";
+		<< "Checkable '" << checkable->GetName() << "' adds to metric list: '"
+		<< std::string_view(body).substr(fieldsBegin) << "'.";
 
-	m_DataBuffer.emplace_back(indexBody + fieldsBody);
+	dataBuffer.EndDataPoint();
 
 	/* Flush if we've buffered too much to prevent excessive memory use. */
-	if (static_cast<int>(m_DataBuffer.size()) >= GetFlushThreshold()) {
+	if (dataBuffer.ShouldFlush(GetFlushThreshold())) {
 		Log(LogDebug, "ElasticsearchWriter")
-			<< "Data buffer overflow writing " << m_DataBuffer.size() << " data points";
-		Flush();
+			<< "Data buffer overflow writing " << dataBuffer.GetDataPoints() << " data points";
+		Flush(index);
 	}
 }
 
@@ -446,25 +504,187 @@ void ElasticsearchWriter::FlushTimeout()
 
 void ElasticsearchWriter::Flush()
 {
+	for (size_t i = 0; i < m_DataBuffers.size(); i++) {
+		Flush(i);
+	}
+}
+
+/**
+ * Sends the data buffered for the given connection.
+ *
+ * Without the spool, the request is just queued on the connection, so that we can go on
+ * collecting data while it's being sent.
+ */
+void ElasticsearchWriter::Flush(size_t index)
+{
+	auto& dataBuffer (m_DataBuffers[index]);
+
 	/* Flush can be called from 1) Timeout 2) Threshold 3) on shutdown/reload. */
-	if (m_DataBuffer.empty())
+	if (dataBuffer.IsEmpty())
 		return;
 
-	/* Ensure you hold a lock against m_DataBuffer so that things
-	 * don't go missing after creating the body and clearing the buffer.
-	 */
-	String body = boost::algorithm::join(m_DataBuffer, "\n");
-	m_DataBuffer.clear();
+	std::string body = dataBuffer.Take();
 
 	/* Elasticsearch 6.x requires a new line. This is compatible to 5.x.
 	 * Tested with 6.0.0 and 5.6.4.
 	 */
 	body += "\n";
 
-	SendRequest(body);
+	if (m_Spool) {
+		/* Nothing may overtake the already spooled data. */
+		if (!m_Spool->IsEmpty() || !m_Spool->IsRetryDue(Utility::GetTime()) || !TrySendRequest(body)) {
+			m_Spool->Push(body);
+		}
+
+		dataBuffer.Recycle(std::move(body));
+		return;
+	}
+
+	auto request (AssembleRequest());
+
+	if (m_Compressor) {
+		std::string compressed;
+		m_Compressor->Compress(body, compressed);
+		dataBuffer.Recycle(std::move(body));
+		body = std::move(compressed);
+
+		request.set(boost::beast::http::field::content_encoding, "gzip");
+	}
+
+	request.body() = std::move(body);
+	request.content_length(request.body().size());
+
+	m_Pool->Enqueue(index, std::move(request), [this, &dataBuffer](HttpRequest& request, const HttpResponse& response) {
+		HandleResponse(request, response);
+
+		/* Whether compressed or not, the body's memory can be reused for the next one. */
+		dataBuffer.Recycle(std::move(request.body()));
+	});
+}
+
+/**
+ * Queues a replay of spooled data on the work-queue if there isn't one queued already.
+ */
+void ElasticsearchWriter::ReplaySpoolTimeout(WorkQueuePriority priority)
+{
+	if (m_SpoolReplayInQueue.exchange(true, std::memory_order_relaxed)) {
+		return;
+	}
+
+	m_WorkQueue.Enqueue([this]() {
+		bool more;
+
+		{
+			Defer resetReplayInQueue{[this]() { m_SpoolReplayInQueue.store(false, std::memory_order_relaxed); }};
+			more = ReplaySpool();
+		}
+
+		/* Go on right away, but after everything else queued meanwhile, e.g. new data or pausing. */
+		if (more) {
+			ReplaySpoolTimeout(PriorityLow);
+		}
+	}, priority);
+}
+
+/**
+ * Sends up to spool_replay_rate spooled bulk requests, oldest first, until one fails.
+ *
+ * @return Whether there's more to replay right away
+ */
+bool ElasticsearchWriter::ReplaySpool()
+{
+	AssertOnWorkQueue();
+
+	if (!m_Spool->IsRetryDue(Utility::GetTime())) {
+		return false;
+	}
+
+	for (int i = 0; i < GetSpoolReplayRate(); i++) {
+		if (m_Spool->IsEmpty()) {
+			return false;
+		}
+
+		std::string body;
+
+		try {
+			body = m_Spool->Front();
+		} catch (const std::exception& ex) {
+			Log(LogWarning, "ElasticsearchWriter")
+				<< "Dropping unreadable spooled data: " << DiagnosticInformation(ex, false);
+			m_Spool->Pop();
+			continue;
+		}
+
+		if (!TrySendRequest(body)) {
+			return false;
+		}
+
+		m_Spool->Pop();
+	}
+
+	return !m_Spool->IsEmpty();
+}
+
+/**
+ * Sends the given bulk body to Elasticsearch right away, giving up after the first failed attempt.
+ *
+ * Failed attempts, including temporary errors reported by Elasticsearch, make the spool back off.
+ *
+ * @param body The body, it's handed back afterwards so that its memory can be reused
+ * @return Whether the body is done with, i.e. it has been delivered or rejected for good
+ */
+bool ElasticsearchWriter::TrySendRequest(std::string& body)
+{
+	auto request (AssembleRequest());
+
+	if (m_Compressor) {
+		request.set(boost::beast::http::field::content_encoding, "gzip");
+		m_Compressor->Compress(body, m_CompressedBody);
+		std::swap(body, m_CompressedBody);
+	}
+
+	request.body() = std::move(body);
+	request.content_length(request.body().size());
+
+	Defer restoreBody ([this, &body, &request]() {
+		body = std::move(request.body());
+
+		/* Hand back the uncompressed body, but keep the compressed one's memory for the next request. */
+		if (m_Compressor) {
+			std::swap(body, m_CompressedBody);
+		}
+	});
+
+	HttpResponse response;
+	try {
+		response = m_Pool->GetConnection(0)->TrySend(request);
+	} catch (const PerfdataWriterConnection::Stopped& ex) {
+		Log(LogDebug, "ElasticsearchWriter") << ex.what();
+		return false;
+	} catch (const std::exception&) {
+		/* Already logged by the connection. */
+		m_Spool->RetryLater(Utility::GetTime());
+		return false;
+	}
+
+	if (PerfdataSpool::IsTemporaryFailure(response.result_int())) {
+		Log(LogWarning, "ElasticsearchWriter")
+			<< "Unexpected response code: " << response.result() << ", keeping the data spooled to retry later.";
+		m_Spool->RetryLater(Utility::GetTime());
+		return false;
+	}
+
+	m_Spool->ResetRetryDelay();
+
+	HandleResponse(request, response);
+
+	return true;
 }
 
-void ElasticsearchWriter::SendRequest(const String& body)
+/**
+ * Creates a bulk request to today's index, without body.
+ */
+ElasticsearchWriter::HttpRequest ElasticsearchWriter::AssembleRequest()
 {
 	namespace beast = boost::beast;
 	namespace http = beast::http;
@@ -487,7 +707,7 @@ void ElasticsearchWriter::SendRequest(const String& body)
 
 	url->SetPath(path);
 
-	http::request<http::string_body> request (http::verb::post, std::string(url->Format(true)), 10);
+	HttpRequest request (http::verb::post, std::string(url->Format(true)), 10);
 
 	request.set(http::field::user_agent, "Icinga/" + Application::GetAppVersion());
 	request.set(http::field::host, url->GetHost() + ":" + url->GetPort());
@@ -508,23 +728,26 @@ void ElasticsearchWriter::SendRequest(const String& body)
 	if (!username.IsEmpty() && !password.IsEmpty())
 		request.set(http::field::authorization, "Basic " + Base64::Encode(username + ":" + password));
 
-	request.body() = body;
-	request.content_length(request.body().size());
-
 	/* Don't log the request body to debug log, this is already done above. */
 	Log(LogDebug, "ElasticsearchWriter")
 		<< "Sending " << request.method_string() << " request" << ((!username.IsEmpty() && !password.IsEmpty()) ? " with basic auth" : "" )
 		<< " to '" << url->Format() << "'.";
 
-	decltype(m_Connection->Send(request)) response;
-	try {
-		response = m_Connection->Send(request);
-	} catch (const PerfdataWriterConnection::Stopped& ex) {
-		Log(LogDebug, "ElasticsearchWriter") << ex.what();
-		return;
-	}
+	return request;
+}
+
+/**
+ * Logs errors reported by Elasticsearch. This may be called from the connections' threads.
+ */
+void ElasticsearchWriter::HandleResponse(const HttpRequest& request, const HttpResponse& response)
+{
+	namespace beast = boost::beast;
+	namespace http = beast::http;
 
 	if (response.result_int() > 299) {
+		String username = GetUsername();
+		String password = GetPassword();
+
 		if (response.result() == http::status::unauthorized) {
 			/* More verbose error logging with Elasticsearch is hidden behind a proxy. */
 			if (!username.IsEmpty() && !password.IsEmpty()) {
@@ -540,7 +763,7 @@ void ElasticsearchWriter::SendRequest(const String& body)
 		}
 
 		std::ostringstream msgbuf;
-		msgbuf << "Unexpected response code " << response.result_int() << " from URL '" << url->Format() << "'";
+		msgbuf << "Unexpected response code " << response.result_int() << " from URL '" << request.target() << "'";
 
 		auto& contentType (response[http::field::content_type]);
 
@@ -548,19 +771,19 @@ void ElasticsearchWriter::SendRequest(const String& body)
 			msgbuf << "; Unexpected Content-Type: '" << contentType << "'";
 		}
 
-		auto& body (response.body());
+		auto& responseBody (response.body());
 
 #ifdef I2_DEBUG
-		msgbuf << "; Response body: '" << body << "'";
+		msgbuf << "; Response body: '" << responseBody << "'";
 #endif /* I2_DEBUG */
 
 		Dictionary::Ptr jsonResponse;
 
 		try {
-			jsonResponse = JsonDecode(body);
+			jsonResponse = JsonDecode(responseBody);
 		} catch (...) {
 			Log(LogWarning, "ElasticsearchWriter")
-				<< "Unable to parse JSON response:\n" << body;
+				<< "Unable to parse JSON response:\n" << responseBody;
 			return;
 		}
 
@@ -647,3 +870,35 @@ void ElasticsearchWriter::ValidateServiceTagsTemplate(const Lazy<Dictionary::Ptr
 		}
 	}
 }
+
+void ElasticsearchWriter::ValidateConnections(const Lazy<int>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<ElasticsearchWriter>::ValidateConnections(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "connections" }, "Connections must be at least 1."));
+}
+
+void ElasticsearchWriter::ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<ElasticsearchWriter>::ValidateCompression(lvalue, utils);
+
+	if (lvalue() != "none" && lvalue() != "gzip")
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "compression" }, "Compression must be either 'none' or 'gzip'."));
+}
+
+void ElasticsearchWriter::ValidateSpoolMaxSize(const Lazy<int64_t>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<ElasticsearchWriter>::ValidateSpoolMaxSize(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "spool_max_size" }, "Spool max size must be at least 1 byte."));
+}
+
+void ElasticsearchWriter::ValidateSpoolReplayRate(const Lazy<int>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<ElasticsearchWriter>::ValidateSpoolReplayRate(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "spool_replay_rate" }, "Spool replay rate must be at least 1."));
+}
@@ -7,8 +7,16 @@
 #include "perfdata/elasticsearchwriter-ti.hpp"
 #include "icinga/checkable.hpp"
 #include "base/configobject.hpp"
+#include "base/atomic.hpp"
+#include "base/gzipcompressor.hpp"
 #include "base/workqueue.hpp"
+#include "perfdata/metricsbuffer.hpp"
+#include "perfdata/perfdataspool.hpp"
 #include "perfdata/perfdatawriterconnection.hpp"
+#include "perfdata/perfdatawriterconnectionpool.hpp"
+#include <deque>
+#include <memory>
+#include <string>
 
 namespace icinga
 {
@@ -19,12 +27,19 @@ public:
 	DECLARE_OBJECT(ElasticsearchWriter);
 	DECLARE_OBJECTNAME(ElasticsearchWriter);
 
+	using HttpRequest = PerfdataWriterConnection::HttpRequest;
+	using HttpResponse = PerfdataWriterConnection::HttpResponse;
+
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 	static String FormatTimestamp(double ts);
 
 	void ValidateHostTagsTemplate(const Lazy<Dictionary::Ptr> &lvalue, const ValidationUtils &utils) override;
 	void ValidateServiceTagsTemplate(const Lazy<Dictionary::Ptr> &lvalue, const ValidationUtils &utils) override;
+	void ValidateConnections(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
+	void ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
+	void ValidateSpoolMaxSize(const Lazy<int64_t>& lvalue, const ValidationUtils& utils) override;
+	void ValidateSpoolReplayRate(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
 
 protected:
 	void OnConfigLoaded() override;
@@ -38,9 +53,16 @@ private:
 	boost::signals2::connection m_HandleCheckResults, m_HandleStateChanges, m_HandleNotifications;
 	Timer::Ptr m_FlushTimer;
 	std::atomic_bool m_FlushTimerInQueue{false};
-	std::vector<String> m_DataBuffer;
+	std::deque<MetricsBuffer> m_DataBuffers;
 	Shared<boost::asio::ssl::context>::Ptr m_SslContext;
-	PerfdataWriterConnection::Ptr m_Connection;
+	PerfdataWriterConnectionPool::Ptr m_Pool;
+	Locked<PerfdataWriterConnectionPool::Ptr> m_LockedPool;
+	std::shared_ptr<PerfdataSpool> m_Spool;
+	Locked<std::shared_ptr<PerfdataSpool>> m_LockedSpool;
+	Timer::Ptr m_SpoolReplayTimer;
+	std::atomic_bool m_SpoolReplayInQueue{false};
+	std::unique_ptr<GzipCompressor> m_Compressor;
+	std::string m_CompressedBody;
 
 	void AddCheckResult(const Dictionary::Ptr& fields, const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
 	void AddTemplateTags(const Dictionary::Ptr& fields, const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
@@ -57,7 +79,12 @@ private:
 	void ExceptionHandler(std::exception_ptr exp);
 	void FlushTimeout();
 	void Flush();
-	void SendRequest(const String& body);
+	void Flush(size_t index);
+	void ReplaySpoolTimeout(WorkQueuePriority priority = PriorityNormal);
+	bool ReplaySpool();
+	bool TrySendRequest(std::string& body);
+	HttpRequest AssembleRequest();
+	void HandleResponse(const HttpRequest& request, const HttpResponse& response);
 };
 
 }
@@ -198,42 +198,34 @@ void GelfWriter::CheckResultHandler(const Checkable::Ptr& checkable, const Check
 			Array::Ptr perfdata = cr->GetPerformanceData();
 
 			if (perfdata) {
-				for (const Value& val : perfdata) {
-					PerfdataValue::Ptr pdv;
-
-					if (val.IsObjectType<PerfdataValue>())
-						pdv = val;
-					else {
-						try {
-							pdv = PerfdataValue::Parse(val);
-						} catch (const std::exception&) {
-							Log(LogWarning, "GelfWriter")
-								<< "Ignoring invalid perfdata for checkable '"
-								<< checkable->GetName() << "' and command '"
-								<< checkable->GetCheckCommand()->GetName() << "' with value: " << val;
-							continue;
-						}
+				for (auto& pdv : *cr->GetParsedPerformanceData()) {
+					if (!pdv.Valid) {
+						Log(LogWarning, "GelfWriter")
+							<< "Ignoring invalid perfdata for checkable '"
+							<< checkable->GetName() << "' and command '"
+							<< checkable->GetCheckCommand()->GetName() << "' with value: " << pdv.Raw;
+						continue;
 					}
 
-					String escaped_key = pdv->GetLabel();
+					String escaped_key = pdv.Label;
 					boost::replace_all(escaped_key, " ", "_");
 					boost::replace_all(escaped_key, ".", "_");
 					boost::replace_all(escaped_key, "\\", "_");
 					boost::algorithm::replace_all(escaped_key, "::", ".");
 
-					fields->Set("_" + escaped_key, pdv->GetValue());
+					fields->Set("_" + escaped_key, pdv.Number);
 
-					if (!pdv->GetMin().IsEmpty())
-						fields->Set("_" + escaped_key + "_min", pdv->GetMin());
-					if (!pdv->GetMax().IsEmpty())
-						fields->Set("_" + escaped_key + "_max", pdv->GetMax());
-					if (!pdv->GetWarn().IsEmpty())
-						fields->Set("_" + escaped_key + "_warn", pdv->GetWarn());
-					if (!pdv->GetCrit().IsEmpty())
-						fields->Set("_" + escaped_key + "_crit", pdv->GetCrit());
+					if (!pdv.Min.IsEmpty())
+						fields->Set("_" + escaped_key + "_min", pdv.Min);
+					if (!pdv.Max.IsEmpty())
+						fields->Set("_" + escaped_key + "_max", pdv.Max);
+					if (!pdv.Warn.IsEmpty())
+						fields->Set("_" + escaped_key + "_warn", pdv.Warn);
+					if (!pdv.Crit.IsEmpty())
+						fields->Set("_" + escaped_key + "_crit", pdv.Crit);
 
-					if (!pdv->GetUnit().IsEmpty())
-						fields->Set("_" + escaped_key + "_unit", pdv->GetUnit());
+					if (!pdv.Unit.IsEmpty())
+						fields->Set("_" + escaped_key + "_unit", pdv.Unit);
 				}
 			}
 		}
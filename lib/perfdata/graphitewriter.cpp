@@ -226,37 +226,29 @@ void GraphiteWriter::SendPerfdata(const Checkable::Ptr& checkable, const String&
 
 	CheckCommand::Ptr checkCommand = checkable->GetCheckCommand();
 
-	for (const Value& val : perfdata) {
-		PerfdataValue::Ptr pdv;
-
-		if (val.IsObjectType<PerfdataValue>())
-			pdv = val;
-		else {
-			try {
-				pdv = PerfdataValue::Parse(val);
-			} catch (const std::exception&) {
-				Log(LogWarning, "GraphiteWriter")
-					<< "Ignoring invalid perfdata for checkable '"
-					<< checkable->GetName() << "' and command '"
-					<< checkCommand->GetName() << "' with value: " << val;
-				continue;
-			}
+	for (auto& pdv : *cr->GetParsedPerformanceData()) {
+		if (!pdv.Valid) {
+			Log(LogWarning, "GraphiteWriter")
+				<< "Ignoring invalid perfdata for checkable '"
+				<< checkable->GetName() << "' and command '"
+				<< checkCommand->GetName() << "' with value: " << pdv.Raw;
+			continue;
 		}
 
-		String escapedKey = EscapeMetricLabel(pdv->GetLabel());
+		String escapedKey = EscapeMetricLabel(pdv.Label);
 		double ts = cr->GetExecutionEnd();
 
-		SendMetric(checkable, prefix, escapedKey + ".value", pdv->GetValue(), ts);
+		SendMetric(checkable, prefix, escapedKey + ".value", pdv.Number, ts);
 
 		if (GetEnableSendThresholds()) {
-			if (!pdv->GetCrit().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".crit", pdv->GetCrit(), ts);
-			if (!pdv->GetWarn().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".warn", pdv->GetWarn(), ts);
-			if (!pdv->GetMin().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".min", pdv->GetMin(), ts);
-			if (!pdv->GetMax().IsEmpty())
-				SendMetric(checkable, prefix, escapedKey + ".max", pdv->GetMax(), ts);
+			if (!pdv.Crit.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".crit", pdv.Crit, ts);
+			if (!pdv.Warn.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".warn", pdv.Warn, ts);
+			if (!pdv.Min.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".min", pdv.Min, ts);
+			if (!pdv.Max.IsEmpty())
+				SendMetric(checkable, prefix, escapedKey + ".max", pdv.Max, ts);
 		}
 	}
 }
@@ -10,6 +10,7 @@
 #include "icinga/icingaapplication.hpp"
 #include "icinga/checkcommand.hpp"
 #include "base/application.hpp"
+#include "base/configuration.hpp"
 #include "base/objectlock.hpp"
 #include "base/logger.hpp"
 #include "base/json.hpp"
@@ -50,6 +51,11 @@ void InfluxdbCommonWriter::OnConfigLoaded()
 
 	m_WorkQueue.SetName(GetReflectionType()->GetName() + ", " + GetName());
 
+	/* One buffer per connection, the spool has to be replayed in order over a single one. */
+	while (m_DataBuffers.size() < (GetEnableSpool() ? 1u : static_cast<size_t>(GetConnections()))) {
+		m_DataBuffers.emplace_back();
+	}
+
 	if (!GetEnableHa()) {
 		Log(LogDebug, GetReflectionType()->GetName())
 			<< "HA functionality disabled. Won't pause connection: " << GetName();
@@ -85,14 +91,39 @@ void InfluxdbCommonWriter::Resume()
 	/* Register exception handler for WQ tasks. */
 	m_WorkQueue.SetExceptionCallback([this](std::exception_ptr exp) { ExceptionHandler(std::move(exp)); });
 
-	/* Setup timer for periodically flushing m_DataBuffer */
+	/* Setup timer for periodically flushing m_DataBuffers */
 	m_FlushTimer = Timer::Create();
 	m_FlushTimer->SetInterval(GetFlushInterval());
 	m_FlushTimer->OnTimerExpired.connect([this](const Timer * const&) { FlushTimeout(); });
 	m_FlushTimer->Start();
 	m_FlushTimer->Reschedule(0);
 
-	m_Connection = new PerfdataWriterConnection{this, GetHost(), GetPort(), m_SslContext, !GetSslInsecureNoverify()};
+	m_Pool = new PerfdataWriterConnectionPool{this, GetHost(), GetPort(), m_SslContext, !GetSslInsecureNoverify(), m_DataBuffers.size()};
+	m_LockedPool.store(m_Pool);
+
+	if (GetCompression() == "gzip" && !m_Compressor) {
+		m_Compressor = std::make_unique<GzipCompressor>();
+	}
+
+	if (GetEnableSpool()) {
+		if (!m_Spool) {
+			try {
+				m_Spool = std::make_shared<PerfdataSpool>(Configuration::SpoolDir + "/" + GetReflectionType()->GetName().ToLower()
+					+ "/" + GetName(), GetSpoolMaxSize(), GetReflectionType()->GetName());
+				m_LockedSpool.store(m_Spool);
+			} catch (const std::exception& ex) {
+				Log(LogCritical, GetReflectionType()->GetName())
+					<< "Unable to set up the spool, continuing without: " << DiagnosticInformation(ex, false);
+			}
+		}
+
+		if (m_Spool) {
+			m_SpoolReplayTimer = Timer::Create();
+			m_SpoolReplayTimer->SetInterval(1);
+			m_SpoolReplayTimer->OnTimerExpired.connect([this](const Timer * const&) { ReplaySpoolTimeout(); });
+			m_SpoolReplayTimer->Start();
+		}
+	}
 
 	/* Register for new metrics. */
 	m_HandleCheckResults = Checkable::OnNewCheckResult.connect([this](const Checkable::Ptr& checkable,
@@ -112,14 +143,19 @@ void InfluxdbCommonWriter::Pause()
 
 	m_FlushTimer->Stop(true);
 
+	if (m_SpoolReplayTimer) {
+		m_SpoolReplayTimer->Stop(true);
+	}
+
 	std::promise<void> queueDonePromise;
 	m_WorkQueue.Enqueue([&]() {
 		FlushWQ();
+		m_Pool->Join();
 		queueDonePromise.set_value();
 	}, PriorityLow);
 
 	auto timeout = std::chrono::duration<double>{GetDisconnectTimeout()};
-	m_Connection->CancelAfterTimeout(queueDonePromise.get_future(), timeout);
+	m_Pool->CancelAfterTimeout(queueDonePromise.get_future(), timeout);
 
 	/* Wait for the flush to complete, implicitly waits for all WQ tasks enqueued prior to pausing. */
 	m_WorkQueue.Join();
@@ -204,7 +240,7 @@ void InfluxdbCommonWriter::CheckResultHandler(const Checkable::Ptr& checkable, c
 	}
 
 	m_WorkQueue.Enqueue([this, checkable, cr, tmpl = std::move(tmpl), metadataFields = std::move(fields)]() {
-		if (m_Connection->IsStopped()) {
+		if (m_Pool->IsStopped()) {
 			return;
 		}
 
@@ -213,41 +249,33 @@ void InfluxdbCommonWriter::CheckResultHandler(const Checkable::Ptr& checkable, c
 		double ts = cr->GetExecutionEnd();
 
 		if (Array::Ptr perfdata = cr->GetPerformanceData()) {
-			for (const Value& val : perfdata) {
-				PerfdataValue::Ptr pdv;
-
-				if (val.IsObjectType<PerfdataValue>())
-					pdv = val;
-				else {
-					try {
-						pdv = PerfdataValue::Parse(val);
-					} catch (const std::exception&) {
-						Log(LogWarning, GetReflectionType()->GetName())
-							<< "Ignoring invalid perfdata for checkable '"
-							<< checkable->GetName() << "' and command '"
-							<< checkable->GetCheckCommand()->GetName() << "' with value: " << val;
-						continue;
-					}
+			for (auto& pdv : *cr->GetParsedPerformanceData()) {
+				if (!pdv.Valid) {
+					Log(LogWarning, GetReflectionType()->GetName())
+						<< "Ignoring invalid perfdata for checkable '"
+						<< checkable->GetName() << "' and command '"
+						<< checkable->GetCheckCommand()->GetName() << "' with value: " << pdv.Raw;
+					continue;
 				}
 
 				Dictionary::Ptr fields = new Dictionary();
-				fields->Set("value", pdv->GetValue());
+				fields->Set("value", pdv.Number);
 
 				if (GetEnableSendThresholds()) {
-					if (!pdv->GetCrit().IsEmpty())
-						fields->Set("crit", pdv->GetCrit());
-					if (!pdv->GetWarn().IsEmpty())
-						fields->Set("warn", pdv->GetWarn());
-					if (!pdv->GetMin().IsEmpty())
-						fields->Set("min", pdv->GetMin());
-					if (!pdv->GetMax().IsEmpty())
-						fields->Set("max", pdv->GetMax());
+					if (!pdv.Crit.IsEmpty())
+						fields->Set("crit", pdv.Crit);
+					if (!pdv.Warn.IsEmpty())
+						fields->Set("warn", pdv.Warn);
+					if (!pdv.Min.IsEmpty())
+						fields->Set("min", pdv.Min);
+					if (!pdv.Max.IsEmpty())
+						fields->Set("max", pdv.Max);
 				}
-				if (!pdv->GetUnit().IsEmpty()) {
-					fields->Set("unit", pdv->GetUnit());
+				if (!pdv.Unit.IsEmpty()) {
+					fields->Set("unit", pdv.Unit);
 				}
 
-				SendMetric(checkable, tmpl, pdv->GetLabel(), fields, ts);
+				SendMetric(checkable, tmpl, pdv.Label, fields, ts);
 			}
 		}
 
@@ -301,8 +329,12 @@ void InfluxdbCommonWriter::SendMetric(const Checkable::Ptr& checkable, const Dic
 {
 	AssertOnWorkQueue();
 
-	std::ostringstream msgbuf;
-	msgbuf << EscapeKeyOrTagValue(tmpl->Get("measurement"));
+	/* All data of a checkable goes over the same connection to keep it in order. */
+	auto index (PerfdataWriterConnectionPool::GetIndexFor(checkable.get(), m_DataBuffers.size()));
+	auto& dataBuffer (m_DataBuffers[index]);
+
+	std::string& msgbuf = dataBuffer.BeginDataPoint();
+	msgbuf.append(EscapeKeyOrTagValue(tmpl->Get("measurement")).GetData());
 
 	Dictionary::Ptr tags = tmpl->Get("tags");
 	if (tags) {
@@ -310,16 +342,17 @@ void InfluxdbCommonWriter::SendMetric(const Checkable::Ptr& checkable, const Dic
 		for (const Dictionary::Pair& pair : tags) {
 			// Empty macro expansion, no tag
 			if (!pair.second.IsEmpty()) {
-				msgbuf << "," << EscapeKeyOrTagValue(pair.first) << "=" << EscapeKeyOrTagValue(pair.second);
+				msgbuf.append(",").append(EscapeKeyOrTagValue(pair.first).GetData())
+					.append("=").append(EscapeKeyOrTagValue(pair.second).GetData());
 			}
 		}
 	}
 
 	// Label may be empty in the case of metadata
 	if (!label.IsEmpty())
-		msgbuf << ",metric=" << EscapeKeyOrTagValue(label);
+		msgbuf.append(",metric=").append(EscapeKeyOrTagValue(label).GetData());
 
-	msgbuf << " ";
+	msgbuf.append(" ");
 
 	{
 		bool first = true;
@@ -329,28 +362,27 @@ void InfluxdbCommonWriter::SendMetric(const Checkable::Ptr& checkable, const Dic
 			if (first)
 				first = false;
 			else
-				msgbuf << ",";
+				msgbuf.append(",");
 
-			msgbuf << EscapeKeyOrTagValue(pair.first) << "=" << EscapeValue(pair.second);
+			msgbuf.append(EscapeKeyOrTagValue(pair.first).GetData()).append("=").append(EscapeValue(pair.second).GetData());
 		}
 	}
 
-	msgbuf << " " <<  static_cast<unsigned long>(ts);
-
-	Log(LogDebug, GetReflectionType()->GetName())
-		<< "Checkable '" << checkable->GetName() << "' adds to metric list:'" << msgbuf.str() << "'.";
+	msgbuf.append(" ").append(std::to_string(static_cast<unsigned long>(ts)));
 
 	// Buffer the data point
-	m_DataBuffer.emplace_back(msgbuf.str());
-	m_DataBufferSize = m_DataBuffer.size();
+	auto dataPoint (dataBuffer.EndDataPoint());
+
+	Log(LogDebug, GetReflectionType()->GetName())
+		<< "Checkable '" << checkable->GetName() << "' adds to metric list:'" << dataPoint << "'.";
 
 	// Flush if we've buffered too much to prevent excessive memory use
-	if (static_cast<int>(m_DataBuffer.size()) >= GetFlushThreshold()) {
+	if (dataBuffer.ShouldFlush(GetFlushThreshold())) {
 		Log(LogDebug, GetReflectionType()->GetName())
-			<< "Data buffer overflow writing " << m_DataBuffer.size() << " data points";
+			<< "Data buffer overflow writing " << dataBuffer.GetDataPoints() << " data points";
 
 		try {
-			FlushWQ();
+			FlushWQ(index);
 		} catch (...) {
 			/* Do nothing. */
 		}
@@ -373,34 +405,195 @@ void InfluxdbCommonWriter::FlushTimeout()
 }
 
 void InfluxdbCommonWriter::FlushWQ()
+{
+	for (size_t i = 0; i < m_DataBuffers.size(); i++) {
+		FlushWQ(i);
+	}
+}
+
+/**
+ * Sends the data buffered for the given connection.
+ *
+ * Without the spool, the request is just queued on the connection, so that we can go on
+ * collecting data while it's being sent.
+ */
+void InfluxdbCommonWriter::FlushWQ(size_t index)
 {
 	AssertOnWorkQueue();
 
-	namespace beast = boost::beast;
-	namespace http = beast::http;
+	auto& dataBuffer (m_DataBuffers[index]);
 
 	/* Flush can be called from 1) Timeout 2) Threshold 3) on shutdown/reload. */
-	if (m_DataBuffer.empty())
+	if (dataBuffer.IsEmpty())
 		return;
 
 	Log(LogDebug, GetReflectionType()->GetName())
 		<< "Flushing data buffer to InfluxDB.";
 
-	String body = boost::algorithm::join(m_DataBuffer, "\n");
-	m_DataBuffer.clear();
-	m_DataBufferSize = 0;
+	std::string body = dataBuffer.Take();
+
+	if (m_Spool) {
+		/* Nothing may overtake the already spooled data. */
+		if (!m_Spool->IsEmpty() || !m_Spool->IsRetryDue(Utility::GetTime()) || !TrySendBody(body)) {
+			m_Spool->Push(body);
+		}
+
+		dataBuffer.Recycle(std::move(body));
+		return;
+	}
+
+	bool compressed = false;
+
+	if (m_Compressor) {
+		std::string compressedBody;
+		m_Compressor->Compress(body, compressedBody);
+		dataBuffer.Recycle(std::move(body));
+		body = std::move(compressedBody);
+		compressed = true;
+	}
+
+	auto request (AssembleRequest(std::move(body)));
+
+	if (compressed) {
+		request.set(boost::beast::http::field::content_encoding, "gzip");
+	}
+
+	m_Pool->Enqueue(index, std::move(request), [this, &dataBuffer](HttpRequest& request, const HttpResponse& response) {
+		HandleResponse(response);
+
+		/* Whether compressed or not, the body's memory can be reused for the next one. */
+		dataBuffer.Recycle(std::move(request.body()));
+	});
+}
+
+/**
+ * Queues a replay of spooled data on the work-queue if there isn't one queued already.
+ */
+void InfluxdbCommonWriter::ReplaySpoolTimeout(WorkQueuePriority priority)
+{
+	if (m_SpoolReplayInQueue.exchange(true, std::memory_order_relaxed)) {
+		return;
+	}
+
+	m_WorkQueue.Enqueue([this]() {
+		bool more;
+
+		{
+			Defer resetReplayInQueue{[this]() { m_SpoolReplayInQueue.store(false, std::memory_order_relaxed); }};
+			more = ReplaySpool();
+		}
+
+		/* Go on right away, but after everything else queued meanwhile, e.g. new data or pausing. */
+		if (more) {
+			ReplaySpoolTimeout(PriorityLow);
+		}
+	}, priority);
+}
+
+/**
+ * Sends up to spool_replay_rate spooled payloads, oldest first, until one fails.
+ *
+ * @return Whether there's more to replay right away
+ */
+bool InfluxdbCommonWriter::ReplaySpool()
+{
+	AssertOnWorkQueue();
+
+	if (!m_Spool->IsRetryDue(Utility::GetTime())) {
+		return false;
+	}
+
+	for (int i = 0; i < GetSpoolReplayRate(); i++) {
+		if (m_Spool->IsEmpty()) {
+			return false;
+		}
+
+		std::string body;
+
+		try {
+			body = m_Spool->Front();
+		} catch (const std::exception& ex) {
+			Log(LogWarning, GetReflectionType()->GetName())
+				<< "Dropping unreadable spooled data: " << DiagnosticInformation(ex, false);
+			m_Spool->Pop();
+			continue;
+		}
+
+		if (!TrySendBody(body)) {
+			return false;
+		}
+
+		m_Spool->Pop();
+	}
+
+	return !m_Spool->IsEmpty();
+}
+
+/**
+ * Sends the given line protocol body to InfluxDB right away, giving up after the first failed attempt.
+ *
+ * Failed attempts, including temporary errors reported by InfluxDB, make the spool back off.
+ *
+ * @param body The body, it's handed back afterwards so that its memory can be reused
+ * @return Whether the body is done with, i.e. it has been delivered or rejected for good
+ */
+bool InfluxdbCommonWriter::TrySendBody(std::string& body)
+{
+	namespace beast = boost::beast;
+	namespace http = beast::http;
+
+	if (m_Compressor) {
+		m_Compressor->Compress(body, m_CompressedBody);
+		std::swap(body, m_CompressedBody);
+	}
 
 	auto request (AssembleRequest(std::move(body)));
 
-	decltype(m_Connection->Send(request)) response;
+	if (m_Compressor) {
+		request.set(http::field::content_encoding, "gzip");
+	}
+
+	Defer restoreBody ([this, &body, &request]() {
+		body = std::move(request.body());
+
+		/* Hand back the uncompressed body, but keep the compressed one's memory for the next request. */
+		if (m_Compressor) {
+			std::swap(body, m_CompressedBody);
+		}
+	});
+
+	HttpResponse response;
 	try {
-		response = m_Connection->Send(request);
+		response = m_Pool->GetConnection(0)->TrySend(request);
 	} catch (const PerfdataWriterConnection::Stopped& ex) {
 		Log(LogDebug, GetReflectionType()->GetName()) << ex.what();
-		return;
+		return false;
+	} catch (const std::exception&) {
+		/* Already logged by the connection. */
+		m_Spool->RetryLater(Utility::GetTime());
+		return false;
 	}
 
-	if (response.result() != http::status::no_content) {
+	if (PerfdataSpool::IsTemporaryFailure(response.result_int())) {
+		Log(LogWarning, GetReflectionType()->GetName())
+			<< "Unexpected response code: " << response.result() << ", keeping the data spooled to retry later.";
+		m_Spool->RetryLater(Utility::GetTime());
+		return false;
+	}
+
+	m_Spool->ResetRetryDelay();
+
+	HandleResponse(response);
+
+	return true;
+}
+
+/**
+ * Logs errors reported by InfluxDB. This may be called from the connections' threads.
+ */
+void InfluxdbCommonWriter::HandleResponse(const HttpResponse& response)
+{
+	if (response.result() != boost::beast::http::status::no_content) {
 		Log(LogCritical, GetReflectionType()->GetName())
 			<< "Unexpected response code: " << response.result() << ", InfluxDB error message:\n" << response.body();
 	}
@@ -415,7 +608,7 @@ boost::beast::http::request<boost::beast::http::string_body> InfluxdbCommonWrite
 
 	request.set(http::field::user_agent, "Icinga/" + Application::GetAppVersion());
 	request.set(http::field::host, url->GetHost() + ":" + url->GetPort());
-	request.body() = std::move(body);
+	request.body() = std::move(body.GetData());
 	request.content_length(request.body().size());
 
 	return request;
@@ -468,3 +661,35 @@ void InfluxdbCommonWriter::ValidateServiceTemplate(const Lazy<Dictionary::Ptr>&
 		}
 	}
 }
+
+void InfluxdbCommonWriter::ValidateConnections(const Lazy<int>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<InfluxdbCommonWriter>::ValidateConnections(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "connections" }, "Connections must be at least 1."));
+}
+
+void InfluxdbCommonWriter::ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<InfluxdbCommonWriter>::ValidateCompression(lvalue, utils);
+
+	if (lvalue() != "none" && lvalue() != "gzip")
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "compression" }, "Compression must be either 'none' or 'gzip'."));
+}
+
+void InfluxdbCommonWriter::ValidateSpoolMaxSize(const Lazy<int64_t>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<InfluxdbCommonWriter>::ValidateSpoolMaxSize(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "spool_max_size" }, "Spool max size must be at least 1 byte."));
+}
+
+void InfluxdbCommonWriter::ValidateSpoolReplayRate(const Lazy<int>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl<InfluxdbCommonWriter>::ValidateSpoolReplayRate(lvalue, utils);
+
+	if (lvalue() < 1)
+		BOOST_THROW_EXCEPTION(ValidationError(this, { "spool_replay_rate" }, "Spool replay rate must be at least 1."));
+}
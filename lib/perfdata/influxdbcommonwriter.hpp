@@ -7,11 +7,19 @@
 #include "perfdata/influxdbcommonwriter-ti.hpp"
 #include "icinga/checkable.hpp"
 #include "base/configobject.hpp"
+#include "base/atomic.hpp"
+#include "base/gzipcompressor.hpp"
 #include "base/perfdatavalue.hpp"
 #include "base/workqueue.hpp"
 #include "remote/url.hpp"
+#include "perfdata/metricsbuffer.hpp"
+#include "perfdata/perfdataspool.hpp"
 #include "perfdata/perfdatawriterconnection.hpp"
+#include "perfdata/perfdatawriterconnectionpool.hpp"
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
 
 namespace icinga
 {
@@ -26,11 +34,18 @@ class InfluxdbCommonWriter : public ObjectImpl<InfluxdbCommonWriter>
 public:
 	DECLARE_OBJECT(InfluxdbCommonWriter);
 
+	using HttpRequest = PerfdataWriterConnection::HttpRequest;
+	using HttpResponse = PerfdataWriterConnection::HttpResponse;
+
 	template<class InfluxWriter>
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 	void ValidateHostTemplate(const Lazy<Dictionary::Ptr>& lvalue, const ValidationUtils& utils) override;
 	void ValidateServiceTemplate(const Lazy<Dictionary::Ptr>& lvalue, const ValidationUtils& utils) override;
+	void ValidateConnections(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
+	void ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
+	void ValidateSpoolMaxSize(const Lazy<int64_t>& lvalue, const ValidationUtils& utils) override;
+	void ValidateSpoolReplayRate(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
 
 protected:
 	void OnConfigLoaded() override;
@@ -48,16 +63,27 @@ private:
 	Timer::Ptr m_FlushTimer;
 	std::atomic_bool m_FlushTimerInQueue{false};
 	WorkQueue m_WorkQueue{10000000, 1};
-	std::vector<String> m_DataBuffer;
-	std::atomic_size_t m_DataBufferSize{0};
+	std::deque<MetricsBuffer> m_DataBuffers;
 	Shared<boost::asio::ssl::context>::Ptr m_SslContext;
-	PerfdataWriterConnection::Ptr m_Connection;
+	PerfdataWriterConnectionPool::Ptr m_Pool;
+	Locked<PerfdataWriterConnectionPool::Ptr> m_LockedPool;
+	std::shared_ptr<PerfdataSpool> m_Spool;
+	Locked<std::shared_ptr<PerfdataSpool>> m_LockedSpool;
+	Timer::Ptr m_SpoolReplayTimer;
+	std::atomic_bool m_SpoolReplayInQueue{false};
+	std::unique_ptr<GzipCompressor> m_Compressor;
+	std::string m_CompressedBody;
 
 	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
 	void SendMetric(const Checkable::Ptr& checkable, const Dictionary::Ptr& tmpl,
 		const String& label, const Dictionary::Ptr& fields, double ts);
 	void FlushTimeout();
 	void FlushWQ();
+	void FlushWQ(size_t index);
+	void ReplaySpoolTimeout(WorkQueuePriority priority = PriorityNormal);
+	bool ReplaySpool();
+	bool TrySendBody(std::string& body);
+	void HandleResponse(const HttpResponse& response);
 
 	static String EscapeKeyOrTagValue(const String& str);
 	static String EscapeValue(const Value& value);
@@ -76,17 +102,37 @@ void InfluxdbCommonWriter::StatsFunc(const Dictionary::Ptr& status, const Array:
 	for (const typename InfluxWriter::Ptr& influxwriter : ConfigType::GetObjectsByType<InfluxWriter>()) {
 		size_t workQueueItems = influxwriter->m_WorkQueue.GetLength();
 		double workQueueItemRate = influxwriter->m_WorkQueue.GetTaskCount(60) / 60.0;
-		size_t dataBufferItems = influxwriter->m_DataBufferSize;
+		size_t dataBufferItems = 0;
+		size_t dataBufferBytes = 0;
+		auto pool (influxwriter->m_LockedPool.load());
+		auto spool (influxwriter->m_LockedSpool.load());
+
+		for (auto& dataBuffer : influxwriter->m_DataBuffers) {
+			dataBufferItems += dataBuffer.GetDataPoints();
+			dataBufferBytes += dataBuffer.GetBytes();
+		}
 
-		nodes.emplace_back(influxwriter->GetName(), new Dictionary({
+		Dictionary::Ptr node = new Dictionary({
 			{ "work_queue_items", workQueueItems },
 			{ "work_queue_item_rate", workQueueItemRate },
-			{ "data_buffer_items", dataBufferItems }
-		}));
+			{ "data_buffer_items", dataBufferItems },
+			{ "data_buffer_bytes", dataBufferBytes }
+		});
+
+		if (pool) {
+			pool->AddStats(node, perfdata, typeName + "_" + influxwriter->GetName());
+		}
+
+		if (spool) {
+			spool->AddStats(node, perfdata, typeName + "_" + influxwriter->GetName());
+		}
+
+		nodes.emplace_back(influxwriter->GetName(), node);
 
 		perfdata->Add(new PerfdataValue(typeName + "_" + influxwriter->GetName() + "_work_queue_items", workQueueItems));
 		perfdata->Add(new PerfdataValue(typeName + "_" + influxwriter->GetName() + "_work_queue_item_rate", workQueueItemRate));
 		perfdata->Add(new PerfdataValue(typeName + "_" + influxwriter->GetName() + "_data_queue_items", dataBufferItems));
+		perfdata->Add(new PerfdataValue(typeName + "_" + influxwriter->GetName() + "_data_buffer_bytes", dataBufferBytes, false, "bytes"));
 	}
 
 	status->Set(typeName, new Dictionary(std::move(nodes)));
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "perfdata/metricsbuffer.hpp"
+#include <utility>
+
+using namespace icinga;
+
+MetricsBuffer::MetricsBuffer(std::string_view separator, std::size_t maxBytes)
+	: m_Separator(separator), m_MaxBytes(maxBytes)
+{
+}
+
+/**
+ * Starts a new data point.
+ *
+ * The data point has to be appended to the returned string, followed by a call to EndDataPoint().
+ *
+ * @return The body to append the data point to
+ */
+std::string& MetricsBuffer::BeginDataPoint()
+{
+	if (!m_Body.empty()) {
+		m_Body.append(m_Separator);
+	}
+
+	m_DataPointBegin = m_Body.size();
+
+	return m_Body;
+}
+
+/**
+ * Finishes the data point started by BeginDataPoint().
+ *
+ * @return The data point just appended, valid until the body is modified
+ */
+std::string_view MetricsBuffer::EndDataPoint()
+{
+	m_DataPoints.fetch_add(1, std::memory_order_relaxed);
+	m_Bytes.store(m_Body.size(), std::memory_order_relaxed);
+
+	return std::string_view(m_Body).substr(m_DataPointBegin);
+}
+
+bool MetricsBuffer::IsEmpty() const
+{
+	return m_Body.empty();
+}
+
+/**
+ * Whether the buffer should be flushed to prevent excessive memory use.
+ *
+ * @param maxDataPoints The writer's data point threshold
+ */
+bool MetricsBuffer::ShouldFlush(std::size_t maxDataPoints) const
+{
+	return GetDataPoints() >= maxDataPoints || m_Body.size() >= m_MaxBytes;
+}
+
+/**
+ * Takes all buffered data points out of the buffer.
+ *
+ * @return The data points joined by the separator
+ */
+std::string MetricsBuffer::Take()
+{
+	std::string body;
+
+	{
+		std::unique_lock<std::mutex> lock (m_PoolMutex);
+
+		if (!m_Pool.empty()) {
+			body = std::move(m_Pool.back());
+			m_Pool.pop_back();
+		}
+	}
+
+	std::swap(body, m_Body);
+
+	m_DataPointBegin = 0;
+	m_DataPoints.store(0, std::memory_order_relaxed);
+	m_Bytes.store(0, std::memory_order_relaxed);
+
+	return body;
+}
+
+/**
+ * Hands a body previously returned by Take() back, so that its memory can be reused. This may be done
+ * from any thread.
+ *
+ * @param body The body, its contents don't matter
+ */
+void MetricsBuffer::Recycle(std::string body)
+{
+	/* Don't keep exceptionally large bodies around forever. */
+	if (body.capacity() > m_MaxBytes * 2) {
+		return;
+	}
+
+	body.clear();
+
+	std::unique_lock<std::mutex> lock (m_PoolMutex);
+
+	if (m_Pool.size() < MaxPooledBodies) {
+		m_Pool.emplace_back(std::move(body));
+	}
+}
+
+std::size_t MetricsBuffer::GetDataPoints() const
+{
+	return m_DataPoints.load(std::memory_order_relaxed);
+}
+
+std::size_t MetricsBuffer::GetBytes() const
+{
+	return m_Bytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace icinga {
+
+/**
+ * Collects serialized data points of a perfdata writer until they're flushed as one request body.
+ *
+ * Data points are written directly into one append-only body, so that neither a String per data
+ * point nor a join on flush is needed. Bodies handed back via Recycle() after sending keep their
+ * capacity for the next batch.
+ *
+ * The flush policy is the same for all writers: flush once the writer's data point threshold or
+ * the byte limit is reached, whichever comes first, and periodically via the writer's flush timer.
+ *
+ * Only the data point and byte counters may be read from other threads, e.g. for stats, and bodies
+ * may be recycled from other threads, e.g. once they have been sent asynchronously.
+ */
+class MetricsBuffer
+{
+public:
+	static constexpr std::size_t DefaultMaxBytes = 32 * 1024 * 1024;
+
+	explicit MetricsBuffer(std::string_view separator = "\n", std::size_t maxBytes = DefaultMaxBytes);
+
+	std::string& BeginDataPoint();
+	std::string_view EndDataPoint();
+
+	bool IsEmpty() const;
+	bool ShouldFlush(std::size_t maxDataPoints) const;
+
+	std::string Take();
+	void Recycle(std::string body);
+
+	std::size_t GetDataPoints() const;
+	std::size_t GetBytes() const;
+
+private:
+	static constexpr std::size_t MaxPooledBodies = 2;
+
+	std::string m_Body;
+	std::mutex m_PoolMutex;
+	std::vector<std::string> m_Pool;
+	std::size_t m_DataPointBegin{0};
+	std::string m_Separator;
+	std::size_t m_MaxBytes;
+
+	std::atomic_size_t m_DataPoints{0};
+	std::atomic_size_t m_Bytes{0};
+};
+
+} // namespace icinga
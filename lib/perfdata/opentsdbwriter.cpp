@@ -8,6 +8,7 @@
 #include "icinga/macroprocessor.hpp"
 #include "icinga/icingaapplication.hpp"
 #include "base/configtype.hpp"
+#include "base/defer.hpp"
 #include "base/objectlock.hpp"
 #include "base/logger.hpp"
 #include "base/convert.hpp"
@@ -55,6 +56,8 @@ void OpenTsdbWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&
 	for (const OpenTsdbWriter::Ptr& opentsdbwriter : ConfigType::GetObjectsByType<OpenTsdbWriter>()) {
 		size_t workQueueItems = opentsdbwriter->m_WorkQueue.GetLength();
 		double workQueueItemRate = opentsdbwriter->m_WorkQueue.GetTaskCount(60) / 60.0;
+		size_t dataBufferItems = opentsdbwriter->m_MsgBuf.GetDataPoints();
+		size_t dataBufferBytes = opentsdbwriter->m_MsgBuf.GetBytes();
 		auto connection = opentsdbwriter->m_LockedConnection.load();
 
 		nodes.emplace_back(
@@ -62,13 +65,17 @@ void OpenTsdbWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&
 			new Dictionary({
 			{ "connected", connection && connection->IsConnected() },
 				{"work_queue_items", workQueueItems},
-				{"work_queue_item_rate", workQueueItemRate}
+				{"work_queue_item_rate", workQueueItemRate},
+				{"data_buffer_items", dataBufferItems},
+				{"data_buffer_bytes", dataBufferBytes}
 				}
 			)
 		);
 		
 		perfdata->Add(new PerfdataValue("opentsdbwriter_" + opentsdbwriter->GetName() + "_work_queue_items", workQueueItems));
 		perfdata->Add(new PerfdataValue("opentsdbwriter_" + opentsdbwriter->GetName() + "_work_queue_item_rate", workQueueItemRate));
+		perfdata->Add(new PerfdataValue("opentsdbwriter_" + opentsdbwriter->GetName() + "_data_buffer_items", dataBufferItems));
+		perfdata->Add(new PerfdataValue("opentsdbwriter_" + opentsdbwriter->GetName() + "_data_buffer_bytes", dataBufferBytes, false, "bytes"));
 	}
 
 	status->Set("opentsdbwriter", new Dictionary(std::move(nodes)));
@@ -94,6 +101,13 @@ void OpenTsdbWriter::Resume()
 	m_Connection = new PerfdataWriterConnection{this, GetHost(), GetPort()};
 	m_LockedConnection.store(m_Connection);
 
+	/* Setup timer for periodically flushing m_MsgBuf */
+	m_FlushTimer = Timer::Create();
+	m_FlushTimer->SetInterval(GetFlushInterval());
+	m_FlushTimer->OnTimerExpired.connect([this](const Timer * const&) { FlushTimeout(); });
+	m_FlushTimer->Start();
+	m_FlushTimer->Reschedule(0);
+
 	m_HandleCheckResults = Service::OnNewCheckResult.connect([this](const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr&) {
 		CheckResultHandler(checkable, cr);
 	});
@@ -106,9 +120,12 @@ void OpenTsdbWriter::Pause()
 {
 	m_HandleCheckResults.disconnect();
 
+	m_FlushTimer->Stop(true);
+
 	std::promise<void> queueDonePromise;
 
 	m_WorkQueue.Enqueue([&]() {
+		SendMsgBuffer();
 		queueDonePromise.set_value();
 	}, PriorityLow);
 
@@ -284,11 +301,32 @@ void OpenTsdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const C
 			AddMetric(checkable, metric + ".latency", tags, cr->CalculateLatency(), ts);
 			AddMetric(checkable, metric + ".execution_time", tags, cr->CalculateExecutionTime(), ts);
 
-			SendMsgBuffer();
+			// Flush if we've buffered too much to prevent excessive memory use
+			if (m_MsgBuf.ShouldFlush(GetFlushThreshold())) {
+				Log(LogDebug, "OpenTsdbWriter")
+					<< "Data buffer overflow writing " << m_MsgBuf.GetDataPoints() << " data points";
+
+				SendMsgBuffer();
+			}
 		}
 	);
 }
 
+/**
+ * Queues a flush on the work queue, unless one is still pending.
+ */
+void OpenTsdbWriter::FlushTimeout()
+{
+	if (m_FlushTimerInQueue.exchange(true, std::memory_order_relaxed)) {
+		return;
+	}
+
+	m_WorkQueue.Enqueue([this]() {
+		Defer resetFlushTimer{[this]() { m_FlushTimerInQueue.store(false, std::memory_order_relaxed); }};
+		SendMsgBuffer();
+	});
+}
+
 /**
  * Parse and send performance data metrics to OpenTSDB
  *
@@ -310,21 +348,13 @@ void OpenTsdbWriter::AddPerfdata(const Checkable::Ptr& checkable, const String&
 
 	CheckCommand::Ptr checkCommand = checkable->GetCheckCommand();
 
-	for (const Value& val : perfdata) {
-		PerfdataValue::Ptr pdv;
-
-		if (val.IsObjectType<PerfdataValue>())
-			pdv = val;
-		else {
-			try {
-				pdv = PerfdataValue::Parse(val);
-			} catch (const std::exception&) {
-				Log(LogWarning, "OpenTsdbWriter")
-					<< "Ignoring invalid perfdata for checkable '"
-					<< checkable->GetName() << "' and command '"
-					<< checkCommand->GetName() << "' with value: " << val;
-				continue;
-			}
+	for (auto& pdv : *cr->GetParsedPerformanceData()) {
+		if (!pdv.Valid) {
+			Log(LogWarning, "OpenTsdbWriter")
+				<< "Ignoring invalid perfdata for checkable '"
+				<< checkable->GetName() << "' and command '"
+				<< checkCommand->GetName() << "' with value: " << pdv.Raw;
+			continue;
 		}
 		
 		String metric_name;
@@ -333,25 +363,25 @@ void OpenTsdbWriter::AddPerfdata(const Checkable::Ptr& checkable, const String&
 		// Do not break original functionality where perfdata labels form
 		// part of the metric name
 		if (!GetEnableGenericMetrics()) {
-			String escaped_key = EscapeMetric(pdv->GetLabel());
+			String escaped_key = EscapeMetric(pdv.Label);
 			boost::algorithm::replace_all(escaped_key, "::", ".");
 			metric_name = metric + "." + escaped_key;
 		} else {
-			String escaped_key = EscapeTag(pdv->GetLabel());
+			String escaped_key = EscapeTag(pdv.Label);
 			metric_name = metric;
 			tags_new["label"] = escaped_key;
 		}
 
-		AddMetric(checkable, metric_name, tags_new, pdv->GetValue(), ts);
+		AddMetric(checkable, metric_name, tags_new, pdv.Number, ts);
 
-		if (!pdv->GetCrit().IsEmpty())
-			AddMetric(checkable, metric_name + "_crit", tags_new, pdv->GetCrit(), ts);
-		if (!pdv->GetWarn().IsEmpty())
-			AddMetric(checkable, metric_name + "_warn", tags_new, pdv->GetWarn(), ts);
-		if (!pdv->GetMin().IsEmpty())
-			AddMetric(checkable, metric_name + "_min", tags_new, pdv->GetMin(), ts);
-		if (!pdv->GetMax().IsEmpty())
-			AddMetric(checkable, metric_name + "_max", tags_new, pdv->GetMax(), ts);
+		if (!pdv.Crit.IsEmpty())
+			AddMetric(checkable, metric_name + "_crit", tags_new, pdv.Crit, ts);
+		if (!pdv.Warn.IsEmpty())
+			AddMetric(checkable, metric_name + "_warn", tags_new, pdv.Warn, ts);
+		if (!pdv.Min.IsEmpty())
+			AddMetric(checkable, metric_name + "_min", tags_new, pdv.Min, ts);
+		if (!pdv.Max.IsEmpty())
+			AddMetric(checkable, metric_name + "_max", tags_new, pdv.Max, ts);
 	}
 }
 
@@ -369,41 +399,45 @@ void OpenTsdbWriter::AddMetric(const Checkable::Ptr& checkable, const String& me
 {
 	ASSERT(m_WorkQueue.IsWorkerThread());
 
-	String tags_string = "";
-
-	for (auto& tag : tags) {
-		tags_string += " " + tag.first + "=" + tag.second;
-	}
-
-	std::ostringstream msgbuf;
 	/*
 	 * must be (http://opentsdb.net/docs/build/html/user_guide/query/timeseries.html)
 	 * put <metric> <timestamp> <value> <tagk1=tagv1[ tagk2=tagv2 ...tagkN=tagvN]>
 	 * "tags" must include at least one tag, we use "host=HOSTNAME"
 	 */
-	msgbuf << "put " << metric << " " << static_cast<long>(ts) << " " << Convert::ToString(value) << tags_string;
+	std::string& msgbuf = m_MsgBuf.BeginDataPoint();
+	msgbuf.append("put ").append(metric.GetData())
+		.append(" ").append(std::to_string(static_cast<long>(ts)))
+		.append(" ").append(Convert::ToString(value).GetData());
 
-	Log(LogDebug, "OpenTsdbWriter")
-		<< "Checkable '" << checkable->GetName() << "' adds to metric list: '" << msgbuf.str() << "'.";
+	for (auto& tag : tags) {
+		msgbuf.append(" ").append(tag.first.GetData()).append("=").append(tag.second.GetData());
+	}
 
-	/* do not send \n to debug log */
-	msgbuf << "\n";
-	m_MsgBuf.append(msgbuf.str());
+	Log(LogDebug, "OpenTsdbWriter")
+		<< "Checkable '" << checkable->GetName() << "' adds to metric list: '" << m_MsgBuf.EndDataPoint() << "'.";
 }
 
 void OpenTsdbWriter::SendMsgBuffer()
 {
 	ASSERT(m_WorkQueue.IsWorkerThread());
 
+	if (m_MsgBuf.IsEmpty())
+		return;
+
 	Log(LogDebug, "OpenTsdbWriter")
 		<< "Flushing data buffer to OpenTsdb.";
 
+	std::string body = m_MsgBuf.Take();
+	body += "\n";
+
 	try {
-		m_Connection->Send(boost::asio::buffer(std::exchange(m_MsgBuf, std::string{})));
+		m_Connection->Send(boost::asio::buffer(body));
 	} catch (const PerfdataWriterConnection::Stopped& ex) {
 		Log(LogDebug, "OpenTsdbWriter") << ex.what();
 		return;
 	}
+
+	m_MsgBuf.Recycle(std::move(body));
 }
 
 /**
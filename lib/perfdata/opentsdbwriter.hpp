@@ -7,7 +7,10 @@
 #include "perfdata/opentsdbwriter-ti.hpp"
 #include "icinga/checkable.hpp"
 #include "base/configobject.hpp"
+#include "base/timer.hpp"
+#include "perfdata/metricsbuffer.hpp"
 #include "perfdata/perfdatawriterconnection.hpp"
+#include <atomic>
 
 namespace icinga
 {
@@ -35,7 +38,9 @@ protected:
 
 private:
 	WorkQueue m_WorkQueue{10000000, 1};
-	std::string m_MsgBuf;
+	Timer::Ptr m_FlushTimer;
+	std::atomic_bool m_FlushTimerInQueue{false};
+	MetricsBuffer m_MsgBuf;
 	PerfdataWriterConnection::Ptr m_Connection;
 	Locked<PerfdataWriterConnection::Ptr> m_LockedConnection;
 
@@ -47,6 +52,7 @@ private:
 	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
 	void AddMetric(const Checkable::Ptr& checkable, const String& metric,
 		const std::map<String, String>& tags, double value, double ts);
+	void FlushTimeout();
 	void SendMsgBuffer();
 	void AddPerfdata(const Checkable::Ptr& checkable, const String& metric,
 		const std::map<String, String>& tags, const CheckResult::Ptr& cr, double ts);
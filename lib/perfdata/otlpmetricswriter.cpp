@@ -9,6 +9,7 @@
 #include "base/object-packer.hpp"
 #include "base/perfdatavalue.hpp"
 #include "base/statsfunction.hpp"
+#include "base/utility.hpp"
 #include "icinga/checkable.hpp"
 #include "icinga/checkcommand.hpp"
 #include "icinga/macroprocessor.hpp"
@@ -30,6 +31,7 @@ REGISTER_STATSFUNCTION(OTLPMetricsWriter, &OTLPMetricsWriter::StatsFunc);
 // [^2]: https://opentelemetry.io/docs/specs/semconv/general/naming
 static constexpr std::string_view l_PerfdataMetric = "state_check.perfdata";
 static constexpr std::string_view l_ThresholdMetric = "state_check.threshold";
+static constexpr std::string_view l_StageMetric = "state_check.stage.duration";
 
 void OTLPMetricsWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
@@ -39,6 +41,8 @@ void OTLPMetricsWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Pt
 		double workQueueItemRate = otlpWriter->m_WorkQueue.GetTaskCount(60) / 60.0;
 		std::size_t dataPointsCount = otlpWriter->m_DataPointsCount.load(std::memory_order_relaxed);
 		uint64_t messageSize = otlpWriter->m_RecordedBytes.load(std::memory_order_relaxed);
+		uint64_t arenaBytes = otlpWriter->m_Arenas->GetBytes();
+		double encodeTime = otlpWriter->m_Exporter ? otlpWriter->m_Exporter->GetLastEncodeTime() : 0;
 
 		const auto name = otlpWriter->GetName();
 		statusData.emplace_back(name, new Dictionary{
@@ -46,12 +50,16 @@ void OTLPMetricsWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Pt
 			{"work_queue_item_rate", workQueueItemRate},
 			{"data_buffer_items", dataPointsCount},
 			{"data_buffer_bytes", messageSize},
+			{"arena_bytes", arenaBytes},
+			{"encode_time", encodeTime},
 		});
 
 		perfdata->Add(new PerfdataValue("otlpmetricswriter_" + name + "_work_queue_items", workQueueSize));
 		perfdata->Add(new PerfdataValue("otlpmetricswriter_" + name + "_work_queue_item_rate", workQueueItemRate));
 		perfdata->Add(new PerfdataValue("otlpmetricswriter_" + name + "_data_buffer_items", dataPointsCount));
 		perfdata->Add(new PerfdataValue("otlpmetricswriter_" + name + "_data_buffer_bytes", messageSize, false, "bytes"));
+		perfdata->Add(new PerfdataValue("otlpmetricswriter_" + name + "_arena_bytes", arenaBytes, false, "bytes"));
+		perfdata->Add(new PerfdataValue("otlpmetricswriter_" + name + "_encode_time", encodeTime, false, "seconds"));
 	}
 	status->Set("otlpmetricswriter", new Dictionary{std::move(statusData)});
 }
@@ -85,6 +93,7 @@ void OTLPMetricsWriter::Start(bool runtimeCreated)
 	connInfo.TlsCrt = GetTlsCertFile();
 	connInfo.TlsKey = GetTlsKeyFile();
 	connInfo.MetricsEndpoint = GetMetricsEndpoint();
+	connInfo.GzipCompression = GetCompression() == "gzip";
 	if (auto auth = GetBasicAuth(); auth) {
 		connInfo.BasicAuth = Base64::Encode(auth->Get("username") + ":" + auth->Get("password"));
 	}
@@ -126,19 +135,42 @@ void OTLPMetricsWriter::Resume()
 	) {
 		CheckResultHandler(checkable, cr);
 	});
+	if (GetEnableCheckTraces()) {
+		m_CheckTracesSlot = CheckTrace::OnFinished.connect([this](const CheckTrace::Ptr& trace) {
+			CheckTraceFinishedHandler(trace);
+		});
+	}
 	m_ActiveChangedSlot = OnActiveChanged.connect([this](const ConfigObject::Ptr& obj, const Value&) {
 		auto checkable = dynamic_pointer_cast<Checkable>(obj);
 		if (!checkable || checkable->IsActive()) {
 			return;
 		}
-		m_WorkQueue.Enqueue([this, checkable] { m_Metrics.erase(checkable.get()); });
+		m_WorkQueue.Enqueue([this, checkable] {
+			m_Metrics.erase(checkable.get());
+			m_Resources.erase(checkable.get());
+			m_Histograms.erase(checkable.get());
+			m_TraceHistograms.erase(checkable.get());
+		});
+	});
+	// Cached resources have to be rebuilt if any of their attributes may have changed.
+	m_VarsChangedSlot = CustomVarObject::OnVarsChanged.connect([this](const CustomVarObject::Ptr& object, const Value&) {
+		// Services may use the vars of their host, so it's not worth to figure out which resources are affected.
+		if (dynamic_pointer_cast<Checkable>(object)) {
+			m_WorkQueue.Enqueue([this] { m_Resources.clear(); });
+		}
+	});
+	m_CheckCommandChangedSlot = Checkable::OnCheckCommandRawChanged.connect([this](const Checkable::Ptr& checkable, const Value&) {
+		m_WorkQueue.Enqueue([this, checkable] { m_Resources.erase(checkable.get()); });
 	});
 }
 
 void OTLPMetricsWriter::Pause()
 {
 	m_CheckResultsSlot.disconnect();
+	m_CheckTracesSlot.disconnect();
 	m_ActiveChangedSlot.disconnect();
+	m_VarsChangedSlot.disconnect();
+	m_CheckCommandChangedSlot.disconnect();
 
 	m_FlushTimer->Stop(true);
 
@@ -158,6 +190,10 @@ void OTLPMetricsWriter::Pause()
 	m_WorkQueue.Join();
 
 	m_Metrics.clear();
+	m_Request.reset();
+	m_Resources.clear();
+	m_Histograms.clear();
+	m_TraceHistograms.clear();
 
 	Log(LogInformation, "OTLPMetricsWriter")
 		<< "'" << GetName() << "' paused.";
@@ -180,39 +216,36 @@ void OTLPMetricsWriter::CheckResultHandler(const Checkable::Ptr& checkable, cons
 		auto startTime = cr->GetScheduleStart();
 		auto endTime = cr->GetExecutionEnd();
 
-		Array::Ptr perfdata = cr->GetPerformanceData();
-		for (const Value& val : perfdata) {
-			PerfdataValue::Ptr pdv;
-			if (val.IsObjectType<PerfdataValue>()) {
-				pdv = val;
-			} else {
-				try {
-					pdv = PerfdataValue::Parse(val);
-				} catch (const std::exception&) {
-					Log(LogWarning, "OTLPMetricsWriter")
-						<< "Ignoring invalid perfdata for checkable '" << checkable->GetName() << "' and command '"
-						<< checkable->GetCheckCommand()->GetName() << "' with value: " << val;
-					continue;
-				}
+		for (auto& pdv : *cr->GetParsedPerformanceData()) {
+			if (!pdv.Valid) {
+				Log(LogWarning, "OTLPMetricsWriter")
+					<< "Ignoring invalid perfdata for checkable '" << checkable->GetName() << "' and command '"
+					<< checkable->GetCheckCommand()->GetName() << "' with value: " << pdv.Raw;
+				continue;
 			}
 
-			OTel::AttrsMap attrs{{"perfdata_label", pdv->GetLabel()}};
-			if (auto unit = pdv->GetUnit(); !unit.IsEmpty()) {
-				attrs.emplace("unit", std::move(unit));
+			OTel::AttrsMap attrs;
+			if (GetEnableHistograms()) {
+				AggregatePerfdata(checkable, cr, pdv);
+			} else {
+				attrs.emplace("perfdata_label", pdv.Label);
+				if (auto unit = pdv.Unit; !unit.IsEmpty()) {
+					attrs.emplace("unit", std::move(unit));
+				}
+				AddBytesAndFlushIfNeeded(Record(checkable, cr, l_PerfdataMetric, pdv.Number, startTime, endTime, std::move(attrs)));
 			}
-			AddBytesAndFlushIfNeeded(Record(checkable, cr, l_PerfdataMetric, pdv->GetValue(), startTime, endTime, std::move(attrs)));
 
 			if (GetEnableSendThresholds()) {
 				std::array<std::pair<String, Value>, 4> thresholds{{
-					{"critical", pdv->GetCrit()},
-					{"warning", pdv->GetWarn()},
-					{"min", pdv->GetMin()},
-					{"max", pdv->GetMax()},
+					{"critical", pdv.Crit},
+					{"warning", pdv.Warn},
+					{"min", pdv.Min},
+					{"max", pdv.Max},
 				}};
 				for (auto& [label, threshold] : thresholds) {
 					if (!threshold.IsEmpty()) {
 						attrs = {
-							{"perfdata_label", pdv->GetLabel()},
+							{"perfdata_label", pdv.Label},
 							{"threshold_type", std::move(label)},
 						};
 						AddBytesAndFlushIfNeeded(
@@ -233,6 +266,45 @@ void OTLPMetricsWriter::CheckResultHandler(const Checkable::Ptr& checkable, cons
 	});
 }
 
+/**
+ * Aggregate the stages of a finished check trace into the stage histograms of its checkable.
+ *
+ * Unlike perfdata, the stages are always aggregated, as a data point per traced check and stage
+ * would blow up the OTel messages. They're recorded into the OTel message on the next flush.
+ *
+ * @param trace The finished trace.
+ */
+void OTLPMetricsWriter::CheckTraceFinishedHandler(const CheckTrace::Ptr& trace)
+{
+	m_WorkQueue.Enqueue([this, trace, endTime = Utility::GetTime()] {
+		if (m_Exporter->Stopped()) {
+			return;
+		}
+
+		auto& checkable (trace->GetCheckable());
+		auto& checkableHistograms = m_TraceHistograms[checkable.get()];
+		checkableHistograms.Object = checkable;
+		checkableHistograms.LastResult = checkable->GetLastCheckResult();
+
+		for (std::size_t i = 0; i < static_cast<std::size_t>(CheckTraceStage::Count); i++) {
+			auto stage (static_cast<CheckTraceStage>(i));
+
+			if (!trace->HasStage(stage)) {
+				continue;
+			}
+
+			auto [it, inserted] = checkableHistograms.Histograms.try_emplace({CheckTrace::GetStageName(stage), "s"});
+			if (inserted) {
+				it->second.StartTime = trace->GetStartTime();
+			}
+			it->second.EndTime = endTime;
+			it->second.Values.Add(trace->GetStageDuration(stage));
+
+			m_DataPointsCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	});
+}
+
 void OTLPMetricsWriter::Flush(bool fromTimer)
 {
 	// If previous export is still in progress and this flush is requested from timer, skip it.
@@ -245,18 +317,17 @@ void OTLPMetricsWriter::Flush(bool fromTimer)
 	Log(LogDebug, "OTLPMetricsWriter")
 		<< "Flushing OTel metrics to OpenTelemetry backend" << (fromTimer ? " (timer expired)." : ".");
 
-	auto request = std::make_unique<OTel::MetricsRequest>();
-	for (auto& [checkable, resourceMetrics] : m_Metrics) {
-		if (resourceMetrics) {
-			request->mutable_resource_metrics()->AddAllocated(resourceMetrics.release());
-		}
-	}
-	if (request->resource_metrics_size() == 0) {
+	RecordHistograms(m_Histograms, l_PerfdataMetric, "perfdata_label");
+	RecordHistograms(m_TraceHistograms, l_StageMetric, "stage");
+
+	if (!m_Request || m_Request->resource_metrics_size() == 0) {
 		Log(LogDebug, "OTLPMetricsWriter")
 			<< "Not flushing OTel metrics: No data points recorded.";
 		return;
 	}
-	m_Exporter->Export(std::move(request));
+	m_Exporter->Export(std::move(m_Request));
+	m_Request.reset();
+	m_Metrics.clear();
 	m_RecordedBytes.store(0, std::memory_order_relaxed);
 	m_DataPointsCount.store(0, std::memory_order_relaxed);
 }
@@ -301,64 +372,9 @@ std::size_t OTLPMetricsWriter::Record(
 )
 {
 	std::size_t bytes = 0;
-	auto& resourceMetrics = m_Metrics[checkable.get()];
-	if (!resourceMetrics) {
-		using namespace std::string_view_literals;
-
-		resourceMetrics = std::make_unique<opentelemetry::proto::metrics::v1::ResourceMetrics>();
-		OTel::PopulateResourceAttrs(resourceMetrics);
-
-		auto* resource = resourceMetrics->mutable_resource();
-		auto* attr = resource->add_attributes();
-		OTel::SetAttribute(*attr, "service.namespace"sv, GetServiceNamespace());
-
-		auto [host, service] = GetHostService(checkable);
-		attr = resource->add_attributes();
-		OTel::SetAttribute(*attr, "icinga2.host.name"sv, host->GetName());
-
-		// Add entity reference (https://opentelemetry.io/docs/specs/otel/entities/data-model/).
-		auto* entity = resource->add_entity_refs();
-		entity->mutable_id_keys()->Add("icinga2.host.name");
-		if (service) {
-			entity->set_type("service");
-			entity->mutable_id_keys()->Add("icinga2.service.name");
-
-			attr = resource->add_attributes();
-			OTel::SetAttribute(*attr, "icinga2.service.name"sv, service->GetShortName());
-		} else {
-			entity->set_type("host");
-		}
-		attr = resource->add_attributes();
-		OTel::SetAttribute(*attr, "icinga2.command.name"sv, checkable->GetCheckCommand()->GetName());
-
-		if (Dictionary::Ptr tmpl = service ? GetServiceResourceAttributes() : GetHostResourceAttributes(); tmpl) {
-			MacroProcessor::ResolverList resolvers{{"host", host}};
-			if (service) {
-				resolvers.emplace_back("service", service);
-			}
+	auto& resourceMetrics = GetResourceMetrics(checkable, cr, bytes);
 
-			ObjectLock olock(tmpl);
-			for (const Dictionary::Pair& pair : tmpl) {
-				String missingMacro;
-				auto resolvedVal = MacroProcessor::ResolveMacros(pair.second, resolvers, cr, &missingMacro);
-				if (missingMacro.IsEmpty()) {
-					attr = resource->add_attributes();
-					try {
-						OTel::SetAttribute(*attr, "icinga2.custom." + pair.first, resolvedVal);
-					} catch (const std::exception& ex) {
-						Log(LogWarning, "OTLPMetricsWriter")
-							<< "Ignoring invalid resource attribute '" << pair.first << "' for checkable '"
-							<< checkable->GetName() << "': " << ex.what();
-						 // Remove the last attribute from the list which is the one we just attempted to set.
-						resource->mutable_attributes()->RemoveLast();
-					}
-				}
-			}
-		}
-		bytes = resourceMetrics->ByteSizeLong();
-	}
-
-	auto* sm = resourceMetrics->mutable_scope_metrics(0);
+	auto* sm = resourceMetrics.mutable_scope_metrics(0);
 	auto* metrics = sm->mutable_metrics();
 	auto it = std::find_if(metrics->begin(), metrics->end(), [metric](const auto& m) { return m.name() == metric; });
 	OTel::Gauge* gaugePtr = nullptr;
@@ -376,6 +392,170 @@ std::size_t OTLPMetricsWriter::Record(
 	return bytes;
 }
 
+/**
+ * Aggregate the given perfdata value into the histogram of its label.
+ *
+ * The histograms are only recorded into the OTel message on the next flush, so that checks with a
+ * high frequency result in a summary per flush interval instead of a data point per check result.
+ *
+ * @param checkable The checkable the perfdata value belongs to.
+ * @param cr The check result the perfdata value is part of.
+ * @param pdv The perfdata value.
+ */
+void OTLPMetricsWriter::AggregatePerfdata(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const ParsedPerfdata& pdv)
+{
+	auto& checkableHistograms = m_Histograms[checkable.get()];
+	checkableHistograms.Object = checkable;
+	checkableHistograms.LastResult = cr;
+
+	auto [it, inserted] = checkableHistograms.Histograms.try_emplace({pdv.Label, pdv.Unit});
+	if (inserted) {
+		it->second.StartTime = cr->GetScheduleStart();
+	}
+	it->second.EndTime = cr->GetExecutionEnd();
+	it->second.Values.Add(pdv.Number);
+
+	m_DataPointsCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Record the given histograms aggregated since the last flush into the current OTel message and reset them.
+ *
+ * @param histograms The histograms, e.g. @c m_Histograms.
+ * @param metricName The name of the OTel metric to record them as.
+ * @param labelAttr The attribute to set to the first part of each histogram's key.
+ */
+void OTLPMetricsWriter::RecordHistograms(
+	std::unordered_map<Checkable*, CheckableHistograms>& histograms,
+	std::string_view metricName,
+	const String& labelAttr
+)
+{
+	if (histograms.empty()) {
+		return;
+	}
+
+	OTel::ValidateName(metricName);
+
+	std::size_t bytes = 0;
+	for (auto& [ptr, checkableHistograms] : histograms) {
+		auto& resourceMetrics = GetResourceMetrics(checkableHistograms.Object, checkableHistograms.LastResult, bytes);
+		auto* metric = resourceMetrics.mutable_scope_metrics(0)->add_metrics();
+		metric->set_name(std::string(metricName));
+		auto* histogram = metric->mutable_exponential_histogram();
+
+		for (auto& [key, data] : checkableHistograms.Histograms) {
+			OTel::AttrsMap attrs{{labelAttr, key.first}};
+			if (!key.second.IsEmpty()) {
+				attrs.emplace("unit", key.second);
+			}
+			bytes += OTel::Record(*histogram, data.Values, data.StartTime, data.EndTime, std::move(attrs));
+		}
+	}
+	histograms.clear();
+	m_RecordedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * Get the OTel resource and scope of the given checkable, as cached since they have been built first.
+ *
+ * @param checkable The checkable to get the resource of.
+ * @param cr The check result used for resolving macros in the custom resource attributes if not cached yet.
+ *
+ * @return A ResourceMetrics message containing the resource and an empty scope.
+ */
+const OTLPMetricsWriter::ResourceMetrics& OTLPMetricsWriter::GetResource(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+{
+	auto& resourceMetrics = m_Resources[checkable.get()];
+	if (resourceMetrics) {
+		return *resourceMetrics;
+	}
+
+	using namespace std::string_view_literals;
+
+	resourceMetrics = std::make_unique<ResourceMetrics>();
+	OTel::PopulateResourceAttrs(*resourceMetrics);
+
+	auto* resource = resourceMetrics->mutable_resource();
+	auto* attr = resource->add_attributes();
+	OTel::SetAttribute(*attr, "service.namespace"sv, GetServiceNamespace());
+
+	auto [host, service] = GetHostService(checkable);
+	attr = resource->add_attributes();
+	OTel::SetAttribute(*attr, "icinga2.host.name"sv, host->GetName());
+
+	// Add entity reference (https://opentelemetry.io/docs/specs/otel/entities/data-model/).
+	auto* entity = resource->add_entity_refs();
+	entity->mutable_id_keys()->Add("icinga2.host.name");
+	if (service) {
+		entity->set_type("service");
+		entity->mutable_id_keys()->Add("icinga2.service.name");
+
+		attr = resource->add_attributes();
+		OTel::SetAttribute(*attr, "icinga2.service.name"sv, service->GetShortName());
+	} else {
+		entity->set_type("host");
+	}
+	attr = resource->add_attributes();
+	OTel::SetAttribute(*attr, "icinga2.command.name"sv, checkable->GetCheckCommand()->GetName());
+
+	if (Dictionary::Ptr tmpl = service ? GetServiceResourceAttributes() : GetHostResourceAttributes(); tmpl) {
+		MacroProcessor::ResolverList resolvers{{"host", host}};
+		if (service) {
+			resolvers.emplace_back("service", service);
+		}
+
+		ObjectLock olock(tmpl);
+		for (const Dictionary::Pair& pair : tmpl) {
+			String missingMacro;
+			auto resolvedVal = MacroProcessor::ResolveMacros(pair.second, resolvers, cr, &missingMacro);
+			if (missingMacro.IsEmpty()) {
+				attr = resource->add_attributes();
+				try {
+					OTel::SetAttribute(*attr, "icinga2.custom." + pair.first, resolvedVal);
+				} catch (const std::exception& ex) {
+					Log(LogWarning, "OTLPMetricsWriter")
+						<< "Ignoring invalid resource attribute '" << pair.first << "' for checkable '"
+						<< checkable->GetName() << "': " << ex.what();
+					 // Remove the last attribute from the list which is the one we just attempted to set.
+					resource->mutable_attributes()->RemoveLast();
+				}
+			}
+		}
+	}
+	return *resourceMetrics;
+}
+
+/**
+ * Get the ResourceMetrics of the given checkable within the current OTel message.
+ *
+ * If the checkable has no data points in the current message yet, its cached resource and scope are copied
+ * into it, creating the message on a recycled arena if necessary.
+ *
+ * @param checkable The checkable to get the ResourceMetrics of.
+ * @param cr The check result used for resolving macros in the custom resource attributes.
+ * @param bytes Incremented by the size of the resource if it has been added to the message.
+ *
+ * @return The ResourceMetrics, owned by the current message.
+ */
+OTLPMetricsWriter::ResourceMetrics& OTLPMetricsWriter::GetResourceMetrics(
+	const Checkable::Ptr& checkable,
+	const CheckResult::Ptr& cr,
+	std::size_t& bytes
+)
+{
+	auto& resourceMetrics = m_Metrics[checkable.get()];
+	if (!resourceMetrics) {
+		if (!m_Request) {
+			m_Request = m_Arenas->NewRequest();
+		}
+		resourceMetrics = m_Request->add_resource_metrics();
+		resourceMetrics->CopyFrom(GetResource(checkable, cr));
+		bytes += resourceMetrics->ByteSizeLong();
+	}
+	return *resourceMetrics;
+}
+
 void OTLPMetricsWriter::ValidatePort(const Lazy<int>& lvalue, const ValidationUtils& utils)
 {
 	ObjectImpl::ValidatePort(lvalue, utils);
@@ -441,3 +621,11 @@ void OTLPMetricsWriter::ValidateResourceAttributes(const Dictionary::Ptr& tmpl,
 		}
 	}
 }
+
+void OTLPMetricsWriter::ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils)
+{
+	ObjectImpl::ValidateCompression(lvalue, utils);
+	if (lvalue() != "none" && lvalue() != "gzip") {
+		BOOST_THROW_EXCEPTION(ValidationError(this, {"compression"}, "Compression must be either 'none' or 'gzip'."));
+	}
+}
@@ -6,8 +6,12 @@
 #include "perfdata/otlpmetricswriter-ti.hpp"
 #include "base/workqueue.hpp"
 #include "icinga/checkable.hpp"
+#include "icinga/checktrace.hpp"
 #include "otel/otel.hpp"
+#include "otel/otelhistogram.hpp"
+#include <map>
 #include <unordered_map>
+#include <utility>
 
 namespace icinga
 {
@@ -29,14 +33,42 @@ protected:
 	void ValidatePort(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
 	void ValidateFlushInterval(const Lazy<int>& lvalue, const ValidationUtils& utils) override;
 	void ValidateFlushThreshold(const Lazy<int64_t>& lvalue, const ValidationUtils& utils) override;
+	void ValidateCompression(const Lazy<String>& lvalue, const ValidationUtils& utils) override;
 	void ValidateHostResourceAttributes(const Lazy<Dictionary::Ptr>& lvalue, const ValidationUtils& utils) override;
 	void ValidateServiceResourceAttributes(const Lazy<Dictionary::Ptr>& lvalue, const ValidationUtils& utils) override;
 
 private:
+	using ResourceMetrics = opentelemetry::proto::metrics::v1::ResourceMetrics;
+
+	/**
+	 * The values of a perfdata label or check trace stage aggregated since the last flush.
+	 */
+	struct Histogram
+	{
+		OTelHistogram Values;
+		double StartTime{0};
+		double EndTime{0};
+	};
+
+	/**
+	 * The histograms of a checkable, keyed by perfdata label (or check trace stage) and unit.
+	 */
+	struct CheckableHistograms
+	{
+		Checkable::Ptr Object;
+		CheckResult::Ptr LastResult; // For resolving the resource attributes if they aren't cached anymore.
+		std::map<std::pair<String, String>, Histogram> Histograms;
+	};
+
 	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
 	void Flush(bool fromTimer = false);
 	void AddBytesAndFlushIfNeeded(std::size_t newBytes = 0);
 	void ValidateResourceAttributes(const Dictionary::Ptr& tmpl, const String& attrName);
+	void CheckTraceFinishedHandler(const CheckTrace::Ptr& trace);
+	void AggregatePerfdata(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const ParsedPerfdata& pdv);
+	void RecordHistograms(std::unordered_map<Checkable*, CheckableHistograms>& histograms, std::string_view metricName, const String& labelAttr);
+	const ResourceMetrics& GetResource(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	ResourceMetrics& GetResourceMetrics(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, std::size_t& bytes);
 
 	template<typename T>
 	[[nodiscard]] std::size_t Record(
@@ -52,11 +84,20 @@ private:
 	std::atomic_uint64_t m_RecordedBytes{0}; // Total bytes recorded in the current OTel message.
 	std::atomic_uint64_t m_DataPointsCount{0}; // Total data points recorded in the current OTel message.
 
-	// Checkables and their associated OTel ResourceMetrics that are being recorded for the current OTel message.
-	std::unordered_map<Checkable*, std::unique_ptr<opentelemetry::proto::metrics::v1::ResourceMetrics>> m_Metrics;
+	std::shared_ptr<OTel::MetricsRequest> m_Request; // The OTel message currently being recorded (if any).
+	// Checkables and their associated OTel ResourceMetrics within m_Request.
+	std::unordered_map<Checkable*, ResourceMetrics*> m_Metrics;
+	// Checkables and their resource and scope, which are copied into each OTel message they have data points in.
+	std::unordered_map<Checkable*, std::unique_ptr<ResourceMetrics>> m_Resources;
+	// Checkables and their perfdata aggregated since the last flush, if enable_histograms is set.
+	std::unordered_map<Checkable*, CheckableHistograms> m_Histograms;
+	// Checkables and their check trace stages aggregated since the last flush, if enable_check_traces is set.
+	std::unordered_map<Checkable*, CheckableHistograms> m_TraceHistograms;
+	OTelArenaPool::Ptr m_Arenas{new OTelArenaPool()};
 
 	WorkQueue m_WorkQueue{10'000'000, 1};
-	boost::signals2::connection m_CheckResultsSlot, m_ActiveChangedSlot;
+	boost::signals2::connection m_CheckResultsSlot, m_ActiveChangedSlot, m_VarsChangedSlot, m_CheckCommandChangedSlot;
+	boost::signals2::connection m_CheckTracesSlot;
 	OTel::Ptr m_Exporter;
 	Timer::Ptr m_FlushTimer;
 	std::atomic_bool m_TimerFlushInProgress{false}; // Whether a timer-initiated flush is in progress.
@@ -0,0 +1,237 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "perfdata/perfdataspool.hpp"
+#include "base/atomic-file.hpp"
+#include "base/convert.hpp"
+#include "base/logger.hpp"
+#include "base/perfdatavalue.hpp"
+#include "base/utility.hpp"
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using namespace icinga;
+
+PerfdataSpool::PerfdataSpool(String path, std::uint64_t maxBytes, String logFacility)
+	: m_Path(std::move(path)), m_MaxBytes(maxBytes), m_LogFacility(std::move(logFacility))
+{
+	namespace fs = boost::filesystem;
+
+	Utility::MkDirP(m_Path, 0750);
+
+	/* Leftovers of segments which were being written while we crashed. */
+	Utility::Glob(m_Path + "/*.seg.tmp.*", &Utility::Remove, GlobFile);
+
+	std::vector<std::pair<std::uint64_t, Segment>> segments;
+
+	Utility::Glob(m_Path + "/*.seg", [&segments](const String& file) {
+		String name = Utility::BaseName(file);
+		std::uint64_t id;
+
+		try {
+			id = Convert::ToLong(name.SubStr(0, name.GetLength() - 4));
+		} catch (const std::exception&) {
+			return;
+		}
+
+		fs::path fsPath (file.Begin(), file.End());
+		segments.emplace_back(id, Segment{file, fs::file_size(fsPath), static_cast<double>(fs::last_write_time(fsPath))});
+	}, GlobFile);
+
+	std::sort(segments.begin(), segments.end(), [](auto& lhs, auto& rhs) { return lhs.first < rhs.first; });
+
+	for (auto& [id, segment] : segments) {
+		m_Bytes.fetch_add(segment.Size, std::memory_order_relaxed);
+		m_Segments.emplace_back(std::move(segment));
+		m_NextId = id + 1;
+	}
+
+	if (!m_Segments.empty()) {
+		Log(LogInformation, m_LogFacility)
+			<< "Found " << m_Segments.size() << " spooled payloads (" << GetBytes() << " bytes) in '" << m_Path << "'.";
+	}
+
+	while (GetBytes() > m_MaxBytes) {
+		DropOldest();
+	}
+
+	UpdateStats();
+}
+
+/**
+ * Appends a payload to the spool, dropping the oldest ones if necessary to stay within the size limit.
+ */
+void PerfdataSpool::Push(std::string_view payload)
+{
+	if (payload.size() > m_MaxBytes) {
+		Log(LogWarning, m_LogFacility)
+			<< "Dropping payload of " << payload.size() << " bytes, it exceeds the spool size limit of " << m_MaxBytes << " bytes.";
+		return;
+	}
+
+	size_t dropped = 0;
+
+	while (GetBytes() + payload.size() > m_MaxBytes) {
+		DropOldest();
+		++dropped;
+	}
+
+	if (dropped) {
+		Log(LogWarning, m_LogFacility)
+			<< "Spool '" << m_Path << "' is full, dropped the " << dropped << " oldest payloads.";
+	}
+
+	std::ostringstream name;
+	name << std::setw(20) << std::setfill('0') << m_NextId << ".seg";
+
+	String file = m_Path + "/" + name.str();
+
+	{
+		AtomicFile fp (file, 0640);
+		fp.write(payload.data(), payload.size());
+		fp.Commit();
+	}
+
+	++m_NextId;
+	m_Segments.emplace_back(Segment{std::move(file), payload.size(), Utility::GetTime()});
+	m_Bytes.fetch_add(payload.size(), std::memory_order_relaxed);
+
+	UpdateStats();
+}
+
+bool PerfdataSpool::IsEmpty() const
+{
+	return m_Segments.empty();
+}
+
+/**
+ * Reads the oldest payload. The spool must not be empty.
+ */
+std::string PerfdataSpool::Front() const
+{
+	auto& path (m_Segments.front().Path);
+
+	std::ifstream fp;
+	fp.open(path.CStr(), std::ios::binary);
+
+	std::string payload ((std::istreambuf_iterator<char>(fp)), std::istreambuf_iterator<char>());
+
+	fp.close();
+
+	if (fp.fail())
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not read spooled payload '" + path + "'."));
+
+	return payload;
+}
+
+/**
+ * Removes the oldest payload, e.g. after it has been sent. The spool must not be empty.
+ */
+void PerfdataSpool::Pop()
+{
+	DropOldest();
+	UpdateStats();
+}
+
+/**
+ * @return Whether a request answered with the given HTTP status code should be sent again later,
+ *         i.e. the endpoint is overloaded or has a temporary problem
+ */
+bool PerfdataSpool::IsTemporaryFailure(unsigned httpStatus)
+{
+	return httpStatus == 429 || httpStatus >= 500;
+}
+
+/**
+ * @return Whether sending may be tried again after the last failed attempt
+ */
+bool PerfdataSpool::IsRetryDue(double now) const
+{
+	return now >= m_NextRetry;
+}
+
+/**
+ * Backs off after a failed attempt to send, twice as long as after the previous one.
+ */
+void PerfdataSpool::RetryLater(double now)
+{
+	m_RetryDelay = std::min(MaxRetryDelay, std::max(MinRetryDelay, m_RetryDelay * 2));
+	m_NextRetry = now + m_RetryDelay;
+}
+
+/**
+ * Resets the backoff after a successful attempt to send.
+ */
+void PerfdataSpool::ResetRetryDelay()
+{
+	m_RetryDelay = 0;
+	m_NextRetry = 0;
+}
+
+std::size_t PerfdataSpool::GetSegments() const
+{
+	return m_SegmentCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t PerfdataSpool::GetBytes() const
+{
+	return m_Bytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @return When the oldest payload was spooled, 0 if the spool is empty
+ */
+double PerfdataSpool::GetOldestTimestamp() const
+{
+	return m_OldestTimestamp.load(std::memory_order_relaxed);
+}
+
+/**
+ * Adds the spool's size and age to a writer's stats.
+ *
+ * @param status The writer's status dictionary
+ * @param perfdata Array of PerfdataValue objects
+ * @param perfdataPrefix Prefix for the perfdata labels, e.g. "influxdbwriter_influxdb"
+ */
+void PerfdataSpool::AddStats(const Dictionary::Ptr& status, const Array::Ptr& perfdata, const String& perfdataPrefix) const
+{
+	size_t items = GetSegments();
+	uint64_t bytes = GetBytes();
+	double oldest = GetOldestTimestamp();
+	double age = oldest ? std::max(0.0, Utility::GetTime() - oldest) : 0;
+
+	status->Set("spool_items", items);
+	status->Set("spool_bytes", bytes);
+	status->Set("spool_oldest_age", age);
+
+	perfdata->Add(new PerfdataValue(perfdataPrefix + "_spool_items", items));
+	perfdata->Add(new PerfdataValue(perfdataPrefix + "_spool_bytes", bytes, false, "bytes"));
+	perfdata->Add(new PerfdataValue(perfdataPrefix + "_spool_oldest_age", age, false, "seconds"));
+}
+
+void PerfdataSpool::DropOldest()
+{
+	auto& segment (m_Segments.front());
+
+	try {
+		Utility::Remove(segment.Path);
+	} catch (const std::exception& ex) {
+		Log(LogWarning, m_LogFacility)
+			<< "Failed to remove spooled payload '" << segment.Path << "': " << ex.what();
+	}
+
+	m_Bytes.fetch_sub(segment.Size, std::memory_order_relaxed);
+	m_Segments.pop_front();
+}
+
+void PerfdataSpool::UpdateStats()
+{
+	m_SegmentCount.store(m_Segments.size(), std::memory_order_relaxed);
+	m_OldestTimestamp.store(m_Segments.empty() ? 0 : m_Segments.front().Timestamp, std::memory_order_relaxed);
+}
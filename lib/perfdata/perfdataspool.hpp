@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include "base/string.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+namespace icinga {
+
+/**
+ * Bounded on-disk FIFO of already serialized payloads, e.g. request bodies, of a perfdata writer.
+ *
+ * Each payload is one segment file in the spool directory, named after an increasing sequence
+ * number, so that the spool survives restarts and is replayed in order. If the spool would exceed
+ * its size limit, the oldest segments are dropped.
+ *
+ * It also keeps track of when to retry sending after a failed attempt, with an exponential backoff.
+ *
+ * Only the stats getters may be called from other threads.
+ */
+class PerfdataSpool
+{
+public:
+	static constexpr double MinRetryDelay = 1;
+	static constexpr double MaxRetryDelay = 60;
+
+	PerfdataSpool(String path, std::uint64_t maxBytes, String logFacility);
+
+	void Push(std::string_view payload);
+
+	bool IsEmpty() const;
+	std::string Front() const;
+	void Pop();
+
+	static bool IsTemporaryFailure(unsigned httpStatus);
+	bool IsRetryDue(double now) const;
+	void RetryLater(double now);
+	void ResetRetryDelay();
+
+	std::size_t GetSegments() const;
+	std::uint64_t GetBytes() const;
+	double GetOldestTimestamp() const;
+
+	void AddStats(const Dictionary::Ptr& status, const Array::Ptr& perfdata, const String& perfdataPrefix) const;
+
+private:
+	struct Segment
+	{
+		String Path;
+		std::uint64_t Size;
+		double Timestamp;
+	};
+
+	String m_Path;
+	std::uint64_t m_MaxBytes;
+	String m_LogFacility;
+
+	std::deque<Segment> m_Segments;
+	std::uint64_t m_NextId{0};
+
+	double m_RetryDelay{0};
+	double m_NextRetry{0};
+
+	std::atomic<std::size_t> m_SegmentCount{0};
+	std::atomic<std::uint64_t> m_Bytes{0};
+	std::atomic<double> m_OldestTimestamp{0};
+
+	void DropOldest();
+	void UpdateStats();
+};
+
+} // namespace icinga
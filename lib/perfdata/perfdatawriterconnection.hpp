@@ -60,6 +60,49 @@ public:
 	 */
 	template<typename Buffer>
 	auto Send(Buffer&& buf)
+	{
+		return SendImpl(std::forward<Buffer>(buf), true);
+	}
+
+	/**
+	 * Like Send(), but gives up after the first failed attempt instead of retrying until stopped.
+	 *
+	 * This is meant for writers that can put the data aside, e.g. into a spool, while the server is
+	 * unreachable. The next attempt connects anew.
+	 *
+	 * @param buf The buffer to send
+	 * @return the return value returned by the WriteMessage overload for Buffer, otherwise void
+	 * @throws Stopped, or the exception which made the attempt fail
+	 */
+	template<typename Buffer>
+	auto TrySend(Buffer&& buf)
+	{
+		return SendImpl(std::forward<Buffer>(buf), false);
+	}
+
+	void Disconnect();
+
+	/**
+	 * Cancels ongoing operations either after a timeout or a future became ready.
+	 *
+	 * This will disconnect and set a flag so that no further Send() requests are accepted.
+	 *
+	 * @param future The future to wait for
+	 * @param timeout The timeout after which ongoing operations are canceled
+	 */
+	template<class Rep, class Period>
+	void CancelAfterTimeout(const std::future<void>& future, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		future.wait_for(timeout);
+		Disconnect();
+	}
+
+	bool IsConnected() const;
+	bool IsStopped() const;
+
+private:
+	template<typename Buffer>
+	auto SendImpl(Buffer&& buf, bool retry)
 	{
 		if (m_Stopped) {
 			BOOST_THROW_EXCEPTION(Stopped{});
@@ -95,6 +138,11 @@ public:
 					m_Stream = MakeStream();
 					m_Connected = false;
 
+					if (!retry) {
+						promise.set_exception(std::current_exception());
+						return;
+					}
+
 					try {
 						BackoffWait(yc);
 					} catch (const std::exception&) {
@@ -108,27 +156,6 @@ public:
 		return promise.get_future().get();
 	}
 
-	void Disconnect();
-
-	/**
-	 * Cancels ongoing operations either after a timeout or a future became ready.
-	 *
-	 * This will disconnect and set a flag so that no further Send() requests are accepted.
-	 *
-	 * @param future The future to wait for
-	 * @param timeout The timeout after which ongoing operations are canceled
-	 */
-	template<class Rep, class Period>
-	void CancelAfterTimeout(const std::future<void>& future, const std::chrono::duration<Rep, Period>& timeout)
-	{
-		future.wait_for(timeout);
-		Disconnect();
-	}
-
-	bool IsConnected() const;
-	bool IsStopped() const;
-
-private:
 	AsioTlsOrTcpStream MakeStream() const;
 	void BackoffWait(const boost::asio::yield_context& yc);
 	void EnsureConnected(const boost::asio::yield_context& yc);
@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "perfdata/perfdatawriterconnectionpool.hpp"
+#include "base/convert.hpp"
+#include "base/exception.hpp"
+#include "base/logger.hpp"
+#include "base/perfdatavalue.hpp"
+#include <utility>
+
+using namespace icinga;
+
+PerfdataWriterConnectionPool::PerfdataWriterConnectionPool(
+	const ConfigObject::Ptr& parent,
+	String host,
+	String port,
+	Shared<boost::asio::ssl::context>::Ptr sslContext,
+	bool verifyPeerCertificate,
+	std::size_t size
+)
+	: PerfdataWriterConnectionPool(
+		  parent->GetReflectionType()->GetName(),
+		  parent->GetName(),
+		  std::move(host),
+		  std::move(port),
+		  std::move(sslContext),
+		  verifyPeerCertificate,
+		  size
+	  ) {};
+
+PerfdataWriterConnectionPool::PerfdataWriterConnectionPool(
+	String logFacility,
+	const String& parentName,
+	const String& host,
+	const String& port,
+	const Shared<boost::asio::ssl::context>::Ptr& sslContext,
+	bool verifyPeerCertificate,
+	std::size_t size
+)
+	: m_LogFacility(std::move(logFacility))
+{
+	for (std::size_t i = 0; i < size; i++) {
+		auto connection (std::make_unique<Connection>());
+
+		connection->Conn = new PerfdataWriterConnection{m_LogFacility, parentName, host, port, sslContext, verifyPeerCertificate};
+		connection->Queue.SetName(m_LogFacility + ", " + parentName + ", connection " + Convert::ToString(i));
+
+		connection->Queue.SetExceptionCallback([this](std::exception_ptr exp) {
+			Log(LogCritical, m_LogFacility)
+				<< "Exception while sending data: " << DiagnosticInformation(std::move(exp));
+		});
+
+		m_Connections.emplace_back(std::move(connection));
+	}
+}
+
+/**
+ * Spreads e.g. checkables evenly over the connections, always choosing the same one for the same key.
+ *
+ * @param key The object's address
+ * @param size The number of connections
+ */
+std::size_t PerfdataWriterConnectionPool::GetIndexFor(const void *key, std::size_t size)
+{
+	/* Objects are aligned, so the low bits of their addresses are all alike. Fibonacci hashing mixes
+	 * the higher bits into the ones that matter for the modulo.
+	 */
+	auto hash (static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key)) * 0x9E3779B97F4A7C15ull);
+
+	return (hash >> 32) % size;
+}
+
+std::size_t PerfdataWriterConnectionPool::GetSize() const
+{
+	return m_Connections.size();
+}
+
+const PerfdataWriterConnection::Ptr& PerfdataWriterConnectionPool::GetConnection(std::size_t index) const
+{
+	return m_Connections.at(index)->Conn;
+}
+
+bool PerfdataWriterConnectionPool::IsStopped() const
+{
+	return m_Connections.front()->Conn->IsStopped();
+}
+
+/**
+ * Queues a request to be sent over the given connection.
+ *
+ * Like PerfdataWriterConnection::Send(), the request is retried until it's delivered or the pool is
+ * canceled, in which case it's dropped.
+ *
+ * @param index The connection to use, requests for the same connection are sent in order
+ * @param request The request
+ * @param handler Called with the response once the request has been delivered
+ */
+void PerfdataWriterConnectionPool::Enqueue(std::size_t index, HttpRequest request, ResponseHandler handler)
+{
+	auto& connection (*m_Connections.at(index));
+
+	connection.Queue.Enqueue([this, &connection, request = std::move(request), handler = std::move(handler)]() mutable {
+		Send(connection, request, handler);
+	});
+}
+
+/**
+ * Waits until all queued requests have been sent or dropped.
+ */
+void PerfdataWriterConnectionPool::Join()
+{
+	for (auto& connection : m_Connections) {
+		connection->Queue.Join();
+	}
+}
+
+void PerfdataWriterConnectionPool::Send(Connection& connection, HttpRequest& request, const ResponseHandler& handler)
+{
+	auto start (std::chrono::steady_clock::now());
+
+	HttpResponse response;
+
+	try {
+		response = connection.Conn->Send(request);
+	} catch (const PerfdataWriterConnection::Stopped& ex) {
+		Log(LogDebug, m_LogFacility) << ex.what();
+		return;
+	}
+
+	double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double average = connection.Requests.fetch_add(1, std::memory_order_relaxed)
+		? connection.Latency.load(std::memory_order_relaxed) * 0.9 + latency * 0.1
+		: latency;
+
+	connection.Latency.store(average, std::memory_order_relaxed);
+	connection.LastLatency.store(latency, std::memory_order_relaxed);
+
+	handler(request, response);
+}
+
+/**
+ * Adds the connections' queue lengths and latencies to a writer's stats.
+ *
+ * @param status The writer's status dictionary
+ * @param perfdata Array of PerfdataValue objects
+ * @param perfdataPrefix Prefix for the perfdata labels, e.g. "elasticsearchwriter_elasticsearch"
+ */
+void PerfdataWriterConnectionPool::AddStats(const Dictionary::Ptr& status, const Array::Ptr& perfdata, const String& perfdataPrefix) const
+{
+	ArrayData connections;
+
+	for (std::size_t i = 0; i < m_Connections.size(); i++) {
+		auto& connection (*m_Connections[i]);
+		size_t queueItems = connection.Queue.GetLength();
+		double latency = connection.Latency.load(std::memory_order_relaxed);
+		double lastLatency = connection.LastLatency.load(std::memory_order_relaxed);
+		String prefix = perfdataPrefix + "_connection_" + Convert::ToString(i);
+
+		connections.emplace_back(new Dictionary({
+			{ "connected", connection.Conn->IsConnected() },
+			{ "queue_items", queueItems },
+			{ "latency", latency },
+			{ "last_latency", lastLatency }
+		}));
+
+		perfdata->Add(new PerfdataValue(prefix + "_queue_items", queueItems));
+		perfdata->Add(new PerfdataValue(prefix + "_latency", latency, false, "seconds"));
+	}
+
+	status->Set("connections", new Array(std::move(connections)));
+}
@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include "base/workqueue.hpp"
+#include "perfdata/perfdatawriterconnection.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace icinga {
+
+/**
+ * A fixed number of keep-alive connections to an HTTP based perfdata backend.
+ *
+ * Each connection sends the requests queued for it one after another in their original order, but
+ * the connections work concurrently. So a slow response only delays the requests queued behind it
+ * on the same connection, while the writer itself can go on preparing the next ones. Writers which
+ * need to keep the data of a checkable in order have to queue all of it for the same connection.
+ */
+class PerfdataWriterConnectionPool final : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(PerfdataWriterConnectionPool);
+
+	using HttpRequest = PerfdataWriterConnection::HttpRequest;
+	using HttpResponse = PerfdataWriterConnection::HttpResponse;
+
+	/**
+	 * Called on the connection's thread once a request has been delivered.
+	 *
+	 * The request may be modified, e.g. to take its body for reuse.
+	 */
+	using ResponseHandler = std::function<void(HttpRequest& request, const HttpResponse& response)>;
+
+	/* Enqueue() blocks while a connection has this many requests waiting. */
+	static constexpr std::size_t MaxQueuedRequests = 4;
+
+	PerfdataWriterConnectionPool(
+		const ConfigObject::Ptr& parent,
+		String host,
+		String port,
+		Shared<boost::asio::ssl::context>::Ptr sslContext,
+		bool verifyPeerCertificate,
+		std::size_t size
+	);
+
+	PerfdataWriterConnectionPool(
+		String logFacility,
+		const String& parentName,
+		const String& host,
+		const String& port,
+		const Shared<boost::asio::ssl::context>::Ptr& sslContext,
+		bool verifyPeerCertificate,
+		std::size_t size
+	);
+
+	static std::size_t GetIndexFor(const void *key, std::size_t size);
+
+	std::size_t GetSize() const;
+	const PerfdataWriterConnection::Ptr& GetConnection(std::size_t index) const;
+	bool IsStopped() const;
+
+	void Enqueue(std::size_t index, HttpRequest request, ResponseHandler handler);
+	void Join();
+
+	/**
+	 * Cancels ongoing operations of all connections either after a timeout or a future became ready.
+	 *
+	 * @param future The future to wait for
+	 * @param timeout The timeout after which ongoing operations are canceled
+	 */
+	template<class Rep, class Period>
+	void CancelAfterTimeout(const std::future<void>& future, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		future.wait_for(timeout);
+
+		for (auto& connection : m_Connections) {
+			connection->Conn->Disconnect();
+		}
+	}
+
+	void AddStats(const Dictionary::Ptr& status, const Array::Ptr& perfdata, const String& perfdataPrefix) const;
+
+private:
+	struct Connection
+	{
+		PerfdataWriterConnection::Ptr Conn;
+		WorkQueue Queue{MaxQueuedRequests, 1};
+
+		/* Exponential moving average of the request latency in seconds. */
+		std::atomic<double> Latency{0};
+		std::atomic<double> LastLatency{0};
+		std::atomic<std::uint64_t> Requests{0};
+	};
+
+	String m_LogFacility;
+	std::vector<std::unique_ptr<Connection>> m_Connections;
+
+	void Send(Connection& connection, HttpRequest& request, const ResponseHandler& handler);
+};
+
+} // namespace icinga
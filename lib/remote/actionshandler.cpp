@@ -5,9 +5,11 @@
 #include "remote/httputility.hpp"
 #include "remote/filterutility.hpp"
 #include "remote/apiaction.hpp"
+#include "remote/apilistener.hpp"
 #include "base/defer.hpp"
 #include "base/exception.hpp"
 #include "base/logger.hpp"
+#include "base/objectlock.hpp"
 #include <set>
 
 using namespace icinga;
@@ -78,9 +80,12 @@ bool ActionsHandler::HandleRequest(
 		<< "Running action " << actionName;
 
 	bool verbose = false;
+	bool bulk = false;
 
-	if (params)
+	if (params) {
 		verbose = HttpUtility::GetLastParameter(params, "verbose");
+		bulk = HttpUtility::GetLastParameter(params, "bulk");
+	}
 
 	std::shared_lock wgLock{*waitGroup, std::try_to_lock};
 	if (!wgLock) {
@@ -88,35 +93,79 @@ bool ActionsHandler::HandleRequest(
 		return true;
 	}
 
-	for (ConfigObject::Ptr obj : objs) {
-		if (!waitGroup->IsLockable()) {
-			if (wgLock) {
-				wgLock.unlock();
-			}
-
-			results.emplace_back(new Dictionary({
-				{ "type", obj->GetReflectionType()->GetName() },
-				{ "name", obj->GetName() },
-				{ "code", 503 },
-				{ "status", "Action skipped: Shutting down."}
-			}));
+	/* Run the action for all objects at once, e.g. to create all of their downtimes in a single activation. */
+	if (bulk && !types.empty() && action->SupportsBulk()) {
+		std::vector<ConfigObject::Ptr> targets;
+		targets.reserve(objs.size());
 
-			continue;
+		for (ConfigObject::Ptr obj : objs) {
+			targets.emplace_back(std::move(obj));
 		}
 
+		Log(LogNotice, "ApiActionHandler")
+			<< "Running action " << actionName << " for " << targets.size() << " objects at once";
+
 		try {
-			results.emplace_back(action->Invoke(obj, user, params));
+			/* Sync all of the created objects with as few cluster messages as possible. */
+			ApiListener::ConfigUpdateBatch batch;
+
+			for (auto& result : action->InvokeBulk(targets, user, params)) {
+				results.emplace_back(std::move(result));
+			}
 		} catch (const std::exception& ex) {
 			Dictionary::Ptr fail = new Dictionary({
 				{ "code", 500 },
 				{ "status", "Action execution failed: '" + DiagnosticInformation(ex, false) + "'." }
 			});
 
-			/* Exception for actions. Normally we would handle this inside SendJsonError(). */
 			if (verbose)
 				fail->Set("diagnostic_information", DiagnosticInformation(ex));
 
-			results.emplace_back(std::move(fail));
+			results = ArrayData(targets.size(), fail);
+		}
+	} else {
+		for (ConfigObject::Ptr obj : objs) {
+			if (!waitGroup->IsLockable()) {
+				if (wgLock) {
+					wgLock.unlock();
+				}
+
+				results.emplace_back(new Dictionary({
+					{ "type", obj->GetReflectionType()->GetName() },
+					{ "name", obj->GetName() },
+					{ "code", 503 },
+					{ "status", "Action skipped: Shutting down."}
+				}));
+
+				continue;
+			}
+
+			try {
+				Value result = action->Invoke(obj, user, params);
+
+				/* Actions like process-check-results return a result per processed item. */
+				if (result.IsObjectType<Array>()) {
+					Array::Ptr items = result;
+					ObjectLock olock(items);
+
+					for (const Value& item : items) {
+						results.emplace_back(item);
+					}
+				} else {
+					results.emplace_back(std::move(result));
+				}
+			} catch (const std::exception& ex) {
+				Dictionary::Ptr fail = new Dictionary({
+					{ "code", 500 },
+					{ "status", "Action execution failed: '" + DiagnosticInformation(ex, false) + "'." }
+				});
+
+				/* Exception for actions. Normally we would handle this inside SendJsonError(). */
+				if (verbose)
+					fail->Set("diagnostic_information", DiagnosticInformation(ex));
+
+				results.emplace_back(std::move(fail));
+			}
 		}
 	}
 
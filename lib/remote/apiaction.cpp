@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "remote/apiaction.hpp"
+#include "base/convert.hpp"
+#include "base/exception.hpp"
 
 using namespace icinga;
 
@@ -9,8 +11,8 @@ INITIALIZE_ONCE_WITH_PRIORITY([]{
 	ApiActionRegistry::GetInstance()->Freeze();
 }, InitializePriority::FreezeNamespaces);
 
-ApiAction::ApiAction(std::vector<String> types, Callback action)
-	: m_Types(std::move(types)), m_Callback(std::move(action))
+ApiAction::ApiAction(std::vector<String> types, Callback action, BulkCallback bulkAction)
+	: m_Types(std::move(types)), m_Callback(std::move(action)), m_BulkCallback(std::move(bulkAction))
 { }
 
 Value ApiAction::Invoke(const ConfigObject::Ptr& target, const ApiUser::Ptr& user, const Dictionary::Ptr& params)
@@ -18,6 +20,27 @@ Value ApiAction::Invoke(const ConfigObject::Ptr& target, const ApiUser::Ptr& use
 	return m_Callback(target, user, params);
 }
 
+bool ApiAction::SupportsBulk() const
+{
+	return (bool)m_BulkCallback;
+}
+
+/**
+ * Runs the action for all of the given targets at once, e.g. to create their objects in one go.
+ *
+ * @return A result per target, in the same order as the targets
+ */
+std::vector<Value> ApiAction::InvokeBulk(const std::vector<ConfigObject::Ptr>& targets, const ApiUser::Ptr& user, const Dictionary::Ptr& params)
+{
+	auto results (m_BulkCallback(targets, user, params));
+
+	if (results.size() != targets.size())
+		BOOST_THROW_EXCEPTION(std::runtime_error("Bulk action returned " + Convert::ToString(results.size())
+			+ " results for " + Convert::ToString(targets.size()) + " objects."));
+
+	return results;
+}
+
 const std::vector<String>& ApiAction::GetTypes() const
 {
 	return m_Types;
@@ -27,11 +27,15 @@ public:
 	DECLARE_PTR_TYPEDEFS(ApiAction);
 
 	typedef std::function<Value(const ConfigObject::Ptr& target, const ApiUser::Ptr&, const Dictionary::Ptr& params)> Callback;
+	typedef std::function<std::vector<Value>(const std::vector<ConfigObject::Ptr>& targets, const ApiUser::Ptr&, const Dictionary::Ptr& params)> BulkCallback;
 
-	ApiAction(std::vector<String> registerTypes, Callback function);
+	ApiAction(std::vector<String> registerTypes, Callback function, BulkCallback bulkFunction = nullptr);
 
 	Value Invoke(const ConfigObject::Ptr& target, const ApiUser::Ptr& user, const Dictionary::Ptr& params);
 
+	bool SupportsBulk() const;
+	std::vector<Value> InvokeBulk(const std::vector<ConfigObject::Ptr>& targets, const ApiUser::Ptr& user, const Dictionary::Ptr& params);
+
 	const std::vector<String>& GetTypes() const;
 
 	static ApiAction::Ptr GetByName(const String& name);
@@ -40,6 +44,7 @@ public:
 private:
 	std::vector<String> m_Types;
 	Callback m_Callback;
+	BulkCallback m_BulkCallback;
 };
 
 /**
@@ -50,6 +55,12 @@ private:
 using ApiActionRegistry = Registry<ApiAction::Ptr>;
 
 #define REGISTER_APIACTION(name, types, callback) \
+	REGISTER_APIACTION_BULK(name, types, callback, nullptr)
+
+/**
+ * Registers an action which can also be run for all of its targets at once, see ApiAction::InvokeBulk().
+ */
+#define REGISTER_APIACTION_BULK(name, types, callback, bulkCallback) \
 	INITIALIZE_ONCE([]() { \
 		String registerName = #name; \
 		boost::algorithm::replace_all(registerName, "_", "-"); \
@@ -57,7 +68,7 @@ using ApiActionRegistry = Registry<ApiAction::Ptr>;
 		String typeNames = types; \
 		if (!typeNames.IsEmpty()) \
 			registerTypes = typeNames.Split(";"); \
-		ApiAction::Ptr action = new ApiAction(registerTypes, callback); \
+		ApiAction::Ptr action = new ApiAction(registerTypes, callback, bulkCallback); \
 		ApiActionRegistry::GetInstance()->Register(registerName, action); \
 	})
 
@@ -8,15 +8,18 @@
 #include "base/configtype.hpp"
 #include "base/convert.hpp"
 #include "base/dependencygraph.hpp"
+#include "base/exception.hpp"
 #include "base/json.hpp"
 #include "config/vmops.hpp"
 #include "remote/configobjectslock.hpp"
+#include <algorithm>
 #include <fstream>
 #include <unordered_set>
 
 using namespace icinga;
 
 REGISTER_APIFUNCTION(UpdateObject, config, &ApiListener::ConfigUpdateObjectAPIHandler);
+REGISTER_APIFUNCTION(UpdateObjects, config, &ApiListener::ConfigUpdateObjectsAPIHandler);
 REGISTER_APIFUNCTION(DeleteObject, config, &ApiListener::ConfigDeleteObjectAPIHandler);
 
 INITIALIZE_ONCE([]() {
@@ -24,6 +27,72 @@ INITIALIZE_ONCE([]() {
 	ConfigObject::OnVersionChanged.connect(&ApiListener::ConfigUpdateObjectHandler);
 });
 
+thread_local ApiListener::ConfigUpdateBatch *ApiListener::m_CurrentConfigUpdateBatch = nullptr;
+
+ApiListener::ConfigUpdateBatch::ConfigUpdateBatch()
+	: m_Active(!m_CurrentConfigUpdateBatch)
+{
+	if (m_Active) {
+		m_CurrentConfigUpdateBatch = this;
+	}
+}
+
+ApiListener::ConfigUpdateBatch::~ConfigUpdateBatch()
+{
+	if (!m_Active) {
+		return;
+	}
+
+	m_CurrentConfigUpdateBatch = nullptr;
+
+	ApiListener::Ptr listener = ApiListener::GetInstance();
+
+	if (!listener || m_Updates.empty()) {
+		return;
+	}
+
+	/* Keep the order of the updates per origin and target zone, parent objects have to be sent first. */
+	std::vector<std::pair<const Update*, ArrayData>> messages;
+
+	for (auto& update : m_Updates) {
+		auto message (std::find_if(messages.begin(), messages.end(), [&update](auto& message) {
+			return message.first->Origin == update.Origin && message.first->Target == update.Target
+				&& message.second.size() < MaxObjectsPerMessage;
+		}));
+
+		if (message == messages.end()) {
+			messages.emplace_back(&update, ArrayData());
+			message = messages.end() - 1;
+		}
+
+		message->second.emplace_back(update.Params);
+	}
+
+	for (auto& message : messages) {
+		Log(LogNotice, "ApiListener")
+			<< "Sending config updates of " << message.second.size() << " objects to zone '"
+			<< message.first->Target->GetName() << "' at once.";
+
+		listener->RelayMessage(message.first->Origin, message.first->Target, new Dictionary({
+			{ "jsonrpc", "2.0" },
+			{ "method", "config::UpdateObjects" },
+			{ "params", new Dictionary({
+				{ "objects", new Array(std::move(message.second)) }
+			}) }
+		}), false);
+	}
+}
+
+/**
+ * Drops the queued updates of the given object.
+ */
+void ApiListener::ConfigUpdateBatch::Drop(const ConfigObject::Ptr& object)
+{
+	m_Updates.erase(std::remove_if(m_Updates.begin(), m_Updates.end(), [&object](const Update& update) {
+		return update.Object == object;
+	}), m_Updates.end());
+}
+
 void ApiListener::ConfigUpdateObjectHandler(const ConfigObject::Ptr& object, const Value& cookie)
 {
 	ApiListener::Ptr listener = ApiListener::GetInstance();
@@ -223,6 +292,35 @@ Value ApiListener::ConfigUpdateObjectAPIHandler(const MessageOrigin::Ptr& origin
 	return Empty;
 }
 
+/**
+ * Processes the config updates of many objects, each as if it had been sent in its own config::UpdateObject message.
+ */
+Value ApiListener::ConfigUpdateObjectsAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
+{
+	Array::Ptr objects = params->Get("objects");
+
+	if (!objects)
+		return Empty;
+
+	/* Relay the updates to our other zones as batched as we received them. */
+	ConfigUpdateBatch batch;
+
+	ObjectLock olock(objects);
+	for (const Value& object : objects) {
+		try {
+			Dictionary::Ptr update = object;
+
+			if (update)
+				ConfigUpdateObjectAPIHandler(origin, update);
+		} catch (const std::exception& ex) {
+			Log(LogWarning, "ApiListener")
+				<< "Error while processing config update: " << DiagnosticInformation(ex, false);
+		}
+	}
+
+	return Empty;
+}
+
 Value ApiListener::ConfigDeleteObjectAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
 {
 	Log(LogNotice, "ApiListener")
@@ -420,7 +518,11 @@ void ApiListener::UpdateConfigObject(const ConfigObject::Ptr& object, const Mess
 		if (!target)
 			target = Zone::GetLocalZone();
 
-		RelayMessage(origin, target, message, false);
+		if (m_CurrentConfigUpdateBatch) {
+			m_CurrentConfigUpdateBatch->m_Updates.emplace_back(ConfigUpdateBatch::Update{object, origin, target, params});
+		} else {
+			RelayMessage(origin, target, message, false);
+		}
 	}
 }
 
@@ -462,6 +564,11 @@ void ApiListener::UpdateConfigObjectWithParents(const ConfigObject::Ptr& object,
 void ApiListener::DeleteConfigObject(const ConfigObject::Ptr& object, const MessageOrigin::Ptr& origin,
 	const JsonRpcConnection::Ptr& client)
 {
+	/* Otherwise peers would ignore the deletion of an object they don't know yet and create it afterwards. */
+	if (!client && m_CurrentConfigUpdateBatch) {
+		m_CurrentConfigUpdateBatch->Drop(object);
+	}
+
 	if (object->GetPackage() != "_api")
 		return;
 
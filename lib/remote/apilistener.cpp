@@ -1230,8 +1230,68 @@ void ApiListener::PersistMessage(const Dictionary::Ptr& message, const ConfigObj
 	}
 }
 
+/* The messages which carry many updates at once and the messages to send instead to endpoints which don't know them. */
+static const struct {
+	const char *Method;
+	const char *Key;
+	const char *SingleMethod;
+	ApiCapabilities Capability;
+} l_BatchedMessages[] = {
+	{ "config::UpdateObjects", "objects", "config::UpdateObject", ApiCapabilities::ConfigUpdateObjects },
+	{ "event::CheckResults", "results", "event::CheckResult", ApiCapabilities::CheckResults }
+};
+
+/**
+ * Splits a message carrying many updates into a message per update if the endpoint doesn't know that message yet.
+ *
+ * @return The messages to send instead or nullptr if the message can be sent as is
+ */
+Array::Ptr ApiListener::SplitBatchedMessage(const Endpoint::Ptr& endpoint, const Dictionary::Ptr& message)
+{
+	String method = message->Get("method");
+
+	for (auto& batched : l_BatchedMessages) {
+		if (method != batched.Method) {
+			continue;
+		}
+
+		if (endpoint->GetCapabilities() & (uint_fast64_t)batched.Capability) {
+			return nullptr;
+		}
+
+		Dictionary::Ptr params = message->Get("params");
+		Array::Ptr updates = params ? params->Get(batched.Key) : Empty;
+		ArrayData messages;
+
+		if (updates) {
+			ObjectLock olock(updates);
+			for (const Value& update : updates) {
+				Dictionary::Ptr single = message->ShallowClone();
+				single->Set("method", batched.SingleMethod);
+				single->Set("params", update);
+
+				messages.emplace_back(std::move(single));
+			}
+		}
+
+		return new Array(std::move(messages));
+	}
+
+	return nullptr;
+}
+
 void ApiListener::SyncSendMessage(const Endpoint::Ptr& endpoint, const Dictionary::Ptr& message)
 {
+	/* Endpoints which don't know e.g. config::UpdateObjects yet get a config::UpdateObject message per object. */
+	if (Array::Ptr messages = SplitBatchedMessage(endpoint, message); messages) {
+		ObjectLock olock(messages);
+		for (const Dictionary::Ptr single : messages) {
+			SyncSendMessage(endpoint, single);
+		}
+
+		return;
+	}
+
 	ObjectLock olock(endpoint);
 
 	if (!endpoint->GetSyncing()) {
@@ -1612,7 +1672,23 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 				}
 
 				try  {
-					client->SendRawMessage(pmessage->Get("message"));
+					String rawMessage = pmessage->Get("message");
+					Array::Ptr messages;
+
+					/* Only batched messages have to be decoded, e.g. for older endpoints which don't know event::CheckResults. */
+					if (rawMessage.Contains("::CheckResults\"") || rawMessage.Contains("::UpdateObjects\"")) {
+						messages = SplitBatchedMessage(endpoint, JsonDecode(rawMessage));
+					}
+
+					if (messages) {
+						ObjectLock olock(messages);
+						for (const Dictionary::Ptr single : messages) {
+							client->SendMessage(single);
+						}
+					} else {
+						client->SendRawMessage(rawMessage);
+					}
+
 					count++;
 				} catch (const std::exception& ex) {
 					Log(LogWarning, "ApiListener")
@@ -28,6 +28,7 @@
 #include <cstdint>
 #include <mutex>
 #include <set>
+#include <vector>
 
 namespace icinga
 {
@@ -73,8 +74,11 @@ enum class ApiCapabilities : uint_fast64_t
 	ExecuteArbitraryCommand = 1u << 0u,
 	IfwApiCheckCommand = 1u << 1u,
 	HostChildrenInheritObjectAuthority = 1u << 2u,
+	ConfigUpdateObjects = 1u << 3u,
+	CheckResults = 1u << 4u,
 
-	MyCapabilities = ExecuteArbitraryCommand | IfwApiCheckCommand | HostChildrenInheritObjectAuthority
+	MyCapabilities = ExecuteArbitraryCommand | IfwApiCheckCommand | HostChildrenInheritObjectAuthority | ConfigUpdateObjects
+		| CheckResults
 };
 
 /**
@@ -88,6 +92,41 @@ public:
 
 	static boost::signals2::signal<void(bool)> OnMasterChanged;
 
+	/**
+	 * Collects the config updates of the objects created or modified by the current thread and relays them
+	 * as config::UpdateObjects messages when going out of scope, e.g. while the API creates the downtimes
+	 * of a whole host group. Such a message carries the updates of up to MaxObjectsPerMessage objects.
+	 *
+	 * Nested batches are merged into the outermost one. Deleting an object drops its queued updates,
+	 * as its deletion is relayed immediately.
+	 */
+	class ConfigUpdateBatch
+	{
+	public:
+		static constexpr std::size_t MaxObjectsPerMessage = 1000;
+
+		ConfigUpdateBatch();
+		ConfigUpdateBatch(const ConfigUpdateBatch&) = delete;
+		ConfigUpdateBatch& operator=(const ConfigUpdateBatch&) = delete;
+		~ConfigUpdateBatch();
+
+	private:
+		struct Update
+		{
+			ConfigObject::Ptr Object;
+			MessageOrigin::Ptr Origin;
+			Zone::Ptr Target;
+			Dictionary::Ptr Params;
+		};
+
+		std::vector<Update> m_Updates;
+		bool m_Active;
+
+		void Drop(const ConfigObject::Ptr& object);
+
+		friend class ApiListener;
+	};
+
 	ApiListener();
 
 	static String GetApiDir();
@@ -131,6 +170,7 @@ public:
 	/* configsync */
 	static void ConfigUpdateObjectHandler(const ConfigObject::Ptr& object, const Value& cookie);
 	static Value ConfigUpdateObjectAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
+	static Value ConfigUpdateObjectsAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
 	static Value ConfigDeleteObjectAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
 
 	/* API config packages */
@@ -196,6 +236,7 @@ private:
 
 	static ApiListener::Ptr m_Instance;
 	static std::atomic<bool> m_UpdatedObjectAuthority;
+	static thread_local ConfigUpdateBatch *m_CurrentConfigUpdateBatch;
 
 	boost::signals2::signal<void()> m_OnListenerShutdown;
 	StoppableWaitGroup::Ptr m_ListenerWaitGroup = new StoppableWaitGroup();
@@ -240,6 +281,8 @@ private:
 	static void LogGlobHandler(std::vector<std::uint64_t>& files, const String& file);
 	void ReplayLog(const JsonRpcConnection::Ptr& client);
 
+	static Array::Ptr SplitBatchedMessage(const Endpoint::Ptr& endpoint, const Dictionary::Ptr& message);
+
 	static void CopyCertificateFile(const String& oldCertPath, const String& newCertPath);
 
 	void UpdateStatusFile(boost::asio::ip::tcp::endpoint localEndpoint);
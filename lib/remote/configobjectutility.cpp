@@ -8,6 +8,7 @@
 #include "config/configitem.hpp"
 #include "base/atomic-file.hpp"
 #include "base/configwriter.hpp"
+#include "base/convert.hpp"
 #include "base/defer.hpp"
 #include "base/exception.hpp"
 #include "base/dependencygraph.hpp"
@@ -180,46 +181,81 @@ String ConfigObjectUtility::CreateObjectConfig(const Type::Ptr& type, const Stri
 
 bool ConfigObjectUtility::CreateObject(const Type::Ptr& type, const String& fullName,
 	const String& config, const Array::Ptr& errors, const Array::Ptr& diagnosticInformation, const Value& cookie)
+{
+	return CreateObjects(type, { { fullName, config } }, errors, diagnosticInformation, cookie);
+}
+
+/**
+ * Creates and activates all of the given objects at once.
+ *
+ * Either all of the objects are committed, or none of them is and all of their config files are removed again.
+ * Objects which are ignored due to errors don't fail the others, only their config files are removed.
+ *
+ * @param objects The names and configs of the objects to create
+ */
+bool ConfigObjectUtility::CreateObjects(const Type::Ptr& type, const std::vector<std::pair<String, String>>& objects,
+	const Array::Ptr& errors, const Array::Ptr& diagnosticInformation, const Value& cookie)
 {
 	CreateStorage();
 
-	{
-		auto configType (dynamic_cast<ConfigType*>(type.get()));
+	auto *ctype = dynamic_cast<ConfigType *>(type.get());
 
-		if (configType && configType->GetObject(fullName)) {
-			errors->Add("Object '" + fullName + "' already exists.");
-			return false;
+	if (ctype) {
+		for (auto& object : objects) {
+			if (ctype->GetObject(object.first)) {
+				errors->Add("Object '" + object.first + "' already exists.");
+				return false;
+			}
 		}
 	}
 
-	String path;
+	std::vector<String> paths;
+	paths.reserve(objects.size());
 
-	try {
-		path = ComputeNewObjectConfigPath(type, fullName);
-	} catch (const std::exception& ex) {
-		errors->Add("Config package broken: " + DiagnosticInformation(ex, false));
-		return false;
-	}
+	// Remove the just created config files in all the error cases and if the object creation
+	// succeeds the deferred callback will be cancelled.
+	Defer removeConfigPaths([&paths]{
+		for (auto& path : paths) {
+			Utility::Remove(path);
+		}
+	});
 
-	// AtomicFile doesn't create not yet existing directories, so we have to do it by ourselves.
-	Utility::MkDirP(Utility::DirName(path), 0700);
+	for (auto& object : objects) {
+		String path;
 
-	AtomicFile::Write(path, 0644, config);
+		try {
+			path = ComputeNewObjectConfigPath(type, object.first);
+		} catch (const std::exception& ex) {
+			errors->Add("Config package broken: " + DiagnosticInformation(ex, false));
+			return false;
+		}
 
-	// Remove the just created config file in all the error cases and if the object creation
-	// succeeds the deferred callback will be cancelled.
-	Defer removeConfigPath([&path]{
-		Utility::Remove(path);
-	});
+		// AtomicFile doesn't create not yet existing directories, so we have to do it by ourselves.
+		Utility::MkDirP(Utility::DirName(path), 0700);
+
+		AtomicFile::Write(path, 0644, object.second);
+		paths.emplace_back(std::move(path));
+	}
+
+	String description = objects.size() == 1
+		? "config item '" + objects[0].first + "'"
+		: Convert::ToString(objects.size()) + " config items";
 
-	std::unique_ptr<Expression> expr = ConfigCompiler::CompileFile(path, String(), "_api");
+	std::vector<std::unique_ptr<Expression>> exprs;
+	exprs.reserve(paths.size());
+
+	for (auto& path : paths) {
+		exprs.emplace_back(ConfigCompiler::CompileFile(path, String(), "_api"));
+	}
 
 	try {
 		ActivationScope ascope;
 
-		ScriptFrame frame(true);
-		expr->Evaluate(frame);
-		expr.reset();
+		for (auto& expr : exprs) {
+			ScriptFrame frame(true);
+			expr->Evaluate(frame);
+			expr.reset();
+		}
 
 		WorkQueue upq;
 		upq.SetName("ConfigObjectUtility::CreateObject");
@@ -233,7 +269,7 @@ bool ConfigObjectUtility::CreateObject(const Type::Ptr& type, const String& full
 		if (!ConfigItem::CommitItems(ascope.GetContext(), upq, newItems, true)) {
 			if (errors) {
 				Log(LogNotice, "ConfigObjectUtility")
-					<< "Failed to commit config item '" << fullName << "'. Aborting and removing config path '" << path << "'.";
+					<< "Failed to commit " << description << ". Aborting and removing their config paths.";
 
 				for (const std::exception_ptr& ex : upq.GetExceptions()) {
 					errors->Add(DiagnosticInformation(ex, false));
@@ -247,14 +283,14 @@ bool ConfigObjectUtility::CreateObject(const Type::Ptr& type, const String& full
 		}
 
 		/*
-		 * Activate the config object.
+		 * Activate the config objects.
 		 * uq, items, runtimeCreated, silent, withModAttrs, cookie
 		 * IMPORTANT: Forward the cookie aka origin in order to prevent sync loops in the same zone!
 		 */
 		if (!ConfigItem::ActivateItems(newItems, true, false, false, cookie)) {
 			if (errors) {
 				Log(LogNotice, "ConfigObjectUtility")
-					<< "Failed to activate config object '" << fullName << "'. Aborting and removing config path '" << path << "'.";
+					<< "Failed to activate " << description << ". Aborting and removing their config paths.";
 
 				for (const std::exception_ptr& ex : upq.GetExceptions()) {
 					errors->Add(DiagnosticInformation(ex, false));
@@ -274,19 +310,22 @@ bool ConfigObjectUtility::CreateObject(const Type::Ptr& type, const String& full
 		if (type->GetName() != "Comment" && type->GetName() != "Downtime")
 			ApiListener::UpdateObjectAuthority();
 
-		// At this stage we should have a config object already. If not, it was ignored before.
-		auto *ctype = dynamic_cast<ConfigType *>(type.get());
-		ConfigObject::Ptr obj = ctype->GetObject(fullName);
+		// Objects are successfully created and activated, so don't remove their configs.
+		removeConfigPaths.Cancel();
 
-		if (obj) {
-			// Object is successfully created and activated, so don't remove its config.
-			removeConfigPath.Cancel();
+		for (std::vector<String>::size_type i = 0; i < objects.size(); i++) {
+			auto& fullName (objects[i].first);
 
-			Log(LogInformation, "ConfigObjectUtility")
-				<< "Created and activated object '" << fullName << "' of type '" << type->GetName() << "'.";
-		} else {
-			Log(LogNotice, "ConfigObjectUtility")
-				<< "Object '" << fullName << "' was not created but ignored due to errors.";
+			// At this stage we should have a config object already. If not, it was ignored before.
+			if (ctype->GetObject(fullName)) {
+				Log(LogInformation, "ConfigObjectUtility")
+					<< "Created and activated object '" << fullName << "' of type '" << type->GetName() << "'.";
+			} else {
+				Log(LogNotice, "ConfigObjectUtility")
+					<< "Object '" << fullName << "' was not created but ignored due to errors.";
+
+				Utility::Remove(paths[i]);
+			}
 		}
 	} catch (const std::exception& ex) {
 		if (errors)
@@ -15,7 +15,7 @@
 using namespace icinga;
 
 std::mutex EventsInbox::m_FiltersMutex;
-std::map<String, EventsInbox::Filter> EventsInbox::m_Filters ({{"", EventsInbox::Filter{1, Expression::Ptr()}}});
+std::map<String, EventsInbox::Filter> EventsInbox::m_Filters ({{"", EventsInbox::Filter{1, Expression::Ptr(), CompiledFilter::Ptr()}}});
 
 EventsRouter EventsRouter::m_Instance;
 
@@ -29,13 +29,14 @@ EventsInbox::EventsInbox(String filter, const String& filterSource)
 		lock.unlock();
 
 		auto expr (ConfigCompiler::CompileText(filterSource, filter));
+		auto compiled (CompiledFilter::Compile(expr.get(), Dictionary::TypeInstance, "event"));
 
 		lock.lock();
 
 		m_Filter = m_Filters.find(filter);
 
 		if (m_Filter == m_Filters.end()) {
-			m_Filter = m_Filters.emplace(std::move(filter), Filter{1, Expression::Ptr(expr.release())}).first;
+			m_Filter = m_Filters.emplace(std::move(filter), Filter{1, Expression::Ptr(expr.release()), std::move(compiled)}).first;
 		} else {
 			++m_Filter->second.Refs;
 		}
@@ -58,6 +59,11 @@ const Expression::Ptr& EventsInbox::GetFilter()
 	return m_Filter->second.Expr;
 }
 
+const CompiledFilter::Ptr& EventsInbox::GetCompiledFilter()
+{
+	return m_Filter->second.Compiled;
+}
+
 void EventsInbox::Push(Dictionary::Ptr event)
 {
 	std::unique_lock<std::mutex> lock (m_Mutex);
@@ -137,7 +143,14 @@ void EventsFilter::Push(Dictionary::Ptr event)
 			frame.Sandboxed = true;
 
 			try {
-				if (!FilterUtility::EvaluateFilter(frame, perFilter.first.get(), event, "event")) {
+				/* All inboxes of the same filter share its bytecode, see EventsInbox::EventsInbox(). */
+				auto& compiled ((*perFilter.second.begin())->GetCompiledFilter());
+
+				if (compiled) {
+					if (!compiled->Evaluate(frame, event)) {
+						continue;
+					}
+				} else if (!FilterUtility::EvaluateFilter(frame, perFilter.first.get(), event, "event")) {
 					continue;
 				}
 			} catch (const std::exception& ex) {
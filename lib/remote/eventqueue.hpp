@@ -6,6 +6,7 @@
 
 #include "remote/httphandler.hpp"
 #include "base/object.hpp"
+#include "config/compiledfilter.hpp"
 #include "config/expression.hpp"
 #include <boost/asio/steady_timer.hpp>
 #include <boost/asio/spawn.hpp>
@@ -51,6 +52,7 @@ public:
 	~EventsInbox();
 
 	const Expression::Ptr& GetFilter();
+	const CompiledFilter::Ptr& GetCompiledFilter();
 
 	void Push(Dictionary::Ptr event);
 	Dictionary::Ptr Shift(boost::asio::yield_context yc, std::chrono::milliseconds timeout = 5s);
@@ -60,6 +62,7 @@ private:
 	{
 		std::size_t Refs;
 		Expression::Ptr Expr;
+		CompiledFilter::Ptr Compiled;
 	};
 
 	static std::mutex m_FiltersMutex;
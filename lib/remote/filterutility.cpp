@@ -7,16 +7,30 @@
 #include "config/applyrule.hpp"
 #include "config/configcompiler.hpp"
 #include "config/expression.hpp"
+#include "base/application.hpp"
+#include "base/base64.hpp"
+#include "base/configuration.hpp"
 #include "base/namespace.hpp"
 #include "base/json.hpp"
 #include "base/configtype.hpp"
 #include "base/logger.hpp"
 #include "base/utility.hpp"
 #include <boost/algorithm/string/case_conv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 using namespace icinga;
 
+static std::mutex l_FilterCacheMutex;
+static std::unordered_map<String, CachedFilter::Ptr> l_FilterCache;
+
 Dictionary::Ptr FilterUtility::GetTargetForVar(const String& name, const Value& value)
 {
 	return new Dictionary({
@@ -63,6 +77,7 @@ public:
 	 */
 	Expression* CheckPermission(const String& permissionString)
 	{
+		std::unique_lock<std::mutex> lock (m_Mutex);
 		auto [it, inserted] = m_PermCache.try_emplace(permissionString);
 		auto& [hasPermission, permissionExpr] = it->second;
 
@@ -109,6 +124,7 @@ public:
 private:
 	bool CheckPermissionAndEvalFilter(const String& permissionString, const Object::Ptr& obj, const String& varName)
 	{
+		std::unique_lock<std::mutex> lock (m_Mutex);
 		auto [it, inserted] = m_PermCache.try_emplace(permissionString);
 		auto& [hasPermission, permissionExpr] = it->second;
 
@@ -116,6 +132,9 @@ private:
 			hasPermission = FilterUtility::HasPermission(m_User, permissionString, &permissionExpr);
 		}
 
+		/* The entry is never modified again, so it can be evaluated without holding the lock. */
+		lock.unlock();
+
 		if (hasPermission && permissionExpr) {
 			ScriptFrame permissionFrame(false, new Namespace());
 			// Sandboxing is lifted because this only evaluates the function from the
@@ -127,6 +146,8 @@ private:
 		return hasPermission;
 	}
 
+	/* Filters may be evaluated by multiple threads at once, see ParallelFilterTargets(). */
+	std::mutex m_Mutex;
 	std::unordered_map<String, std::pair<bool, std::unique_ptr<Expression>>> m_PermCache;
 	ApiUser::Ptr m_User;
 };
@@ -232,14 +253,221 @@ bool FilterUtility::EvaluateFilter(ScriptFrame& frame, Expression *filter,
 	return Convert::ToBool(filter->Evaluate(frame));
 }
 
-static void FilteredAddTarget(ScriptFrame& permissionFrame, Expression *permissionFilter,
-	ScriptFrame& frame, Expression *ufilter, std::vector<Value>& result, const String& variableName, const Object::Ptr& target)
+/**
+ * Parses the given filter and lowers it into bytecode if possible, or returns the cached result of a previous call.
+ *
+ * The bytecode depends not only on the filter itself, but also on the type of the objects it's evaluated for and
+ * on the names of the filter variables, so these are part of the cache key as well.
+ *
+ * @param filter The filter expression as specified by the API client
+ * @param type The type of the objects the filter will be evaluated for, nullptr if they aren't config objects
+ * @param variableName The name the objects are available as in the filter, defaults to the type name in lower case
+ * @param filterVars The variables which will be available to the filter, only their names are relevant here
+ *
+ * @return The parsed filter, its Compiled member is nullptr if the filter can't be lowered
+ */
+CachedFilter::Ptr FilterUtility::GetCachedFilter(const String& filter, const Type::Ptr& type,
+	const String& variableName, const Dictionary::Ptr& filterVars)
 {
-	if (FilterUtility::EvaluateFilter(permissionFrame, permissionFilter, target, variableName)) {
-		if (FilterUtility::EvaluateFilter(frame, ufilter, target, variableName)) {
-			result.emplace_back(std::move(target));
+	std::vector<String> variables;
+	String key;
+
+	/* Length-prefixed, so e.g. the variables "a,b" and "a", "b" don't end up with the same key. */
+	auto addToKey ([&key](const String& part) {
+		key += Convert::ToString(part.GetLength()) + ":" + part;
+	});
+
+	addToKey(type ? type->GetName() : "");
+	addToKey(variableName);
+
+	if (filterVars) {
+		ObjectLock olock (filterVars);
+
+		for (auto& kv : filterVars) {
+			variables.emplace_back(kv.first);
+			addToKey(kv.first);
+		}
+	}
+
+	addToKey(filter);
+
+	{
+		std::unique_lock<std::mutex> lock (l_FilterCacheMutex);
+		auto it (l_FilterCache.find(key));
+
+		if (it != l_FilterCache.end()) {
+			return it->second;
 		}
 	}
+
+	CachedFilter::Ptr cached = new CachedFilter();
+	cached->Expr = ConfigCompiler::CompileText("<API query>", filter).release();
+
+	if (type) {
+		cached->Compiled = CompiledFilter::Compile(cached->Expr.get(), type, variableName, variables);
+	}
+
+	std::unique_lock<std::mutex> lock (l_FilterCacheMutex);
+
+	/* Filters are arbitrary user input, so don't let the cache grow indefinitely. */
+	if (l_FilterCache.size() >= 1024u) {
+		l_FilterCache.clear();
+	}
+
+	return l_FilterCache.emplace(std::move(key), cached).first->second;
+}
+
+/* Number of objects handed to a thread at once by ParallelFilterTargets(). */
+static constexpr std::size_t l_FilterChunkSize = 512;
+
+/**
+ * Calls func for consecutive chunks of [0, count) on the calling thread and on up to Concurrency - 1 thread pool
+ * threads and returns the results of all chunks concatenated in the order of the chunks, not of their completion.
+ *
+ * The calling thread takes part in processing the chunks, so this never waits for the thread pool to pick up work.
+ * If func throws, remaining chunks are skipped and the exception of the first failed chunk is rethrown.
+ *
+ * @param count Number of items to process
+ * @param func Called as func(begin, end, result) for every chunk, appends its results to result
+ *
+ * @return The results of all chunks
+ */
+static std::vector<Value> ParallelFilterTargets(std::size_t count,
+	const std::function<void (std::size_t, std::size_t, std::vector<Value>&)>& func)
+{
+	/* Owned by all threads, a pool thread may only start after all chunks have been processed. */
+	struct SharedState
+	{
+		std::atomic<std::size_t> Next{0};
+		std::atomic<bool> Failed{false};
+		std::mutex Mutex;
+		std::condition_variable CV;
+		std::size_t Done{0};
+	};
+
+	std::size_t chunks = (count + l_FilterChunkSize - 1u) / l_FilterChunkSize;
+	std::vector<std::vector<Value>> results (chunks);
+	std::vector<std::exception_ptr> errors (chunks);
+	auto state (std::make_shared<SharedState>());
+
+	/* Anything but state is only accessed after claiming a chunk, so the references are still valid. */
+	auto work ([state, chunks, count, &func, &results, &errors]() {
+		for (;;) {
+			auto chunk (state->Next.fetch_add(1));
+
+			if (chunk >= chunks) {
+				break;
+			}
+
+			if (!state->Failed.load()) {
+				try {
+					func(chunk * l_FilterChunkSize, std::min(count, (chunk + 1u) * l_FilterChunkSize), results[chunk]);
+				} catch (...) {
+					errors[chunk] = std::current_exception();
+					state->Failed.store(true);
+				}
+			}
+
+			std::unique_lock<std::mutex> lock (state->Mutex);
+
+			if (++state->Done == chunks) {
+				state->CV.notify_all();
+			}
+		}
+	});
+
+	auto helpers (std::min<std::size_t>(Configuration::Concurrency, chunks));
+
+	for (std::size_t i = 1; i < helpers; i++) {
+		Application::GetTP().Post(work, DefaultScheduler);
+	}
+
+	work();
+
+	{
+		std::unique_lock<std::mutex> lock (state->Mutex);
+		state->CV.wait(lock, [&state, chunks]() { return state->Done == chunks; });
+	}
+
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	std::vector<Value> result;
+	std::size_t total = 0;
+
+	for (auto& chunk : results) {
+		total += chunk.size();
+	}
+
+	result.reserve(total);
+
+	for (auto& chunk : results) {
+		std::move(chunk.begin(), chunk.end(), std::back_inserter(result));
+	}
+
+	return result;
+}
+
+/**
+ * Adds all objects of the given type matching both the permission filter and the user's filter to result.
+ *
+ * Config object types with many objects are evaluated in parallel, each thread using its own ScriptFrames.
+ */
+static void FilterTargets(const TargetProvider::Ptr& provider, const String& type,
+	const FilterExprPermissionChecker::Ptr& permissionChecker, Expression *permissionFilter, Expression *ufilter,
+	const CompiledFilter::Ptr& compiled, const Dictionary::Ptr& filterVars, const String& variableName, std::vector<Value>& result)
+{
+	auto evaluate ([&](const auto& forEachTarget, std::vector<Value>& out) {
+		ScriptFrame permissionFrame(false, new Namespace());
+		Namespace::Ptr frameNS = new Namespace();
+		ScriptFrame frame(false, frameNS);
+		frame.Sandboxed = true;
+		frame.PermChecker = permissionChecker;
+
+		if (filterVars) {
+			ObjectLock olock (filterVars);
+
+			for (auto& kv : filterVars) {
+				frameNS->Set(kv.first, kv.second);
+			}
+		}
+
+		forEachTarget([&](const Object::Ptr& target) {
+			if (!FilterUtility::EvaluateFilter(permissionFrame, permissionFilter, target, variableName)) {
+				return;
+			}
+
+			if (compiled ? compiled->Evaluate(frame, target, filterVars) : FilterUtility::EvaluateFilter(frame, ufilter, target, variableName)) {
+				out.emplace_back(target);
+			}
+		});
+	});
+
+	auto ctype (dynamic_cast<ConfigType*>(Type::GetByName(type).get()));
+
+	if (ctype && Configuration::Concurrency > 1 && dynamic_cast<ConfigObjectTargetProvider*>(provider.get())) {
+		auto objects (ctype->GetObjects());
+
+		if (objects.size() >= l_FilterChunkSize * 2u) {
+			auto matches (ParallelFilterTargets(objects.size(), [&evaluate, &objects](std::size_t begin, std::size_t end, std::vector<Value>& out) {
+				evaluate([&objects, begin, end](const auto& addTarget) {
+					for (auto i (begin); i < end; i++) {
+						addTarget(objects[i]);
+					}
+				}, out);
+			}));
+
+			result.insert(result.end(), std::make_move_iterator(matches.begin()), std::make_move_iterator(matches.end()));
+			return;
+		}
+	}
+
+	evaluate([&provider, &type](const auto& addTarget) {
+		provider->FindTargets(type, addTarget);
+	}, result);
 }
 
 /**
@@ -397,21 +625,18 @@ std::vector<Value> FilterUtility::GetFilterTargets(const QueryDescription& qd, c
 		if (qd.Types.find(type) == qd.Types.end())
 			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid type specified for this query."));
 
-		Namespace::Ptr frameNS = new Namespace();
-		ScriptFrame frame(false, frameNS);
-		frame.Sandboxed = true;
-		frame.PermChecker = permissionChecker;
-
 		if (query->Contains("filter")) {
 			CheckPermission(user, ApiUser::FilterExpressionPerm, nullptr);
 			String filter = HttpUtility::GetLastParameter(query, "filter");
-			std::unique_ptr<Expression> ufilter = ConfigCompiler::CompileText("<API query>", filter);
 			Dictionary::Ptr filter_vars = query->Get("filter_vars");
+			bool configObjects = dynamic_cast<ConfigObjectTargetProvider*>(provider.get());
+			CachedFilter::Ptr cachedFilter = GetCachedFilter(filter, configObjects ? Type::GetByName(type) : nullptr, variableName, filter_vars);
+			Expression *ufilter = cachedFilter->Expr.get();
 			bool targeted = false;
 			std::vector<ConfigObject::Ptr> targets;
 
-			if (dynamic_cast<ConfigObjectTargetProvider*>(provider.get())) {
-				auto dict (dynamic_cast<DictExpression*>(ufilter.get()));
+			if (configObjects) {
+				auto dict (dynamic_cast<DictExpression*>(ufilter));
 
 				if (dict) {
 					auto& subex (dict->GetExpressions());
@@ -461,27 +686,130 @@ std::vector<Value> FilterUtility::GetFilterTargets(const QueryDescription& qd, c
 					}
 				}
 			} else {
-				if (filter_vars) {
-					ObjectLock olock (filter_vars);
-
-					for (auto& kv : filter_vars) {
-						frameNS->Set(kv.first, kv.second);
-					}
-				}
-
-				provider->FindTargets(type, [&permissionFrame, permissionFilter, &frame, &ufilter, &result, variableName](const Object::Ptr& target) {
-					FilteredAddTarget(permissionFrame, permissionFilter, frame, &*ufilter, result, variableName, target);
-				});
+				FilterTargets(provider, type, permissionChecker, permissionFilter, ufilter,
+					cachedFilter->Compiled, filter_vars, variableName, result);
 			}
 		} else {
-			/* Ensure to pass a nullptr as filter expression.
-			 * GCC 8.1.1 on F28 causes problems, see GH #6533.
-			 */
-			provider->FindTargets(type, [&permissionFrame, permissionFilter, &frame, &result, variableName](const Object::Ptr& target) {
-				FilteredAddTarget(permissionFrame, permissionFilter, frame, nullptr, result, variableName, target);
-			});
+			FilterTargets(provider, type, permissionChecker, permissionFilter, nullptr, nullptr, nullptr, variableName, result);
 		}
 	}
 
 	return result;
 }
+
+/**
+ * Reads a non-negative integer query parameter.
+ *
+ * @param query The query parameters
+ * @param name Name of the parameter
+ *
+ * @return The parameter's value
+ */
+static std::size_t GetCountParameter(const Dictionary::Ptr& query, const String& name)
+{
+	double value;
+
+	try {
+		value = HttpUtility::GetLastParameter(query, name);
+	} catch (const std::exception&) {
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid value for '" + name + "' specified. Non-negative integer is required."));
+	}
+
+	if (!(value >= 0) || value != std::floor(value)) {
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid value for '" + name + "' specified. Non-negative integer is required."));
+	}
+
+	return value > SIZE_MAX ? SIZE_MAX : value;
+}
+
+/**
+ * Restricts the targets to the page requested via the query parameters 'limit', 'offset' and 'cursor'.
+ *
+ * Pages are taken from the targets sorted by name. The cursor is an opaque string identifying the last
+ * object of the previous page. Unlike an offset, it stays valid if objects are added, removed or stop
+ * matching the filter: The next page starts with the first target after that object's name, even if
+ * that object doesn't exist anymore.
+ *
+ * @param targets The config objects returned by GetFilterTargets()
+ * @param query The query parameters
+ *
+ * @return The cursor for the next page, empty if a limit wasn't specified or this was the last page
+ */
+String FilterUtility::PaginateTargets(std::vector<Value>& targets, const Dictionary::Ptr& query)
+{
+	if (!query) {
+		return String();
+	}
+
+	bool hasLimit = query->Contains("limit");
+	bool hasOffset = query->Contains("offset");
+	bool hasCursor = query->Contains("cursor");
+
+	if (!hasLimit && !hasOffset && !hasCursor) {
+		return String();
+	}
+
+	if (hasOffset && hasCursor) {
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Parameters 'offset' and 'cursor' are mutually exclusive."));
+	}
+
+	std::size_t limit = SIZE_MAX;
+
+	if (hasLimit) {
+		limit = GetCountParameter(query, "limit");
+
+		if (!limit) {
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid value for 'limit' specified. Positive integer is required."));
+		}
+	}
+
+	String cursor;
+
+	if (hasCursor) {
+		try {
+			cursor = Base64::Decode(HttpUtility::GetLastParameter(query, "cursor"));
+		} catch (const std::exception&) {
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid cursor specified."));
+		}
+	}
+
+	std::vector<std::pair<String, Value>> sorted;
+	sorted.reserve(targets.size());
+
+	for (auto& target : targets) {
+		sorted.emplace_back(static_cast<ConfigObject::Ptr>(target)->GetName(), std::move(target));
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<String, Value>& a, const std::pair<String, Value>& b) {
+		return a.first < b.first;
+	});
+
+	std::size_t begin = 0;
+
+	if (hasOffset) {
+		begin = std::min(GetCountParameter(query, "offset"), sorted.size());
+	}
+
+	if (hasCursor) {
+		/* All objects up to and including the cursor's one belong to the previous pages. */
+		begin = std::upper_bound(sorted.begin(), sorted.end(), cursor, [](const String& name, const std::pair<String, Value>& target) {
+			return name < target.first;
+		}) - sorted.begin();
+	}
+
+	std::size_t end = begin + std::min(limit, sorted.size() - begin);
+
+	String next;
+
+	if (end < sorted.size() && end > begin) {
+		next = Base64::Encode(sorted[end - 1u].first);
+	}
+
+	targets.clear();
+
+	for (auto i (begin); i < end; i++) {
+		targets.emplace_back(std::move(sorted[i].second));
+	}
+
+	return next;
+}
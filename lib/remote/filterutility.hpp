@@ -6,6 +6,7 @@
 
 #include "remote/i2-remote.hpp"
 #include "remote/apiuser.hpp"
+#include "config/compiledfilter.hpp"
 #include "config/expression.hpp"
 #include "base/dictionary.hpp"
 #include "base/configobject.hpp"
@@ -43,6 +44,19 @@ struct QueryDescription
 	String Permission;
 };
 
+/**
+ * A parsed filter expression together with its bytecode, if the filter could be lowered.
+ *
+ * @ingroup remote
+ */
+struct CachedFilter : public SharedObject
+{
+	DECLARE_PTR_TYPEDEFS(CachedFilter);
+
+	Expression::Ptr Expr;
+	CompiledFilter::Ptr Compiled;
+};
+
 /**
  * Filter utilities.
  *
@@ -60,6 +74,9 @@ public:
 		const ApiUser::Ptr& user, const String& variableName = String());
 	static bool EvaluateFilter(ScriptFrame& frame, Expression *filter,
 		const Object::Ptr& target, const String& variableName = String());
+	static String PaginateTargets(std::vector<Value>& targets, const Dictionary::Ptr& query);
+	static CachedFilter::Ptr GetCachedFilter(const String& filter, const Type::Ptr& type,
+		const String& variableName = String(), const Dictionary::Ptr& filterVars = nullptr);
 };
 
 /**
@@ -12,6 +12,7 @@
 #include "base/objectlock.hpp"
 #include "base/utility.hpp"
 #include "base/logger.hpp"
+#include "base/metricsregistry.hpp"
 #include "base/exception.hpp"
 #include "base/convert.hpp"
 #include "base/tlsstream.hpp"
@@ -30,6 +31,13 @@ REGISTER_APIFUNCTION(SetLogPosition, log, &SetLogPositionHandler);
 
 static RingBuffer l_TaskStats (15 * 60);
 
+static auto l_MessagesMetric (MetricsRegistry::Register("icinga_jsonrpc_messages",
+	"JSON-RPC messages processed.", {}, std::make_shared<MetricCounter>()));
+static auto l_SemaphoreWaitMetric (MetricsRegistry::Register("icinga_jsonrpc_semaphore_wait_seconds",
+	"Time JSON-RPC messages waited for a CPU-bound work slot.", {}, std::make_shared<MetricLatencyHistogram>()));
+static auto l_ProcessingTimeMetric (MetricsRegistry::Register("icinga_jsonrpc_message_duration_seconds",
+	"Time spent processing a JSON-RPC message, including the semaphore wait.", {}, std::make_shared<MetricLatencyHistogram>()));
+
 JsonRpcConnection::JsonRpcConnection(const WaitGroup::Ptr& waitGroup, const String& identity, bool authenticated,
 	const Shared<AsioTlsStream>::Ptr& stream, ConnectionRole role)
 	: JsonRpcConnection(waitGroup, identity, authenticated, stream, role, IoEngine::Get().GetIoContext())
@@ -96,6 +104,7 @@ void JsonRpcConnection::HandleIncomingMessages(boost::asio::yield_context yc)
 
 			// Cache the elapsed time to acquire a CPU semaphore used to detect extremely heavy workloads.
 			cpuBoundDuration = ch::steady_clock::now() - start;
+			l_SemaphoreWaitMetric->Record(cpuBoundDuration);
 
 			Dictionary::Ptr message;
 			try {
@@ -125,6 +134,8 @@ void JsonRpcConnection::HandleIncomingMessages(boost::asio::yield_context yc)
 			l_TaskStats.InsertValue(Utility::GetTime(), 1);
 
 			auto total = ch::steady_clock::now() - start;
+			l_MessagesMetric->Increment();
+			l_ProcessingTimeMetric->Record(total);
 			if (m_Endpoint) {
 				m_Endpoint->AddMessageProcessed(total);
 			}
@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/metricsregistry.hpp"
+#include "remote/filterutility.hpp"
+#include "remote/metricshandler.hpp"
+#include <sstream>
+
+using namespace icinga;
+
+REGISTER_URLHANDLER("/v1/metrics", MetricsHandler);
+
+bool MetricsHandler::HandleRequest(
+	const WaitGroup::Ptr&,
+	const HttpApiRequest& request,
+	HttpApiResponse& response,
+	boost::asio::yield_context&
+)
+{
+	namespace http = boost::beast::http;
+
+	auto url = request.Url();
+	auto user = request.User();
+
+	if (url->GetPath().size() != 2) {
+		return false;
+	}
+
+	if (request.method() != http::verb::get) {
+		return false;
+	}
+
+	FilterUtility::CheckPermission(user, "status/query");
+
+	std::ostringstream body;
+	MetricsRegistry::WriteOpenMetrics(body);
+
+	response.result(200);
+	response.set(http::field::content_type, "application/openmetrics-text; version=1.0.0; charset=utf-8");
+	response.body() << body.str();
+
+	return true;
+}
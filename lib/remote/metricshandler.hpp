@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "remote/httphandler.hpp"
+
+namespace icinga
+{
+
+class MetricsHandler final : public HttpHandler
+{
+public:
+	DECLARE_PTR_TYPEDEFS(MetricsHandler);
+
+	bool HandleRequest(
+		const WaitGroup::Ptr& waitGroup,
+		const HttpApiRequest& request,
+		HttpApiResponse& response,
+		boost::asio::yield_context& yc
+	) override;
+};
+
+}
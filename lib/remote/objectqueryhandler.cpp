@@ -10,6 +10,8 @@
 #include "base/dependencygraph.hpp"
 #include "base/configtype.hpp"
 #include <boost/algorithm/string/case_conv.hpp>
+#include <algorithm>
+#include <map>
 #include <set>
 #include <unordered_map>
 #include <memory>
@@ -18,11 +20,17 @@ using namespace icinga;
 
 REGISTER_URLHANDLER("/v1/objects", ObjectQueryHandler);
 
-Dictionary::Ptr ObjectQueryHandler::SerializeObjectAttrs(const Object::Ptr& object,
+/**
+ * Resolves the attributes requested for objects of the given type to their field IDs.
+ *
+ * Fields which aren't supposed to be serialized for the user are skipped here already,
+ * so that SerializeObjectAttrs() only touches the fields actually ending up in the response.
+ *
+ * @return The IDs of the fields to serialize
+ */
+std::vector<int> ObjectQueryHandler::GetSerializableFields(const Type::Ptr& type,
 	const String& attrPrefix, const Array::Ptr& attrs, bool isJoin, bool allAttrs)
 {
-	Type::Ptr type = object->GetReflectionType();
-
 	std::vector<int> fids;
 
 	if (isJoin && attrs) {
@@ -69,24 +77,30 @@ Dictionary::Ptr ObjectQueryHandler::SerializeObjectAttrs(const Object::Ptr& obje
 		}
 	}
 
-	DictionaryData resultAttrs;
-	resultAttrs.reserve(fids.size());
-
-	for (int fid : fids) {
+	fids.erase(std::remove_if(fids.begin(), fids.end(), [&type](int fid) {
 		Field field = type->GetFieldInfo(fid);
 
-		Value val = object->GetField(fid);
-
 		/* hide attributes which shouldn't be user-visible */
 		if (field.Attributes & FANoUserView)
-			continue;
+			return true;
 
 		/* hide internal navigation fields */
-		if (field.Attributes & FANavigation && !(field.Attributes & (FAConfig | FAState)))
-			continue;
+		return field.Attributes & FANavigation && !(field.Attributes & (FAConfig | FAState));
+	}), fids.end());
+
+	return fids;
+}
 
-		Value sval = Serialize(val, FAConfig | FAState);
-		resultAttrs.emplace_back(field.Name, sval);
+Dictionary::Ptr ObjectQueryHandler::SerializeObjectAttrs(const Object::Ptr& object, const std::vector<int>& fids)
+{
+	Type::Ptr type = object->GetReflectionType();
+
+	DictionaryData resultAttrs;
+	resultAttrs.reserve(fids.size());
+
+	for (int fid : fids) {
+		Value sval = Serialize(object->GetField(fid), FAConfig | FAState);
+		resultAttrs.emplace_back(type->GetFieldInfo(fid).Name, sval);
 	}
 
 	return new Dictionary(std::move(resultAttrs));
@@ -186,6 +200,15 @@ bool ObjectQueryHandler::HandleRequest(
 		return true;
 	}
 
+	String nextCursor;
+
+	try {
+		nextCursor = FilterUtility::PaginateTargets(objs, params);
+	} catch (const std::invalid_argument& ex) {
+		HttpUtility::SendJsonError(response, params, 400, ex.what());
+		return true;
+	}
+
 	std::set<int> joinAttrs;
 	std::set<String> userJoinAttrs;
 
@@ -211,6 +234,31 @@ bool ObjectQueryHandler::HandleRequest(
 	std::unordered_map<Type*, std::pair<bool, std::unique_ptr<Expression>>> typePermissions;
 	std::unordered_map<Object*, bool> objectAccessAllowed;
 
+	/* The requested attributes are resolved once per type (and join) rather than once per object,
+	 * an invalid one is reported for every object as before.
+	 */
+	std::unordered_map<Type*, std::pair<std::vector<int>, String>> attrFields;
+	std::map<std::pair<int, Type*>, std::pair<std::vector<int>, String>> joinFields;
+
+	auto getFields = [](auto& cache, const auto& key, const Type::Ptr& type, const String& attrPrefix,
+		const Array::Ptr& attrs, bool isJoin, bool allAttrs) -> const std::pair<std::vector<int>, String>& {
+		auto it = cache.find(key);
+
+		if (it == cache.end()) {
+			std::pair<std::vector<int>, String> fields;
+
+			try {
+				fields.first = GetSerializableFields(type, attrPrefix, attrs, isJoin, allAttrs);
+			} catch (const ScriptError& ex) {
+				fields.second = ex.what();
+			}
+
+			it = cache.emplace(key, std::move(fields)).first;
+		}
+
+		return it->second;
+	};
+
 	auto generatorFunc = [&](const ConfigObject::Ptr& obj) -> Value {
 		DictionaryData result1{
 			{ "name", obj->GetName() },
@@ -236,17 +284,20 @@ bool ObjectQueryHandler::HandleRequest(
 
 		result1.emplace_back("meta", new Dictionary(std::move(metaAttrs)));
 
-		try {
-			result1.emplace_back("attrs", SerializeObjectAttrs(obj, String(), uattrs, false, false));
-		} catch (const ScriptError& ex) {
+		Type::Ptr objType = obj->GetReflectionType();
+		auto& fields (getFields(attrFields, objType.get(), objType, String(), uattrs, false, false));
+
+		if (!fields.second.IsEmpty()) {
 			return new Dictionary{
 				{"type", type->GetName()},
 				{"name", obj->GetName()},
 				{"code", 400},
-				{"status", ex.what()}
+				{"status", fields.second}
 			};
 		}
 
+		result1.emplace_back("attrs", SerializeObjectAttrs(obj, fields.first));
+
 		DictionaryData joins;
 
 		for (auto joinAttr : joinAttrs) {
@@ -303,16 +354,19 @@ bool ObjectQueryHandler::HandleRequest(
 
 			String prefix = field.NavigationName;
 
-			try {
-				joins.emplace_back(prefix, SerializeObjectAttrs(joinedObj, prefix, ujoins, true, allJoins));
-			} catch (const ScriptError& ex) {
+			auto& joinedFields (getFields(joinFields, std::make_pair(joinAttr, reflectionType.get()),
+				reflectionType, prefix, ujoins, true, allJoins));
+
+			if (!joinedFields.second.IsEmpty()) {
 				return new Dictionary{
 					{"type", type->GetName()},
 					{"name", obj->GetName()},
 					{"code", 400},
-					{"status", ex.what()}
+					{"status", joinedFields.second}
 				};
 			}
+
+			joins.emplace_back(prefix, SerializeObjectAttrs(joinedObj, joinedFields.first));
 		}
 
 		result1.emplace_back("joins", new Dictionary(std::move(joins)));
@@ -321,6 +375,11 @@ bool ObjectQueryHandler::HandleRequest(
 	};
 
 	Dictionary::Ptr results = new Dictionary{{"results", new ValueGenerator{objs, generatorFunc}}};
+
+	if (!nextCursor.IsEmpty()) {
+		results->Set("next_cursor", nextCursor);
+	}
+
 	results->Freeze();
 
 	response.result(http::status::ok);
@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/gzipcompressor.hpp"
+#include <BoostTestTargetConfig.h>
+#include <zlib.h>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <utility>
+
+using namespace icinga;
+
+static std::string Gunzip(const std::string& in)
+{
+	z_stream stream {};
+	BOOST_REQUIRE_EQUAL(inflateInit2(&stream, 15 + 16), Z_OK);
+
+	std::string out;
+	char buf[4096];
+	int rc;
+
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+	stream.avail_in = in.size();
+
+	do {
+		stream.next_out = reinterpret_cast<Bytef*>(buf);
+		stream.avail_out = sizeof(buf);
+		rc = inflate(&stream, Z_NO_FLUSH);
+		out.append(buf, sizeof(buf) - stream.avail_out);
+	} while (rc == Z_OK);
+
+	inflateEnd(&stream);
+	BOOST_REQUIRE_EQUAL(rc, Z_STREAM_END);
+
+	return out;
+}
+
+/* Line protocol as sent by the InfluxdbWriter for a few thousand services. */
+static std::string GetLineProtocolPayload(size_t lines)
+{
+	std::mt19937 rng (42);
+	std::string payload;
+
+	for (size_t i = 0; i < lines; i++) {
+		payload += "ping4,hostname=host" + std::to_string(i % 500) + ",service=ping4,metric=rta value="
+			+ std::to_string(rng() % 100000 / 1000.0) + ",warn=100,crit=200,unit=\"seconds\" "
+			+ std::to_string(1700000000 + i / 100) + "\n";
+	}
+
+	return payload;
+}
+
+/* A bulk request body as sent by the ElasticsearchWriter for the check results of a few thousand services. */
+static std::string GetBulkPayload(size_t documents)
+{
+	std::mt19937 rng (42);
+	std::string payload;
+
+	for (size_t i = 0; i < documents; i++) {
+		auto host ("host" + std::to_string(i % 500));
+		auto timestamp ("2023-11-14T22:" + std::to_string(10 + i / 100 % 50) + ":00.000+0000");
+		auto rta (std::to_string(rng() % 100000 / 1000.0));
+
+		payload += "{\"index\": {} }\n{\"@timestamp\":\"" + timestamp + "\",\"check_command\":\"ping4\","
+			"\"check_result.check_source\":\"satellite" + std::to_string(i % 3) + "\",\"check_result.command\":"
+			"[\"/usr/lib/nagios/plugins/check_ping\",\"-H\",\"" + host + "\",\"-c\",\"200,15%\",\"-w\",\"100,5%\"],"
+			"\"check_result.execution_end\":\"" + timestamp + "\",\"check_result.execution_start\":\"" + timestamp + "\","
+			"\"check_result.execution_time\":4.0" + std::to_string(rng() % 1000) + ",\"check_result.exit_status\":0,"
+			"\"check_result.latency\":0.00" + std::to_string(rng() % 1000) + ",\"check_result.output\":"
+			"\"PING OK - Packet loss = 0%, RTA = " + rta + " ms\",\"check_result.perfdata.rta.crit\":0.2,"
+			"\"check_result.perfdata.rta.min\":0.0,\"check_result.perfdata.rta.unit\":\"seconds\","
+			"\"check_result.perfdata.rta.value\":" + rta + ",\"check_result.perfdata.rta.warn\":0.1,"
+			"\"check_result.schedule_end\":\"" + timestamp + "\",\"check_result.schedule_start\":\"" + timestamp + "\","
+			"\"check_result.state\":0.0,\"check_result.vars_after\":{\"attempt\":1.0,\"reachable\":true,\"state\":0.0,"
+			"\"state_type\":1.0},\"check_result.vars_before\":{\"attempt\":1.0,\"reachable\":true,\"state\":0.0,"
+			"\"state_type\":1.0},\"current_check_attempt\":1.0,\"host\":\"" + host + "\",\"last_hard_state\":0.0,"
+			"\"last_state\":0.0,\"max_check_attempts\":5.0,\"reachable\":true,\"service\":\"ping4\",\"state\":0.0,"
+			"\"state_type\":1.0,\"timestamp\":\"" + timestamp + "\",\"type\":\"icinga2.event.checkresult\"}\n";
+	}
+
+	return payload;
+}
+
+BOOST_AUTO_TEST_SUITE(base_gzipcompressor)
+
+BOOST_AUTO_TEST_CASE(compress)
+{
+	GzipCompressor compressor;
+	std::string out;
+
+	for (auto& in : { std::string(), std::string("a"), GetLineProtocolPayload(1000) }) {
+		compressor.Compress(in, out);
+		BOOST_CHECK_EQUAL(Gunzip(out), in);
+	}
+
+	auto payload (GetLineProtocolPayload(1000));
+	compressor.Compress(payload, out);
+	BOOST_CHECK_LT(out.size(), payload.size() / 5);
+}
+
+BOOST_AUTO_TEST_CASE(incompressible)
+{
+	std::mt19937 rng (42);
+	std::string in (100000, '\0');
+
+	for (auto& c : in) {
+		c = static_cast<char>(rng());
+	}
+
+	GzipCompressor compressor;
+	std::string out;
+
+	compressor.Compress(in, out);
+	BOOST_CHECK_EQUAL(Gunzip(out), in);
+}
+
+BOOST_AUTO_TEST_CASE(streaming)
+{
+	auto in (GetLineProtocolPayload(1000));
+	GzipCompressor compressor;
+	std::string out;
+	char buf[100];
+
+	/* Small, odd pieces on both sides. */
+	for (size_t pos = 0; pos < in.size(); pos += 333) {
+		compressor.SetInput(in.data() + pos, std::min(in.size() - pos, size_t(333)));
+
+		while (!compressor.IsInputConsumed()) {
+			out.append(buf, compressor.Deflate(buf, sizeof(buf), false));
+		}
+	}
+
+	while (!compressor.IsFinished()) {
+		out.append(buf, compressor.Deflate(buf, sizeof(buf), true));
+	}
+
+	BOOST_CHECK_EQUAL(Gunzip(out), in);
+
+	/* The state is reusable. */
+	std::string again;
+	compressor.Compress(in, again);
+	BOOST_CHECK_EQUAL(again, out);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	std::pair<const char*, std::string> payloads[] = {
+		{ "InfluxDB line protocol", GetLineProtocolPayload(50000) },
+		{ "Elasticsearch bulk JSON", GetBulkPayload(10000) }
+	};
+
+	for (auto& payload : payloads) {
+		for (int level : { 1, GzipCompressor::DefaultLevel, 9 }) {
+			GzipCompressor compressor (level);
+			std::string out;
+			const int count = 20;
+
+			auto start (std::clock());
+
+			for (int i = 0; i < count; i++) {
+				compressor.Compress(payload.second, out);
+			}
+
+			double ms = 1000.0 * (std::clock() - start) / CLOCKS_PER_SEC / count;
+			double savedMiB = (payload.second.size() - out.size()) / 1024.0 / 1024.0;
+
+			std::cout << payload.first << ", level " << level << ": " << payload.second.size() << " -> " << out.size()
+				<< " bytes (" << double(payload.second.size()) / out.size() << "x), " << ms << " ms CPU per body, "
+				<< ms / savedMiB << " ms per MiB saved" << std::endl;
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "base/metricsregistry.hpp"
+#include <BoostTestTargetConfig.h>
+#include <sstream>
+
+using namespace icinga;
+
+using Clock = MetricLatencyHistogram::Clock;
+
+BOOST_AUTO_TEST_SUITE(base_metricsregistry)
+
+BOOST_AUTO_TEST_CASE(bucket_index)
+{
+	BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(0), 0);
+	BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(31), 31);
+	BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(63), 63);
+	BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(64), 64);
+	BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(65), 64);
+	BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(uint64_t(-1)), MetricLatencyHistogram::BucketCount - 1);
+
+	for (uint64_t value = 1; value < (uint64_t(1) << MetricLatencyHistogram::MaxExponent); value += value / 7 + 1) {
+		auto index (MetricLatencyHistogram::GetBucketIndex(value));
+		auto upper (MetricLatencyHistogram::GetBucketUpperBound(index));
+
+		BOOST_CHECK_LT(index, MetricLatencyHistogram::BucketCount);
+		BOOST_CHECK_GE(upper, value);
+		BOOST_CHECK_LE(upper - value, value / MetricLatencyHistogram::SubBuckets);
+		BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(upper), index);
+		BOOST_CHECK_EQUAL(MetricLatencyHistogram::GetBucketIndex(upper + 1), index + 1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(quantiles)
+{
+	MetricLatencyHistogram histogram;
+	auto now (Clock::now());
+
+	for (int i = 1; i <= 1000; i++) {
+		histogram.Record(std::chrono::milliseconds(i), now);
+	}
+
+	auto snapshot (histogram.GetSnapshot(now));
+
+	BOOST_CHECK_EQUAL(snapshot.Count, 1000);
+	BOOST_CHECK_EQUAL(snapshot.WindowCount, 1000);
+	BOOST_CHECK_CLOSE(snapshot.Sum, 500.5, 0.001);
+	BOOST_CHECK_CLOSE(snapshot.P50, 0.5, 100.0 / MetricLatencyHistogram::SubBuckets);
+	BOOST_CHECK_CLOSE(snapshot.P90, 0.9, 100.0 / MetricLatencyHistogram::SubBuckets);
+	BOOST_CHECK_CLOSE(snapshot.P99, 0.99, 100.0 / MetricLatencyHistogram::SubBuckets);
+	BOOST_CHECK_CLOSE(snapshot.Max, 1, 100.0 / MetricLatencyHistogram::SubBuckets);
+}
+
+BOOST_AUTO_TEST_CASE(windows)
+{
+	MetricLatencyHistogram histogram;
+	auto now (Clock::now());
+	auto window (MetricLatencyHistogram::WindowLength);
+
+	histogram.Record(10.0, now);
+	histogram.Record(0.001, now + window);
+
+	/* The previous window still counts... */
+	auto snapshot (histogram.GetSnapshot(now + window));
+	BOOST_CHECK_EQUAL(snapshot.WindowCount, 2);
+	BOOST_CHECK_CLOSE(snapshot.Max, 10, 100.0 / MetricLatencyHistogram::SubBuckets);
+
+	/* ... but not the one before. */
+	histogram.Record(0.001, now + window * 2);
+	snapshot = histogram.GetSnapshot(now + window * 2);
+	BOOST_CHECK_EQUAL(snapshot.WindowCount, 2);
+	BOOST_CHECK_LT(snapshot.Max, 0.01);
+
+	/* Without new samples, the windows expire on their own. */
+	snapshot = histogram.GetSnapshot(now + window * 4);
+	BOOST_CHECK_EQUAL(snapshot.Count, 3);
+	BOOST_CHECK_EQUAL(snapshot.WindowCount, 0);
+	BOOST_CHECK_EQUAL(snapshot.P99, 0);
+}
+
+BOOST_AUTO_TEST_CASE(open_metrics)
+{
+	auto counter (MetricsRegistry::Register("test_openmetrics_requests", "Requests.", {},
+		std::make_shared<MetricCounter>()));
+	auto gauge (MetricsRegistry::Register("test_openmetrics_items", "Queued \"items\".", { { "queue", "a\"b" } },
+		std::make_shared<MetricGauge>()));
+
+	counter->Increment(3);
+	gauge->Set(42);
+
+	{
+		auto expired (MetricsRegistry::Register("test_openmetrics_expired", "Gone.", {},
+			std::make_shared<MetricCounter>()));
+	}
+
+	std::ostringstream out;
+	MetricsRegistry::WriteOpenMetrics(out);
+	auto text (out.str());
+
+	BOOST_CHECK_NE(text.find("# TYPE test_openmetrics_requests counter\n# HELP test_openmetrics_requests Requests.\ntest_openmetrics_requests_total 3\n"), std::string::npos);
+	BOOST_CHECK_NE(text.find("# HELP test_openmetrics_items Queued \"items\".\ntest_openmetrics_items{queue=\"a\\\"b\"} 42\n"), std::string::npos);
+	BOOST_CHECK_EQUAL(text.find("test_openmetrics_expired"), std::string::npos);
+	BOOST_CHECK(text.size() >= 6 && text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+
+	Dictionary::Ptr status = MetricsRegistry::GetStatus();
+	Array::Ptr items = status->Get("test_openmetrics_items");
+	BOOST_REQUIRE(items);
+	BOOST_REQUIRE_EQUAL(items->GetLength(), 1);
+
+	Dictionary::Ptr item = items->Get(0);
+	BOOST_CHECK_EQUAL(item->Get("value"), 42);
+	BOOST_CHECK_EQUAL(Dictionary::Ptr(item->Get("labels"))->Get("queue"), "a\"b");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,11 @@
 // SPDX-FileCopyrightText: 2012 Icinga GmbH <https://icinga.com>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include "base/charscanner.hpp"
 #include "base/string.hpp"
 #include "base/value.hpp"
+#include <cstring>
+#include <random>
 #include <vector>
 #include <BoostTestTargetConfig.h>
 
@@ -144,4 +147,39 @@ BOOST_AUTO_TEST_CASE(move_string_out_of_Value_type)
 #endif /* _MSC_VER */
 }
 
+BOOST_AUTO_TEST_CASE(char_scanner)
+{
+	CharScanner scanner ("|;\n");
+
+	BOOST_CHECK_EQUAL(scanner.FindFirst(""), String::NPos);
+	BOOST_CHECK_EQUAL(scanner.FindFirst("abc"), String::NPos);
+	BOOST_CHECK_EQUAL(scanner.FindFirst("a|b;c"), 1u);
+	BOOST_CHECK_EQUAL(scanner.FindFirst("a|b;c", 2), 3u);
+	BOOST_CHECK_EQUAL(scanner.FindFirst("a|b;c", 5), String::NPos);
+	BOOST_CHECK_EQUAL(scanner.FindFirst("0123456789abcdefghijklmnopqrstuvwxyz\n"), 36u);
+
+	/* Compare against std::string::find_first_of() for all offsets and lengths around the vector width. */
+	std::mt19937 rng (42);
+	std::uniform_int_distribution<int> byte (0, 255);
+
+	for (const char *chars : { "|", "|;", "|;\n", "\r\n|=", "abcdefgh" }) {
+		CharScanner randScanner (chars);
+
+		for (int i = 0; i < 1000; i++) {
+			std::string data (i % 70, '\0');
+
+			for (auto& c : data) {
+				/* Mostly harmless bytes, so that matches are sparse. */
+				c = byte(rng) < 16 ? chars[byte(rng) % strlen(chars)] : 'x' + byte(rng) % 3;
+			}
+
+			for (size_t pos = 0; pos <= data.size(); pos++) {
+				size_t expected = data.find_first_of(chars, pos);
+
+				BOOST_CHECK_EQUAL(randScanner.FindFirst(data, pos), expected == std::string::npos ? String::NPos : expected);
+			}
+		}
+	}
+}
+
 BOOST_AUTO_TEST_SUITE_END()
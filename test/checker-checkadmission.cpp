@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "checker/checkadmission.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(checker_checkadmission)
+
+/**
+ * Admits as many checks as possible during the given time, in steps of a millisecond.
+ */
+static int AdmitAll(CheckAdmission& admission, double& now, double duration)
+{
+	int admitted = 0;
+
+	for (double end = now + duration; now < end; now += 0.001) {
+		while (admission.TryAdmit(now)) {
+			admitted++;
+		}
+	}
+
+	return admitted;
+}
+
+BOOST_AUTO_TEST_CASE(slow_start)
+{
+	CheckAdmission admission;
+	admission.SetTargets(0.5, 0);
+
+	double now = 1000;
+	admission.Update(now, 0);
+
+	BOOST_CHECK_EQUAL(admission.GetRate(), CheckAdmission::BaseRate);
+
+	/* A burst of due checks is started faster and faster, as long as the system keeps up. */
+	for (double rate = CheckAdmission::BaseRate; rate < 2000; rate *= 2) {
+		int admitted = AdmitAll(admission, now, 1);
+
+		BOOST_CHECK_LE(admitted, rate * (1 + CheckAdmission::BurstLength) + 1);
+
+		admission.RecordStartLatency(0.01);
+		admission.Update(now, 0);
+
+		BOOST_CHECK_CLOSE(admission.GetRate(), rate * 2, 1);
+	}
+
+	/* Without demand, the rate limit follows the actual rate down to the base rate. */
+	now += 1;
+	admission.Update(now, 0);
+
+	BOOST_CHECK_EQUAL(admission.GetRate(), CheckAdmission::BaseRate);
+}
+
+BOOST_AUTO_TEST_CASE(congestion)
+{
+	CheckAdmission admission;
+	admission.SetTargets(0.5, 2);
+
+	double now = 1000;
+	admission.Update(now, 0);
+
+	AdmitAll(admission, now, 1);
+	admission.Update(now, 0);
+	AdmitAll(admission, now, 1);
+	admission.Update(now, 0);
+
+	BOOST_CHECK_CLOSE(admission.GetRate(), 400, 1);
+
+	/* Slow check starts halve the rate limit. */
+	AdmitAll(admission, now, 1);
+	admission.RecordStartLatency(3);
+	admission.Update(now, 0);
+
+	BOOST_CHECK_CLOSE(admission.GetRate(), 200, 1);
+	BOOST_CHECK_GT(admission.GetStartLatency(), 0.5);
+	BOOST_CHECK(!admission.TryAdmit(now));
+	BOOST_CHECK_GT(admission.GetWaitTime(now), 0);
+
+	/* Forced checks are admitted anyway. */
+	BOOST_CHECK(admission.TryAdmit(now, true));
+
+	/* The high latency fades out once checks start quickly again. */
+	for (int i = 0; i < 3; i++) {
+		AdmitAll(admission, now, 1);
+		admission.RecordStartLatency(0.01);
+		admission.Update(now, 0);
+	}
+
+	BOOST_CHECK_LT(admission.GetStartLatency(), 0.5);
+
+	double rate = admission.GetRate();
+
+	AdmitAll(admission, now, 1);
+	admission.RecordStartLatency(0.01);
+	admission.Update(now, 0);
+
+	BOOST_CHECK_CLOSE(admission.GetRate(), rate * 2, 1);
+
+	/* A high load limits the rate just like slow check starts, but not below the minimum. */
+	for (int i = 0; i < 20; i++) {
+		AdmitAll(admission, now, 1);
+		admission.Update(now, 3);
+	}
+
+	BOOST_CHECK_EQUAL(admission.GetRate(), CheckAdmission::MinRate);
+}
+
+BOOST_AUTO_TEST_CASE(disabled_targets)
+{
+	CheckAdmission admission;
+	admission.SetTargets(0, 0);
+
+	double now = 1000;
+	admission.Update(now, 0);
+
+	/* Without any targets, there's neither a slow start nor a limit at all. */
+	for (int i = 0; i < 10000; i++) {
+		BOOST_REQUIRE(admission.TryAdmit(now));
+	}
+
+	BOOST_CHECK_EQUAL(admission.GetWaitTime(now), 0);
+
+	now += 1;
+	admission.RecordStartLatency(60);
+	admission.Update(now, 100);
+
+	BOOST_CHECK(admission.TryAdmit(now));
+	BOOST_CHECK_EQUAL(admission.GetRate(), 0);
+
+	/* Once a target is set, the checks are limited again, starting at most with the base rate. */
+	admission.SetTargets(0.5, 0);
+	now += 1;
+	admission.Update(now, 0);
+
+	BOOST_CHECK_LE(admission.GetRate(), CheckAdmission::BaseRate);
+	BOOST_CHECK_LE(AdmitAll(admission, now, 1), CheckAdmission::BaseRate * (1 + CheckAdmission::BurstLength) + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,246 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <BoostTestTargetConfig.h>
+#include "icinga/host.hpp"
+#include "config/applyruleindex.hpp"
+#include "config/configcompiler.hpp"
+#include "base/scriptglobal.hpp"
+#include "test/icingaapplication-fixture.hpp"
+#include <chrono>
+#include <iostream>
+
+using namespace icinga;
+
+/**
+ * Compiles the filter and keeps it alive in the given vector.
+ *
+ * @returns The actual filter expression (without the surrounding DictExpression)
+ */
+static Expression *CompileFilter(std::vector<std::unique_ptr<Expression>>& compiled, const String& filter)
+{
+	compiled.emplace_back(ConfigCompiler::CompileText("<test>", filter));
+
+	auto dict (dynamic_cast<DictExpression*>(compiled.back().get()));
+	BOOST_REQUIRE(dict && dict->GetExpressions().size() == 1u);
+
+	return dict->GetExpressions()[0].get();
+}
+
+static Host::Ptr MakeHost(const String& name, const Dictionary::Ptr& vars, const Array::Ptr& groups = nullptr)
+{
+	Host::Ptr host = new Host();
+
+	host->SetName(name);
+	host->SetVars(vars);
+	host->SetGroups(groups);
+
+	return host;
+}
+
+/**
+ * Evaluates the filter like Service::EvaluateApplyRule() does.
+ *
+ * @returns Whether the filter matches or throws.
+ */
+static bool MayMatch(Expression *filter, const Host::Ptr& host)
+{
+	ScriptFrame frame (true);
+	frame.Locals->Set("host", host);
+
+	try {
+		return Convert::ToBool(filter->Evaluate(frame));
+	} catch (const std::exception&) {
+		return true;
+	}
+}
+
+// clang-format off
+BOOST_AUTO_TEST_SUITE(config_applyruleindex,
+	*boost::unit_test::label("config"))
+// clang-format on
+
+BOOST_FIXTURE_TEST_CASE(candidates, IcingaApplicationFixture)
+{
+	std::vector<Host::Ptr> hosts ({
+		MakeHost("db-01", new Dictionary({
+			{ "os", "Linux" },
+			{ "tags", new Array({ "a", "b" }) }
+		}), new Array({ "linux-servers" })),
+		MakeHost("DB-02", new Dictionary({
+			{ "os", "Windows" },
+			{ "location", new Dictionary({ { "dc", "ber" } }) }
+		}), new Array({ "windows" })),
+		MakeHost("web-01", new Dictionary({
+			{ "os", 5 },
+			{ "tags", "notarray" },
+			{ "location", "ber" }
+		}), new Array()),
+		MakeHost("web-02", nullptr),
+		MakeHost("mail", new Dictionary({
+			{ "os", "" },
+			{ "tags", new Array({ 1, "a" }) }
+		}))
+	});
+
+	std::vector<size_t> all ({ 0, 1, 2, 3, 4 });
+
+	/* The hosts the index is expected to return, i.e. the matching ones plus the undecidable ones. */
+	std::vector<std::pair<String, std::vector<size_t>>> rules ({
+		{ R"(host.vars.os == "Linux")", { 0, 2 } },
+		{ R"("Linux" == host.vars.os && host.vars.missing.x)", { 0, 2 } },
+		{ R"(host.vars.location.dc == "ber")", { 1, 2 } },
+		{ R"(host["vars"]["location"].dc == "ber")", { 1, 2 } },
+		{ R"("linux-servers" in host.groups || "windows" in host.groups)", { 0, 1 } },
+		{ R"("a" in host.vars.tags)", { 0, 2, 4 } },
+		{ R"(match("db-*", host.name))", { 0, 1 } },
+		{ R"(match("web-0?", host.name) && host.vars.os)", { 2, 3 } },
+		{ R"(match("\\*", host.name) || match("DB-0*", host.name))", { 0, 1 } },
+		{ R"(host.vars.os == "")", { 2, 3, 4 } },
+		{ R"(host.vars.os != "Linux")", all },
+		{ R"(true)", all },
+		{ R"(host.vars.tags && "a" in host.vars.tags)", all },
+		{ R"(match("*-01", host.name))", all },
+		{ R"(match("db-*", host.name, MatchAny))", all },
+		{ R"(host.vars.os == "Linux" || host.vars.os != "Linux")", all },
+		{ R"(host.name == host.vars.os)", all }
+	});
+
+	ApplyRuleIndex index (Host::TypeInstance);
+	std::vector<std::unique_ptr<Expression>> compiled;
+	std::vector<Expression*> filters;
+
+	for (auto& rule : rules) {
+		filters.emplace_back(CompileFilter(compiled, rule.first));
+		index.Add(filters.back());
+	}
+
+	BOOST_CHECK_EQUAL(index.GetRuleCount(), rules.size());
+	BOOST_CHECK_EQUAL(index.GetIndexedRuleCount(), 10u);
+
+	std::vector<std::vector<size_t>> candidates;
+
+	for (auto& host : hosts) {
+		candidates.emplace_back();
+		index.GetCandidates(host, ScriptGlobal::GetGlobals(), candidates.back());
+	}
+
+	for (size_t i = 0; i < rules.size(); i++) {
+		BOOST_TEST_CONTEXT("filter: " << rules[i].first) {
+			std::vector<size_t> expected;
+
+			for (size_t h = 0; h < hosts.size(); h++) {
+				bool candidate = std::find(candidates[h].begin(), candidates[h].end(), i) != candidates[h].end();
+
+				if (candidate) {
+					expected.emplace_back(h);
+				}
+
+				if (MayMatch(filters[i], hosts[h])) {
+					BOOST_CHECK_MESSAGE(candidate, "host " << hosts[h]->GetName() << " is missing");
+				}
+			}
+
+			BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), rules[i].second.begin(), rules[i].second.end());
+		}
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(locals, IcingaApplicationFixture)
+{
+	auto host (MakeHost("db-01", new Dictionary({ { "os", "Windows" } })));
+	std::vector<std::unique_ptr<Expression>> compiled;
+	auto filter (CompileFilter(compiled, R"(host.vars.os == "Linux" || match("db-*", host.vars.os))"));
+	ApplyRuleIndex index (Host::TypeInstance);
+	std::vector<size_t> candidates;
+
+	index.Add(filter);
+	index.Add(filter, { "host" });
+	index.Add(filter, { "match" });
+	index.Add(filter, { "disk", "config" });
+
+	BOOST_CHECK_EQUAL(index.GetIndexedRuleCount(), 2u);
+
+	index.GetCandidates(host, ScriptGlobal::GetGlobals(), candidates);
+	BOOST_CHECK(candidates == std::vector<size_t>({ 1, 2 }));
+
+	/* Fields of "this" shadow match() just like locals do. */
+	Namespace::Ptr self = new Namespace();
+	self->Set("match", true);
+
+	index.GetCandidates(host, self, candidates);
+	BOOST_CHECK(candidates == std::vector<size_t>({ 0, 1, 2, 3 }));
+}
+
+BOOST_FIXTURE_TEST_CASE(benchmark, IcingaApplicationFixture,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	std::vector<Host::Ptr> hosts;
+
+	for (int i = 0; i < 20000; i++) {
+		hosts.emplace_back(MakeHost("site" + Convert::ToString(i % 50) + "-host" + Convert::ToString(i), new Dictionary({
+			{ "role", "role" + Convert::ToString(i % 100) },
+			{ "os", i % 2 ? "Linux" : "Windows" }
+		}), new Array({ "group" + Convert::ToString(i % 200) })));
+	}
+
+	ApplyRuleIndex index (Host::TypeInstance);
+	std::vector<std::unique_ptr<Expression>> compiled;
+	std::vector<Expression*> filters;
+
+	for (int i = 0; i < 1000; i++) {
+		String n = Convert::ToString(i % 333);
+
+		switch (i % 3) {
+			case 0:
+				filters.emplace_back(CompileFilter(compiled, "host.vars.role == \"role" + n + "\" && host.vars.os == \"Linux\""));
+				break;
+			case 1:
+				filters.emplace_back(CompileFilter(compiled, "\"group" + n + "\" in host.groups"));
+				break;
+			default:
+				filters.emplace_back(CompileFilter(compiled, "match(\"site" + n + "-*\", host.name)"));
+		}
+
+		index.Add(filters.back());
+	}
+
+	size_t fullMatches = 0, indexedMatches = 0, evaluated = 0;
+
+	auto start (std::chrono::steady_clock::now());
+
+	for (auto& host : hosts) {
+		for (auto& filter : filters) {
+			ScriptFrame frame (true);
+			frame.Locals->Set("host", host);
+			fullMatches += Convert::ToBool(filter->Evaluate(frame));
+		}
+	}
+
+	auto fullDone (std::chrono::steady_clock::now());
+	std::vector<size_t> candidates;
+
+	for (auto& host : hosts) {
+		index.GetCandidates(host, ScriptGlobal::GetGlobals(), candidates);
+		evaluated += candidates.size();
+
+		for (auto pos : candidates) {
+			ScriptFrame frame (true);
+			frame.Locals->Set("host", host);
+			indexedMatches += Convert::ToBool(filters[pos]->Evaluate(frame));
+		}
+	}
+
+	auto indexedDone (std::chrono::steady_clock::now());
+
+	BOOST_CHECK_EQUAL(fullMatches, indexedMatches);
+
+	using ms = std::chrono::duration<double, std::milli>;
+
+	std::cout << "all rules: " << ms(fullDone - start).count() << " ms, candidates only: "
+		<< ms(indexedDone - fullDone).count() << " ms (" << evaluated << " evaluations, "
+		<< indexedMatches << " matches)" << std::endl;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
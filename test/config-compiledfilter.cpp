@@ -0,0 +1,264 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <BoostTestTargetConfig.h>
+#include "icinga/host.hpp"
+#include "config/compiledfilter.hpp"
+#include "config/configcompiler.hpp"
+#include "remote/filterutility.hpp"
+#include "test/icingaapplication-fixture.hpp"
+#include <chrono>
+#include <iostream>
+
+using namespace icinga;
+
+/**
+ * Evaluates the filter both by walking its AST and by running its bytecode and checks that both agree,
+ * i.e. that either both return the same result or both throw the same error.
+ */
+static void CheckCompiledFilter(const String& filter, const Type::Ptr& type, const String& varName,
+	const std::vector<Object::Ptr>& targets, const Dictionary::Ptr& vars = nullptr, bool throws = false)
+{
+	BOOST_TEST_CONTEXT("filter: " << filter) {
+		std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", filter);
+		std::vector<String> varNames;
+
+		if (vars) {
+			ObjectLock olock (vars);
+
+			for (auto& kv : vars) {
+				varNames.emplace_back(kv.first);
+			}
+		}
+
+		auto compiled (CompiledFilter::Compile(expr.get(), type, varName, varNames));
+		BOOST_REQUIRE(compiled);
+
+		for (auto& target : targets) {
+			ScriptFrame astFrame (false, new Namespace());
+			astFrame.Sandboxed = true;
+
+			if (vars) {
+				Namespace::Ptr ns = astFrame.Self;
+				ObjectLock olock (vars);
+
+				for (auto& kv : vars) {
+					ns->Set(kv.first, kv.second);
+				}
+			}
+
+			ScriptFrame compiledFrame (false, new Namespace());
+			compiledFrame.Sandboxed = true;
+
+			if (throws) {
+				String astError, compiledError;
+
+				try {
+					FilterUtility::EvaluateFilter(astFrame, expr.get(), target, varName);
+				} catch (const std::exception& ex) {
+					astError = ex.what();
+				}
+
+				try {
+					compiled->Evaluate(compiledFrame, target, vars);
+				} catch (const std::exception& ex) {
+					compiledError = ex.what();
+				}
+
+				BOOST_CHECK(!astError.IsEmpty());
+				BOOST_CHECK_EQUAL(compiledError, astError);
+			} else {
+				BOOST_CHECK_EQUAL(compiled->Evaluate(compiledFrame, target, vars),
+					FilterUtility::EvaluateFilter(astFrame, expr.get(), target, varName));
+			}
+		}
+	}
+}
+
+// clang-format off
+BOOST_AUTO_TEST_SUITE(config_compiledfilter,
+	*boost::unit_test::label("config"))
+// clang-format on
+
+BOOST_AUTO_TEST_CASE(unsupported)
+{
+	std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", "var x = 1; x == 1");
+	BOOST_CHECK(!CompiledFilter::Compile(expr.get(), Dictionary::TypeInstance, "event"));
+
+	expr = ConfigCompiler::CompileText("<test>", "function() { return true }()");
+	BOOST_CHECK(!CompiledFilter::Compile(expr.get(), Dictionary::TypeInstance, "event"));
+
+	expr = ConfigCompiler::CompileText("<test>", "event.type == \"CheckResult\"");
+	BOOST_CHECK(!CompiledFilter::Compile(expr.get(), nullptr, "event"));
+}
+
+BOOST_FIXTURE_TEST_CASE(dictionary, IcingaApplicationFixture)
+{
+	std::vector<Object::Ptr> events;
+
+	for (int i = 0; i < 8; i++) {
+		events.emplace_back(new Dictionary({
+			{ "type", i % 2 ? "CheckResult" : "StateChange" },
+			{ "host", "host" + Convert::ToString(i) },
+			{ "state", i % 4 },
+			{ "check_result", new Dictionary({
+				{ "exit_status", i % 3 },
+				{ "output", "output " + Convert::ToString(i) }
+			}) }
+		}));
+	}
+
+	auto type (Dictionary::TypeInstance);
+
+	CheckCompiledFilter("event.type == \"CheckResult\"", type, "event", events);
+	CheckCompiledFilter("obj.type != \"CheckResult\" && event.state >= 2", type, "event", events);
+	CheckCompiledFilter("event.check_result.exit_status > 0 || event.host == \"host4\"", type, "event", events);
+	CheckCompiledFilter("event.host in [ \"host1\", \"host3\", \"host7\" ]", type, "event", events);
+	CheckCompiledFilter("event.host !in [ \"host1\", \"host3\" ]", type, "event", events);
+	CheckCompiledFilter("match(\"host[13]\", event.host)", type, "event", events);
+	CheckCompiledFilter("event.check_result.output.contains(\"5\")", type, "event", events);
+	CheckCompiledFilter("!(event.state * 2 + 1 > 4)", type, "event", events);
+	CheckCompiledFilter("event.state % 2 == 0 && event.missing == null", type, "event", events);
+	CheckCompiledFilter("event[\"type\"] == \"StateChange\"", type, "event", events);
+	CheckCompiledFilter("event.state == state", type, "event", events, new Dictionary({ { "state", 2 } }));
+	CheckCompiledFilter("event.host in hosts", type, "event", events,
+		new Dictionary({ { "hosts", new Array({ "host0", "host6" }) } }));
+
+	CheckCompiledFilter("event.host in 42", type, "event", events, nullptr, true);
+	CheckCompiledFilter("undefined_variable == 1", type, "event", events, nullptr, true);
+
+	/* Operands are evaluated in the same order as by the AST, so the same one fails or isn't evaluated at all. */
+	CheckCompiledFilter("undefined_variable in event.missing", type, "event", events);
+	CheckCompiledFilter("undefined_variable !in null", type, "event", events);
+	CheckCompiledFilter("undefined_variable in 42", type, "event", events, nullptr, true);
+	CheckCompiledFilter("event.host(undefined_variable)", type, "event", events, nullptr, true);
+	CheckCompiledFilter("event.missing(undefined_variable)", type, "event", events, nullptr, true);
+}
+
+BOOST_FIXTURE_TEST_CASE(host, IcingaApplicationFixture)
+{
+	auto createObjects = []() {
+		String config = R"CONFIG({
+object CheckCommand "compiledfilter-dummy" {
+  command = "/bin/echo"
+}
+
+for (i in range(10)) {
+  object Host "compiledfilter-host" + i use (i) {
+    check_command = "compiledfilter-dummy"
+    check_interval = 30 * (i + 1)
+    enable_active_checks = i % 3 != 0
+    vars.os = "Windows"
+    vars.tags = [ "windows", "tag" + i ]
+
+    if (i % 2) {
+      vars.os = "Linux"
+      vars.tags = [ "linux", "tag" + i ]
+    }
+
+    vars.num = i
+    vars.list = range(i)
+  }
+}
+})CONFIG";
+		std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", config);
+		ScriptFrame frame (true);
+		expr->Evaluate(frame);
+	};
+
+	ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", createObjects));
+
+	std::vector<Object::Ptr> hosts;
+
+	for (int i = 0; i < 10; i++) {
+		auto host (Host::GetByName("compiledfilter-host" + Convert::ToString(i)));
+		BOOST_REQUIRE(host);
+		hosts.emplace_back(host);
+	}
+
+	auto type (Host::TypeInstance);
+
+	CheckCompiledFilter("host.name == \"compiledfilter-host3\"", type, "host", hosts);
+	CheckCompiledFilter("host.vars.os == \"Linux\" && host.enable_active_checks", type, "host", hosts);
+	CheckCompiledFilter("\"linux\" in host.vars.tags", type, "host", hosts);
+	CheckCompiledFilter("host.vars.tags.contains(\"tag3\")", type, "host", hosts);
+	CheckCompiledFilter("match(\"*host[2-5]\", host.name) || host.vars.num > 8", type, "host", hosts);
+	CheckCompiledFilter("host.check_interval * 2 >= 300 && host.vars.num % 2 == 0", type, "host", hosts);
+	CheckCompiledFilter("obj.vars.missing", type, "host", hosts);
+	CheckCompiledFilter("host.vars[\"os\"] != \"Windows\"", type, "host", hosts);
+	CheckCompiledFilter("num in host.vars.list", type, "host", hosts, new Dictionary({ { "num", 4 } }));
+	CheckCompiledFilter("host.vars.num in host.vars.list", type, "host", hosts);
+	CheckCompiledFilter("host.name in 42", type, "host", hosts, nullptr, true);
+
+	/* Host objects are also matched by the Checkable type, just without the field ID fast path. */
+	CheckCompiledFilter("host.vars.os == \"Linux\"", Checkable::TypeInstance, "host", hosts);
+}
+
+BOOST_FIXTURE_TEST_CASE(benchmark, IcingaApplicationFixture,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	auto createObjects = []() {
+		String config = R"CONFIG({
+object CheckCommand "compiledfilter-bench" {
+  command = "/bin/echo"
+}
+
+for (i in range(100000)) {
+  object Host "compiledfilter-bench" + i use (i) {
+    check_command = "compiledfilter-bench"
+    vars.os = "Windows"
+    vars.num = i
+
+    if (i % 2) {
+      vars.os = "Linux"
+    }
+  }
+}
+})CONFIG";
+		std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", config);
+		ScriptFrame frame (true);
+		expr->Evaluate(frame);
+	};
+
+	ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", createObjects));
+
+	String filter = "host.vars.os == \"Linux\" && host.vars.num % 3 == 0 && match(\"compiledfilter-bench*\", host.name)";
+	std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", filter);
+	auto compiled (CompiledFilter::Compile(expr.get(), Host::TypeInstance, "host"));
+	BOOST_REQUIRE(compiled);
+
+	auto hosts (ConfigType::GetObjectsByType<Host>());
+	BOOST_REQUIRE_GE(hosts.size(), 100000u);
+
+	size_t astMatches = 0, compiledMatches = 0;
+
+	auto start (std::chrono::steady_clock::now());
+
+	for (auto& host : hosts) {
+		ScriptFrame frame (false, new Namespace());
+		frame.Sandboxed = true;
+
+		astMatches += FilterUtility::EvaluateFilter(frame, expr.get(), host, "host");
+	}
+
+	auto astDone (std::chrono::steady_clock::now());
+
+	for (auto& host : hosts) {
+		ScriptFrame frame (false, new Namespace());
+		frame.Sandboxed = true;
+
+		compiledMatches += compiled->Evaluate(frame, host);
+	}
+
+	auto compiledDone (std::chrono::steady_clock::now());
+
+	BOOST_CHECK_EQUAL(astMatches, compiledMatches);
+
+	using ms = std::chrono::duration<double, std::milli>;
+
+	std::cout << "AST: " << ms(astDone - start).count() << " ms, bytecode: "
+		<< ms(compiledDone - astDone).count() << " ms (" << compiledMatches << " matches)" << std::endl;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
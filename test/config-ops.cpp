@@ -3,7 +3,9 @@
 
 #include "config/configcompiler.hpp"
 #include "base/exception.hpp"
+#include "test/base-configuration-fixture.hpp"
 #include <BoostTestTargetConfig.h>
+#include <fstream>
 
 using namespace icinga;
 
@@ -289,4 +291,34 @@ BOOST_AUTO_TEST_CASE(sandboxed_ticket_salt)
 	BOOST_CHECK_THROW(expr->Evaluate(frame), ScriptError);
 }
 
+BOOST_FIXTURE_TEST_CASE(collect_includes, ConfigurationDataDirFixture)
+{
+	std::vector<String> files;
+
+	for (int i = 0; i < 16; i++) {
+		files.emplace_back(Configuration::DataDir + "/" + Convert::ToString(i) + ".conf");
+		std::ofstream(files.back().CStr()) << "order.add(" << i << ")\n";
+	}
+
+	auto prevConcurrency (Configuration::Concurrency);
+	Configuration::Concurrency = 4;
+
+	std::vector<std::unique_ptr<Expression>> expressions;
+	ConfigCompiler::CollectIncludes(expressions, files, String(), String());
+
+	Configuration::Concurrency = prevConcurrency;
+
+	BOOST_REQUIRE_EQUAL(expressions.size(), files.size());
+
+	DictExpression expr (std::move(expressions));
+	expr.MakeInline();
+
+	Array::Ptr order = new Array();
+	ScriptFrame frame (true);
+	frame.Locals->Set("order", order);
+	expr.Evaluate(frame);
+
+	BOOST_CHECK_EQUAL(order->Join(","), "0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,12 +1,22 @@
 // SPDX-FileCopyrightText: 2012 Icinga GmbH <https://icinga.com>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include "icinga/dependency.hpp"
 #include "icinga/downtime.hpp"
 #include "icinga/host.hpp"
 #include "icinga/service.hpp"
+#include "base/configuration.hpp"
+#include "base/defer.hpp"
+#include "base/objectlock.hpp"
 #include <BoostTestTargetConfig.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -1033,4 +1043,316 @@ BOOST_AUTO_TEST_CASE(suppressed_notification)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(concurrent_event_order)
+{
+	Host::Ptr host = new Host();
+	host->SetActive(true);
+	host->SetMaxCheckAttempts(1);
+	host->Activate();
+	host->SetAuthority(true);
+
+	std::mutex mutex;
+	std::vector<double> announced;
+
+	boost::signals2::connection c = Checkable::OnNewCheckResult.connect([&host, &mutex, &announced](
+		const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr&) {
+		if (checkable == host) {
+			std::unique_lock<std::mutex> lock (mutex);
+			announced.emplace_back(cr->GetExecutionStart());
+		}
+	});
+
+	std::atomic<int> next (0);
+	std::vector<std::thread> threads;
+	/* In the past, as check results from the future are always accepted. */
+	double start = Utility::GetTime() - 3600;
+
+	for (int i = 0; i < 4; i++) {
+		threads.emplace_back([&host, &next, start]() {
+			for (int j = 0; j < 100; j++) {
+				auto cr (MakeCheckResult(j % 2 ? ServiceOK : ServiceCritical));
+				cr->SetExecutionStart(start + next++ * 0.001);
+				host->ProcessCheckResult(cr, new StoppableWaitGroup());
+			}
+		});
+	}
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	c.disconnect();
+
+	/* Older check results are rejected, so the accepted ones must be announced in ascending order. */
+	BOOST_CHECK(!announced.empty());
+	BOOST_CHECK(std::is_sorted(announced.begin(), announced.end()));
+	BOOST_CHECK_EQUAL(host->GetLastCheckResult()->GetExecutionStart(), announced.back());
+}
+
+BOOST_AUTO_TEST_CASE(lock_contention_benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	/* A hot checkable receiving lots of passive check results while being read via the API. */
+	Host::Ptr host = new Host();
+	host->SetActive(true);
+	host->SetMaxCheckAttempts(3);
+	host->Activate();
+	host->SetAuthority(true);
+
+	/* E.g. writing the new state to a database. */
+	boost::signals2::connection c = Checkable::OnNewCheckResult.connect([](const Checkable::Ptr&, const CheckResult::Ptr&,
+		const MessageOrigin::Ptr&) {
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	});
+
+	using us = std::chrono::duration<double, std::micro>;
+
+	std::atomic<bool> done (false);
+	std::atomic<uint_fast64_t> reads (0);
+	std::mutex mutex;
+	double totalWait = 0, maxWait = 0;
+	std::vector<std::thread> readers, writers;
+
+	for (int i = 0; i < 4; i++) {
+		readers.emplace_back([&]() {
+			double total = 0, max = 0;
+			uint_fast64_t count = 0;
+
+			while (!done) {
+				auto start (std::chrono::steady_clock::now());
+
+				{
+					ObjectLock olock (host);
+					auto wait (us(std::chrono::steady_clock::now() - start).count());
+
+					total += wait;
+					max = std::max(max, wait);
+					count++;
+
+					(void)host->GetLastCheckResult();
+					(void)host->GetStateType();
+				}
+
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+
+			std::unique_lock<std::mutex> lock (mutex);
+			totalWait += total;
+			maxWait = std::max(maxWait, max);
+			reads += count;
+		});
+	}
+
+	auto start (std::chrono::steady_clock::now());
+
+	for (int i = 0; i < 4; i++) {
+		writers.emplace_back([&host]() {
+			for (int j = 0; j < 2000; j++) {
+				host->ProcessCheckResult(MakeCheckResult(j % 3 ? ServiceOK : ServiceCritical), new StoppableWaitGroup());
+			}
+		});
+	}
+
+	for (auto& writer : writers) {
+		writer.join();
+	}
+
+	auto end (std::chrono::steady_clock::now());
+
+	done = true;
+
+	for (auto& reader : readers) {
+		reader.join();
+	}
+
+	c.disconnect();
+
+	std::cout << "check results: " << us(end - start).count() / 8000 << " us each, reads: " << reads << " with "
+		<< totalWait / reads << " us average and " << maxWait << " us maximum lock wait" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(process_many)
+{
+	auto concurrency (Configuration::Concurrency);
+	Defer restoreConcurrency ([concurrency]() { Configuration::Concurrency = concurrency; });
+
+	Configuration::Concurrency = 4;
+
+	std::vector<Host::Ptr> hosts;
+
+	for (int i = 0; i < 10; i++) {
+		Host::Ptr host = new Host();
+		host->SetActive(true);
+		host->SetMaxCheckAttempts(1);
+		host->Activate();
+		host->SetAuthority(true);
+		hosts.emplace_back(std::move(host));
+	}
+
+	Host::Ptr inactive = new Host();
+
+	std::mutex mutex;
+	std::map<Checkable::Ptr, std::vector<double>> announced;
+
+	boost::signals2::connection c = Checkable::OnNewCheckResult.connect([&mutex, &announced](
+		const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr&) {
+		std::unique_lock<std::mutex> lock (mutex);
+		announced[checkable].emplace_back(cr->GetExecutionStart());
+	});
+
+	std::vector<Checkable::QueuedCheckResult> results;
+	double start = Utility::GetTime() - 3600;
+
+	for (int i = 0; i < 200; i++) {
+		auto cr (MakeCheckResult(i % 3 ? ServiceOK : ServiceCritical));
+		cr->SetExecutionStart(start + i);
+		results.emplace_back(Checkable::QueuedCheckResult{hosts[i % hosts.size()], cr});
+	}
+
+	results.emplace_back(Checkable::QueuedCheckResult{inactive, MakeCheckResult(ServiceOK)});
+
+	Checkable::ProcessCheckResults(results, new StoppableWaitGroup());
+
+	c.disconnect();
+
+	for (auto& result : results) {
+		BOOST_CHECK(!result.Error);
+	}
+
+	BOOST_CHECK(results.back().Outcome == Checkable::ProcessingResult::CheckableInactive);
+
+	/* All check results of the same checkable are processed in the given order. */
+	for (auto& host : hosts) {
+		auto& starts (announced[host]);
+
+		BOOST_CHECK_EQUAL(starts.size(), 20);
+		BOOST_CHECK(std::is_sorted(starts.begin(), starts.end()));
+		BOOST_CHECK_EQUAL(host->GetLastCheckResult()->GetExecutionStart(), starts.back());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(process_many_reachability)
+{
+	auto concurrency (Configuration::Concurrency);
+	Defer restoreConcurrency ([concurrency]() { Configuration::Concurrency = concurrency; });
+
+	Configuration::Concurrency = 4;
+
+	auto createHost ([](const String& name) {
+		Host::Ptr host = new Host();
+		host->SetName(name);
+		host->PushDependencyGroupsToRegistry();
+		host->SetActive(true);
+		host->SetMaxCheckAttempts(1);
+		host->Activate();
+		host->SetAuthority(true);
+		return host;
+	});
+
+	Host::Ptr parent (createHost("process_many_reachability_parent"));
+	std::vector<Host::Ptr> children;
+
+	for (int i = 0; i < 120; i++) {
+		Host::Ptr child (createHost("process_many_reachability_child" + std::to_string(i)));
+
+		Dependency::Ptr dep = new Dependency();
+		dep->SetParent(parent);
+		dep->SetChild(child);
+		dep->SetName("dep!" + child->GetName());
+		dep->SetStateFilter(StateFilterUp);
+		dep->SetDisableChecks(true);
+		child->AddDependency(dep);
+		parent->AddReverseDependency(dep);
+
+		children.emplace_back(std::move(child));
+	}
+
+	/* The parent goes down first, so all check results of its children have to be ignored,
+	 * no matter how the batch is split up for processing it in parallel.
+	 */
+	std::vector<Checkable::QueuedCheckResult> results;
+
+	results.emplace_back(Checkable::QueuedCheckResult{parent, MakeCheckResult(ServiceCritical)});
+
+	for (auto& child : children) {
+		Checkable::QueuedCheckResult queued;
+		queued.Object = child;
+		queued.Result = MakeCheckResult(ServiceCritical);
+		queued.IgnoreIfUnreachable = true;
+
+		results.emplace_back(std::move(queued));
+	}
+
+	Checkable::ProcessCheckResults(results, new StoppableWaitGroup());
+
+	BOOST_CHECK_EQUAL(parent->GetState(), HostDown);
+
+	for (auto& result : results) {
+		BOOST_CHECK(!result.Error);
+	}
+
+	for (decltype(results.size()) i = 1; i < results.size(); i++) {
+		BOOST_CHECK(results[i].Unreachable);
+		BOOST_CHECK(!results[i].Object->GetLastCheckResult());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(process_many_benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	/* A passive monitoring agent submitting the check results of a lot of hosts at once. */
+	const size_t count = 50000;
+
+	auto concurrency (Configuration::Concurrency);
+	Defer restoreConcurrency ([concurrency]() { Configuration::Concurrency = concurrency; });
+
+	Configuration::Concurrency = std::max(2u, std::thread::hardware_concurrency());
+
+	std::vector<Host::Ptr> hosts;
+
+	for (size_t i = 0; i < 5000; i++) {
+		Host::Ptr host = new Host();
+		host->SetActive(true);
+		host->SetMaxCheckAttempts(3);
+		host->Activate();
+		host->SetAuthority(true);
+		hosts.emplace_back(std::move(host));
+	}
+
+	/* E.g. writing the new state to a database. */
+	boost::signals2::connection c = Checkable::OnNewCheckResult.connect([](const Checkable::Ptr&, const CheckResult::Ptr&,
+		const MessageOrigin::Ptr&) {
+		std::this_thread::sleep_for(std::chrono::microseconds(20));
+	});
+
+	using ms = std::chrono::duration<double, std::milli>;
+
+	for (bool batched : { false, true }) {
+		std::vector<Checkable::QueuedCheckResult> results;
+
+		for (size_t i = 0; i < count; i++) {
+			results.emplace_back(Checkable::QueuedCheckResult{hosts[i % hosts.size()], MakeCheckResult(i % 3 ? ServiceOK : ServiceCritical)});
+		}
+
+		auto start (std::chrono::steady_clock::now());
+
+		if (batched) {
+			Checkable::ProcessCheckResults(results, new StoppableWaitGroup());
+		} else {
+			for (auto& result : results) {
+				result.Object->ProcessCheckResult(result.Result, new StoppableWaitGroup());
+			}
+		}
+
+		auto end (std::chrono::steady_clock::now());
+
+		std::cout << (batched ? "batched" : "single") << " check results: " << ms(end - start).count() << " ms ("
+			<< count / std::chrono::duration<double>(end - start).count() << " per second)" << std::endl;
+	}
+
+	c.disconnect();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/checktrace.hpp"
+#include "icinga/host.hpp"
+#include <BoostTestTargetConfig.h>
+#include <thread>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(icinga_checktrace)
+
+BOOST_AUTO_TEST_CASE(sample)
+{
+	Host::Ptr host = new Host();
+
+	CheckTrace::SetSampleRate(0);
+	for (int i = 0; i < 100; i++) {
+		BOOST_CHECK(!CheckTrace::Sample(host));
+	}
+
+	CheckTrace::SetSampleRate(1);
+	for (int i = 0; i < 100; i++) {
+		auto trace (CheckTrace::Sample(host));
+
+		BOOST_REQUIRE(trace);
+		BOOST_CHECK(trace->GetCheckable() == host);
+	}
+
+	CheckTrace::SetSampleRate(0);
+}
+
+BOOST_AUTO_TEST_CASE(spans)
+{
+	auto trace (std::make_shared<CheckTrace>(new Host()));
+
+	for (std::size_t i = 0; i < static_cast<std::size_t>(CheckTraceStage::Count); i++) {
+		BOOST_CHECK(!trace->HasStage(static_cast<CheckTraceStage>(i)));
+	}
+
+	{
+		/* Spans without a trace must not do anything. */
+		CheckTrace::Span span (nullptr, CheckTraceStage::Spawn);
+	}
+
+	{
+		CheckTrace::Span span (trace, CheckTraceStage::Spawn);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	BOOST_CHECK(trace->HasStage(CheckTraceStage::Spawn));
+	BOOST_CHECK_GE(trace->GetStageDuration(CheckTraceStage::Spawn), 0.01);
+
+	{
+		CheckTrace::Span span (trace, CheckTraceStage::MacroResolution);
+		span.End();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	BOOST_CHECK(trace->HasStage(CheckTraceStage::MacroResolution));
+	BOOST_CHECK_LT(trace->GetStageDuration(CheckTraceStage::MacroResolution), 0.01);
+
+	trace->Record(CheckTraceStage::PluginRuntime, -1.0);
+	BOOST_CHECK_EQUAL(trace->GetStageDuration(CheckTraceStage::PluginRuntime), 0);
+}
+
+BOOST_AUTO_TEST_CASE(scope)
+{
+	auto outer (std::make_shared<CheckTrace>(new Host()));
+	auto inner (std::make_shared<CheckTrace>(new Host()));
+
+	BOOST_CHECK(!CheckTrace::GetCurrent());
+
+	{
+		CheckTrace::Scope outerScope (outer);
+		BOOST_CHECK_EQUAL(CheckTrace::GetCurrent(), outer);
+
+		{
+			CheckTrace::Scope innerScope (inner);
+			BOOST_CHECK_EQUAL(CheckTrace::GetCurrent(), inner);
+		}
+
+		BOOST_CHECK_EQUAL(CheckTrace::GetCurrent(), outer);
+
+		std::thread([]() { BOOST_CHECK(!CheckTrace::GetCurrent()); }).join();
+	}
+
+	BOOST_CHECK(!CheckTrace::GetCurrent());
+}
+
+BOOST_AUTO_TEST_CASE(finish)
+{
+	auto trace (std::make_shared<CheckTrace>(new Host()));
+	int finished = 0;
+
+	auto slot (CheckTrace::OnFinished.connect([&trace, &finished](const CheckTrace::Ptr& t) {
+		BOOST_CHECK_EQUAL(t, trace);
+		finished++;
+	}));
+
+	trace->Record(CheckTraceStage::DispatchWait, 0.5);
+	trace->Finish();
+	trace->Finish();
+
+	/* E.g. event handlers run after the trace has been finished don't change it anymore. */
+	trace->Record(CheckTraceStage::DispatchWait, 1.0);
+	trace->Record(CheckTraceStage::Spawn, 1.0);
+
+	slot.disconnect();
+
+	BOOST_CHECK_EQUAL(finished, 1);
+	BOOST_CHECK_EQUAL(trace->GetStageDuration(CheckTraceStage::DispatchWait), 0.5);
+	BOOST_CHECK(!trace->HasStage(CheckTraceStage::Spawn));
+}
+
+BOOST_AUTO_TEST_CASE(stage_names)
+{
+	BOOST_CHECK_EQUAL(CheckTrace::GetStageName(CheckTraceStage::DispatchWait), "dispatch_wait");
+	BOOST_CHECK_EQUAL(CheckTrace::GetStageName(CheckTraceStage::SignalHandlers), "signal_handlers");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
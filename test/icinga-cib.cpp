@@ -0,0 +1,341 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/cib.hpp"
+#include "icinga/dependency.hpp"
+#include "icinga/downtime.hpp"
+#include "icinga/host.hpp"
+#include "icinga/service.hpp"
+#include <BoostTestTargetConfig.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(icinga_cib)
+
+BOOST_AUTO_TEST_CASE(duration_sketch_empty)
+{
+	DurationSketch sketch;
+
+	BOOST_CHECK_EQUAL(sketch.GetCount(), 0);
+	BOOST_CHECK_EQUAL(sketch.GetMin(), 0);
+	BOOST_CHECK_EQUAL(sketch.GetMax(), 0);
+	BOOST_CHECK(std::isnan(sketch.GetAvg()));
+
+	sketch.Add(1.5);
+	sketch.Remove(1.5);
+
+	BOOST_CHECK_EQUAL(sketch.GetCount(), 0);
+	BOOST_CHECK_EQUAL(sketch.GetMax(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(duration_sketch_accuracy)
+{
+	DurationSketch sketch;
+
+	sketch.Add(0.25);
+	sketch.Add(2);
+	sketch.Add(30);
+	sketch.Add(0);
+
+	BOOST_CHECK_EQUAL(sketch.GetCount(), 4);
+	BOOST_CHECK_EQUAL(sketch.GetMin(), 0);
+	BOOST_CHECK_CLOSE(sketch.GetMax(), 30, 1);
+	BOOST_CHECK_CLOSE(sketch.GetAvg(), 8.0625, 1e-6);
+
+	sketch.Remove(30);
+	sketch.Remove(0);
+
+	BOOST_CHECK_CLOSE(sketch.GetMin(), 0.25, 1);
+	BOOST_CHECK_CLOSE(sketch.GetMax(), 2, 1);
+	BOOST_CHECK_CLOSE(sketch.GetAvg(), 1.125, 1e-6);
+
+	/* E.g. check results with their end before their start due to a clock going backwards. */
+	sketch.Add(-1);
+
+	BOOST_CHECK_LE(sketch.GetMin(), sketch.GetAvg());
+	BOOST_CHECK_GE(sketch.GetMax(), sketch.GetAvg());
+}
+
+BOOST_AUTO_TEST_CASE(duration_sketch_bounds)
+{
+	DurationSketch sketch;
+
+	/* All values are the same, so the approximations must not differ from the average. */
+	for (int i = 0; i < 3; i++) {
+		sketch.Add(0.123);
+	}
+
+	BOOST_CHECK_LE(sketch.GetMin(), sketch.GetAvg());
+	BOOST_CHECK_GE(sketch.GetMax(), sketch.GetAvg());
+	BOOST_CHECK_CLOSE(sketch.GetMin(), 0.123, 1);
+	BOOST_CHECK_CLOSE(sketch.GetMax(), 0.123, 1);
+
+	sketch.Add(1e12);
+
+	BOOST_CHECK_GT(sketch.GetMax(), 1e7);
+}
+
+static CheckResult::Ptr MakeCheckResult(ServiceState state)
+{
+	CheckResult::Ptr cr = new CheckResult();
+
+	cr->SetState(state);
+
+	double now = Utility::GetTime();
+	cr->SetScheduleStart(now - 1);
+	cr->SetScheduleEnd(now);
+	cr->SetExecutionStart(now - 0.5);
+	cr->SetExecutionEnd(now);
+
+	return cr;
+}
+
+/**
+ * Compares what the given hosts and services changed in the incremental statistics with a full scan of them,
+ * the way the statistics used to be calculated.
+ */
+static void CheckStatistics(const HostStatistics& hostsBefore, const ServiceStatistics& servicesBefore,
+	const std::vector<Host::Ptr>& hosts, const std::vector<Service::Ptr>& services)
+{
+	HostStatistics hs = {};
+
+	for (auto& host : hosts) {
+		if (!host->IsActive())
+			continue;
+
+		if (host->IsReachable()) {
+			if (host->GetState() == HostUp)
+				hs.hosts_up++;
+			if (host->GetState() == HostDown)
+				hs.hosts_down++;
+		} else
+			hs.hosts_unreachable++;
+
+		if (!host->GetLastCheckResult())
+			hs.hosts_pending++;
+
+		if (host->IsFlapping())
+			hs.hosts_flapping++;
+		if (host->IsInDowntime())
+			hs.hosts_in_downtime++;
+		if (host->IsAcknowledged())
+			hs.hosts_acknowledged++;
+
+		if (host->GetHandled())
+			hs.hosts_handled++;
+		if (host->GetProblem())
+			hs.hosts_problem++;
+	}
+
+	ServiceStatistics ss = {};
+
+	for (auto& service : services) {
+		if (!service->IsActive())
+			continue;
+
+		if (service->GetState() == ServiceOK)
+			ss.services_ok++;
+		if (service->GetState() == ServiceWarning)
+			ss.services_warning++;
+		if (service->GetState() == ServiceCritical)
+			ss.services_critical++;
+		if (service->GetState() == ServiceUnknown)
+			ss.services_unknown++;
+
+		if (!service->GetLastCheckResult())
+			ss.services_pending++;
+
+		if (!service->IsReachable())
+			ss.services_unreachable++;
+
+		if (service->IsFlapping())
+			ss.services_flapping++;
+		if (service->IsInDowntime())
+			ss.services_in_downtime++;
+		if (service->IsAcknowledged())
+			ss.services_acknowledged++;
+
+		if (service->GetHandled())
+			ss.services_handled++;
+		if (service->GetProblem())
+			ss.services_problem++;
+	}
+
+	auto hosts (CIB::CalculateHostStats());
+
+	BOOST_CHECK_EQUAL(hosts.hosts_up - hostsBefore.hosts_up, hs.hosts_up);
+	BOOST_CHECK_EQUAL(hosts.hosts_down - hostsBefore.hosts_down, hs.hosts_down);
+	BOOST_CHECK_EQUAL(hosts.hosts_unreachable - hostsBefore.hosts_unreachable, hs.hosts_unreachable);
+	BOOST_CHECK_EQUAL(hosts.hosts_pending - hostsBefore.hosts_pending, hs.hosts_pending);
+	BOOST_CHECK_EQUAL(hosts.hosts_flapping - hostsBefore.hosts_flapping, hs.hosts_flapping);
+	BOOST_CHECK_EQUAL(hosts.hosts_in_downtime - hostsBefore.hosts_in_downtime, hs.hosts_in_downtime);
+	BOOST_CHECK_EQUAL(hosts.hosts_acknowledged - hostsBefore.hosts_acknowledged, hs.hosts_acknowledged);
+	BOOST_CHECK_EQUAL(hosts.hosts_handled - hostsBefore.hosts_handled, hs.hosts_handled);
+	BOOST_CHECK_EQUAL(hosts.hosts_problem - hostsBefore.hosts_problem, hs.hosts_problem);
+
+	auto services (CIB::CalculateServiceStats());
+
+	BOOST_CHECK_EQUAL(services.services_ok - servicesBefore.services_ok, ss.services_ok);
+	BOOST_CHECK_EQUAL(services.services_warning - servicesBefore.services_warning, ss.services_warning);
+	BOOST_CHECK_EQUAL(services.services_critical - servicesBefore.services_critical, ss.services_critical);
+	BOOST_CHECK_EQUAL(services.services_unknown - servicesBefore.services_unknown, ss.services_unknown);
+	BOOST_CHECK_EQUAL(services.services_pending - servicesBefore.services_pending, ss.services_pending);
+	BOOST_CHECK_EQUAL(services.services_unreachable - servicesBefore.services_unreachable, ss.services_unreachable);
+	BOOST_CHECK_EQUAL(services.services_flapping - servicesBefore.services_flapping, ss.services_flapping);
+	BOOST_CHECK_EQUAL(services.services_in_downtime - servicesBefore.services_in_downtime, ss.services_in_downtime);
+	BOOST_CHECK_EQUAL(services.services_acknowledged - servicesBefore.services_acknowledged, ss.services_acknowledged);
+	BOOST_CHECK_EQUAL(services.services_handled - servicesBefore.services_handled, ss.services_handled);
+	BOOST_CHECK_EQUAL(services.services_problem - servicesBefore.services_problem, ss.services_problem);
+}
+
+BOOST_AUTO_TEST_CASE(incremental_statistics)
+{
+	auto hostsBefore (CIB::CalculateHostStats());
+	auto servicesBefore (CIB::CalculateServiceStats());
+
+	auto createHost ([](const String& name) {
+		Host::Ptr host = new Host();
+		host->SetName(name);
+		host->PushDependencyGroupsToRegistry();
+		host->SetActive(true);
+		host->SetMaxCheckAttempts(1);
+		host->Activate();
+		host->SetAuthority(true);
+		host->Register();
+		return host;
+	});
+
+	Host::Ptr parent (createHost("cib_incremental_parent"));
+	Host::Ptr child (createHost("cib_incremental_child"));
+
+	Dependency::Ptr dep = new Dependency();
+	dep->SetParent(parent);
+	dep->SetChild(child);
+	dep->SetName(child->GetName() + "!" + parent->GetName());
+	dep->SetStateFilter(StateFilterUp);
+	child->AddDependency(dep);
+	parent->AddReverseDependency(dep);
+
+	Service::Ptr service = new Service();
+	service->SetHostName(parent->GetName());
+	service->SetName("cib_incremental_service");
+	service->SetActive(true);
+	service->SetMaxCheckAttempts(1);
+	service->Activate();
+	service->SetAuthority(true);
+	service->Register();
+
+	parent->OnAllConfigLoaded();
+	child->OnAllConfigLoaded();
+	service->OnAllConfigLoaded();
+
+	std::vector<Host::Ptr> hosts { parent, child };
+	std::vector<Service::Ptr> services { service };
+
+	BOOST_TEST_MESSAGE("pending");
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	BOOST_TEST_MESSAGE("check results");
+	parent->ProcessCheckResult(MakeCheckResult(ServiceOK), new StoppableWaitGroup());
+	child->ProcessCheckResult(MakeCheckResult(ServiceCritical), new StoppableWaitGroup());
+	service->ProcessCheckResult(MakeCheckResult(ServiceWarning), new StoppableWaitGroup());
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	BOOST_TEST_MESSAGE("acknowledgement");
+	child->AcknowledgeProblem("cib", "", AcknowledgementNormal, false, false, Utility::GetTime());
+	service->AcknowledgeProblem("cib", "", AcknowledgementSticky, false, false, Utility::GetTime());
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	child->ClearAcknowledgement("cib", Utility::GetTime());
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	BOOST_TEST_MESSAGE("downtime start");
+	Downtime::Ptr downtime = new Downtime();
+	downtime->SetHostName(parent->GetName());
+	downtime->SetServiceName(service->GetName());
+	downtime->SetName("cib_incremental_downtime");
+	downtime->SetFixed(true);
+	downtime->SetStartTime(Utility::GetTime() - 3600);
+	downtime->SetEndTime(Utility::GetTime() + 3600);
+	downtime->Register();
+	downtime->OnAllConfigLoaded();
+	downtime->Activate();
+
+	BOOST_CHECK(service->IsInDowntime());
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	BOOST_TEST_MESSAGE("reachability");
+	parent->ProcessCheckResult(MakeCheckResult(ServiceCritical), new StoppableWaitGroup());
+
+	BOOST_CHECK(!child->IsReachable());
+	BOOST_CHECK(!service->IsReachable());
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	parent->ProcessCheckResult(MakeCheckResult(ServiceOK), new StoppableWaitGroup());
+
+	BOOST_CHECK(child->IsReachable());
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	BOOST_TEST_MESSAGE("downtime removal");
+	downtime->Deactivate(true);
+	downtime->Unregister();
+
+	BOOST_CHECK(!service->IsInDowntime());
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	BOOST_TEST_MESSAGE("deactivation");
+	service->Deactivate();
+	child->Deactivate();
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	parent->Deactivate();
+	CheckStatistics(hostsBefore, servicesBefore, hosts, services);
+
+	service->Unregister();
+	child->Unregister();
+	parent->Unregister();
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_updates)
+{
+	auto hostsBefore (CIB::CalculateHostStats());
+	auto servicesBefore (CIB::CalculateServiceStats());
+
+	Host::Ptr host = new Host();
+	host->SetActive(true);
+	host->SetMaxCheckAttempts(1);
+	host->Activate();
+	host->SetAuthority(true);
+
+	/* E.g. the host's acknowledgement being set and cleared while it processes check results. */
+	std::vector<std::thread> threads;
+
+	threads.emplace_back([&host]() {
+		for (int i = 0; i < 500; i++) {
+			host->ProcessCheckResult(MakeCheckResult(i % 2 ? ServiceOK : ServiceCritical), new StoppableWaitGroup());
+		}
+	});
+
+	for (int i = 0; i < 3; i++) {
+		threads.emplace_back([&host]() {
+			for (int j = 0; j < 2000; j++) {
+				CIB::UpdateCheckable(host);
+			}
+		});
+	}
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	/* Whichever update finished last, the statistics must not be stuck with an older state. */
+	BOOST_CHECK_EQUAL(host->GetState(), HostUp);
+	CheckStatistics(hostsBefore, servicesBefore, { host }, {});
+
+	host->Deactivate();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -164,6 +164,79 @@ BOOST_AUTO_TEST_CASE(multi_parent)
 	BOOST_CHECK(childHost->IsReachable() == false);
 }
 
+BOOST_AUTO_TEST_CASE(materialized_reachability)
+{
+	/* Only the reachability of active checkables is materialized, as only they emit change signals. */
+	Host::Ptr grandParent(CreateHost("materializedGrandParent"));
+	Host::Ptr parent(CreateHost("materializedParent"));
+	Host::Ptr child(CreateHost("materializedChild"));
+
+	for (auto& host : {grandParent, parent, child}) {
+		host->SetActive(true);
+		host->SetStateRaw(ServiceOK);
+		host->SetStateType(StateTypeHard);
+		host->SetLastCheckResult(new CheckResult());
+	}
+
+	Dependency::Ptr dep1(CreateDependency(grandParent, parent, "dep1"));
+	dep1->SetStateFilter(StateFilterUp);
+	RegisterDependency(dep1, "");
+
+	Dependency::Ptr dep2(CreateDependency(parent, child, "dep2"));
+	dep2->SetStateFilter(StateFilterUp);
+	RegisterDependency(dep2, "");
+
+	auto assertReachable = [](const Checkable::Ptr& checkable, bool expected) {
+		BOOST_CHECK_MESSAGE(
+			checkable->IsReachable() == expected,
+			"Checkable '" << checkable->GetName() << "' should be " << (expected ? "reachable" : "unreachable")
+		);
+		BOOST_CHECK_MESSAGE(
+			DependencyStateChecker(DependencyState, false).IsReachable(checkable) == expected,
+			"Full evaluation of checkable '" << checkable->GetName() << "' differs from the materialized one"
+		);
+	};
+
+	assertReachable(child, true);
+	assertReachable(parent, true);
+
+	// Check results which don't change the state must not invalidate anything.
+	auto generation(DependencyStateChecker::GetGeneration(child.get()));
+	grandParent->SetLastCheckResult(new CheckResult());
+	BOOST_CHECK_EQUAL(generation, DependencyStateChecker::GetGeneration(child.get()));
+	assertReachable(child, true);
+
+	// A state change of the grandparent has to be propagated down to the grandchild.
+	grandParent->SetStateRaw(ServiceCritical);
+	BOOST_CHECK_LT(generation, DependencyStateChecker::GetGeneration(child.get()));
+	assertReachable(parent, false);
+	assertReachable(child, false);
+
+	grandParent->SetStateType(StateTypeSoft);
+	assertReachable(child, true);
+
+	grandParent->SetStateType(StateTypeHard);
+	assertReachable(child, false);
+
+	grandParent->SetStateRaw(ServiceOK);
+	assertReachable(child, true);
+
+	// Dependencies changed at runtime have to be taken into account as well.
+	grandParent->SetStateRaw(ServiceCritical);
+	assertReachable(child, false);
+	parent->RemoveDependency(dep1);
+	assertReachable(parent, true);
+	assertReachable(child, true);
+
+	RegisterDependency(dep1, "");
+	assertReachable(child, false);
+
+	// Deactivated checkables don't use outdated materialized results anymore.
+	child->SetActive(false);
+	grandParent->SetStateRaw(ServiceOK);
+	assertReachable(child, true);
+}
+
 BOOST_AUTO_TEST_CASE(push_dependency_groups_to_registry)
 {
 	Checkable::Ptr childHostC(CreateHost("C", false));
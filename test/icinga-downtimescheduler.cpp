@@ -0,0 +1,187 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "icinga/downtimescheduler.hpp"
+#include "base/timer.hpp"
+#include "base/utility.hpp"
+#include <BoostTestTargetConfig.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(icinga_downtimescheduler)
+
+BOOST_AUTO_TEST_CASE(pop_due)
+{
+	DowntimeScheduler scheduler;
+	Downtime::Ptr first = new Downtime();
+	Downtime::Ptr second = new Downtime();
+
+	scheduler.Schedule(second, DowntimeEventType::Expire, 300);
+	scheduler.Schedule(first, DowntimeEventType::Start, 100);
+	scheduler.Schedule(first, DowntimeEventType::Expire, 200);
+
+	BOOST_CHECK_EQUAL(scheduler.GetSize(), 3);
+	BOOST_CHECK_EQUAL(scheduler.GetNextDue(), 100);
+	BOOST_CHECK(scheduler.PopDue(99).empty());
+
+	auto due (scheduler.PopDue(200));
+
+	BOOST_REQUIRE_EQUAL(due.size(), 2);
+	BOOST_CHECK(due[0].Object == first && due[0].Type == DowntimeEventType::Start);
+	BOOST_CHECK(due[1].Object == first && due[1].Type == DowntimeEventType::Expire);
+
+	BOOST_CHECK_EQUAL(scheduler.GetSize(), 1);
+	BOOST_CHECK_EQUAL(scheduler.GetNextDue(), 300);
+
+	BOOST_CHECK_EQUAL(scheduler.PopDue(1000).size(), 1);
+	BOOST_CHECK_EQUAL(scheduler.GetNextDue(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(reschedule)
+{
+	DowntimeScheduler scheduler;
+	Downtime::Ptr downtime = new Downtime();
+
+	/* E.g. a flexible downtime which has been triggered expires earlier than its end time. */
+	scheduler.Schedule(downtime, DowntimeEventType::Expire, 500);
+	scheduler.Schedule(downtime, DowntimeEventType::Expire, 200);
+
+	BOOST_CHECK_EQUAL(scheduler.GetSize(), 1);
+	BOOST_CHECK_EQUAL(scheduler.GetNextDue(), 200);
+
+	scheduler.Schedule(downtime, DowntimeEventType::Start, 100);
+	scheduler.Unschedule(downtime, DowntimeEventType::Expire);
+
+	BOOST_CHECK_EQUAL(scheduler.GetSize(), 1);
+
+	scheduler.Schedule(downtime, DowntimeEventType::Expire, 200);
+	scheduler.Unschedule(downtime);
+
+	BOOST_CHECK_EQUAL(scheduler.GetSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(batch)
+{
+	DowntimeScheduler scheduler;
+	Downtime::Ptr kept = new Downtime();
+	Downtime::Ptr removed = new Downtime();
+
+	{
+		DowntimeScheduler::Batch batch (scheduler);
+
+		{
+			DowntimeScheduler::Batch nested (scheduler);
+
+			scheduler.Schedule(kept, DowntimeEventType::Expire, 100);
+			scheduler.Schedule(removed, DowntimeEventType::Expire, 100);
+		}
+
+		/* Nested batches are merged into the outer one. */
+		BOOST_CHECK_EQUAL(scheduler.GetSize(), 0);
+
+		scheduler.Schedule(kept, DowntimeEventType::Expire, 200);
+		scheduler.Unschedule(removed);
+
+		BOOST_CHECK_EQUAL(scheduler.GetSize(), 0);
+	}
+
+	BOOST_CHECK_EQUAL(scheduler.GetSize(), 1);
+	BOOST_CHECK_EQUAL(scheduler.GetNextDue(), 200);
+
+	{
+		/* Batches of other schedulers don't matter. */
+		DowntimeScheduler other;
+		DowntimeScheduler::Batch batch (other);
+
+		scheduler.Schedule(removed, DowntimeEventType::Start, 50);
+
+		BOOST_CHECK_EQUAL(scheduler.GetSize(), 2);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(burst_benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	/* A weekly maintenance window of a lot of hosts. */
+	const size_t count = 200000;
+	const double begin = 1735689600; // 2025-01-01 00:00:00 UTC
+	const double end = begin + 2 * 3600;
+
+	std::vector<Downtime::Ptr> downtimes;
+
+	for (size_t i = 0; i < count; i++) {
+		downtimes.emplace_back(new Downtime());
+	}
+
+	using ms = std::chrono::duration<double, std::milli>;
+
+	{
+		/* What the cleanup timers of all downtimes used to do. */
+		std::vector<Timer::Ptr> timers;
+
+		auto start (std::chrono::steady_clock::now());
+
+		for (size_t i = 0; i < count; i++) {
+			auto timer (Timer::Create());
+			timer->Reschedule(Utility::GetTime() + 86400 + i % 60);
+			timer->Start();
+			timers.emplace_back(std::move(timer));
+		}
+
+		auto created (std::chrono::steady_clock::now());
+
+		for (auto& timer : timers) {
+			timer->Stop();
+		}
+
+		timers.clear();
+
+		auto stopped (std::chrono::steady_clock::now());
+
+		std::cout << "timers: " << ms(created - start).count() << " ms to start, "
+			<< ms(stopped - created).count() << " ms to stop (" << count << " downtimes)" << std::endl;
+	}
+
+	for (bool batched : { false, true }) {
+		DowntimeScheduler scheduler;
+
+		auto start (std::chrono::steady_clock::now());
+
+		{
+			std::unique_ptr<DowntimeScheduler::Batch> batch;
+
+			if (batched) {
+				batch.reset(new DowntimeScheduler::Batch(scheduler));
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				scheduler.Schedule(downtimes[i], DowntimeEventType::Start, begin);
+				scheduler.Schedule(downtimes[i], DowntimeEventType::Expire, end + i % 60);
+			}
+		}
+
+		auto scheduled (std::chrono::steady_clock::now());
+
+		size_t started = scheduler.PopDue(begin).size();
+		size_t expired = 0;
+
+		for (double now = end; now < end + 60; now++) {
+			expired += scheduler.PopDue(now).size();
+		}
+
+		auto popped (std::chrono::steady_clock::now());
+
+		BOOST_CHECK_EQUAL(started, count);
+		BOOST_CHECK_EQUAL(expired, count);
+
+		std::cout << (batched ? "batched" : "single") << " events: " << ms(scheduled - start).count()
+			<< " ms to schedule, " << ms(popped - scheduled).count() << " ms to start and expire ("
+			<< count << " downtimes)" << std::endl;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
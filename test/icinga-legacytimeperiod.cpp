@@ -1,6 +1,7 @@
 // SPDX-FileCopyrightText: 2012 Icinga GmbH <https://icinga.com>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include "base/objectlock.hpp"
 #include "base/utility.hpp"
 #include "icinga/legacytimeperiod.hpp"
 #include "test/utils.hpp"
@@ -10,7 +11,9 @@
 #include <boost/date_time/gregorian/conversion.hpp>
 #include <boost/date_time/date.hpp>
 #include <boost/optional.hpp>
+#include <chrono>
 #include <iomanip>
+#include <iostream>
 #include <BoostTestTargetConfig.h>
 
 using namespace icinga;
@@ -344,15 +347,16 @@ BOOST_AUTO_TEST_CASE(include_exclude_timeperiods)
 		// The updated region is 2024-06-11 - 13, so there should be 3 segements, when the *prefer* includes works correctly.
 		BOOST_REQUIRE_EQUAL(3, segments->GetLength());
 
-		Dictionary::Ptr segment = segments->Get(0);
+		// The segments are sorted by their begin.
+		Dictionary::Ptr segment = segments->Get(1);
 		BOOST_CHECK_EQUAL(1718182800, segment->Get("begin")); // 2024-06-12 09:00:00 UTC
 		BOOST_CHECK_EQUAL(1718211600, segment->Get("end")); // 2024-06-12 17:00:00 UTC
 
-		segment = segments->Get(1);
+		segment = segments->Get(2);
 		BOOST_CHECK_EQUAL(1718269200, segment->Get("begin")); // 2024-06-13 09:00:00 UTC
 		BOOST_CHECK_EQUAL(1718298000, segment->Get("end")); // 2024-06-13 17:00:00 UTC
 
-		segment = segments->Get(2);
+		segment = segments->Get(0);
 		BOOST_CHECK_EQUAL(1718092800, segment->Get("begin")); // 2024-06-11 08:00:00 UTC
 		BOOST_CHECK_EQUAL(1718125200, segment->Get("end")); // 2024-06-11 17:00:00 UTC
 
@@ -363,6 +367,148 @@ BOOST_AUTO_TEST_CASE(include_exclude_timeperiods)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(segments)
+{
+	Array::Ptr segments = new Array({
+		new Dictionary({{"begin", 500}, {"end", 600}}),
+		new Dictionary({{"begin", 100}, {"end", 200}}),
+		new Dictionary({{"begin", 150}, {"end", 250}}),
+		new Dictionary({{"begin", 250}, {"end", 300}}),
+		new Dictionary({{"begin", 400}, {"end", 400}})
+	});
+
+	TimePeriod::Ptr tp = new TimePeriod();
+	tp->SetUpdate(new Function("Segments", [segments](const std::vector<Value>&) -> Value { return segments; }), true);
+	tp->UpdateRegion(0, 1000, true);
+
+	// Overlapping and adjacent segments are merged, empty ones dropped and the rest is sorted.
+	Array::Ptr serialized = tp->GetSegments();
+	{
+		BOOST_REQUIRE_EQUAL(2, serialized->GetLength());
+
+		Dictionary::Ptr segment = serialized->Get(0);
+		BOOST_CHECK_EQUAL(100, segment->Get("begin"));
+		BOOST_CHECK_EQUAL(300, segment->Get("end"));
+
+		segment = serialized->Get(1);
+		BOOST_CHECK_EQUAL(500, segment->Get("begin"));
+		BOOST_CHECK_EQUAL(600, segment->Get("end"));
+	}
+
+	// The dictionary form is only built again once the segments change.
+	BOOST_CHECK_EQUAL(serialized, tp->GetSegments());
+
+	BOOST_CHECK_EQUAL(false, tp->IsInside(99));
+	BOOST_CHECK_EQUAL(true, tp->IsInside(100));
+	BOOST_CHECK_EQUAL(true, tp->IsInside(299.5));
+	BOOST_CHECK_EQUAL(false, tp->IsInside(300));
+	BOOST_CHECK_EQUAL(false, tp->IsInside(400));
+	BOOST_CHECK_EQUAL(true, tp->IsInside(500));
+	BOOST_CHECK_EQUAL(false, tp->IsInside(600));
+	BOOST_CHECK_EQUAL(true, tp->IsInside(1001)); // Outside of the valid region
+
+	BOOST_CHECK_EQUAL(100, tp->FindNextTransition(0));
+	BOOST_CHECK_EQUAL(300, tp->FindNextTransition(100));
+	BOOST_CHECK_EQUAL(500, tp->FindNextTransition(300));
+	BOOST_CHECK_EQUAL(600, tp->FindNextTransition(550));
+	BOOST_CHECK_EQUAL(-1, tp->FindNextTransition(600));
+
+	// Excluding a time period may split a segment.
+	TimePeriod::Ptr excludedTp = new TimePeriod();
+	excludedTp->SetName("segments-excluded", true);
+	excludedTp->SetUpdate(new Function("Segments", [](const std::vector<Value>&) -> Value {
+		return new Array({ new Dictionary({{"begin", 150}, {"end", 160}}) });
+	}), true);
+	excludedTp->UpdateRegion(0, 1000, true);
+	excludedTp->Register();
+
+	tp->SetExcludes(new Array({"segments-excluded"}), true);
+	tp->UpdateRegion(0, 1000, true);
+
+	BOOST_CHECK_NE(serialized, tp->GetSegments());
+	BOOST_CHECK_EQUAL(3, tp->GetSegments()->GetLength());
+	BOOST_CHECK_EQUAL(true, tp->IsInside(149));
+	BOOST_CHECK_EQUAL(false, tp->IsInside(150));
+	BOOST_CHECK_EQUAL(true, tp->IsInside(160));
+	BOOST_CHECK_EQUAL(160, tp->FindNextTransition(150));
+
+	// Restored segments, e.g. from the state file, are merged and sorted as well.
+	tp->SetSegments(new Array({
+		new Dictionary({{"begin", 700}, {"end", 800}}),
+		new Dictionary({{"begin", 100}, {"end", 200}}),
+		new Dictionary({{"begin", 150}, {"end", 300}})
+	}), true);
+
+	BOOST_CHECK_EQUAL(2, tp->GetSegments()->GetLength());
+	BOOST_CHECK_EQUAL(true, tp->IsInside(250));
+	BOOST_CHECK_EQUAL(false, tp->IsInside(500));
+	BOOST_CHECK_EQUAL(true, tp->IsInside(750));
+}
+
+BOOST_AUTO_TEST_CASE(isinside_benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	/* Office hours plus a lot of single days, e.g. holidays and on-call duties. */
+	Dictionary::Ptr ranges = new Dictionary({
+		{"monday", "08:00-12:00,13:00-17:00"},
+		{"tuesday", "08:00-12:00,13:00-17:00"},
+		{"wednesday", "08:00-12:00,13:00-17:00"},
+		{"thursday", "08:00-12:00,13:00-17:00"},
+		{"friday", "08:00-12:00,13:00-17:00"}
+	});
+
+	const double begin = 1735689600; // 2025-01-01 00:00:00 UTC
+	const double end = begin + 90 * 24 * 3600;
+
+	for (double day = begin; day < end; day += 2 * 24 * 3600) {
+		ranges->Set(Utility::FormatDateTime("%Y-%m-%d", day), "06:00-07:00,18:00-22:00");
+	}
+
+	TimePeriod::Ptr tp = new TimePeriod();
+	tp->SetUpdate(new Function("LegacyTimePeriod", LegacyTimePeriod::ScriptFunc, {"tp", "begin", "end"}), true);
+	tp->SetRanges(ranges, true);
+	tp->UpdateRegion(begin, end, true);
+
+	Array::Ptr segments = tp->GetSegments();
+
+	const int count = 100000;
+	size_t scanned = 0, searched = 0;
+
+	auto start (std::chrono::steady_clock::now());
+
+	/* What IsInside() used to do. */
+	for (int i = 0; i < count; i++) {
+		double ts = begin + (end - begin) * i / count;
+
+		ObjectLock olock(tp);
+		ObjectLock dlock(segments);
+
+		for (Dictionary::Ptr segment : segments) {
+			if (ts >= segment->Get("begin") && ts < segment->Get("end")) {
+				scanned++;
+				break;
+			}
+		}
+	}
+
+	auto scannedDone (std::chrono::steady_clock::now());
+
+	for (int i = 0; i < count; i++) {
+		searched += tp->IsInside(begin + (end - begin) * i / count);
+	}
+
+	auto searchedDone (std::chrono::steady_clock::now());
+
+	BOOST_CHECK_EQUAL(scanned, searched);
+
+	using ms = std::chrono::duration<double, std::milli>;
+
+	std::cout << "linear scan: " << ms(scannedDone - start).count() << " ms, binary search: "
+		<< ms(searchedDone - scannedDone).count() << " ms (" << count << " lookups, "
+		<< segments->GetLength() << " segments)" << std::endl;
+}
+
 struct DateTime
 {
 	struct {
@@ -743,6 +889,169 @@ BOOST_AUTO_TEST_CASE(dst_isinside)
 	}
 }
 
+/* What LegacyTimePeriod::ScriptFunc() used to do before the ranges have been compiled. */
+static Array::Ptr ParseRangesPerDay(const Dictionary::Ptr& ranges, double begin, double end)
+{
+	Array::Ptr segments = new Array();
+
+	tm reference = Utility::LocalTime(begin);
+	reference.tm_hour = 0;
+	reference.tm_min = 0;
+	reference.tm_sec = 0;
+	reference.tm_isdst = -1;
+
+	while (Utility::TmToTimestamp(&reference) <= end) {
+		ObjectLock olock(ranges);
+		for (const Dictionary::Pair& kv : ranges) {
+			if (LegacyTimePeriod::IsInDayDefinition(kv.first, &reference)) {
+				LegacyTimePeriod::ProcessTimeRanges(kv.second, &reference, segments);
+			}
+		}
+
+		reference.tm_mday++;
+		reference.tm_isdst = -1;
+		Utility::NormalizeTm(&reference);
+		reference.tm_isdst = -1;
+	}
+
+	return segments;
+}
+
+static void CheckCompiledRanges(const TimePeriod::Ptr& tp, double begin, double end)
+{
+	Array::Ptr expected = ParseRangesPerDay(tp->GetRanges(), begin, end);
+	Array::Ptr actual = LegacyTimePeriod::ScriptFunc(tp, begin, end);
+
+	BOOST_REQUIRE_EQUAL(expected->GetLength(), actual->GetLength());
+
+	for (decltype(expected->GetLength()) i = 0; i < expected->GetLength(); i++) {
+		Dictionary::Ptr e = expected->Get(i);
+		Dictionary::Ptr a = actual->Get(i);
+
+		BOOST_CHECK_MESSAGE(e->Get("begin") == a->Get("begin") && e->Get("end") == a->Get("end"),
+			"segment " << i << " of " << pretty_time(begin) << " .. " << pretty_time(end) << ": expected "
+			<< e->Get("begin") << " .. " << e->Get("end") << ", got " << a->Get("begin") << " .. " << a->Get("end"));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(compiled_ranges)
+{
+	std::vector<Dictionary::Ptr> allRanges {
+		new Dictionary({
+			{"monday - friday", "08:00-12:00,13:00-17:00"},
+			{"saturday", "22:00-02:00"},
+			{"sunday", "00:00-24:00"}
+		}),
+		new Dictionary({
+			{"monday 1", "10:00-11:00"},
+			{"friday -1", "12:15:30-12:23:43,16:00-18:00"},
+			{"sunday -1 march", "01:00-03:30"},
+			{"sunday 1 november", "00:00-24:00"}
+		}),
+		new Dictionary({
+			{"day 1", "00:00-24:00"},
+			{"day -1", "02:00-03:00"},
+			{"day 1 - 15", "09:00-10:00"},
+			{"day -5 - -1", "11:00-12:00"}
+		}),
+		new Dictionary({
+			{"january 1", "00:00-24:00"},
+			{"february -1", "00:00-24:00"},
+			{"march 10 - 20", "01:30-02:30"},
+			{"june 3 - 7", "00:00-24:00"}
+		}),
+		new Dictionary({
+			{"2021-03-14", "00:00-24:00"},
+			{"2021-11-07", "01:00-02:00"},
+			{"2021-10-20 - 2021-11-10 / 3", "05:00-06:00"},
+			{"monday - friday / 2", "07:00-08:00"},
+			{"day 2 - 20 / 5", "00:00-01:00"}
+		}),
+		new Dictionary({
+			{"wednesday 1 - friday 2", "14:00-15:00"},
+			{"thursday - sunday", "23:00-01:00"}
+		})
+	};
+
+	const double begin = 1609459200; // 2021-01-01 00:00:00 UTC
+	const double end = begin + 366 * 24 * 3600;
+
+	for (auto& ranges : allRanges) {
+		TimePeriod::Ptr tp = new TimePeriod();
+		tp->SetRanges(ranges, true);
+
+		/* Evaluate every day twice per timezone, so that the memoized days are compared too. */
+		for (int pass = 0; pass < 2; pass++) {
+			for (const char *timezone : {"UTC", GlobalTimezoneFixture::TestTimezoneWithDST}) {
+				GlobalTimezoneFixture tz(timezone);
+
+				for (double day = begin; day < end; day += 24 * 3600 + 7 * 3600) {
+					CheckCompiledRanges(tp, day, day + 2 * 24 * 3600);
+				}
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(compiled_ranges_replaced)
+{
+	TimePeriod::Ptr tp = new TimePeriod();
+	tp->SetRanges(new Dictionary({{"2024-06-12", "10:00-12:00"}}), true);
+
+	BOOST_CHECK_EQUAL(1, LegacyTimePeriod::ScriptFunc(tp, 1718150400, 1718236800)->GetLength()); // 2024-06-12 UTC
+
+	tp->SetRanges(new Dictionary({{"2024-06-12", "10:00-12:00,14:00-16:00"}}), true);
+
+	BOOST_CHECK_EQUAL(2, LegacyTimePeriod::ScriptFunc(tp, 1718150400, 1718236800)->GetLength());
+
+	tp->SetRanges(new Dictionary({{"2024-06-12", "invalid"}}), true);
+
+	BOOST_CHECK_THROW(LegacyTimePeriod::ScriptFunc(tp, 1718150400, 1718236800), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(compiled_validation)
+{
+	tm reference = Utility::LocalTime(1718150400); // 2024-06-12 UTC
+
+	/* The day definitions and time ranges have to be rejected exactly if the string based parser rejects them. */
+	for (const char *daydef : {"monday", "monday - friday", "monday - friday / 2", "day 1 - 15", "day -5 - -1",
+		"january 1", "march 10 - 20", "sunday -1 march", "2021-10-20 - 2021-11-10 / 3", "friday 2 - monday 1",
+		"someday", "day x", "2015-12-32", "2015-28-01", "monday 1 smarch", "monday / x", "", "monday - someday"}) {
+		bool valid = true;
+
+		try {
+			tm begin, end;
+			int stride;
+			LegacyTimePeriod::ParseTimeRange(daydef, &begin, &end, &stride, &reference);
+		} catch (const std::exception&) {
+			valid = false;
+		}
+
+		if (valid) {
+			BOOST_CHECK_NO_THROW(LegacyTimeRanges::ValidateDayDefinition(daydef));
+		} else {
+			BOOST_CHECK_THROW(LegacyTimeRanges::ValidateDayDefinition(daydef), std::exception);
+		}
+	}
+
+	for (const char *timeranges : {"08:00-12:00", "08:00-12:00,13:00-17:00", "22:00-02:00", "12:15:30-12:23:43",
+		"00:00-24:00", "08:00", "08-12", "08:00-12:00-13:00", "xx:00-12:00", "08:00-12:00,", "", "1:2:3:4-05:00"}) {
+		bool valid = true;
+
+		try {
+			LegacyTimePeriod::ProcessTimeRanges(timeranges, &reference, new Array());
+		} catch (const std::exception&) {
+			valid = false;
+		}
+
+		if (valid) {
+			BOOST_CHECK_NO_THROW(LegacyTimeRanges::ValidateTimeRanges(timeranges));
+		} else {
+			BOOST_CHECK_THROW(LegacyTimeRanges::ValidateTimeRanges(timeranges), std::exception);
+		}
+	}
+}
+
 BOOST_AUTO_TEST_CASE(find_nth_weekday) {
 	auto run = [](const std::string& refDay, int wday, int n, const std::string& expectedDay) {
 		tm expected = make_tm(expectedDay + " 00:00:00");
@@ -2,7 +2,12 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "icinga/macroprocessor.hpp"
+#include "icinga/checkcommand.hpp"
+#include "base/scriptframe.hpp"
+#include "config/configcompiler.hpp"
 #include <BoostTestTargetConfig.h>
+#include <chrono>
+#include <iostream>
 
 using namespace icinga;
 
@@ -48,4 +53,190 @@ BOOST_AUTO_TEST_CASE(simple)
 
 }
 
+BOOST_AUTO_TEST_CASE(templates)
+{
+	Dictionary::Ptr macros = new Dictionary({
+		{ "a", "x" },
+		{ "b", 2 },
+		{ "arr", new Array({ 1, "y" }) },
+		{ "vars", new Dictionary({ { "nested", "<$macros.a$>" } }) }
+	});
+
+	MacroProcessor::ResolverList resolvers;
+	resolvers.emplace_back("macros", macros);
+
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("no macros", resolvers), "no macros");
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("$$", resolvers), "$");
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("a$$b", resolvers), "a$b");
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("$a$$b$", resolvers), "x2");
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("-$macros.a$-", resolvers), "-x-");
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("[$macros.vars.nested$]", resolvers), "[<x>]");
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("$b$", resolvers), 2);
+
+	Array::Ptr arr = MacroProcessor::ResolveMacros("$arr$", resolvers);
+	BOOST_CHECK_EQUAL(arr->GetLength(), 2);
+
+	BOOST_CHECK_THROW(MacroProcessor::ResolveMacros("x $arr$", resolvers), std::invalid_argument);
+	BOOST_CHECK_THROW(MacroProcessor::ResolveMacros("$a$ $b", resolvers), std::runtime_error);
+
+	String missingMacro;
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("$missing$ $a$", resolvers, nullptr, &missingMacro), " x");
+	BOOST_CHECK_EQUAL(missingMacro, "missing");
+
+	auto escape = [](const Value& value) -> Value { return "'" + value + "'"; };
+	BOOST_CHECK_EQUAL(MacroProcessor::ResolveMacros("$a$ b", resolvers, nullptr, nullptr, escape), "'x' b");
+
+	Array::Ptr resolved = MacroProcessor::ResolveMacros(new Array({ "$a$", "$arr$", 3 }), resolvers);
+	BOOST_CHECK_EQUAL(resolved->Join(" "), "x 1;y 3");
+}
+
+BOOST_AUTO_TEST_CASE(arguments)
+{
+	Dictionary::Ptr macros = new Dictionary({
+		{ "address", "127.0.0.1" },
+		{ "port", 80 },
+		{ "ssl", true },
+		{ "list", new Array({ "a", "b" }) }
+	});
+
+	MacroProcessor::ResolverList resolvers;
+	resolvers.emplace_back("macros", macros);
+
+	Array::Ptr command = new Array({ "check_x" });
+
+	Dictionary::Ptr arguments = new Dictionary({
+		{ "-H", "$address$" },
+		{ "-p", new Dictionary({ { "value", "$port$" }, { "order", -1 } }) },
+		{ "-S", new Dictionary({ { "set_if", "$ssl$" } }) },
+		{ "-N", new Dictionary({ { "set_if", "$nossl$" } }) },
+		{ "-l", new Dictionary({ { "value", "$list$" }, { "repeat_key", false } }) },
+		{ "-w", new Dictionary({ { "value", "$missing$" } }) },
+		{ "--sep", new Dictionary({ { "value", "$port$" }, { "separator", "=" }, { "order", 1 } }) }
+	});
+
+	String expected = "check_x -p 80 -H 127.0.0.1 -S -l a b --sep=80";
+
+	Array::Ptr resolved = MacroProcessor::ResolveArguments(command, arguments, resolvers, nullptr, nullptr, false);
+	BOOST_CHECK_EQUAL(resolved->Join(" "), expected);
+
+	CommandTemplate tmpl (command, arguments);
+
+	for (int i = 0; i < 2; i++) {
+		resolved = MacroProcessor::ResolveArguments(tmpl, resolvers, nullptr, nullptr, false);
+		BOOST_CHECK_EQUAL(resolved->Join(" "), expected);
+	}
+
+	arguments->Set("-w", new Dictionary({ { "value", "$missing$" }, { "required", true } }));
+	BOOST_CHECK_THROW(MacroProcessor::ResolveArguments(CommandTemplate(command, arguments), resolvers, nullptr, nullptr, false), ScriptError);
+}
+
+BOOST_AUTO_TEST_CASE(command_template)
+{
+	CheckCommand::Ptr cmd = new CheckCommand();
+	cmd->SetCommandLine(new Array({ "check_x" }), true);
+	cmd->SetArguments(new Dictionary({ { "-H", "$address$" } }), true);
+
+	auto tmpl (cmd->GetTemplate());
+	BOOST_REQUIRE(tmpl);
+	BOOST_CHECK(cmd->GetTemplate() == tmpl);
+
+	cmd->SetArguments(new Dictionary({ { "-I", "$address$" } }), true);
+
+	auto tmpl2 (cmd->GetTemplate());
+	BOOST_REQUIRE(tmpl2);
+	BOOST_CHECK(tmpl2 != tmpl);
+
+	MacroProcessor::ResolverList resolvers;
+	resolvers.emplace_back("macros", new Dictionary({ { "address", "127.0.0.1" } }));
+
+	Array::Ptr resolved = MacroProcessor::ResolveArguments(*tmpl2, resolvers, nullptr, nullptr, false);
+	BOOST_CHECK_EQUAL(resolved->Join(" "), "check_x -I 127.0.0.1");
+}
+
+BOOST_AUTO_TEST_CASE(benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	/* The command line and arguments of the ITL's CheckCommand "http" (abridged). */
+	std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", R"CONFIG({
+command = [ "/usr/lib/nagios/plugins/check_http" ]
+arguments = {
+	"-H" = { value = "$http_vhost$" }
+	"--extra-opts" = { set_if = {{ string(macro("$http_extra_opts$")) != "" }}; value = "$http_extra_opts$" }
+	"-I" = { set_if = {{ string(macro("$http_address$")) != "" }}; value = "$http_address$" }
+	"-u" = { value = "$http_uri$" }
+	"-p" = { value = "$http_port$" }
+	"-S" = { set_if = "$http_ssl$" }
+	"-S1" = { set_if = "$http_ssl_force_tlsv1$" }
+	"-S1.2" = { set_if = "$http_ssl_force_tlsv1_2$" }
+	"--sni" = { set_if = "$http_sni$" }
+	"-C" = { value = "$http_certificate$" }
+	"-J" = { value = "$http_clientcert$" }
+	"-K" = { value = "$http_privatekey$" }
+	"-a" = { value = "$http_auth_pair$" }
+	"--no-body" = { set_if = "$http_ignore_body$" }
+	"-r" = { value = "$http_expect_body_regex$" }
+	"-w" = { value = "$http_warn_time$" }
+	"-c" = { value = "$http_critical_time$" }
+	"-e" = { value = "$http_expect$" }
+	"-d" = { value = "$http_headerstring$" }
+	"-s" = { value = "$http_string$" }
+	"-P" = { value = "$http_post$" }
+	"-j" = { value = "$http_method$" }
+	"-M" = { value = "$http_maxage$" }
+	"-N" = { set_if = "$http_no_body$" }
+	"-k" = { value = "$http_header$"; repeat_key = true }
+	"-E" = { set_if = "$http_extendedperfdata$" }
+	"-t" = { value = "$http_timeout$" }
+	"-4" = { set_if = "$http_ipv4$" }
+	"-6" = { set_if = "$http_ipv6$" }
+}
+})CONFIG");
+
+	ScriptFrame frame (true);
+	Dictionary::Ptr cmd = expr->Evaluate(frame).GetValue();
+
+	Dictionary::Ptr macros = new Dictionary({
+		{ "http_vhost", "www.example.com" },
+		{ "http_address", "192.0.2.1" },
+		{ "http_uri", "/health" },
+		{ "http_ssl", true },
+		{ "http_sni", true },
+		{ "http_warn_time", 5 },
+		{ "http_critical_time", 10 },
+		{ "http_header", new Array({ "X-A: 1", "X-B: 2" }) }
+	});
+
+	MacroProcessor::ResolverList resolvers;
+	resolvers.emplace_back("host", macros);
+
+	const int count = 100000;
+	size_t uncompiledArgs = 0, compiledArgs = 0;
+
+	auto start (std::chrono::steady_clock::now());
+
+	for (int i = 0; i < count; i++) {
+		Array::Ptr args = MacroProcessor::ResolveArguments(cmd->Get("command"), cmd->Get("arguments"), resolvers, nullptr, nullptr, false);
+		uncompiledArgs += args->GetLength();
+	}
+
+	auto uncompiledDone (std::chrono::steady_clock::now());
+
+	CommandTemplate tmpl (cmd->Get("command"), cmd->Get("arguments"));
+
+	for (int i = 0; i < count; i++) {
+		Array::Ptr args = MacroProcessor::ResolveArguments(tmpl, resolvers, nullptr, nullptr, false);
+		compiledArgs += args->GetLength();
+	}
+
+	auto compiledDone (std::chrono::steady_clock::now());
+
+	BOOST_CHECK_EQUAL(uncompiledArgs, compiledArgs);
+
+	using ms = std::chrono::duration<double, std::milli>;
+
+	std::cout << "uncompiled: " << ms(uncompiledDone - start).count() << " ms, compiled: "
+		<< ms(compiledDone - uncompiledDone).count() << " ms (" << count << " command lines)" << std::endl;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,11 +2,63 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "base/perfdatavalue.hpp"
+#include "base/serializer.hpp"
+#include "icinga/checkresult.hpp"
 #include "icinga/pluginutility.hpp"
 #include <BoostTestTargetConfig.h>
+#include <boost/algorithm/string/trim.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
 
 using namespace icinga;
 
+/* The String::Split() based implementation PluginUtility::ParseCheckOutput() used before it got vectorized. */
+static std::pair<String, String> ReferenceParseCheckOutput(const String& output)
+{
+	String text;
+	String perfdata;
+
+	std::vector<String> lines = output.Split("\r\n");
+
+	for (const String& line : lines) {
+		size_t delim = line.FindFirstOf("|");
+
+		if (!text.IsEmpty())
+			text += "\n";
+
+		if (delim != String::NPos && line.FindFirstOf("=", delim) != String::NPos) {
+			text += line.SubStr(0, delim);
+
+			if (!perfdata.IsEmpty())
+				perfdata += " ";
+
+			perfdata += line.SubStr(delim + 1, line.GetLength());
+		} else {
+			text += line;
+		}
+	}
+
+	boost::algorithm::trim(perfdata);
+
+	return std::make_pair(text, perfdata);
+}
+
+static String GetLongPluginOutput(int interfaces)
+{
+	String output = "OK - " + std::to_string(interfaces) + " interfaces up | interfaces=" + std::to_string(interfaces) + "\n";
+
+	for (int i = 0; i < interfaces; i++) {
+		String iface = "GigabitEthernet0/" + std::to_string(i);
+
+		output += "Interface " + iface + " is up, speed 1 Gbit/s, no errors"
+			" | '" + iface + "::in'=123456789c;;;0 '" + iface + "::out'=987654321c;;;0 "
+			"'" + iface + "::errors'=0c;1;10;0\n";
+	}
+
+	return output;
+}
+
 BOOST_AUTO_TEST_SUITE(icinga_perfdata)
 
 BOOST_AUTO_TEST_CASE(empty)
@@ -436,4 +488,202 @@ BOOST_AUTO_TEST_CASE(parse_edgecases)
 	BOOST_CHECK_EQUAL(pv->GetUnit(), "bytes");
 }
 
+BOOST_AUTO_TEST_CASE(parsed_performance_data)
+{
+	CheckResult::Ptr cr = new CheckResult();
+	BOOST_CHECK(cr->GetParsedPerformanceData()->empty());
+
+	PerfdataValue::Ptr obj = new PerfdataValue("obj", 42, true, "c");
+
+	cr->SetPerformanceData(new Array({ "time=1.5s;1;2;0;10", "invalid", obj, "'a b'=10%" }));
+
+	auto parsed (cr->GetParsedPerformanceData());
+	BOOST_REQUIRE_EQUAL(parsed->size(), 4u);
+
+	auto& time ((*parsed)[0]);
+	PerfdataValue::Ptr expected = PerfdataValue::Parse("time=1.5s;1;2;0;10");
+	BOOST_CHECK(time.Valid);
+	BOOST_CHECK_EQUAL(time.Raw, "time=1.5s;1;2;0;10");
+	BOOST_CHECK_EQUAL(time.Label, expected->GetLabel());
+	BOOST_CHECK_EQUAL(time.Number, expected->GetValue());
+	BOOST_CHECK_EQUAL(time.Unit, expected->GetUnit());
+	BOOST_CHECK_EQUAL(time.Warn, expected->GetWarn());
+	BOOST_CHECK_EQUAL(time.Crit, expected->GetCrit());
+	BOOST_CHECK_EQUAL(time.Min, expected->GetMin());
+	BOOST_CHECK_EQUAL(time.Max, expected->GetMax());
+
+	BOOST_CHECK(!(*parsed)[1].Valid);
+	BOOST_CHECK_EQUAL((*parsed)[1].Raw, "invalid");
+
+	BOOST_CHECK((*parsed)[2].Valid);
+	BOOST_CHECK_EQUAL((*parsed)[2].Label, "obj");
+	BOOST_CHECK_EQUAL((*parsed)[2].Number, 42);
+	BOOST_CHECK((*parsed)[2].Counter);
+	BOOST_CHECK_EQUAL((*parsed)[2].Unit, "c");
+
+	BOOST_CHECK_EQUAL((*parsed)[3].Label, "a b");
+	BOOST_CHECK_EQUAL((*parsed)[3].Unit, "%");
+
+	BOOST_CHECK_EQUAL(cr->GetParsedPerformanceData(), parsed);
+
+	cr->SetPerformanceData(new Array({ "x=1" }));
+
+	auto reparsed (cr->GetParsedPerformanceData());
+	BOOST_CHECK_NE(reparsed, parsed);
+	BOOST_REQUIRE_EQUAL(reparsed->size(), 1u);
+	BOOST_CHECK_EQUAL((*reparsed)[0].Label, "x");
+	BOOST_CHECK_EQUAL(parsed->size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(parsed_performance_data_not_serialized)
+{
+	CheckResult::Ptr cr = new CheckResult();
+	cr->SetPerformanceData(new Array({ "a=1", "b=2" }));
+
+	String before = JsonEncode(Serialize(cr, FAState));
+	cr->GetParsedPerformanceData();
+
+	BOOST_CHECK_EQUAL(JsonEncode(Serialize(cr, FAState)), before);
+}
+
+BOOST_AUTO_TEST_CASE(parsed_performance_data_benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	std::vector<CheckResult::Ptr> results;
+
+	for (int i = 0; i < 10000; i++) {
+		CheckResult::Ptr cr = new CheckResult();
+		cr->SetPerformanceData(PluginUtility::SplitPerfdata(
+			"rta=0.123ms;100;500;0 pl=0%;20;60;0;100 'disk /var'=1234567B;;;0;9999999 load1=0.5;5;10;0 users=3"
+		));
+		results.emplace_back(std::move(cr));
+	}
+
+	/* Like four perfdata writers processing the same check results. */
+	const int writers = 4;
+	double sum = 0;
+
+	auto start (std::chrono::steady_clock::now());
+
+	for (int w = 0; w < writers; w++) {
+		for (auto& cr : results) {
+			ObjectLock olock (cr->GetPerformanceData());
+
+			for (const Value& val : cr->GetPerformanceData()) {
+				sum += PerfdataValue::Parse(val)->GetValue();
+			}
+		}
+	}
+
+	auto parseDone (std::chrono::steady_clock::now());
+	double parsedSum = 0;
+
+	for (int w = 0; w < writers; w++) {
+		for (auto& cr : results) {
+			for (auto& pdv : *cr->GetParsedPerformanceData()) {
+				parsedSum += pdv.Number;
+			}
+		}
+	}
+
+	auto cachedDone (std::chrono::steady_clock::now());
+
+	BOOST_CHECK_EQUAL(sum, parsedSum);
+
+	using ms = std::chrono::duration<double, std::milli>;
+
+	std::cout << "parsing per writer: " << ms(parseDone - start).count() << " ms, parsed once: "
+		<< ms(cachedDone - parseDone).count() << " ms" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(parse_check_output)
+{
+	BOOST_CHECK(PluginUtility::ParseCheckOutput("") == std::make_pair(String(), String()));
+	BOOST_CHECK(PluginUtility::ParseCheckOutput("OK") == std::make_pair(String("OK"), String()));
+	BOOST_CHECK(PluginUtility::ParseCheckOutput("OK | a=1") == std::make_pair(String("OK "), String("a=1")));
+	BOOST_CHECK(PluginUtility::ParseCheckOutput("OK | no perfdata") == std::make_pair(String("OK | no perfdata"), String()));
+	BOOST_CHECK(PluginUtility::ParseCheckOutput("OK | a=1\r\nline 2 | b=2 | c=3\nline 3")
+		== std::make_pair(String("OK \n\nline 2 \nline 3"), String("a=1  b=2 | c=3")));
+
+	String output = GetLongPluginOutput(100);
+	BOOST_CHECK(PluginUtility::ParseCheckOutput(output) == ReferenceParseCheckOutput(output));
+}
+
+BOOST_AUTO_TEST_CASE(parse_check_output_fuzz)
+{
+	/* Random outputs mostly consisting of the characters the tokenizer cares about. */
+	const char alphabet[] = "\r\n|=; ',.abc0123";
+
+	std::mt19937 rng (42);
+	std::uniform_int_distribution<size_t> length (0, 100);
+	std::uniform_int_distribution<size_t> character (0, sizeof(alphabet) - 2);
+
+	for (int i = 0; i < 10000; i++) {
+		String output;
+
+		for (auto l (length(rng)); l; l--) {
+			output += alphabet[character(rng)];
+		}
+
+		auto actual (PluginUtility::ParseCheckOutput(output));
+		auto expected (ReferenceParseCheckOutput(output));
+
+		BOOST_CHECK_MESSAGE(actual == expected, "Output: '" << output << "'");
+
+		/* The perfdata value tokenizer must reject decimal commas just like before, wherever they are. */
+		String pd = "label=" + actual.second.SubStr(0, actual.second.FindFirstOf(' '));
+
+		if (pd.SubStr(pd.FindLastOf('=')).FindFirstOf(',') != String::NPos) {
+			BOOST_CHECK_THROW(PerfdataValue::Parse(pd), std::invalid_argument);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(parse_long_value)
+{
+	PerfdataValue::Ptr pv = PerfdataValue::Parse("'a long label to cross vector boundaries'=1234567890.123456789;1;2;0;9999999999.99");
+	BOOST_CHECK_EQUAL(pv->GetLabel(), "a long label to cross vector boundaries");
+	BOOST_CHECK_EQUAL(pv->GetValue(), 1234567890.123456789);
+	BOOST_CHECK_EQUAL(pv->GetWarn(), 1);
+	BOOST_CHECK_EQUAL(pv->GetCrit(), 2);
+	BOOST_CHECK_EQUAL(pv->GetMin(), 0);
+	BOOST_CHECK_EQUAL(pv->GetMax(), 9999999999.99);
+
+	BOOST_CHECK_THROW(PerfdataValue::Parse("a=1234567890.123456789;1;2;0;9999999999,99"), std::invalid_argument);
+	BOOST_CHECK_THROW(PerfdataValue::Parse("a=1234567890,123456789;1;2;0;9999999999.99"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(parse_check_output_benchmark,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	String output = GetLongPluginOutput(50);
+	const int runs = 20000;
+	size_t sizes = 0, referenceSizes = 0;
+
+	auto start (std::chrono::steady_clock::now());
+
+	for (int i = 0; i < runs; i++) {
+		referenceSizes += ReferenceParseCheckOutput(output).second.GetLength();
+	}
+
+	auto referenceDone (std::chrono::steady_clock::now());
+
+	for (int i = 0; i < runs; i++) {
+		sizes += PluginUtility::ParseCheckOutput(output).second.GetLength();
+	}
+
+	auto done (std::chrono::steady_clock::now());
+
+	BOOST_CHECK_EQUAL(sizes, referenceSizes);
+
+	using seconds = std::chrono::duration<double>;
+	double mb = output.GetLength() * runs / 1024.0 / 1024.0;
+
+	std::cout << "ParseCheckOutput() of " << output.GetLength() << " bytes: reference "
+		<< mb / seconds(referenceDone - start).count() << " MiB/s, vectorized "
+		<< mb / seconds(done - referenceDone).count() << " MiB/s" << std::endl;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
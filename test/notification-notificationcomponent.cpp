@@ -193,6 +193,11 @@ object NotificationComponent "nc" {}
 		InvokeTimerHandler(nc);
 	}
 
+	static unsigned long GetScheduledNotifications()
+	{
+		return NotificationComponent::GetByName("nc")->GetScheduledNotifications();
+	}
+
 	void ReceiveCheckResults(std::size_t num, ServiceState state)
 	{
 		::ReceiveCheckResults(m_Host, num, state);
@@ -629,4 +634,53 @@ BOOST_AUTO_TEST_CASE(no_more_notifications_race)
 	BOOST_REQUIRE(!ExpectLogPattern("^Sending reminder.*$", 0s));
 }
 
+/* Tests that the timer only has to look at notifications which may have something to send.
+ */
+BOOST_AUTO_TEST_CASE(schedule_due_notifications)
+{
+	BeginTimePeriod();
+
+	// Without an interval, there's nothing to remind of in an OK state.
+	ReceiveCheckResults(1, ServiceOK);
+	BOOST_REQUIRE_EQUAL(GetScheduledNotifications(), 0);
+
+	// Neither is there once the problem notification has been sent.
+	ReceiveCheckResults(3, ServiceCritical);
+	BOOST_REQUIRE(WaitForExpectedNotificationCount(1));
+	BOOST_REQUIRE_EQUAL(GetScheduledNotifications(), 0);
+
+	// With an interval, the next reminder is due right away.
+	SetNotificationInverval(10);
+	BOOST_REQUIRE_EQUAL(GetScheduledNotifications(), 1);
+
+	NotificationTimerHandler();
+	BOOST_REQUIRE(WaitForExpectedNotificationCount(2));
+	BOOST_REQUIRE_EQUAL(GetLastNotification(), NotificationProblem);
+	BOOST_REQUIRE_GT(GetNextNotificationTimestamp(), Utility::GetTime());
+	BOOST_REQUIRE_EQUAL(GetScheduledNotifications(), 1);
+
+	// The next reminder isn't due yet.
+	NotificationTimerHandler();
+	BOOST_REQUIRE(AssertNoAttemptedSendLogPattern());
+	BOOST_REQUIRE_EQUAL(GetNotificationCount(), 2);
+
+	// A suppressed notification is looked at on every run, until it can be sent.
+	SetNotificationInverval(0);
+	EndTimePeriod();
+	ReceiveCheckResults(1, ServiceOK);
+	BOOST_REQUIRE_EQUAL(GetSuppressedNotifications(), NotificationRecovery);
+	BOOST_REQUIRE_EQUAL(GetScheduledNotifications(), 1);
+
+	NotificationTimerHandler();
+	BOOST_REQUIRE(AssertNoReSendSuppressedLogPattern());
+	BOOST_REQUIRE_EQUAL(GetScheduledNotifications(), 1);
+
+	BeginTimePeriod();
+	NotificationTimerHandler();
+	BOOST_REQUIRE(WaitForExpectedNotificationCount(3));
+	BOOST_REQUIRE_EQUAL(GetLastNotification(), NotificationRecovery);
+	BOOST_REQUIRE_EQUAL(GetSuppressedNotifications(), 0);
+	BOOST_REQUIRE_EQUAL(GetScheduledNotifications(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "otel/otelhistogram.hpp"
+#include <BoostTestTargetConfig.h>
+#include <cmath>
+#include <random>
+
+using namespace icinga;
+
+using DataPoint = opentelemetry::proto::metrics::v1::ExponentialHistogramDataPoint;
+
+BOOST_AUTO_TEST_SUITE(otel_otelhistogram)
+
+BOOST_AUTO_TEST_CASE(map_to_index)
+{
+	// Buckets are upper-inclusive, so powers of two belong to the bucket below them.
+	BOOST_CHECK_EQUAL(OTelHistogram::MapToIndex(1, 0), -1);
+	BOOST_CHECK_EQUAL(OTelHistogram::MapToIndex(2, 0), 0);
+	BOOST_CHECK_EQUAL(OTelHistogram::MapToIndex(3, 0), 1);
+	BOOST_CHECK_EQUAL(OTelHistogram::MapToIndex(4, -1), 0);
+	BOOST_CHECK_EQUAL(OTelHistogram::MapToIndex(5, -1), 1);
+	BOOST_CHECK_EQUAL(OTelHistogram::MapToIndex(2, 3), 7);
+	BOOST_CHECK_EQUAL(OTelHistogram::MapToIndex(2.0001, 3), 8);
+
+	double base = std::pow(2.0, 1.0 / 8);
+	for (double value = 0.01; value < 1000; value *= 1.0137) {
+		auto index = OTelHistogram::MapToIndex(value, 3);
+		BOOST_CHECK_LT(std::pow(base, index), value * (1 + 1e-9));
+		BOOST_CHECK_LE(value, std::pow(base, index + 1) * (1 + 1e-9));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(aggregate)
+{
+	OTelHistogram histogram;
+	histogram.Add(1);
+	histogram.Add(-2);
+	histogram.Add(0);
+	histogram.Add(NAN);
+	histogram.Add(INFINITY);
+
+	DataPoint dataPoint;
+	histogram.Encode(dataPoint);
+
+	BOOST_CHECK_EQUAL(dataPoint.count(), 3);
+	BOOST_CHECK_EQUAL(dataPoint.zero_count(), 1);
+	BOOST_CHECK_EQUAL(dataPoint.sum(), -1);
+	BOOST_CHECK_EQUAL(dataPoint.min(), -2);
+	BOOST_CHECK_EQUAL(dataPoint.max(), 1);
+	BOOST_CHECK_EQUAL(dataPoint.scale(), OTelHistogram::MaxScale);
+	BOOST_CHECK_EQUAL(dataPoint.positive().bucket_counts_size(), 1);
+	BOOST_CHECK_EQUAL(dataPoint.negative().bucket_counts_size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(downscale)
+{
+	OTelHistogram histogram;
+	std::mt19937 generator (42);
+	std::lognormal_distribution<double> distribution (0, 3);
+
+	for (int i = 0; i < 100000; i++) {
+		histogram.Add(i % 7 ? distribution(generator) : -distribution(generator));
+	}
+
+	DataPoint dataPoint;
+	histogram.Encode(dataPoint);
+
+	BOOST_CHECK_LT(dataPoint.scale(), OTelHistogram::MaxScale);
+	BOOST_CHECK_LE(dataPoint.positive().bucket_counts_size(), OTelHistogram::MaxSize);
+	BOOST_CHECK_LE(dataPoint.negative().bucket_counts_size(), OTelHistogram::MaxSize);
+
+	uint64_t count = dataPoint.zero_count();
+	for (auto bucketCount : dataPoint.positive().bucket_counts()) {
+		count += bucketCount;
+	}
+	for (auto bucketCount : dataPoint.negative().bucket_counts()) {
+		count += bucketCount;
+	}
+	BOOST_CHECK_EQUAL(count, 100000);
+
+	// The extremes must end up in the outermost buckets.
+	const auto& positive = dataPoint.positive();
+	BOOST_CHECK_EQUAL(
+		OTelHistogram::MapToIndex(dataPoint.max(), dataPoint.scale()),
+		positive.offset() + positive.bucket_counts_size() - 1
+	);
+	BOOST_CHECK_EQUAL(
+		OTelHistogram::MapToIndex(-dataPoint.min(), dataPoint.scale()),
+		dataPoint.negative().offset() + dataPoint.negative().bucket_counts_size() - 1
+	);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <BoostTestTargetConfig.h>
+#include "perfdata/metricsbuffer.hpp"
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(perfdata_metricsbuffer,
+	*boost::unit_test::label("perfdata")
+)
+
+BOOST_AUTO_TEST_CASE(append_and_take)
+{
+	MetricsBuffer buffer;
+	BOOST_CHECK(buffer.IsEmpty());
+	BOOST_CHECK_EQUAL(buffer.Take(), "");
+
+	buffer.BeginDataPoint().append("a value=1");
+	BOOST_CHECK_EQUAL(buffer.EndDataPoint(), "a value=1");
+
+	buffer.BeginDataPoint().append("b value=2");
+	BOOST_CHECK_EQUAL(buffer.EndDataPoint(), "b value=2");
+
+	BOOST_CHECK(!buffer.IsEmpty());
+	BOOST_CHECK_EQUAL(buffer.GetDataPoints(), 2u);
+	BOOST_CHECK_EQUAL(buffer.GetBytes(), 19u);
+
+	BOOST_CHECK_EQUAL(buffer.Take(), "a value=1\nb value=2");
+	BOOST_CHECK(buffer.IsEmpty());
+	BOOST_CHECK_EQUAL(buffer.GetDataPoints(), 0u);
+	BOOST_CHECK_EQUAL(buffer.GetBytes(), 0u);
+
+	buffer.BeginDataPoint().append("c value=3");
+	buffer.EndDataPoint();
+	BOOST_CHECK_EQUAL(buffer.Take(), "c value=3");
+}
+
+BOOST_AUTO_TEST_CASE(flush_policy)
+{
+	MetricsBuffer buffer ("\n", 16);
+
+	buffer.BeginDataPoint().append("12345");
+	buffer.EndDataPoint();
+
+	BOOST_CHECK(!buffer.ShouldFlush(2));
+	BOOST_CHECK(buffer.ShouldFlush(1));
+
+	buffer.BeginDataPoint().append("1234567890");
+	buffer.EndDataPoint();
+
+	/* 16 bytes, including the separator */
+	BOOST_CHECK(buffer.ShouldFlush(100));
+}
+
+BOOST_AUTO_TEST_CASE(recycle)
+{
+	MetricsBuffer buffer;
+
+	buffer.BeginDataPoint().append(std::string(1000, 'x'));
+	buffer.EndDataPoint();
+
+	auto body (buffer.Take());
+	auto data (body.data());
+	buffer.Recycle(std::move(body));
+
+	/* The buffer continues with the recycled body once the current one is taken. */
+	buffer.BeginDataPoint().append("a");
+	buffer.EndDataPoint();
+	buffer.Take();
+
+	buffer.BeginDataPoint().append("b");
+	buffer.EndDataPoint();
+
+	body = buffer.Take();
+	BOOST_CHECK_EQUAL(body, "b");
+	BOOST_CHECK_EQUAL(static_cast<const void*>(body.data()), static_cast<const void*>(data));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -36,6 +36,21 @@ BOOST_AUTO_TEST_CASE(connect)
 	PauseWriter();
 }
 
+BOOST_AUTO_TEST_CASE(flush_interval)
+{
+	// Below the threshold, the data points are only sent by the flush timer.
+	GetWriter()->SetFlushThreshold(1000000);
+	ResumeWriter();
+
+	ReceiveCheckResults(1, ServiceState::ServiceCritical);
+
+	Accept();
+	auto msg = GetDataUntil('\n');
+
+	BOOST_REQUIRE_EQUAL(msg.substr(0, 22), "put icinga.host.state ");
+	PauseWriter();
+}
+
 BOOST_AUTO_TEST_CASE(pause_with_pending_work)
 {
 	ResumeWriter();
@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <BoostTestTargetConfig.h>
+#include "perfdata/perfdataspool.hpp"
+#include "base/utility.hpp"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+
+using namespace icinga;
+
+struct PerfdataSpoolFixture
+{
+	PerfdataSpoolFixture()
+		: m_Path(boost::filesystem::current_path() / "spool" / std::string{Utility::NewUniqueID()})
+	{
+	}
+
+	~PerfdataSpoolFixture()
+	{
+		boost::filesystem::remove_all(m_Path);
+	}
+
+	String GetPath() const
+	{
+		return m_Path.string();
+	}
+
+	boost::filesystem::path m_Path;
+};
+
+BOOST_FIXTURE_TEST_SUITE(perfdata_perfdataspool, PerfdataSpoolFixture,
+	*boost::unit_test::label("perfdata")
+)
+
+BOOST_AUTO_TEST_CASE(fifo)
+{
+	PerfdataSpool spool (GetPath(), 1024, "PerfdataSpool");
+	BOOST_CHECK(spool.IsEmpty());
+	BOOST_CHECK_EQUAL(spool.GetOldestTimestamp(), 0);
+
+	spool.Push("first");
+	spool.Push("second");
+
+	BOOST_CHECK(!spool.IsEmpty());
+	BOOST_CHECK_EQUAL(spool.GetSegments(), 2u);
+	BOOST_CHECK_EQUAL(spool.GetBytes(), 11u);
+	BOOST_CHECK_GT(spool.GetOldestTimestamp(), 0);
+
+	BOOST_CHECK_EQUAL(spool.Front(), "first");
+	spool.Pop();
+	BOOST_CHECK_EQUAL(spool.Front(), "second");
+	spool.Pop();
+
+	BOOST_CHECK(spool.IsEmpty());
+	BOOST_CHECK_EQUAL(spool.GetBytes(), 0u);
+	BOOST_CHECK_EQUAL(spool.GetOldestTimestamp(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(size_limit)
+{
+	PerfdataSpool spool (GetPath(), 10, "PerfdataSpool");
+
+	spool.Push("aaaa");
+	spool.Push("bbbb");
+	spool.Push("cccc");
+
+	BOOST_CHECK_EQUAL(spool.GetSegments(), 2u);
+	BOOST_CHECK_EQUAL(spool.GetBytes(), 8u);
+	BOOST_CHECK_EQUAL(spool.Front(), "bbbb");
+
+	/* Payloads which never fit are dropped right away. */
+	spool.Push("0123456789a");
+
+	BOOST_CHECK_EQUAL(spool.GetSegments(), 2u);
+	BOOST_CHECK_EQUAL(spool.Front(), "bbbb");
+}
+
+BOOST_AUTO_TEST_CASE(recovery)
+{
+	{
+		PerfdataSpool spool (GetPath(), 1024, "PerfdataSpool");
+
+		for (int i = 0; i < 12; i++) {
+			spool.Push("payload " + std::to_string(i));
+		}
+
+		spool.Pop();
+	}
+
+	PerfdataSpool spool (GetPath(), 1024, "PerfdataSpool");
+	BOOST_CHECK_EQUAL(spool.GetSegments(), 11u);
+
+	for (int i = 1; i < 12; i++) {
+		BOOST_CHECK_EQUAL(spool.Front(), "payload " + std::to_string(i));
+		spool.Pop();
+	}
+
+	BOOST_CHECK(spool.IsEmpty());
+
+	/* Sequence numbers continue after the recovered ones. */
+	spool.Push("new");
+	BOOST_CHECK_EQUAL(spool.Front(), "new");
+}
+
+BOOST_AUTO_TEST_CASE(recovery_size_limit)
+{
+	{
+		PerfdataSpool spool (GetPath(), 1024, "PerfdataSpool");
+		spool.Push("aaaa");
+		spool.Push("bbbb");
+	}
+
+	PerfdataSpool spool (GetPath(), 5, "PerfdataSpool");
+	BOOST_CHECK_EQUAL(spool.GetSegments(), 1u);
+	BOOST_CHECK_EQUAL(spool.Front(), "bbbb");
+}
+
+BOOST_AUTO_TEST_CASE(retry_backoff)
+{
+	PerfdataSpool spool (GetPath(), 1024, "PerfdataSpool");
+	double now = 1000;
+
+	BOOST_CHECK(spool.IsRetryDue(now));
+
+	/* Every failed attempt doubles the delay until the next one, up to a maximum. */
+	double delay = PerfdataSpool::MinRetryDelay;
+
+	for (int i = 0; i < 10; i++) {
+		spool.RetryLater(now);
+
+		BOOST_CHECK(!spool.IsRetryDue(now + delay - 0.1));
+		BOOST_CHECK(spool.IsRetryDue(now + delay));
+
+		now += delay;
+		delay = std::min(delay * 2, PerfdataSpool::MaxRetryDelay);
+	}
+
+	spool.ResetRetryDelay();
+	BOOST_CHECK(spool.IsRetryDue(now));
+
+	spool.RetryLater(now);
+	BOOST_CHECK(spool.IsRetryDue(now + PerfdataSpool::MinRetryDelay));
+
+	BOOST_CHECK(PerfdataSpool::IsTemporaryFailure(429));
+	BOOST_CHECK(PerfdataSpool::IsTemporaryFailure(503));
+	BOOST_CHECK(!PerfdataSpool::IsTemporaryFailure(204));
+	BOOST_CHECK(!PerfdataSpool::IsTemporaryFailure(400));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <BoostTestTargetConfig.h>
+#include "perfdata/perfdatawriterconnectionpool.hpp"
+#include "base/io-engine.hpp"
+#include "test/test-thread.hpp"
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/http.hpp>
+#include <mutex>
+#include <set>
+
+using namespace icinga;
+
+/**
+ * An HTTP sink accepting any number of keep-alive connections, which holds back the response to
+ * requests with a "slow" body until it's released.
+ */
+class SlowHttpSinkFixture
+{
+public:
+	SlowHttpSinkFixture() : m_Acceptor(IoEngine::Get().GetIoContext())
+	{
+		boost::asio::ip::tcp::endpoint ep{boost::asio::ip::address_v4::loopback(), 0};
+		m_Acceptor.open(ep.protocol());
+		m_Acceptor.bind(ep);
+		m_Acceptor.listen();
+
+		m_SlowFuture = m_SlowPromise.get_future().share();
+	}
+
+	unsigned short GetPort() { return m_Acceptor.local_endpoint().port(); }
+
+	/**
+	 * Accepts the given number of connections and serves each one on its own thread until it's closed.
+	 */
+	void Serve(std::size_t connections)
+	{
+		std::vector<std::unique_ptr<TestThread>> threads;
+
+		for (std::size_t i = 0; i < connections; i++) {
+			auto socket (std::make_shared<boost::asio::ip::tcp::socket>(IoEngine::Get().GetIoContext()));
+			m_Acceptor.accept(*socket);
+
+			threads.emplace_back(std::make_unique<TestThread>([this, socket]() {
+				namespace http = boost::beast::http;
+
+				boost::beast::flat_buffer buf;
+
+				for (;;) {
+					http::request<http::string_body> request;
+					boost::system::error_code ec;
+
+					http::read(*socket, buf, request, ec);
+
+					if (ec) {
+						return;
+					}
+
+					if (request.body() == "slow") {
+						m_SlowFuture.wait();
+					}
+
+					http::response<http::empty_body> response;
+					response.result(http::status::no_content);
+					response.keep_alive(true);
+					response.prepare_payload();
+					http::write(*socket, response, ec);
+
+					if (ec) {
+						return;
+					}
+				}
+			}));
+		}
+
+		for (auto& thread : threads) {
+			BOOST_REQUIRE_MESSAGE(thread->TryJoinWithin(std::chrono::seconds(5)), "Thread not joinable within timeout.");
+		}
+	}
+
+	void ReleaseSlow() { m_SlowPromise.set_value(); }
+
+	static PerfdataWriterConnectionPool::HttpRequest MakeRequest(const std::string& body)
+	{
+		PerfdataWriterConnectionPool::HttpRequest request{boost::beast::http::verb::post, "/write", 11};
+		request.set(boost::beast::http::field::host, "localhost");
+		request.body() = body;
+		request.prepare_payload();
+		return request;
+	}
+
+private:
+	boost::asio::ip::tcp::acceptor m_Acceptor;
+	std::promise<void> m_SlowPromise;
+	std::shared_future<void> m_SlowFuture;
+};
+
+BOOST_FIXTURE_TEST_SUITE(perfdata_connection_pool, SlowHttpSinkFixture,
+	*boost::unit_test::label("perfdata")
+	*boost::unit_test::label("network")
+)
+
+BOOST_AUTO_TEST_CASE(index_for)
+{
+	std::vector<int> objects (64);
+	std::set<std::size_t> used;
+
+	for (auto& object : objects) {
+		auto index (PerfdataWriterConnectionPool::GetIndexFor(&object, 4));
+
+		BOOST_CHECK_LT(index, 4);
+		BOOST_CHECK_EQUAL(index, PerfdataWriterConnectionPool::GetIndexFor(&object, 4));
+		used.insert(index);
+	}
+
+	/* Consecutive addresses must not all end up on the same connection. */
+	BOOST_CHECK_EQUAL(used.size(), 4);
+}
+
+/* A request stuck on one connection must neither block the other connection nor the caller, and
+ * each connection has to deliver its requests in order.
+ */
+BOOST_AUTO_TEST_CASE(slow_connection)
+{
+	PerfdataWriterConnectionPool::Ptr pool = new PerfdataWriterConnectionPool{
+		"Test", "test", "127.0.0.1", std::to_string(GetPort()), nullptr, true, 2
+	};
+
+	TestThread sinkThread{[this]() { Serve(2); }};
+
+	std::mutex mutex;
+	std::vector<std::string> delivered;
+	std::promise<void> fastDone;
+
+	auto handler ([&](PerfdataWriterConnectionPool::HttpRequest& request, const PerfdataWriterConnectionPool::HttpResponse& response) {
+		BOOST_CHECK_EQUAL(response.result(), boost::beast::http::status::no_content);
+
+		std::unique_lock<std::mutex> lock (mutex);
+		delivered.emplace_back(request.body());
+
+		if (request.body() == "fast-3") {
+			fastDone.set_value();
+		}
+	});
+
+	pool->Enqueue(0, MakeRequest("slow"), handler);
+	pool->Enqueue(0, MakeRequest("after-slow"), handler);
+
+	for (auto body : {"fast-1", "fast-2", "fast-3"}) {
+		pool->Enqueue(1, MakeRequest(body), handler);
+	}
+
+	BOOST_REQUIRE(fastDone.get_future().wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+	{
+		std::vector<std::string> expected ({ "fast-1", "fast-2", "fast-3" });
+
+		std::unique_lock<std::mutex> lock (mutex);
+		BOOST_CHECK_EQUAL_COLLECTIONS(delivered.begin(), delivered.end(), expected.begin(), expected.end());
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	ReleaseSlow();
+	pool->Join();
+
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		BOOST_REQUIRE_EQUAL(delivered.size(), 5);
+		BOOST_CHECK_EQUAL(delivered[3], "slow");
+		BOOST_CHECK_EQUAL(delivered[4], "after-slow");
+	}
+
+	Dictionary::Ptr status = new Dictionary();
+	Array::Ptr perfdata = new Array();
+	pool->AddStats(status, perfdata, "test");
+
+	Array::Ptr connections = status->Get("connections");
+	BOOST_REQUIRE_EQUAL(connections->GetLength(), 2);
+	BOOST_CHECK_EQUAL(perfdata->GetLength(), 4);
+
+	Dictionary::Ptr slow = connections->Get(0);
+	Dictionary::Ptr fast = connections->Get(1);
+
+	double slowLatency = slow->Get("latency");
+	double fastLatency = fast->Get("latency");
+
+	BOOST_CHECK_EQUAL(static_cast<double>(slow->Get("queue_items")), 0);
+	BOOST_CHECK_GE(static_cast<double>(slow->Get("last_latency")), 0);
+
+	/* The held back request dominates the moving average of its connection. */
+	BOOST_CHECK_GE(slowLatency, 0.05);
+	BOOST_CHECK_GT(slowLatency, fastLatency);
+
+	std::promise<void> done;
+	done.set_value();
+	pool->CancelAfterTimeout(done.get_future(), std::chrono::seconds(0));
+
+	REQUIRE_JOINS_WITHIN(sinkThread, std::chrono::seconds(5));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: 2026 Icinga GmbH <https://icinga.com>
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "remote/apiaction.hpp"
+#include "icinga/host.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(remote_apiaction)
+
+BOOST_AUTO_TEST_CASE(bulk)
+{
+	std::vector<ConfigObject::Ptr> targets { new Host(), new Host(), new Host() };
+	size_t calls = 0;
+
+	ApiAction::Ptr single = new ApiAction({ "Host" }, [](const ConfigObject::Ptr&, const ApiUser::Ptr&, const Dictionary::Ptr&) {
+		return Value(200);
+	});
+
+	BOOST_CHECK(!single->SupportsBulk());
+
+	ApiAction::Ptr bulk = new ApiAction({ "Host" },
+		[](const ConfigObject::Ptr&, const ApiUser::Ptr&, const Dictionary::Ptr&) {
+			return Value(200);
+		},
+		[&calls](const std::vector<ConfigObject::Ptr>& objects, const ApiUser::Ptr&, const Dictionary::Ptr&) {
+			calls++;
+			return std::vector<Value>(objects.size(), 200);
+		});
+
+	BOOST_CHECK(bulk->SupportsBulk());
+
+	auto results (bulk->InvokeBulk(targets, nullptr, new Dictionary()));
+
+	BOOST_CHECK_EQUAL(calls, 1u);
+	BOOST_CHECK_EQUAL(results.size(), targets.size());
+
+	/* Every target must get its own result. */
+	ApiAction::Ptr broken = new ApiAction({ "Host" }, nullptr,
+		[](const std::vector<ConfigObject::Ptr>&, const ApiUser::Ptr&, const Dictionary::Ptr&) {
+			return std::vector<Value>{ 200 };
+		});
+
+	BOOST_CHECK_THROW(broken->InvokeBulk(targets, nullptr, new Dictionary()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
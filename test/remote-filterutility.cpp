@@ -7,6 +7,15 @@
 #include "remote/filterutility.hpp"
 #include "test/icingaapplication-fixture.hpp"
 #include "config/configcompiler.hpp"
+#include "base/application.hpp"
+#include "base/base64.hpp"
+#include "base/configuration.hpp"
+#include "base/json.hpp"
+#include "base/serializer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
 
 using namespace icinga;
 
@@ -378,4 +387,308 @@ object Host "host1" {
 	BOOST_CHECK_EQUAL(objs.size(), 0);
 }
 
+BOOST_FIXTURE_TEST_CASE(parallel_filter_order, IcingaApplicationFixture)
+{
+	auto createObjects = []() {
+		String config = R"CONFIG({
+object CheckCommand "parallel-dummy" {
+  command = "/bin/echo"
+}
+
+object ApiUser "parallelFilterUser" {
+  permissions = [
+    "filter-expression",
+    {
+      permission = "objects/query/Host"
+      filter = {{ host.vars.num % 7 != 0 }}
+    }
+  ]
+}
+
+for (i in range(5000)) {
+  object Host "parallel-host" + i use (i) {
+    check_command = "parallel-dummy"
+    vars.num = i
+  }
+}
+})CONFIG";
+		std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", config);
+		ScriptFrame frame (true);
+		expr->Evaluate(frame);
+	};
+
+	ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", createObjects));
+
+	auto user = ApiUser::GetByName("parallelFilterUser");
+	BOOST_REQUIRE(user);
+
+	QueryDescription qd;
+	qd.Types.insert("Host");
+	qd.Permission = "objects/query/Host";
+
+	Dictionary::Ptr queryParams = new Dictionary();
+	queryParams->Set("type", "Host");
+
+	auto concurrency (Configuration::Concurrency);
+	std::vector<Value> sequential, parallel;
+
+	for (String filter : { "match({{{parallel-host*3}}}, host.name)", "host.vars.num % 2 == 0" }) {
+		queryParams->Set("filter", filter);
+
+		Configuration::Concurrency = 1;
+		BOOST_CHECK_NO_THROW(sequential = FilterUtility::GetFilterTargets(qd, queryParams, user));
+
+		Configuration::Concurrency = 4;
+		BOOST_CHECK_NO_THROW(parallel = FilterUtility::GetFilterTargets(qd, queryParams, user));
+
+		BOOST_CHECK(!sequential.empty());
+		BOOST_CHECK(sequential == parallel);
+	}
+
+	/* Fails in one of the last chunks only. */
+	queryParams->Set("filter", "host.vars.num < 4900 || host.name in 42");
+	BOOST_CHECK_THROW(FilterUtility::GetFilterTargets(qd, queryParams, user), ScriptError);
+
+	Configuration::Concurrency = concurrency;
+}
+
+BOOST_FIXTURE_TEST_CASE(parallel_filter_benchmark, IcingaApplicationFixture,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	auto createObjects = []() {
+		String config = R"CONFIG({
+object CheckCommand "bench-dummy" {
+  command = "/bin/echo"
+}
+
+object ApiUser "benchUser" {
+  permissions = [ "*" ]
+}
+
+for (h in range(5000)) {
+  object Host "bench-host" + h {
+    check_command = "bench-dummy"
+  }
+
+  for (s in range(100)) {
+    object Service "bench-service" + s use (h) {
+      host_name = "bench-host" + h
+      check_command = "bench-dummy"
+    }
+  }
+}
+})CONFIG";
+		std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", config);
+		ScriptFrame frame (true);
+		expr->Evaluate(frame);
+	};
+
+	ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", createObjects));
+
+	auto user = ApiUser::GetByName("benchUser");
+	BOOST_REQUIRE(user);
+
+	QueryDescription qd;
+	qd.Types.insert("Service");
+	qd.Permission = "objects/query/Service";
+
+	Dictionary::Ptr queryParams = new Dictionary();
+	queryParams->Set("type", "Service");
+	queryParams->Set("filter", "match(\"*!bench-service1*\", service.name) || match(\"bench-host*7*\", host.name)");
+
+	auto concurrency (Configuration::Concurrency);
+	auto threads (std::max(1u, std::thread::hardware_concurrency()));
+	size_t expected = 0;
+
+	for (auto workers (1u); workers <= threads; workers *= 2u) {
+		Configuration::Concurrency = workers;
+		Application::GetTP().Restart();
+
+		auto start (std::chrono::steady_clock::now());
+		auto objs (FilterUtility::GetFilterTargets(qd, queryParams, user));
+		std::chrono::duration<double, std::milli> took (std::chrono::steady_clock::now() - start);
+
+		if (workers == 1u) {
+			expected = objs.size();
+		}
+
+		BOOST_CHECK_EQUAL(objs.size(), expected);
+		std::cout << workers << " thread(s): " << took.count() << " ms (" << objs.size() << " matches)" << std::endl;
+	}
+
+	Configuration::Concurrency = concurrency;
+	Application::GetTP().Restart();
+}
+
+BOOST_FIXTURE_TEST_CASE(paginate_targets, IcingaApplicationFixture)
+{
+	auto createObjects = []() {
+		String config = R"CONFIG({
+object CheckCommand "page-dummy" {
+  command = "/bin/echo"
+}
+
+object ApiUser "pageUser" {
+  permissions = [ "*" ]
+}
+
+for (i in range(10)) {
+  object Host "page-host" + i use (i) {
+    check_command = "page-dummy"
+  }
+}
+})CONFIG";
+		std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", config);
+		ScriptFrame frame (true);
+		expr->Evaluate(frame);
+	};
+
+	ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", createObjects));
+
+	auto user = ApiUser::GetByName("pageUser");
+	BOOST_REQUIRE(user);
+
+	QueryDescription qd;
+	qd.Types.insert("Host");
+	qd.Permission = "objects/query/Host";
+
+	auto getPage ([&qd, &user](const Dictionary::Ptr& params, String& cursor) {
+		params->Set("type", "Host");
+
+		if (!params->Contains("filter")) {
+			params->Set("filter", "match({{{page-host*}}}, host.name)");
+		}
+
+		auto objs (FilterUtility::GetFilterTargets(qd, params, user));
+		cursor = FilterUtility::PaginateTargets(objs, params);
+
+		std::vector<String> names;
+
+		for (ConfigObject::Ptr obj : objs) {
+			names.emplace_back(obj->GetName());
+		}
+
+		return names;
+	});
+
+	std::vector<String> all, page;
+	String cursor;
+
+	BOOST_REQUIRE_NO_THROW(all = getPage(new Dictionary(), cursor));
+	BOOST_REQUIRE_EQUAL(all.size(), 10u);
+	BOOST_CHECK(cursor.IsEmpty());
+
+	/* Pages are taken from the objects sorted by name. */
+	std::sort(all.begin(), all.end());
+
+	BOOST_REQUIRE_NO_THROW(page = getPage(new Dictionary({{"limit", 3}}), cursor));
+	BOOST_CHECK(page == std::vector<String>(all.begin(), all.begin() + 3));
+	BOOST_CHECK_EQUAL(Base64::Decode(cursor), all[2]);
+
+	BOOST_REQUIRE_NO_THROW(page = getPage(new Dictionary({{"limit", "3"}, {"cursor", cursor}}), cursor));
+	BOOST_CHECK(page == std::vector<String>(all.begin() + 3, all.begin() + 6));
+	BOOST_CHECK_EQUAL(Base64::Decode(cursor), all[5]);
+
+	BOOST_REQUIRE_NO_THROW(page = getPage(new Dictionary({{"offset", 8}, {"limit", 3}}), cursor));
+	BOOST_CHECK(page == std::vector<String>(all.begin() + 8, all.end()));
+	BOOST_CHECK(cursor.IsEmpty());
+
+	BOOST_REQUIRE_NO_THROW(page = getPage(new Dictionary({{"offset", 20}}), cursor));
+	BOOST_CHECK(page.empty());
+
+	/* The object the cursor points to doesn't have to match the filter anymore. */
+	auto params (new Dictionary({
+		{"cursor", Base64::Encode(all[2])},
+		{"limit", 2},
+		{"filter", "host.name != {{{" + all[2] + "}}} && match({{{page-host*}}}, host.name)"}
+	}));
+	BOOST_REQUIRE_NO_THROW(page = getPage(params, cursor));
+	BOOST_CHECK(page == std::vector<String>(all.begin() + 3, all.begin() + 5));
+
+	BOOST_CHECK_THROW(getPage(new Dictionary({{"limit", 0}}), cursor), std::invalid_argument);
+	BOOST_CHECK_THROW(getPage(new Dictionary({{"limit", -1}}), cursor), std::invalid_argument);
+	BOOST_CHECK_THROW(getPage(new Dictionary({{"limit", "many"}}), cursor), std::invalid_argument);
+	BOOST_CHECK_THROW(getPage(new Dictionary({{"offset", 1.5}}), cursor), std::invalid_argument);
+	BOOST_CHECK_THROW(getPage(new Dictionary({{"offset", 1}, {"cursor", Base64::Encode(all[0])}}), cursor), std::invalid_argument);
+
+	/* If the object the cursor points to doesn't exist anymore, the next page starts with the next object by name. */
+	BOOST_REQUIRE_NO_THROW(page = getPage(new Dictionary({{"cursor", Base64::Encode(all[3] + "-deleted")}, {"limit", 2}}), cursor));
+	BOOST_CHECK(page == std::vector<String>(all.begin() + 4, all.begin() + 6));
+	BOOST_CHECK_EQUAL(Base64::Decode(cursor), all[5]);
+}
+
+BOOST_FIXTURE_TEST_CASE(paginate_targets_benchmark, IcingaApplicationFixture,
+	*boost::unit_test::label("benchmark")
+	*boost::unit_test::disabled())
+{
+	auto createObjects = []() {
+		String config = R"CONFIG({
+object CheckCommand "page-dummy" {
+  command = "/bin/echo"
+}
+
+object ApiUser "pageUser" {
+  permissions = [ "*" ]
+}
+
+for (i in range(200000)) {
+  object Host "page-host" + i use (i) {
+    check_command = "page-dummy"
+    vars.num = i
+  }
+}
+})CONFIG";
+		std::unique_ptr<Expression> expr = ConfigCompiler::CompileText("<test>", config);
+		ScriptFrame frame (true);
+		expr->Evaluate(frame);
+	};
+
+	ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", createObjects));
+
+	auto user = ApiUser::GetByName("pageUser");
+	BOOST_REQUIRE(user);
+
+	QueryDescription qd;
+	qd.Types.insert("Host");
+	qd.Permission = "objects/query/Host";
+
+	/* Selects the objects like ObjectQueryHandler does and serializes the ones ending up in the response. */
+	auto query ([&qd, &user](const Dictionary::Ptr& params) {
+		params->Set("type", "Host");
+
+		auto start (std::chrono::steady_clock::now());
+		auto objs (FilterUtility::GetFilterTargets(qd, params, user));
+		auto cursor (FilterUtility::PaginateTargets(objs, params));
+
+		for (ConfigObject::Ptr obj : objs) {
+			Serialize(obj, FAConfig | FAState);
+		}
+
+		std::chrono::duration<double, std::milli> took (std::chrono::steady_clock::now() - start);
+		std::cout << JsonEncode(params) << ": " << took.count() << " ms (" << objs.size() << " objects)" << std::endl;
+
+		return cursor;
+	});
+
+	query(new Dictionary());
+	auto cursor (query(new Dictionary({{"limit", 100}})));
+	query(new Dictionary({{"limit", 100}, {"cursor", cursor}}));
+	query(new Dictionary({{"limit", 100}, {"offset", 100000}}));
+	query(new Dictionary({{"limit", 100}, {"filter", "host.vars.num % 2 == 0"}}));
+}
+
+BOOST_AUTO_TEST_CASE(cached_filter_key)
+{
+	auto cached (FilterUtility::GetCachedFilter("a == b", Host::TypeInstance, "host", new Dictionary({{"a", 1}, {"b", 2}})));
+
+	BOOST_REQUIRE(cached->Compiled);
+	BOOST_CHECK(FilterUtility::GetCachedFilter("a == b", Host::TypeInstance, "host", new Dictionary({{"a", 3}, {"b", 4}})) == cached);
+
+	/* Different variable names must never share a cache entry, no matter how they're spelled. */
+	BOOST_CHECK(FilterUtility::GetCachedFilter("a == b", Host::TypeInstance, "host", new Dictionary({{"a,b", 1}})) != cached);
+	BOOST_CHECK(FilterUtility::GetCachedFilter("a == b", Host::TypeInstance, "host", new Dictionary({{"a", 1}})) != cached);
+	BOOST_CHECK(FilterUtility::GetCachedFilter("a == b", Host::TypeInstance, "host", nullptr) != cached);
+}
+
 BOOST_AUTO_TEST_SUITE_END()